@@ -22,7 +22,7 @@
 	case err: return #err
 
 static const char *itoa(int i) {
-	static char buf[12];
+	static __thread char buf[12];
 	char *ptr = buf + sizeof(buf) - 1;
 	unsigned int u;
 	int minus = 0;
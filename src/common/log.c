@@ -3,29 +3,478 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
-
+#include <stdlib.h>
 #include <alloca.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+// Lines logged to file are formatted by caller into its own ring buffer,
+// writer thread drains all rings to the file opened once. Only the thread
+// owning ring moves head and only the writer moves tail, so no lock is taken
+// per line. Console output is written at once as before.
+
+#define LOG_RING_SIZE (64 * 1024)
+#define LOG_LINE_SIZE 1024
+#define LOG_WRITER_PERIOD_MS 50
+#define LOG_ROTATE_SIZE (16 * 1024 * 1024)
+#define LOG_ROTATE_FILES 3
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+typedef struct log_ring {
+	struct log_ring * next;
+	// owner thread is finished, ring is freed by writer when empty
+	int closed;
+	size_t head __attribute__((aligned(64)));
+	size_t tail __attribute__((aligned(64)));
+	char data[LOG_RING_SIZE];
+} log_ring;
+
+static struct {
+	// rings list, path and writer state
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t flushed;
+	// file descriptor, rotation
+	pthread_mutex_t file_lock;
+
+	log_ring * rings;
+	pthread_key_t ring_key;
+	pthread_t writer;
+	int running;
+	int stop;
+	int wakeup;
+	unsigned long flush_req;
+	unsigned long flush_done;
+
+	char path[PATH_MAX];
+	unsigned int path_gen;
+	unsigned int fd_gen;
+	int fd;
+	int regular;
+	size_t size;
+	size_t rotate_size;
+	unsigned int rotate_files;
+} logger = {
+	PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+	PTHREAD_MUTEX_INITIALIZER,
+	0, 0, 0, 0, 0, 0, 0, 0,
+	{0}, 0, 0, -1, 0, 0,
+	LOG_ROTATE_SIZE,
+	LOG_ROTATE_FILES
+};
+
+int common_log_level = LOG_LEVEL_TRACE;
+
+static pthread_once_t logger_once = PTHREAD_ONCE_INIT;
+static __thread log_ring * thread_ring;
+static __thread char thread_path[PATH_MAX];
+
+// under file_lock
+static void LogRotate(void)
+{
+	char from[PATH_MAX + 16], to[PATH_MAX + 16];
+	unsigned int n;
+
+	close(logger.fd);
+	logger.fd = -1;
+
+	// rename over existing file makes some filesystems (ext4) flush it first
+	snprintf(to, sizeof(to), "%s.%u", logger.path, logger.rotate_files);
+	if( logger.rotate_files )
+		unlink(to);
+
+	for( n = logger.rotate_files; n > 1; n-- ) {
+		snprintf(from, sizeof(from), "%s.%u", logger.path, n - 1);
+		snprintf(to, sizeof(to), "%s.%u", logger.path, n);
+		rename(from, to);
+	}
+	snprintf(to, sizeof(to), "%s.1", logger.path);
+	if( logger.rotate_files )
+		rename(logger.path, to);
+	else
+		unlink(logger.path);
+}
+
+// under file_lock
+static int LogOpen(void)
+{
+	struct stat st;
+
+	if( logger.fd >= 0 && logger.fd_gen == logger.path_gen )
+		return logger.fd;
+
+	if( logger.fd >= 0 )
+		close(logger.fd);
+
+	logger.fd = open(logger.path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	logger.fd_gen = logger.path_gen;
+	logger.regular = 0;
+	logger.size = 0;
+	if( logger.fd >= 0 && fstat(logger.fd, &st) == 0 && S_ISREG(st.st_mode) ) {
+		logger.regular = 1;
+		logger.size = (size_t)st.st_size;
+	}
+	return logger.fd;
+}
+
+// under file_lock
+static void LogWrite(const char * data, size_t len)
+{
+	if( LogOpen() < 0 ) {
+		if( write(STDERR_FILENO, data, len) < 0 ) {}
+		return;
+	}
+
+	while( len ) {
+		ssize_t res = write(logger.fd, data, len);
+		if( res < 0 ) {
+			if( errno == EINTR )
+				continue;
+			break;
+		}
+		data += res;
+		len -= (size_t)res;
+		logger.size += (size_t)res;
+	}
+
+	if( logger.regular && logger.rotate_size && logger.size >= logger.rotate_size )
+		LogRotate();
+}
+
+// writer thread only
+static size_t LogDrainRing(log_ring * ring)
+{
+	size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+	size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	size_t pos = tail % LOG_RING_SIZE, len = head - tail;
+
+	if( !len )
+		return 0;
+
+	if( pos + len > LOG_RING_SIZE ) {
+		LogWrite(ring->data + pos, LOG_RING_SIZE - pos);
+		LogWrite(ring->data, len - (LOG_RING_SIZE - pos));
+	} else
+		LogWrite(ring->data + pos, len);
+
+	__atomic_store_n(&ring->tail, head, __ATOMIC_RELEASE);
+	return len;
+}
+
+// writer thread (or after it is stopped), rings of finished threads are removed when empty
+static void LogDrain(void)
+{
+	log_ring ** prev, * ring;
+
+	pthread_mutex_lock(&logger.lock);
+	ring = logger.rings;
+	pthread_mutex_unlock(&logger.lock);
+
+	// new rings are added to list head, so walk without lock is safe
+	pthread_mutex_lock(&logger.file_lock);
+	for( ; ring; ring = ring->next )
+		LogDrainRing(ring);
+	pthread_mutex_unlock(&logger.file_lock);
+
+	pthread_mutex_lock(&logger.lock);
+	for( prev = &logger.rings; (ring = *prev) != 0; ) {
+		if( __atomic_load_n(&ring->closed, __ATOMIC_ACQUIRE) &&
+			__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == ring->tail ) {
+			*prev = ring->next;
+			free(ring);
+		} else
+			prev = &ring->next;
+	}
+	pthread_mutex_unlock(&logger.lock);
+}
+
+static void * LogWriter(void * arg)
+{
+	struct timespec ts;
+	unsigned long req;
+	int stop;
+
+	(void)arg;
+	for( ;; ) {
+		pthread_mutex_lock(&logger.lock);
+		if( !logger.wakeup && !logger.stop && logger.flush_req == logger.flush_done ) {
+			clock_gettime(CLOCK_REALTIME, &ts);
+			ts.tv_nsec += LOG_WRITER_PERIOD_MS * 1000000L;
+			if( ts.tv_nsec >= 1000000000L ) {
+				ts.tv_sec++;
+				ts.tv_nsec -= 1000000000L;
+			}
+			pthread_cond_timedwait(&logger.wake, &logger.lock, &ts);
+		}
+		logger.wakeup = 0;
+		stop = logger.stop;
+		req = logger.flush_req;
+		pthread_mutex_unlock(&logger.lock);
+
+		LogDrain();
+
+		pthread_mutex_lock(&logger.lock);
+		logger.flush_done = req;
+		pthread_cond_broadcast(&logger.flushed);
+		pthread_mutex_unlock(&logger.lock);
+
+		if( stop )
+			break;
+	}
+	return 0;
+}
+
+static void LogThreadExit(void * arg)
+{
+	__atomic_store_n(&((log_ring *)arg)->closed, 1, __ATOMIC_RELEASE);
+}
+
+static void LogStop(void)
+{
+	int running;
+
+	pthread_mutex_lock(&logger.lock);
+	running = logger.running;
+	logger.stop = 1;
+	pthread_cond_signal(&logger.wake);
+	pthread_mutex_unlock(&logger.lock);
+
+	if( running ) {
+		pthread_join(logger.writer, 0);
+
+		pthread_mutex_lock(&logger.lock);
+		__atomic_store_n(&logger.running, 0, __ATOMIC_RELEASE);
+		pthread_mutex_unlock(&logger.lock);
+
+		// lines pushed after last pass of writer
+		LogDrain();
+
+		pthread_mutex_lock(&logger.file_lock);
+		if( logger.fd >= 0 )
+			close(logger.fd);
+		logger.fd = -1;
+		pthread_mutex_unlock(&logger.file_lock);
+	}
+
+	// destructor of the key is code of this object, threads exiting
+	// after dlclose() must not call it
+	pthread_key_delete(logger.ring_key);
+}
+
+static void LogForkPrepare(void)
+{
+	pthread_mutex_lock(&logger.lock);
+	pthread_mutex_lock(&logger.file_lock);
+}
+
+static void LogForkParent(void)
+{
+	pthread_mutex_unlock(&logger.file_lock);
+	pthread_mutex_unlock(&logger.lock);
+}
+
+// writer is not copied to child, it writes directly
+static void LogForkChild(void)
+{
+	logger.running = 0;
+	logger.rings = 0;
+	thread_ring = 0;
+	pthread_mutex_unlock(&logger.file_lock);
+	pthread_mutex_unlock(&logger.lock);
+}
+
+static void LogInit(void)
+{
+	pthread_key_create(&logger.ring_key, LogThreadExit);
+	pthread_atfork(LogForkPrepare, LogForkParent, LogForkChild);
+
+	pthread_mutex_lock(&logger.lock);
+	__atomic_store_n(&logger.running, pthread_create(&logger.writer, 0, LogWriter, 0) == 0, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&logger.lock);
+
+	// in shared object it is called by dlclose()
+	atexit(LogStop);
+}
+
+static log_ring * LogThreadRing(void)
+{
+	log_ring * ring = thread_ring;
+	if( ring )
+		return ring;
+
+	ring = (log_ring *)calloc(1, sizeof(log_ring));
+	if( !ring )
+		return 0;
+
+	pthread_mutex_lock(&logger.lock);
+	if( !logger.running ) {
+		pthread_mutex_unlock(&logger.lock);
+		free(ring);
+		return 0;
+	}
+	ring->next = logger.rings;
+	logger.rings = ring;
+	pthread_mutex_unlock(&logger.lock);
+
+	pthread_setspecific(logger.ring_key, ring);
+	thread_ring = ring;
+	return ring;
+}
+
+static void LogWakeWriter(void)
+{
+	pthread_mutex_lock(&logger.lock);
+	logger.wakeup = 1;
+	pthread_cond_signal(&logger.wake);
+	pthread_mutex_unlock(&logger.lock);
+}
+
+static int LogPush(const char * line, size_t len)
+{
+	log_ring * ring = LogThreadRing();
+	size_t head, tail, pos;
+
+	if( !ring || len > LOG_RING_SIZE || !__atomic_load_n(&logger.running, __ATOMIC_ACQUIRE) )
+		return 0;
+
+	head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+	for( ;; ) {
+		tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+		if( LOG_RING_SIZE - (head - tail) >= len )
+			break;
+		// full, wait for writer instead of losing lines
+		if( !__atomic_load_n(&logger.running, __ATOMIC_ACQUIRE) )
+			return 0;
+		LogWakeWriter();
+		sched_yield();
+	}
+
+	pos = head % LOG_RING_SIZE;
+	if( pos + len > LOG_RING_SIZE ) {
+		memcpy(ring->data + pos, line, LOG_RING_SIZE - pos);
+		memcpy(ring->data, line + (LOG_RING_SIZE - pos), len - (LOG_RING_SIZE - pos));
+	} else
+		memcpy(ring->data + pos, line, len);
+
+	__atomic_store_n(&ring->head, head + len, __ATOMIC_RELEASE);
+
+	// do not wait for period when ring is half full
+	if( head + len - tail > LOG_RING_SIZE / 2 )
+		LogWakeWriter();
+	return 1;
+}
+
+// lines already queued belong to previous file
+static void LogSetPath(const char * filename)
+{
+	size_t len = strlen(filename);
+
+	if( len >= sizeof(thread_path) )
+		len = sizeof(thread_path) - 1;
+	memcpy(thread_path, filename, len);
+	thread_path[len] = 0;
+
+	pthread_mutex_lock(&logger.file_lock);
+	if( strcmp(logger.path, thread_path) ) {
+		pthread_mutex_unlock(&logger.file_lock);
+		common_log_flush();
+		pthread_mutex_lock(&logger.file_lock);
+		memcpy(logger.path, thread_path, len + 1);
+		logger.path_gen++;
+	}
+	pthread_mutex_unlock(&logger.file_lock);
+}
+
+extern void common_log_flush(void)
+{
+	unsigned long req;
+
+	pthread_mutex_lock(&logger.lock);
+	if( logger.running ) {
+		req = ++logger.flush_req;
+		pthread_cond_signal(&logger.wake);
+		while( logger.running && (long)(logger.flush_done - req) < 0 )
+			pthread_cond_wait(&logger.flushed, &logger.lock);
+	}
+	pthread_mutex_unlock(&logger.lock);
+}
+
+extern void common_log_rotate(size_t max_size, unsigned int max_files)
+{
+	pthread_mutex_lock(&logger.file_lock);
+	logger.rotate_size = max_size;
+	logger.rotate_files = max_files;
+	pthread_mutex_unlock(&logger.file_lock);
+}
 
 extern void common_log(const char * filename, const char * prefix, const char * file, const char *function, unsigned int line, const char *format, ...)
 {
 	va_list args;
-	const char out_format[] = "%s %s:%u %s %s%s";
-	char *xformat = (char *)alloca(strlen(prefix) + strlen(file) + strlen(format) + strlen(function) + sizeof(out_format));
-	sprintf(xformat, out_format, prefix, file, line, function, (*format != '\n') ? " - " : "", format);
+	char buf[LOG_LINE_SIZE], * out = buf;
+	int hlen, len;
+
+	if( !filename || !filename[0] ) {
+		const char out_format[] = "%s %s:%u %s %s%s";
+		char *xformat = (char *)alloca(strlen(prefix) + strlen(file) + strlen(format) + strlen(function) + sizeof(out_format));
+		sprintf(xformat, out_format, prefix, file, line, function, (*format != '\n') ? " - " : "", format);
+
+		va_start(args, format);
+		vfprintf(stderr, xformat, args);
+		va_end(args);
+		return;
+	}
 
-	FILE *stream = 0;
-	if( filename && filename[0] )
-		stream = fopen(filename, "at");
+	// logging is off
+	if( !strcmp(filename, "/dev/null") )
+		return;
 
-	if( !stream )
-		stream = stderr;
+	hlen = snprintf(buf, sizeof(buf), "%s %s:%u %s %s", prefix, file, line, function, (*format != '\n') ? " - " : "");
+	if( hlen < 0 )
+		return;
+	if( (size_t)hlen >= sizeof(buf) )
+		hlen = sizeof(buf) - 1;
 
 	va_start(args, format);
-	vfprintf(stream, xformat, args);
+	len = vsnprintf(buf + hlen, sizeof(buf) - hlen, format, args);
 	va_end(args);
+	if( len < 0 )
+		return;
 
-	if( stream != stderr )
-		fclose(stream);
+	if( (size_t)(hlen + len) >= sizeof(buf) ) {
+		out = (char *)malloc(hlen + len + 1);
+		if( !out )
+			return;
+		memcpy(out, buf, hlen);
+		va_start(args, format);
+		vsnprintf(out + hlen, len + 1, format, args);
+		va_end(args);
+	}
+
+	pthread_once(&logger_once, LogInit);
+
+	if( strcmp(thread_path, filename) )
+		LogSetPath(filename);
+
+	// writer is stopped (exit) or failed to start
+	if( !LogPush(out, hlen + len) ) {
+		pthread_mutex_lock(&logger.file_lock);
+		LogWrite(out, hlen + len);
+		pthread_mutex_unlock(&logger.file_lock);
+	}
+
+	if( out != buf )
+		free(out);
 }
 
 #ifdef MAIN_COMMON_LOG
@@ -44,3 +493,59 @@ int main(int argc, char * argv[])
 	return 0;
 }
 #endif // MAIN_COMMON_LOG
+
+#ifdef MAIN_COMMON_LOG_BENCH
+
+#define LOG_SOURCE_FILE "log.c"
+
+static const char * LOG_FILE = "/dev/null";
+
+static double BenchNow(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned long lines_per_thread;
+
+static void * BenchThread(void * arg)
+{
+	unsigned long i;
+	for( i = 0; i < lines_per_thread; i++ )
+		LOG_INFO("thread %lu line %lu dst 10.%lu.%lu.0/24 oif %lu\n", (unsigned long)(size_t)arg, i, (i >> 8) & 255, i & 255, i % 16);
+	return 0;
+}
+
+// log_bench <file> [lines] [threads] [rotate MB]
+int main(int argc, char * argv[])
+{
+	unsigned long lines = argc > 2 ? strtoul(argv[2], 0, 10):1000000;
+	unsigned long threads = argc > 3 ? strtoul(argv[3], 0, 10):1, i;
+	pthread_t tid[64];
+	double start, logged, flushed;
+
+	if( argc < 2 || !threads || threads > 64 ) {
+		fprintf(stderr, "usage: %s <file> [lines] [threads] [rotate MB]\n", argv[0]);
+		return 1;
+	}
+	if( argc > 4 )
+		common_log_rotate(strtoul(argv[4], 0, 10) * 1024 * 1024, LOG_ROTATE_FILES);
+	lines_per_thread = lines / threads;
+
+	LOG_FILE = argv[1];
+	start = BenchNow();
+	for( i = 0; i < threads; i++ )
+		pthread_create(&tid[i], 0, BenchThread, (void *)(size_t)i);
+	for( i = 0; i < threads; i++ )
+		pthread_join(tid[i], 0);
+	logged = BenchNow();
+	common_log_flush();
+	flushed = BenchNow();
+
+	printf("%lu lines by %lu threads: logged %.3f ms (%.1f ns/line), written %.3f ms\n",
+		lines_per_thread * threads, threads, (logged - start)*1e3,
+		(logged - start)*1e9/(lines_per_thread * threads), (flushed - start)*1e3);
+	return 0;
+}
+#endif // MAIN_COMMON_LOG_BENCH
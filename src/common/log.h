@@ -1,25 +1,57 @@
 #ifndef __COMMON_LOG_H__
 #define __COMMON_LOG_H__
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE  4
+
+// levels below are compiled out, release builds use -DLOG_MIN_LEVEL=LOG_LEVEL_INFO
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_TRACE
+#endif
+
+// levels below are skipped at runtime, LOG_LEVEL_TRACE by default
+extern int common_log_level;
+
 void common_log(const char * filename, const char * prefix, const char * file, const char *function, unsigned int line, const char *format, ...);
 
+// file output is buffered and written by background thread,
+// returns when all lines logged before the call are written
+void common_log_flush(void);
+
+// file is renamed to file.1 (file.1 to file.2 ...) when it grows over max_size,
+// 0 max_size disables rotation, 0 max_files removes file instead
+void common_log_rotate(size_t max_size, unsigned int max_files);
+
 #ifdef __cplusplus
 }
 #endif
 
 // LOG_FILE and LOG_SOURCE_FILE define in c(cpp) file
 // use '#define LOG_FILE ""' for console output
+// "/dev/null" LOG_FILE disables logging
+
+// arguments are not evaluated when level is off
+#define LOG_ENABLED(level) ((level) >= LOG_MIN_LEVEL && (level) >= common_log_level)
+#define LOG_AT(level, filename, prefix, args...) \
+	do { if( LOG_ENABLED(level) ) common_log(filename, prefix, LOG_SOURCE_FILE, __FUNCTION__, __LINE__, args); } while(0)
 
-#define LOG_INFO(args...) common_log(LOG_FILE,  "[info] ", LOG_SOURCE_FILE, __FUNCTION__, __LINE__, args)
-#define LOG_WARN(args...) common_log(LOG_FILE,  "[warn] ", LOG_SOURCE_FILE, __FUNCTION__, __LINE__, args)
-#define LOG_ERROR(args...) common_log(LOG_FILE, "[error]", LOG_SOURCE_FILE, __FUNCTION__, __LINE__, args)
+// per record and per attribute dump of parsers
+#define LOG_TRACE(args...) LOG_AT(LOG_LEVEL_TRACE, LOG_FILE, "[trace]", args)
+#define LOG_INFO(args...) LOG_AT(LOG_LEVEL_INFO, LOG_FILE,  "[info] ", args)
+#define LOG_WARN(args...) LOG_AT(LOG_LEVEL_WARN, LOG_FILE,  "[warn] ", args)
+#define LOG_ERROR(args...) LOG_AT(LOG_LEVEL_ERROR, LOG_FILE, "[error]", args)
 
-#define LOG_INFO_CONSOLE(args...) common_log(0,  "[info] ", LOG_SOURCE_FILE, __FUNCTION__, __LINE__, args)
-#define LOG_WARN_CONSOLE(args...) common_log(0,  "[warn] ", LOG_SOURCE_FILE, __FUNCTION__, __LINE__, args)
-#define LOG_ERROR_CONSOLE(args...) common_log(0, "[error]", LOG_SOURCE_FILE, __FUNCTION__, __LINE__, args)
+#define LOG_INFO_CONSOLE(args...) LOG_AT(LOG_LEVEL_INFO, 0,  "[info] ", args)
+#define LOG_WARN_CONSOLE(args...) LOG_AT(LOG_LEVEL_WARN, 0,  "[warn] ", args)
+#define LOG_ERROR_CONSOLE(args...) LOG_AT(LOG_LEVEL_ERROR, 0, "[error]", args)
 
 #endif // __COMMON_LOG_H__
@@ -2,6 +2,11 @@
 
 // https://habr.com/ru/articles/121254/
 
+// recvmmsg()
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include "netlink.h"
 #include "netutils.h"
 
@@ -12,6 +17,8 @@
 
 #ifdef MAIN_COMMON_NETLINK
 const char * LOG_FILE = "";
+#elif defined(MAIN_COMMON_NETLINK_BENCH) || defined(MAIN_COMMON_NETLINK_REPLAY)
+const char * LOG_FILE = "/dev/null";
 #else
 extern const char * LOG_FILE;
 #endif
@@ -22,6 +29,11 @@ extern const char * LOG_FILE;
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <net/if_arp.h>
 
 #ifndef SOL_NETLINK
 #define SOL_NETLINK 270
@@ -37,6 +49,7 @@ extern const char * LOG_FILE;
 
 #define NETLINK_SEND_BUFFER_SIZE (32768)
 #define NETLINK_RECV_BUFFER_SIZE (1024 * 1024)
+#define NETLINK_RECV_CHUNK (32768)
 #define NETLINK_EXT_ASK TRUE
 
 #if INTPTR_MAX == INT32_MAX
@@ -47,14 +60,17 @@ extern const char * LOG_FILE;
     #error "Environment not 32 or 64-bit."
 #endif
 
-typedef struct {
-	struct nlmsghdr nlm;
-	char * info;
-	struct rtattr *tb[1];
-} UniversalRecord;
+struct NetlinkTransport;
+struct NetlinkReplay;
 
 typedef struct {
 	int netlink_socket;
+	// socket by default, replay feeds recorded datagrams instead of kernel
+	const struct NetlinkTransport * transport;
+	struct NetlinkReplay * replay;
+	// pcap file for all sent and received datagrams
+	FILE * record;
+
 	size_t sndbufsize;
 	size_t rcvbufsize;
 	uint32_t sequence_number;
@@ -67,7 +83,27 @@ typedef struct {
 
 	size_t infosize;
 	uint16_t max_tbl_items;
-	const char * (*typeprint)( uint16_t type );
+	int dump_intr;
+	int dump_done;
+	// datagram was truncated, the rest of reply is drained and request may be repeated
+	int truncated;
+	// NETLINK_GET_STRICT_CHK is not supported by kernel
+	int no_strict_chk;
+
+	// per-dump arena: records and attribute offsets are reset before each dump
+	// and only grow, memory is freed in CloseNetlink()
+	size_t records_size;
+	uint32_t * offsets;
+	size_t offsets_size;
+	size_t offsets_used;
+
+	// change requests packed by AddRequest() and sent by CommitRequests()
+	char * batch;
+	size_t batch_size;
+	size_t batch_used;
+	size_t batch_last;
+	uint32_t batch_count;
+	uint32_t batch_seq;
 
 	union {
 		char * ptr;
@@ -86,32 +122,67 @@ typedef struct {
 	};
 } netlink_ctx;
 
+// all netlink I/O goes through transport
+typedef struct NetlinkTransport {
+	const char * name;
+	ssize_t (* send)(netlink_ctx * ctx, const void * buf, size_t len);
+	// one datagram per call, MSG_PEEK | MSG_TRUNC returns full size of the next one
+	ssize_t (* recvmsg)(netlink_ctx * ctx, struct msghdr * msg, int flags);
+	// several datagrams per call, optional
+	int (* recvmmsg)(netlink_ctx * ctx, struct mmsghdr * msgs, unsigned int vlen, int flags);
+	void (* close)(netlink_ctx * ctx);
+} NetlinkTransport;
+
 #ifndef FIELD_OFFSET
 #define	FIELD_OFFSET(s, field) ((addr_t)&((s *)(0))->field)
 #define	addr_t unsigned long
 #endif
 
+#ifndef NLM_F_CAPPED
+#define NLM_F_CAPPED	0x100	/* request was capped */
+#endif
+
+#ifndef NLM_F_ACK_TLVS
+#define NLM_F_ACK_TLVS	0x200	/* extended ACK TVLs were included */
+#endif
+
+#ifndef NLMSGERR_ATTR_MSG
+#define NLMSGERR_ATTR_MSG 1
+#endif
+
 #ifndef NETLINK_EXT_ACK
 #define NETLINK_EXT_ACK	11
 #endif
 
+#ifndef NETLINK_GET_STRICT_CHK
+#define NETLINK_GET_STRICT_CHK	12
+#endif
+
+static const FlagName fibruleflags_names[] = {
+	{ FIB_RULE_PERMANENT, "PERMANENT" },
+	{ FIB_RULE_INVERT, "INVERT" },
+	{ FIB_RULE_UNRESOLVED, "UNRESOLVED" },
+	{ FIB_RULE_DEV_DETACHED, "IIF_DETACHED" },
+	{ FIB_RULE_OIF_DETACHED, "OIF_DETACHED" },
+	{ FIB_RULE_FIND_SADDR, "FIND_SADDR" },
+	{ 0, 0 }
+};
+
+const char * fibruleflagsname_r(uint32_t flags, char * buf, size_t size) // FIB_RULE_
+{
+	return flagsname_r(fibruleflags_names, ", ", flags, buf, size);
+}
+
 const char * fibruleflagsname(uint32_t flags) // FIB_RULE_
 {
-	static char buf[sizeof("PERMANENT, INVERT, UNRESOLVED, IIF_DETACHED, OIF_DETACHED, FIND_SADDR")] = {0};
-	buf[0] = '\0';
-	flags = addflag(buf, "PERMANENT", flags, FIB_RULE_PERMANENT);
-	flags = addflag(buf, "INVERT", flags, FIB_RULE_INVERT);
-	flags = addflag(buf, "UNRESOLVED", flags, FIB_RULE_UNRESOLVED);
-	flags = addflag(buf, "IIF_DETACHED", flags, FIB_RULE_DEV_DETACHED);
-	flags = addflag(buf, "OIF_DETACHED", flags, FIB_RULE_OIF_DETACHED);
-	flags = addflag(buf, "FIND_SADDR", flags, FIB_RULE_FIND_SADDR);
-	return buf;
+	static __thread char buf[FIBRULEFLAGSNAME_SIZE];
+	return fibruleflagsname_r(flags, buf, sizeof(buf));
 }
 
 
 const char * ndmsgflagsname(uint8_t flags)
 {
-	static char buf[sizeof("use, self, master, proxy, extern_learn, offload, sticky, router")] = {0};
+	static __thread char buf[sizeof("use, self, master, proxy, extern_learn, offload, sticky, router")] = {0};
 	buf[0] = '\0';
 	flags = addflag(buf, "use", flags, NTF_USE);
 	flags = addflag(buf, "self", flags, NTF_SELF);
@@ -125,27 +196,35 @@ const char * ndmsgflagsname(uint8_t flags)
 	return buf;
 }
 
-const char * tunnelflagsname(uint16_t flags) 
+static const FlagName tunnelflags_names[] = {
+	{ TUNNEL_CSUM, "csum" },
+	{ TUNNEL_ROUTING, "routing" },
+	{ TUNNEL_KEY, "key" },
+	{ TUNNEL_SEQ, "seq" },
+	{ TUNNEL_STRICT, "strict" },
+	{ TUNNEL_REC, "rec" },
+	{ TUNNEL_VERSION, "version" },
+	{ TUNNEL_NO_KEY, "no key" },
+	{ TUNNEL_DONT_FRAGMENT, "dont fragment" },
+	{ TUNNEL_OAM, "oam" },
+	{ TUNNEL_CRIT_OPT, "crit_opts" },
+	{ TUNNEL_NOCACHE, "nocache" },
+	{ TUNNEL_GTP_OPT, "gtp_opts" },
+	{ TUNNEL_GENEVE_OPT, "geneve_opts" },
+	{ TUNNEL_VXLAN_OPT, "vxlan_opts" },
+	{ TUNNEL_ERSPAN_OPT, "erspan_opts" },
+	{ 0, 0 }
+};
+
+const char * tunnelflagsname_r(uint16_t flags, char * buf, size_t size) // TUNNEL_
 {
-	static char buf[sizeof("csum, routing, key, seq, strict, rec, version, no key, dont fragment, oam, crit opt, geneve opt, vxlan opt, nocache, erspan opt, gtp opt")] = {0};
-	buf[0] = '\0';
-	flags = addflag_space_separator(buf, "csum", flags, TUNNEL_CSUM);
-	flags = addflag_space_separator(buf, "routing", flags, TUNNEL_ROUTING);
-	flags = addflag_space_separator(buf, "key", flags, TUNNEL_KEY);
-	flags = addflag_space_separator(buf, "seq", flags, TUNNEL_SEQ);
-	flags = addflag_space_separator(buf, "strict", flags, TUNNEL_STRICT);
-	flags = addflag_space_separator(buf, "rec", flags, TUNNEL_REC);
-	flags = addflag_space_separator(buf, "version", flags, TUNNEL_VERSION);
-	flags = addflag_space_separator(buf, "no key", flags, TUNNEL_NO_KEY);
-	flags = addflag_space_separator(buf, "dont fragment", flags, TUNNEL_DONT_FRAGMENT);
-	flags = addflag_space_separator(buf, "oam", flags, TUNNEL_OAM);
-	flags = addflag_space_separator(buf, "crit_opts", flags, TUNNEL_CRIT_OPT);
-	flags = addflag_space_separator(buf, "nocache", flags, TUNNEL_NOCACHE);
-	flags = addflag_space_separator(buf, "gtp_opts", flags, TUNNEL_GTP_OPT);
-	flags = addflag_space_separator(buf, "geneve_opts", flags, TUNNEL_GENEVE_OPT);
-	flags = addflag_space_separator(buf, "vxlan_opts", flags, TUNNEL_VXLAN_OPT);
-	flags = addflag_space_separator(buf, "erspan_opts", flags, TUNNEL_ERSPAN_OPT);
-	return buf;
+	return flagsname_r(tunnelflags_names, " ", flags, buf, size);
+}
+
+const char * tunnelflagsname(uint16_t flags) // TUNNEL_
+{
+	static __thread char buf[TUNNELFLAGSNAME_SIZE];
+	return tunnelflagsname_r(flags, buf, sizeof(buf));
 }
 
 
@@ -204,28 +283,35 @@ const char * iptunneloptserspantype( uint16_t type ) // LWTUNNEL_IP_OPT_ERSPAN_
 	return "UNKNOWN";
 }
 
-const char * rtnhflagsname(uint8_t flags)
+static const FlagName rtnhflags_names[] = {
+	{ RTNH_F_DEAD, "dead" },
+	{ RTNH_F_ONLINK, "onlink" },
+	{ RTNH_F_PERVASIVE, "pervasive" },
+	{ RTNH_F_OFFLOAD, "offload" },
+	{ RTNH_F_TRAP, "trap" },
+	{ RTM_F_NOTIFY, "notify" },
+	{ RTNH_F_LINKDOWN, "linkdown" },
+	{ RTNH_F_UNRESOLVED, "unresolved" },
+	{ RTM_F_OFFLOAD, "rt_offload" },
+	{ RTM_F_TRAP, "rt_trap" },
+	{ RTM_F_OFFLOAD_FAILED, "rt_offload_failed" },
+	{ 0, 0 }
+};
+
+const char * rtnhflagsname_r(uint8_t flags, char * buf, size_t size)
 {
-	static char buf[sizeof("dead, onlink, pervasive, offload, trap, notify, linkdown, unresolved, rt_offload, rt_offload_failed")] = {0};
-	buf[0] = '\0';
-	flags = addflag(buf, "dead", flags, RTNH_F_DEAD);
-	flags = addflag(buf, "onlink", flags, RTNH_F_ONLINK);
-	flags = addflag(buf, "pervasive", flags, RTNH_F_PERVASIVE);
-	flags = addflag(buf, "offload", flags, RTNH_F_OFFLOAD);
-	flags = addflag(buf, "trap", flags, RTNH_F_TRAP);
-	flags = addflag(buf, "notify", flags, RTM_F_NOTIFY);
-	flags = addflag(buf, "linkdown", flags, RTNH_F_LINKDOWN);
-	flags = addflag(buf, "unresolved", flags, RTNH_F_UNRESOLVED);
-	flags = addflag(buf, "rt_offload", flags, RTM_F_OFFLOAD);
-	flags = addflag(buf, "rt_trap", flags, RTM_F_TRAP);
-	flags = addflag(buf, "rt_offload_failed", flags, RTM_F_OFFLOAD_FAILED);
+	return flagsname_r(rtnhflags_names, ", ", flags, buf, size);
+}
 
-	return buf;
+const char * rtnhflagsname(uint8_t flags)
+{
+	static __thread char buf[RTNHFLAGSNAME_SIZE];
+	return rtnhflagsname_r(flags, buf, sizeof(buf));
 }
 
 const char * ndmsgflags_extname(uint32_t flags)
 {
-	static char buf[sizeof("managed, locked")] = {0};
+	static __thread char buf[sizeof("managed, locked")] = {0};
 	buf[0] = '\0';
 	flags = addflag(buf, "managed", flags, NTF_EXT_MANAGED);
 	flags = addflag(buf, "locked", flags, NTF_EXT_LOCKED);
@@ -255,9 +341,8 @@ const char * ndmsgstate(uint16_t state)
 	return "UNKNOWN";
 }
 
-const char * rticmp6pref(uint8_t pref)
+const char * rticmp6pref_r(uint8_t pref, char * buf, size_t size)
 {
-	static char s[sizeof("256")] = {0};
 	switch (pref) {
 	case ICMPV6_ROUTER_PREF_LOW:
 		return "low";
@@ -266,15 +351,20 @@ const char * rticmp6pref(uint8_t pref)
 	case ICMPV6_ROUTER_PREF_HIGH:
 		return "high";
 	default:
-		if( snprintf(s, sizeof(s), "%u", pref) > 0 )
-			return s;
+		if( snprintf(buf, size, "%u", pref) > 0 )
+			return buf;
 	}
 	return "";
 }
 
-const char * rtruletable( uint32_t table )
+const char * rticmp6pref(uint8_t pref)
+{
+	static __thread char buf[RTICMP6PREF_SIZE];
+	return rticmp6pref_r(pref, buf, sizeof(buf));
+}
+
+const char * rtruletable_r(uint32_t table, char * buf, size_t size)
 {
-	static char s[sizeof("4294967296")] = {0};
 	switch(table) {
 		case RT_TABLE_UNSPEC:
 			return "all"; // "RT_TABLE_UNSPEC";
@@ -287,15 +377,21 @@ const char * rtruletable( uint32_t table )
 		case RT_TABLE_LOCAL:
 			return "local";
 		default:
-			if( snprintf(s, sizeof(s), "%u", table) > 0 )
-				return s;
+			if( snprintf(buf, size, "%u", table) > 0 )
+				return buf;
 	};
 	return "";
 }
 
+const char * rtruletable(uint32_t table)
+{
+	static __thread char buf[RTRULETABLE_SIZE];
+	return rtruletable_r(table, buf, sizeof(buf));
+}
+
 const char * fractionrule( uint8_t action )
 {
-	static char s[sizeof("256")] = {0};
+	static __thread char s[sizeof("256")] = {0};
 	switch(action) {
 		case FR_ACT_UNSPEC:
 			return "unspec";//FR_ACT_UNSPEC;
@@ -325,9 +421,8 @@ const char * fractionrule( uint8_t action )
 	return "";
 }
 
-const char * rtscopetype( uint8_t scope )
+const char * rtscopetype_r(uint8_t scope, char * buf, size_t size)
 {
-	static char s[sizeof("256")] = {0};
 	switch(scope) {
 		case RT_SCOPE_UNIVERSE:
 			return "global"; //"universe";
@@ -340,14 +435,19 @@ const char * rtscopetype( uint8_t scope )
 		case RT_SCOPE_NOWHERE:
 			return "nowhere";
 	};
-	if( snprintf(s, sizeof(s), "%u", scope) > 0 )
-		return s;
+	if( snprintf(buf, size, "%u", scope) > 0 )
+		return buf;
 	return "";
 }
 
-const char * rtprotocoltype( uint8_t type )
+const char * rtscopetype(uint8_t scope)
+{
+	static __thread char buf[RTSCOPETYPE_SIZE];
+	return rtscopetype_r(scope, buf, sizeof(buf));
+}
+
+const char * rtprotocoltype_r(uint8_t type, char * buf, size_t size)
 {
-	static char s[sizeof("256")] = {0};
 	switch(type) {
 
 		case RTPROT_UNSPEC:
@@ -404,15 +504,20 @@ const char * rtprotocoltype( uint8_t type )
 			return "eigrp";
 	};
 
-	if( snprintf(s, sizeof(s), "%u", type) > 0 )
-		return s;
+	if( snprintf(buf, size, "%u", type) > 0 )
+		return buf;
 
 	return "";
 }
 
-const char *lwtunnelencaptype(uint16_t type)
+const char * rtprotocoltype(uint8_t type)
+{
+	static __thread char buf[RTPROTOCOLTYPE_SIZE];
+	return rtprotocoltype_r(type, buf, sizeof(buf));
+}
+
+const char * lwtunnelencaptype_r(uint16_t type, char * buf, size_t size)
 {
-	static char s[sizeof("65536")] = {0};
 	switch (type) {
 	case LWTUNNEL_ENCAP_NONE:
 		return "";
@@ -437,11 +542,17 @@ const char *lwtunnelencaptype(uint16_t type)
 	case LWTUNNEL_ENCAP_XFRM:
 		return "xfrm";
 	}
-	if( snprintf(s, sizeof(s), "%u", type) > 0 )
-		return s;
+	if( snprintf(buf, size, "%u", type) > 0 )
+		return buf;
 	return "";
 }
 
+const char * lwtunnelencaptype(uint16_t type)
+{
+	static __thread char buf[LWTUNNELENCAPTYPE_SIZE];
+	return lwtunnelencaptype_r(type, buf, sizeof(buf));
+}
+
 #define CASE_NLMSGTYPE(type) \
 	case type: return #type
 
@@ -980,23 +1091,505 @@ int TuneNetlinkSocket(netlink_ctx * ctx)
 	return 0;
 }
 
+static ssize_t SocketSend(netlink_ctx * ctx, const void * buf, size_t len)
+{
+	return send(ctx->netlink_socket, buf, len, 0);
+}
+
+static ssize_t SocketRecvmsg(netlink_ctx * ctx, struct msghdr * msg, int flags)
+{
+	return recvmsg(ctx->netlink_socket, msg, flags);
+}
+
+static int SocketRecvmmsg(netlink_ctx * ctx, struct mmsghdr * msgs, unsigned int vlen, int flags)
+{
+	return recvmmsg(ctx->netlink_socket, msgs, vlen, flags, 0);
+}
+
+static void SocketClose(netlink_ctx * ctx)
+{
+	if( ctx->netlink_socket >= 0  && close(ctx->netlink_socket) < 0 ) {
+		LOG_ERROR("close(ctx->netlink_socket) ... error (%s)\n", errorname(errno));	
+	}
+	ctx->netlink_socket = -1;
+}
+
+static const NetlinkTransport socket_transport = {
+	"socket",
+	SocketSend,
+	SocketRecvmsg,
+	SocketRecvmmsg,
+	SocketClose
+};
+
+// pcap with LINKTYPE_NETLINK, as written by tcpdump on nlmon device:
+// every packet starts with linux cooked header (SLL), fields are big endian
+#define PCAP_MAGIC 0xA1B2C3D4
+#define PCAP_MAGIC_NSEC 0xA1B23C4D
+#define PCAP_SNAPLEN 0x40000
+#define LINKTYPE_NETLINK 253
+#define SLL_HEADER_SIZE 16
+#define SLL_PACKET_OUTGOING 4
+#define NLMON_PACKET_USER 6	// sent to user socket (kernel replies)
+#define NLMON_PACKET_KERNEL 7	// sent to kernel (requests)
+
+#ifndef ARPHRD_NETLINK
+#define ARPHRD_NETLINK 824
+#endif
+
+typedef struct {
+	uint32_t magic;
+	uint16_t version_major;
+	uint16_t version_minor;
+	int32_t thiszone;
+	uint32_t sigfigs;
+	uint32_t snaplen;
+	uint32_t network;
+} PcapHeader;
+
+typedef struct {
+	uint32_t ts_sec;
+	uint32_t ts_usec;
+	uint32_t incl_len;
+	uint32_t orig_len;
+} PcapPacketHeader;
+
+// process wide trace of all rtnetlink sockets, see TraceNetlink()
+#define TRACE_BUFFER_SIZE (256 * 1024)
+
+static struct {
+	pthread_mutex_t lock;
+	FILE * file;
+	char * buffer;
+} trace = { PTHREAD_MUTEX_INITIALIZER, 0, 0 };
+
+// port id of socket is kept as SLL address, nlmon leaves it empty
+static void RecordPacket(FILE * file, const void * data, size_t len, uint16_t pkttype, uint32_t portid)
+{
+	unsigned char sll[SLL_HEADER_SIZE] = {0};
+	PcapPacketHeader ph;
+	struct timeval tv;
+
+	gettimeofday(&tv, 0);
+	ph.ts_sec = (uint32_t)tv.tv_sec;
+	ph.ts_usec = (uint32_t)tv.tv_usec;
+	ph.incl_len = ph.orig_len = (uint32_t)(len + SLL_HEADER_SIZE);
+
+	sll[1] = (unsigned char)pkttype;
+	sll[2] = (unsigned char)(ARPHRD_NETLINK >> 8);
+	sll[3] = (unsigned char)(ARPHRD_NETLINK & 0xFF);
+	if( portid ) {
+		sll[5] = sizeof(portid);
+		sll[6] = (unsigned char)(portid >> 24);
+		sll[7] = (unsigned char)(portid >> 16);
+		sll[8] = (unsigned char)(portid >> 8);
+		sll[9] = (unsigned char)portid;
+	}
+	sll[15] = NETLINK_ROUTE;
+
+	if( fwrite(&ph, sizeof(ph), 1, file) != 1 ||
+	    fwrite(sll, sizeof(sll), 1, file) != 1 ||
+	    fwrite(data, len, 1, file) != 1 )
+		LOG_ERROR("can`t record %u bytes ... error (%s)\n", len, errorname(errno));
+}
+
+int RecordNetlink(void * nl, const char * path)
+{
+	netlink_ctx * ctx = (netlink_ctx *)nl;
+	PcapHeader hdr = { PCAP_MAGIC, 2, 4, 0, 0, PCAP_SNAPLEN, LINKTYPE_NETLINK };
+
+	assert( ctx != 0 );
+
+	if( ctx->record ) {
+		fclose(ctx->record);
+		ctx->record = 0;
+	}
+
+	if( !path )
+		return TRUE;
+
+	ctx->record = fopen(path, "wb");
+	if( !ctx->record ) {
+		LOG_ERROR("fopen(\"%s\") ... error (%s)\n", path, errorname(errno));
+		return FALSE;
+	}
+
+	if( fwrite(&hdr, sizeof(hdr), 1, ctx->record) != 1 ) {
+		LOG_ERROR("fwrite(\"%s\") ... error (%s)\n", path, errorname(errno));
+		fclose(ctx->record);
+		ctx->record = 0;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+int TraceNetlink(const char * path)
+{
+	PcapHeader hdr = { PCAP_MAGIC, 2, 4, 0, 0, PCAP_SNAPLEN, LINKTYPE_NETLINK };
+	FILE * file = 0;
+	char * buffer = 0;
+	int res = TRUE;
+
+	if( path ) {
+		file = fopen(path, "wb");
+		buffer = (char *)malloc(TRACE_BUFFER_SIZE);
+		if( !file || !buffer ) {
+			LOG_ERROR("can`t open trace \"%s\" ... error (%s)\n", path, errorname(errno));
+			res = FALSE;
+		} else {
+			// datagram is copied to buffer, file is written when it is full
+			setvbuf(file, buffer, _IOFBF, TRACE_BUFFER_SIZE);
+			if( fwrite(&hdr, sizeof(hdr), 1, file) != 1 ) {
+				LOG_ERROR("fwrite(\"%s\") ... error (%s)\n", path, errorname(errno));
+				res = FALSE;
+			}
+		}
+		if( !res ) {
+			if( file )
+				fclose(file);
+			free(buffer);
+			file = 0;
+			buffer = 0;
+		}
+	}
+
+	pthread_mutex_lock(&trace.lock);
+	if( trace.file ) {
+		fclose(trace.file);
+		free(trace.buffer);
+	}
+	__atomic_store_n(&trace.file, file, __ATOMIC_RELEASE);
+	trace.buffer = buffer;
+	pthread_mutex_unlock(&trace.lock);
+	return res;
+}
+
+static void TracePacket(netlink_ctx * ctx, const void * data, size_t len, uint16_t pkttype)
+{
+	// replayed datagrams are already in capture
+	if( ctx->replay )
+		return;
+
+	pthread_mutex_lock(&trace.lock);
+	if( trace.file )
+		RecordPacket(trace.file, data, len, pkttype, ctx->sa.nl_pid);
+	pthread_mutex_unlock(&trace.lock);
+}
+
+static ssize_t NetlinkSend(netlink_ctx * ctx, const void * buf, size_t len)
+{
+	ssize_t res = ctx->transport->send(ctx, buf, len);
+	if( res > 0 && ctx->record )
+		RecordPacket(ctx->record, buf, (size_t)res, NLMON_PACKET_KERNEL, ctx->sa.nl_pid);
+	if( res > 0 && __atomic_load_n(&trace.file, __ATOMIC_ACQUIRE) )
+		TracePacket(ctx, buf, (size_t)res, NLMON_PACKET_KERNEL);
+	return res;
+}
+
+static NetlinkStats netlink_stats;
+
+static ssize_t NetlinkRecvmsg(netlink_ctx * ctx, struct msghdr * msg, int flags)
+{
+	ssize_t res = ctx->transport->recvmsg(ctx, msg, flags);
+	size_t len = (size_t)res < msg->msg_iov->iov_len ? (size_t)res:msg->msg_iov->iov_len;
+
+	__atomic_add_fetch(&netlink_stats.recvs, 1, __ATOMIC_RELAXED);
+	if( res <= 0 || (flags & MSG_PEEK) )
+		return res;
+
+	__atomic_add_fetch(&netlink_stats.datagrams, 1, __ATOMIC_RELAXED);
+
+	if( ctx->record )
+		RecordPacket(ctx->record, msg->msg_iov->iov_base, len, NLMON_PACKET_USER, ctx->sa.nl_pid);
+	if( __atomic_load_n(&trace.file, __ATOMIC_ACQUIRE) )
+		TracePacket(ctx, msg->msg_iov->iov_base, len, NLMON_PACKET_USER);
+	return res;
+}
+
+// NetlinkRecvmsg() for several datagrams, transport without recvmmsg() gives one
+static int NetlinkRecvmmsg(netlink_ctx * ctx, struct mmsghdr * msgs, unsigned int vlen, int flags)
+{
+	int res, i;
+
+	if( !ctx->transport->recvmmsg ) {
+		ssize_t len = NetlinkRecvmsg(ctx, &msgs[0].msg_hdr, flags);
+		if( len < 0 )
+			return -1;
+		msgs[0].msg_len = (unsigned int)len;
+		return 1;
+	}
+
+	res = ctx->transport->recvmmsg(ctx, msgs, vlen, flags);
+	__atomic_add_fetch(&netlink_stats.recvs, 1, __ATOMIC_RELAXED);
+	if( res <= 0 )
+		return res;
+
+	__atomic_add_fetch(&netlink_stats.datagrams, res, __ATOMIC_RELAXED);
+	for( i = 0; i < res; i++ ) {
+		size_t len = msgs[i].msg_len < msgs[i].msg_hdr.msg_iov->iov_len ? msgs[i].msg_len:msgs[i].msg_hdr.msg_iov->iov_len;
+		if( ctx->record )
+			RecordPacket(ctx->record, msgs[i].msg_hdr.msg_iov->iov_base, len, NLMON_PACKET_USER, ctx->sa.nl_pid);
+		if( __atomic_load_n(&trace.file, __ATOMIC_ACQUIRE) )
+			TracePacket(ctx, msgs[i].msg_hdr.msg_iov->iov_base, len, NLMON_PACKET_USER);
+	}
+	return res;
+}
+
+typedef struct {
+	const char * data;
+	uint32_t len;
+	int request;
+	// for decoder
+	uint32_t ts_sec;
+	uint32_t ts_frac;
+	uint32_t portid;
+} ReplayPacket;
+
+typedef struct NetlinkReplay {
+	char * file;
+	ReplayPacket * packets;
+	size_t count;
+	size_t requests;
+	// next datagram of the current dump, count if there is no one
+	size_t current;
+	// requests are searched from here, so repeated ones go through the capture
+	size_t next;
+	// delivered datagrams and bytes
+	uint64_t datagrams;
+	uint64_t bytes;
+	// ts_frac is in nanoseconds
+	int nsec;
+} NetlinkReplay;
+
+static uint32_t PcapUint32(uint32_t value, int swap)
+{
+	return swap ? __builtin_bswap32(value):value;
+}
+
+static NetlinkReplay * LoadReplay(const char * path)
+{
+	NetlinkReplay * rp = (NetlinkReplay *)calloc(1, sizeof(NetlinkReplay));
+	FILE * file = fopen(path, "rb");
+	size_t size = 0, offset, max = 0;
+	PcapHeader hdr;
+	int swap;
+
+	if( !rp || !file ) {
+		LOG_ERROR("can`t open \"%s\" ... error (%s)\n", path, errorname(errno));
+		goto error;
+	}
+
+	if( fseek(file, 0, SEEK_END) < 0 || (long)(size = (size_t)ftell(file)) < 0 || fseek(file, 0, SEEK_SET) < 0 ) {
+		LOG_ERROR("can`t get size of \"%s\" ... error (%s)\n", path, errorname(errno));
+		goto error;
+	}
+
+	rp->file = (char *)malloc(size);
+	if( size < sizeof(PcapHeader) || !rp->file || fread(rp->file, size, 1, file) != 1 ) {
+		LOG_ERROR("can`t read %u bytes from \"%s\" ... error (%s)\n", size, path, errorname(errno));
+		goto error;
+	}
+
+	memmove(&hdr, rp->file, sizeof(hdr));
+	swap = hdr.magic != PCAP_MAGIC && hdr.magic != PCAP_MAGIC_NSEC;
+	if( swap && __builtin_bswap32(hdr.magic) != PCAP_MAGIC && __builtin_bswap32(hdr.magic) != PCAP_MAGIC_NSEC ) {
+		LOG_ERROR("\"%s\" is not pcap file (magic 0x%08X)\n", path, hdr.magic);
+		goto error;
+	}
+	if( PcapUint32(hdr.network, swap) != LINKTYPE_NETLINK ) {
+		LOG_ERROR("\"%s\" has link type %u, LINKTYPE_NETLINK is expected\n", path, PcapUint32(hdr.network, swap));
+		goto error;
+	}
+	rp->nsec = PcapUint32(hdr.magic, swap) == PCAP_MAGIC_NSEC;
+
+	for( offset = sizeof(PcapHeader); offset + sizeof(PcapPacketHeader) <= size; ) {
+		PcapPacketHeader ph;
+		uint32_t len;
+		const unsigned char * sll = (const unsigned char *)rp->file + offset + sizeof(PcapPacketHeader);
+
+		memmove(&ph, rp->file + offset, sizeof(ph));
+		len = PcapUint32(ph.incl_len, swap);
+		if( offset + sizeof(PcapPacketHeader) + len > size ) {
+			LOG_WARN("\"%s\" is truncated at %u\n", path, offset);
+			break;
+		}
+		offset += sizeof(PcapPacketHeader) + len;
+
+		// only complete rtnetlink datagrams
+		if( len < SLL_HEADER_SIZE + sizeof(struct nlmsghdr) || len != PcapUint32(ph.orig_len, swap) ||
+		    sll[14] != 0 || sll[15] != NETLINK_ROUTE )
+			continue;
+
+		if( rp->count == max ) {
+			ReplayPacket * packets = (ReplayPacket *)realloc(rp->packets, (max = max ? max*2:1024) * sizeof(ReplayPacket));
+			if( !packets ) {
+				LOG_ERROR("realloc(%u) ... error (%s)\n", max * sizeof(ReplayPacket), errorname(errno));
+				goto error;
+			}
+			rp->packets = packets;
+		}
+
+		rp->packets[rp->count].data = (const char *)sll + SLL_HEADER_SIZE;
+		rp->packets[rp->count].len = len - SLL_HEADER_SIZE;
+		rp->packets[rp->count].request = sll[1] == NLMON_PACKET_KERNEL || sll[1] == SLL_PACKET_OUTGOING;
+		rp->packets[rp->count].ts_sec = PcapUint32(ph.ts_sec, swap);
+		rp->packets[rp->count].ts_frac = PcapUint32(ph.ts_usec, swap);
+		rp->packets[rp->count].portid = sll[5] == sizeof(uint32_t) ?
+			((uint32_t)sll[6] << 24) | ((uint32_t)sll[7] << 16) | ((uint32_t)sll[8] << 8) | sll[9]:0;
+		rp->requests += rp->packets[rp->count].request;
+		rp->count++;
+	}
+
+	LOG_INFO("\"%s\": %u datagrams\n", path, rp->count);
+	rp->current = rp->count;
+	fclose(file);
+	return rp;
+
+error:
+	if( file )
+		fclose(file);
+	if( rp ) {
+		free(rp->packets);
+		free(rp->file);
+		free(rp);
+	}
+	return 0;
+}
+
+// datagram after request, after previous dump or the first one in capture
+static int ReplayDumpStart(NetlinkReplay * rp, size_t index)
+{
+	const ReplayPacket * prev;
+	const struct nlmsghdr * nlh;
+	int len;
+
+	if( !index || rp->packets[index-1].request )
+		return TRUE;
+
+	prev = &rp->packets[index-1];
+	nlh = (const struct nlmsghdr *)prev->data;
+	len = (int)prev->len;
+	for( ; NLMSG_OK(nlh, (unsigned int)len); nlh = NLMSG_NEXT(nlh, len) )
+		if( nlh->nlmsg_type == NLMSG_DONE || nlh->nlmsg_type == NLMSG_ERROR )
+			return TRUE;
+	return FALSE;
+}
+
+static ssize_t ReplaySend(netlink_ctx * ctx, const void * buf, size_t len)
+{
+	NetlinkReplay * rp = ctx->replay;
+	const struct nlmsghdr * req = (const struct nlmsghdr *)buf;
+	size_t i, index;
+
+	assert( len >= sizeof(struct nlmsghdr) );
+
+	// recorded request with the same type and payload, sequence numbers and ports are ignored
+	for( i = 0; i < rp->count; i++ ) {
+		const ReplayPacket * p = &rp->packets[index = (rp->next + i) % rp->count];
+		const struct nlmsghdr * nlh = (const struct nlmsghdr *)p->data;
+		if( p->request && p->len == len && nlh->nlmsg_type == req->nlmsg_type &&
+		    !memcmp(NLMSG_DATA(nlh), NLMSG_DATA(req), len - NLMSG_HDRLEN) ) {
+			rp->current = rp->next = index + 1;
+			return (ssize_t)len;
+		}
+	}
+
+	// capture without requests, rtnetlink RTM_GETx is answered with RTM_NEWx
+	for( i = 0; !rp->requests && i < rp->count; i++ ) {
+		const ReplayPacket * p = &rp->packets[index = (rp->next + i) % rp->count];
+		const struct nlmsghdr * nlh = (const struct nlmsghdr *)p->data;
+		if( !p->request && nlh->nlmsg_type + 2 == req->nlmsg_type && ReplayDumpStart(rp, index) ) {
+			rp->current = index;
+			rp->next = index + 1;
+			return (ssize_t)len;
+		}
+	}
+
+	LOG_ERROR("request %u (%s) is not recorded\n", req->nlmsg_type, nlmsgtype(req->nlmsg_type));
+	rp->current = rp->count;
+	errno = ENOENT;
+	return -1;
+}
+
+static ssize_t ReplayRecvmsg(netlink_ctx * ctx, struct msghdr * msg, int flags)
+{
+	NetlinkReplay * rp = ctx->replay;
+	const ReplayPacket * p;
+	struct nlmsghdr * nlh;
+	size_t size;
+	int len;
+
+	assert( msg->msg_iovlen == 1 );
+
+	if( rp->current >= rp->count || rp->packets[rp->current].request ) {
+		// there is no notifications in capture, dump is over
+		errno = (flags & MSG_DONTWAIT) ? EAGAIN:ENODATA;
+		return -1;
+	}
+
+	p = &rp->packets[rp->current];
+	size = p->len < msg->msg_iov->iov_len ? p->len:msg->msg_iov->iov_len;
+	memmove(msg->msg_iov->iov_base, p->data, size);
+
+	// looks like reply to our request
+	nlh = (struct nlmsghdr *)msg->msg_iov->iov_base;
+	len = (int)size;
+	for( ; NLMSG_OK(nlh, (unsigned int)len); nlh = NLMSG_NEXT(nlh, len) ) {
+		nlh->nlmsg_seq = ctx->sequence_number;
+		nlh->nlmsg_pid = ctx->sa.nl_pid;
+	}
+
+	if( msg->msg_name && msg->msg_namelen >= sizeof(struct sockaddr_nl) ) {
+		memset(msg->msg_name, 0, sizeof(struct sockaddr_nl));
+		((struct sockaddr_nl *)msg->msg_name)->nl_family = AF_NETLINK;
+		msg->msg_namelen = sizeof(struct sockaddr_nl);
+	}
+	msg->msg_flags = size < p->len ? MSG_TRUNC:0;
+
+	if( !(flags & MSG_PEEK) ) {
+		rp->current++;
+		rp->datagrams++;
+		rp->bytes += p->len;
+	}
+	return (ssize_t)((flags & MSG_TRUNC) ? p->len:size);
+}
+
+static void ReplayClose(netlink_ctx * ctx)
+{
+	if( ctx->replay ) {
+		free(ctx->replay->packets);
+		free(ctx->replay->file);
+		free(ctx->replay);
+		ctx->replay = 0;
+	}
+}
+
+static const NetlinkTransport replay_transport = {
+	"replay",
+	ReplaySend,
+	ReplayRecvmsg,
+	0,
+	ReplayClose
+};
+
 void CloseNetlink(void * nl)
 {
 	netlink_ctx * ctx = (netlink_ctx *)nl;
 
 	assert( ctx != 0 );
-	assert( ctx->netlink_socket >= 0 );
+	assert( ctx->transport != 0 );
 
 	free(ctx->info.ptr);
+	free(ctx->offsets);
 	free(ctx->buf);
+	free(ctx->batch);
 
-	if( ctx->netlink_socket >= 0  && close(ctx->netlink_socket) < 0 ) {
-		LOG_ERROR("close(ctx->netlink_socket) ... error (%s)\n", errorname(errno));	
-	}
+	RecordNetlink(ctx, 0);
+	ctx->transport->close(ctx);
 	free(nl);
 }
 
-void * OpenNetlink(void)
+static void * OpenNetlinkSocket(uint32_t groups)
 {
 	netlink_ctx * ctx = (netlink_ctx *)malloc(sizeof(netlink_ctx));
 	socklen_t socket_size = sizeof(ctx->sa);
@@ -1007,6 +1600,8 @@ void * OpenNetlink(void)
 	}
 
 	memset(ctx, 0, sizeof(netlink_ctx));
+	ctx->netlink_socket = -1;
+	ctx->transport = &socket_transport;
 
 	do {
 		// NETLINK_ROUTE — получать уведомления об изменениях таблицы маршрутизации и сетевых интерфейсов.
@@ -1042,7 +1637,7 @@ void * OpenNetlink(void)
 					// that the process subsequently creates
 					// pthread_self() << 16 | getpid();
 
-		ctx->sa.nl_groups = 0;	// When bind is called on the socket, the nl_groups
+		ctx->sa.nl_groups = groups;	// When bind is called on the socket, the nl_groups
 					// field in the sockaddr_nl should be set to a bit mask of the
 					// groups which it wishes to listen to.
 					// default value for this field is zero which means that no 
@@ -1093,6 +1688,20 @@ void * OpenNetlink(void)
 			break;
 		}
 		
+		// RTNLGRP_IPV6_RULE has no legacy RTMGRP_* bitmask for nl_groups,
+		// it is joined by NETLINK_ADD_MEMBERSHIP together with IPv4 rules
+		if( (groups & RTMGRP_IPV4_RULE) ) {
+			int group = RTNLGRP_IPV6_RULE;
+			if( setsockopt(ctx->netlink_socket, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &group, sizeof(group)) < 0 )
+				LOG_WARN("setsockopt(SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, RTNLGRP_IPV6_RULE) ... warn (%s)\n", errorname(errno));
+		}
+
+		// notifications are read without blocking
+		if( groups && fcntl(ctx->netlink_socket, F_SETFL, fcntl(ctx->netlink_socket, F_GETFL, 0) | O_NONBLOCK) < 0 ) {
+			LOG_ERROR("fcntl(netlink_socket, O_NONBLOCK) ... error (%s)\n", errorname(errno));
+			break;
+		}
+
 		ctx->buf = (char *)malloc(ctx->sndbufsize > ctx->rcvbufsize ? ctx->sndbufsize:ctx->rcvbufsize);
 		memset(ctx->buf, 0, ctx->sndbufsize > ctx->rcvbufsize ? ctx->sndbufsize:ctx->rcvbufsize);
 
@@ -1106,75 +1715,248 @@ void * OpenNetlink(void)
 	return ctx;
 }
 
-static int EnumMsg(netlink_ctx * ctx, int (* fn)(netlink_ctx * ctx, struct nlmsghdr * nlh))
+static uint64_t NetlinkNow(void)
 {
-	struct nlmsghdr * nlh = (struct nlmsghdr *)(ctx->buf+ctx->offset);
-	int res = FALSE, rcvsize = (int)ctx->rcvsize;
-
-	assert( rcvsize > 0 && (size_t)rcvsize <= (ctx->rcvbufsize-ctx->offset) );
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
 
-	LOG_INFO("nlh->nlmsg_type: %d (%s)\n", nlh->nlmsg_type, nlmsgtype(nlh->nlmsg_type));
+void * OpenNetlink(void)
+{
+	uint64_t start = NetlinkNow();
+	void * nl = OpenNetlinkSocket(0);
 
-	for(	; (rcvsize >= 0 && NLMSG_OK(nlh, (unsigned int)rcvsize));
-		nlh = NLMSG_NEXT(nlh, rcvsize) ) {
+	if( nl ) {
+		__atomic_add_fetch(&netlink_stats.opened, 1, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&netlink_stats.open_ns, NetlinkNow() - start, __ATOMIC_RELAXED);
+	}
+	return nl;
+}
 
-		res = FALSE;
+// shared request socket, see OpenNetlinkSession()
+static struct {
+	pthread_mutex_t lock;
+	netlink_ctx * ctx;
+	unsigned int refs;
+	int busy;
+} session = { PTHREAD_MUTEX_INITIALIZER, 0, 0, FALSE };
 
-		// skip not our message
-		if( nlh->nlmsg_pid && nlh->nlmsg_pid != ctx->sa.nl_pid ) {
-			LOG_WARN("ports are diffrent (nlmsg_pid %d != sa.nl_pid %d)\n", nlh->nlmsg_pid, ctx->sa.nl_pid);
-			errno = ESRCH;
-			continue;
-		}
-		if( nlh->nlmsg_seq != ctx->sequence_number ) {
-			LOG_WARN("sequence_number are diffrent (nlmsg_seq %d != sequence_number %d)\n", nlh->nlmsg_seq, ctx->sequence_number);
-			errno = EPROTO;
-			continue;
-		}
-		if( nlh->nlmsg_flags & NLM_F_DUMP_INTR ) {
-			LOG_ERROR("receive data was interrupted\n");
-			errno = EINTR;
-			break;
-		}
+int OpenNetlinkSession(void)
+{
+	netlink_ctx * ctx = 0;
+	int res = TRUE;
 
-		if( nlh->nlmsg_type >= NLMSG_MIN_TYPE ) {
-			res = fn(ctx, nlh);
-			if( !res )
-				break;
-		} else {
-			const struct nlmsgerr *err = (const struct nlmsgerr *)NLMSG_DATA(nlh);
-			switch(nlh->nlmsg_type) {
-			case NLMSG_ERROR:
-				LOG_ERROR("NLMSG_ERROR (Error) %u\n", err->error);
-				break;
-			case NLMSG_DONE:
-				LOG_INFO("NLMSG_DONE (End of a dump) %u\n", err->error);
-				break;
-			case NLMSG_NOOP:
-				LOG_INFO("NLMSG_NOOP (Nothing) %u\n", err->error);
-				res = TRUE;
-				break;
-			case NLMSG_OVERRUN:
-				LOG_INFO("NLMSG_OVERRUN (Data lost) %u\n", err->error);
-				break;
-			}
-			break;
-		}
-	}
+	pthread_mutex_lock(&session.lock);
+	if( !session.refs++ && !session.ctx )
+		ctx = session.ctx = (netlink_ctx *)OpenNetlink();
+	res = session.ctx != 0;
+	pthread_mutex_unlock(&session.lock);
 
+	if( ctx )
+		LOG_INFO("session socket nl_pid %u\n", ctx->sa.nl_pid);
 	return res;
 }
 
-static int IncrementTotalMsg(netlink_ctx * ctx, struct nlmsghdr * nlh)
+void CloseNetlinkSession(void)
 {
-	ctx->totalmsg++;
-	return TRUE;
+	netlink_ctx * ctx = 0;
+
+	pthread_mutex_lock(&session.lock);
+	assert( session.refs > 0 );
+	if( !--session.refs && !session.busy ) {
+		ctx = session.ctx;
+		session.ctx = 0;
+	}
+	pthread_mutex_unlock(&session.lock);
+
+	if( ctx )
+		CloseNetlink(ctx);
 }
 
-const char * rttype(unsigned char rtm_type)
+void * AcquireNetlink(void)
 {
-	const char * rtm_type_name[] = {
-		"unspec",        // "RTN_UNSPEC",                                                    
+	netlink_ctx * ctx = 0;
+	int reopen = FALSE;
+
+	__atomic_add_fetch(&netlink_stats.acquired, 1, __ATOMIC_RELAXED);
+
+	pthread_mutex_lock(&session.lock);
+	if( session.refs && !session.busy ) {
+		if( !session.ctx ) {
+			// dropped after interrupted dump
+			session.ctx = (netlink_ctx *)OpenNetlink();
+			reopen = TRUE;
+		}
+		if( (ctx = session.ctx) != 0 )
+			session.busy = TRUE;
+	}
+	pthread_mutex_unlock(&session.lock);
+
+	if( !ctx )
+		return OpenNetlink();
+
+	if( !reopen )
+		__atomic_add_fetch(&netlink_stats.reused, 1, __ATOMIC_RELAXED);
+
+	ctx->dump_intr = FALSE;
+	ctx->batch_used = 0;
+	ctx->batch_last = 0;
+	ctx->batch_count = 0;
+	return ctx;
+}
+
+void ReleaseNetlink(void * nl)
+{
+	netlink_ctx * ctx = (netlink_ctx *)nl;
+	char byte;
+	int drop;
+
+	pthread_mutex_lock(&session.lock);
+	if( ctx != session.ctx ) {
+		pthread_mutex_unlock(&session.lock);
+		CloseNetlink(ctx);
+		return;
+	}
+
+	// rest of interrupted or failed dump would be read as reply to next request
+	drop = !session.refs || ctx->dump_intr ||
+		recv(ctx->netlink_socket, &byte, sizeof(byte), MSG_PEEK | MSG_DONTWAIT) >= 0;
+	if( drop )
+		session.ctx = 0;
+	session.busy = FALSE;
+	pthread_mutex_unlock(&session.lock);
+
+	if( drop )
+		CloseNetlink(ctx);
+}
+
+void GetNetlinkStats(NetlinkStats * stats)
+{
+	stats->opened = __atomic_load_n(&netlink_stats.opened, __ATOMIC_RELAXED);
+	stats->open_ns = __atomic_load_n(&netlink_stats.open_ns, __ATOMIC_RELAXED);
+	stats->acquired = __atomic_load_n(&netlink_stats.acquired, __ATOMIC_RELAXED);
+	stats->reused = __atomic_load_n(&netlink_stats.reused, __ATOMIC_RELAXED);
+	stats->dumps = __atomic_load_n(&netlink_stats.dumps, __ATOMIC_RELAXED);
+	stats->dump_ns = __atomic_load_n(&netlink_stats.dump_ns, __ATOMIC_RELAXED);
+	stats->recvs = __atomic_load_n(&netlink_stats.recvs, __ATOMIC_RELAXED);
+	stats->datagrams = __atomic_load_n(&netlink_stats.datagrams, __ATOMIC_RELAXED);
+}
+
+void * OpenNetlinkReplay(const char * path)
+{
+	netlink_ctx * ctx = (netlink_ctx *)malloc(sizeof(netlink_ctx));
+
+	if( !ctx ) {
+		LOG_ERROR("malloc(%u) ... error (%s)\n", sizeof(netlink_ctx), errorname(errno));
+		return 0;
+	}
+
+	memset(ctx, 0, sizeof(netlink_ctx));
+	ctx->netlink_socket = -1;
+	ctx->transport = &replay_transport;
+	ctx->sndbufsize = NETLINK_SEND_BUFFER_SIZE;
+	ctx->rcvbufsize = NETLINK_RECV_BUFFER_SIZE;
+	ctx->sa.nl_family = AF_NETLINK;
+	ctx->sa.nl_pid = getpid();
+
+	ctx->replay = LoadReplay(path);
+	if( ctx->replay )
+		ctx->buf = (char *)calloc(1, ctx->sndbufsize > ctx->rcvbufsize ? ctx->sndbufsize:ctx->rcvbufsize);
+
+	if( !ctx->buf ) {
+		CloseNetlink(ctx);
+		ctx = 0;
+	}
+	return ctx;
+}
+
+void * OpenNetlinkMonitor(uint32_t groups)
+{
+	assert( groups != 0 );
+	return OpenNetlinkSocket(groups);
+}
+
+int DumpInterrupted(void * nl)
+{
+	netlink_ctx * ctx = (netlink_ctx *)nl;
+	return ctx->dump_intr;
+}
+
+static int EnumMsg(netlink_ctx * ctx, int (* fn)(netlink_ctx * ctx, struct nlmsghdr * nlh))
+{
+	struct nlmsghdr * nlh = (struct nlmsghdr *)(ctx->buf+ctx->offset);
+	int res = FALSE, rcvsize = (int)ctx->rcvsize;
+
+	assert( rcvsize > 0 && (size_t)rcvsize <= (ctx->rcvbufsize-ctx->offset) );
+
+	LOG_TRACE("nlh->nlmsg_type: %d (%s)\n", nlh->nlmsg_type, nlmsgtype(nlh->nlmsg_type));
+
+	for(	; (rcvsize >= 0 && NLMSG_OK(nlh, (unsigned int)rcvsize));
+		nlh = NLMSG_NEXT(nlh, rcvsize) ) {
+
+		res = FALSE;
+
+		// skip not our message
+		if( nlh->nlmsg_pid && nlh->nlmsg_pid != ctx->sa.nl_pid ) {
+			LOG_WARN("ports are diffrent (nlmsg_pid %d != sa.nl_pid %d)\n", nlh->nlmsg_pid, ctx->sa.nl_pid);
+			errno = ESRCH;
+			continue;
+		}
+		if( nlh->nlmsg_seq != ctx->sequence_number ) {
+			LOG_WARN("sequence_number are diffrent (nlmsg_seq %d != sequence_number %d)\n", nlh->nlmsg_seq, ctx->sequence_number);
+			errno = EPROTO;
+			continue;
+		}
+		if( nlh->nlmsg_flags & NLM_F_DUMP_INTR ) {
+			LOG_ERROR("receive data was interrupted\n");
+			ctx->dump_intr = TRUE;
+			errno = EINTR;
+			break;
+		}
+
+		if( nlh->nlmsg_type >= NLMSG_MIN_TYPE ) {
+			res = fn(ctx, nlh);
+			if( !res )
+				break;
+		} else {
+			const struct nlmsgerr *err = (const struct nlmsgerr *)NLMSG_DATA(nlh);
+			switch(nlh->nlmsg_type) {
+			case NLMSG_ERROR:
+				LOG_ERROR("NLMSG_ERROR (Error) %u\n", err->error);
+				errno = err->error ? -err->error:EPROTO;
+				break;
+			case NLMSG_DONE:
+				LOG_TRACE("NLMSG_DONE (End of a dump) %u\n", err->error);
+				// may be in the same datagram with the last records
+				ctx->dump_done = TRUE;
+				res = TRUE;
+				break;
+			case NLMSG_NOOP:
+				LOG_TRACE("NLMSG_NOOP (Nothing) %u\n", err->error);
+				res = TRUE;
+				break;
+			case NLMSG_OVERRUN:
+				LOG_TRACE("NLMSG_OVERRUN (Data lost) %u\n", err->error);
+				break;
+			}
+			break;
+		}
+	}
+
+	return res;
+}
+
+static int IncrementTotalMsg(netlink_ctx * ctx, struct nlmsghdr * nlh)
+{
+	ctx->totalmsg++;
+	return TRUE;
+}
+
+const char * rttype(unsigned char rtm_type)
+{
+	const char * rtm_type_name[] = {
+		"unspec",        // "RTN_UNSPEC",                                                    
 		"unicast", 	 // "RTN_UNICAST (Gateway or direct route)",                         			
 		"local", 	 // "RTN_LOCAL (Accept locally)",                                    			
 		"broadcast",     // "RTN_BROADCAST (Accept locally as broadcast, send as broadcast)",
@@ -1216,7 +1998,7 @@ int FillAttr(struct rtattr *rta, struct rtattr **tb, unsigned short max, unsigne
 	memset(tb, 0, sizeof(struct rtattr *) * (max + 1));
 	while( RTA_OK(rta, len) ) {
 		unsigned short type = rta->rta_type & flagsmask;
-		LOG_INFO("%p: type: %s (%u) size %u\n", rta, typeprint ? typeprint(type):"", type, rta->rta_len);
+		LOG_TRACE("%p: type: %s (%u) size %u\n", rta, typeprint ? typeprint(type):"", type, rta->rta_len);
 		if( type <= max && !tb[type] )
 			tb[type] = rta;
 		rta = RTA_NEXT(rta, len);
@@ -1290,19 +2072,19 @@ static int FillIp(uint8_t family, Encap * enc, struct rtattr * rta)
 	if( ip[LWTUNNEL_IP_ID] && RTA_PAYLOAD(ip[LWTUNNEL_IP_ID]) >= sizeof(uint64_t) ) {
 		enc->data.ip.id = ntohll(RTA_UINT64_T(ip[LWTUNNEL_IP_ID]));
 		enc->data.ip.valid.id = 1;
-		LOG_INFO("LWTUNNEL_IP_ID:  " LLFMT "\n", enc->data.ip.id);
+		LOG_TRACE("LWTUNNEL_IP_ID:  " LLFMT "\n", enc->data.ip.id);
 	}
 
 	if( ip[LWTUNNEL_IP_DST] && RTA_PAYLOAD(ip[LWTUNNEL_IP_DST]) >= addrlen ) {
 		if( inet_ntop(family, RTA_DATA(ip[LWTUNNEL_IP_DST]), enc->data.ip.dst, sizeof(enc->data.ip.dst)) )
 			enc->data.ip.valid.dst = 1;
-		LOG_INFO("LWTUNNEL_IP_DST:  %s\n", enc->data.ip.dst);
+		LOG_TRACE("LWTUNNEL_IP_DST:  %s\n", enc->data.ip.dst);
 	}
 
 	if( ip[LWTUNNEL_IP_SRC] && RTA_PAYLOAD(ip[LWTUNNEL_IP_SRC]) >= addrlen ) {
 		if( inet_ntop(family, RTA_DATA(ip[LWTUNNEL_IP_DST]), enc->data.ip.src, sizeof(enc->data.ip.src)) )
 			enc->data.ip.valid.src = 1;
-		LOG_INFO("LWTUNNEL_IP_SRC:  %s\n", enc->data.ip.src);
+		LOG_TRACE("LWTUNNEL_IP_SRC:  %s\n", enc->data.ip.src);
 	}
 
 	//static_assert( (int)LWTUNNEL_IP6_HOPLIMIT == (int)LWTUNNEL_IP_TTL, "unsupported LWTUNNEL_IP6_HOPLIMIT" );
@@ -1311,11 +2093,11 @@ static int FillIp(uint8_t family, Encap * enc, struct rtattr * rta)
 		if( family == AF_INET6 ) {
 			enc->data.ip.hoplimit = RTA_UINT8_T(ip[LWTUNNEL_IP6_HOPLIMIT]);
 			enc->data.ip.valid.hoplimit = 1;
-			LOG_INFO("LWTUNNEL_IP6_HOPLIMIT: %u\n", enc->data.ip.hoplimit);
+			LOG_TRACE("LWTUNNEL_IP6_HOPLIMIT: %u\n", enc->data.ip.hoplimit);
 		} else {
 			enc->data.ip.ttl = RTA_UINT8_T(ip[LWTUNNEL_IP_TTL]);
 			enc->data.ip.valid.ttl = 1;
-			LOG_INFO("LWTUNNEL_IP_TTL: %u\n", enc->data.ip.ttl);
+			LOG_TRACE("LWTUNNEL_IP_TTL: %u\n", enc->data.ip.ttl);
 		}
 	}
 
@@ -1324,18 +2106,19 @@ static int FillIp(uint8_t family, Encap * enc, struct rtattr * rta)
 		if( family == AF_INET6 ) {
 			enc->data.ip.tc = RTA_UINT8_T(ip[LWTUNNEL_IP6_TC]);
 			enc->data.ip.valid.tc = 1;
-			LOG_INFO("LWTUNNEL_IP6_TC: %u\n", enc->data.ip.tc);
+			LOG_TRACE("LWTUNNEL_IP6_TC: %u\n", enc->data.ip.tc);
 		} else {
 			enc->data.ip.tos = RTA_UINT8_T(ip[LWTUNNEL_IP_TOS]);
 			enc->data.ip.valid.tos = 1;
-			LOG_INFO("LWTUNNEL_IP_TOS: %u\n", enc->data.ip.tos);
+			LOG_TRACE("LWTUNNEL_IP_TOS: %u\n", enc->data.ip.tos);
 		}
 	}
 
 	if( ip[LWTUNNEL_IP_FLAGS] && RTA_PAYLOAD(ip[LWTUNNEL_IP_FLAGS]) >= sizeof(uint16_t) ) {
+		char flags[TUNNELFLAGSNAME_SIZE];
 		enc->data.ip.flags = RTA_UINT16_T(ip[LWTUNNEL_IP_FLAGS]);
 		enc->data.ip.valid.flags = 1;
-		LOG_INFO("LWTUNNEL_IP_FLAGS: 0x%04X (%s)\n", enc->data.ip.flags, tunnelflagsname(enc->data.ip.flags));
+		LOG_TRACE("LWTUNNEL_IP_FLAGS: 0x%04X (%s)\n", enc->data.ip.flags, tunnelflagsname_r(enc->data.ip.flags, flags, sizeof(flags)));
 	}
 
 	if( ip[LWTUNNEL_IP_OPTS] && RTA_PAYLOAD(ip[LWTUNNEL_IP_OPTS]) >= sizeof(uint32_t) ) {
@@ -1359,7 +2142,7 @@ static int FillIp(uint8_t family, Encap * enc, struct rtattr * rta)
 
 				while( RTA_OK(rta, rest) ) {
 					unsigned short type = rta->rta_type & (~NLA_F_NESTED);
-					LOG_INFO("%p: type: %s (%u) size %u\n", rta, iptunneloptsgenevetype(type), type, rta->rta_len);
+					LOG_TRACE("%p: type: %s (%u) size %u\n", rta, iptunneloptsgenevetype(type), type, rta->rta_len);
 					if( type <= LWTUNNEL_IP_OPT_GENEVE_MAX && !geneve[type] )
 						geneve[type] = rta;
 
@@ -1375,16 +2158,16 @@ static int FillIp(uint8_t family, Encap * enc, struct rtattr * rta)
 
 						if( RTA_PAYLOAD(geneve[LWTUNNEL_IP_OPT_GENEVE_CLASS]) >= sizeof(uint16_t) ) {
 							g->cls = ntohs(RTA_UINT16_T(geneve[LWTUNNEL_IP_OPT_GENEVE_CLASS]));
-							LOG_INFO("%d. LWTUNNEL_IP_OPT_GENEVE_CLASS: %u\n", total_geneves, g->cls);
+							LOG_TRACE("%d. LWTUNNEL_IP_OPT_GENEVE_CLASS: %u\n", total_geneves, g->cls);
 						}
 
 						if( RTA_PAYLOAD(geneve[LWTUNNEL_IP_OPT_GENEVE_TYPE]) >= sizeof(uint8_t) ) {
 							g->type = RTA_UINT8_T(geneve[LWTUNNEL_IP_OPT_GENEVE_TYPE]);
-							LOG_INFO("%d. LWTUNNEL_IP_OPT_GENEVE_TYPE: %u\n", total_geneves, g->type);
+							LOG_TRACE("%d. LWTUNNEL_IP_OPT_GENEVE_TYPE: %u\n", total_geneves, g->type);
 						}
 
 						memmove(g->data, RTA_DATA(geneve[LWTUNNEL_IP_OPT_GENEVE_DATA]), g->size);
-						LOG_INFO("%d. LWTUNNEL_IP_OPT_GENEVE_DATA: %02X%02X%02X\n", total_geneves, g->data[0], g->data[1], g->data[2]);
+						LOG_TRACE("%d. LWTUNNEL_IP_OPT_GENEVE_DATA: %02X%02X%02X\n", total_geneves, g->data[0], g->data[1], g->data[2]);
 
 						memset(geneve, 0, sizeof(geneve));
 						total_geneves++;
@@ -1393,7 +2176,7 @@ static int FillIp(uint8_t family, Encap * enc, struct rtattr * rta)
 					rta = RTA_NEXT(rta, rest);
 				}
 				genevetostring(total_geneves, geneve_opts, enc->data.ip.geneve_opts, sizeof(enc->data.ip.geneve_opts));
-				LOG_INFO("geneve_opts %s\n", enc->data.ip.geneve_opts);
+				LOG_TRACE("geneve_opts %s\n", enc->data.ip.geneve_opts);
 			}
 			if( opts[LWTUNNEL_IP_OPTS_VXLAN] ) {
 				struct rtattr * vxlan[LWTUNNEL_IP_OPT_VXLAN_MAX+1];
@@ -1407,7 +2190,7 @@ static int FillIp(uint8_t family, Encap * enc, struct rtattr * rta)
 					if( vxlan[LWTUNNEL_IP_OPT_VXLAN_GBP] && RTA_PAYLOAD(vxlan[LWTUNNEL_IP_OPT_VXLAN_GBP]) >= sizeof(uint32_t) ) {
 						enc->data.ip.valid.vxlan_gbp = 1;
 						enc->data.ip.vxlan_gbp = RTA_UINT32_T(vxlan[LWTUNNEL_IP_OPT_VXLAN_GBP]);
-						LOG_INFO("LWTUNNEL_IP_OPT_VXLAN_GBP: %u\n", enc->data.ip.vxlan_gbp);
+						LOG_TRACE("LWTUNNEL_IP_OPT_VXLAN_GBP: %u\n", enc->data.ip.vxlan_gbp);
 					}
 				}
 			}
@@ -1431,27 +2214,27 @@ static int FillIp(uint8_t family, Encap * enc, struct rtattr * rta)
 
 					if( erspan[LWTUNNEL_IP_OPT_ERSPAN_VER] && RTA_PAYLOAD(erspan[LWTUNNEL_IP_OPT_ERSPAN_VER]) >= sizeof(uint8_t) ) {
 						er.ver = RTA_UINT8_T(erspan[LWTUNNEL_IP_OPT_ERSPAN_VER]);
-						LOG_INFO("LWTUNNEL_IP_OPT_ERSPAN_VER: %u\n", er.ver);
+						LOG_TRACE("LWTUNNEL_IP_OPT_ERSPAN_VER: %u\n", er.ver);
 					}
 
 					if( erspan[LWTUNNEL_IP_OPT_ERSPAN_INDEX] && RTA_PAYLOAD(erspan[LWTUNNEL_IP_OPT_ERSPAN_INDEX]) >= sizeof(uint32_t) ) {
 						er.index = ntohl(RTA_UINT32_T(erspan[LWTUNNEL_IP_OPT_ERSPAN_INDEX]));
-						LOG_INFO("LWTUNNEL_IP_OPT_ERSPAN_INDEX: %u\n", er.index);
+						LOG_TRACE("LWTUNNEL_IP_OPT_ERSPAN_INDEX: %u\n", er.index);
 					}
 
 					if( erspan[LWTUNNEL_IP_OPT_ERSPAN_DIR] && RTA_PAYLOAD(erspan[LWTUNNEL_IP_OPT_ERSPAN_DIR]) >= sizeof(uint8_t) ) {
 						er.dir = RTA_UINT8_T(erspan[LWTUNNEL_IP_OPT_ERSPAN_DIR]);
-						LOG_INFO("LWTUNNEL_IP_OPT_ERSPAN_DIR: %u\n", er.dir);
+						LOG_TRACE("LWTUNNEL_IP_OPT_ERSPAN_DIR: %u\n", er.dir);
 					}
 
 					if( erspan[LWTUNNEL_IP_OPT_ERSPAN_HWID] && RTA_PAYLOAD(erspan[LWTUNNEL_IP_OPT_ERSPAN_HWID]) >= sizeof(uint8_t) ) {
 						er.hwid = RTA_UINT8_T(erspan[LWTUNNEL_IP_OPT_ERSPAN_HWID]);
-						LOG_INFO("LWTUNNEL_IP_OPT_ERSPAN_HWID: %u\n", er.hwid);
+						LOG_TRACE("LWTUNNEL_IP_OPT_ERSPAN_HWID: %u\n", er.hwid);
 					}
 				}
 
 				snprintf(enc->data.ip.erspan_opts, sizeof(enc->data.ip.erspan_opts), "%u:%u:%u:%u", er.ver, er.index, er.dir, er.hwid);
-				LOG_INFO("erspan_opts %s\n", enc->data.ip.erspan_opts);
+				LOG_TRACE("erspan_opts %s\n", enc->data.ip.erspan_opts);
 			}
 		}
 	}
@@ -1476,12 +2259,12 @@ int FillEncap(Encap * enc, struct rtattr * rta)
 			if( mpls[MPLS_IPTUNNEL_DST] && RTA_PAYLOAD(mpls[MPLS_IPTUNNEL_DST]) >= sizeof(uint32_t) ) {
 				mpls_ntop((const struct mpls_label *)RTA_DATA(mpls[MPLS_IPTUNNEL_DST]), enc->data.mpls.dst, sizeof(enc->data.mpls.dst)-1);
 				enc->data.mpls.valid.dst = 1;
-				LOG_INFO("MPLS_IPTUNNEL_DST: %s\n", enc->data.mpls.dst);
+				LOG_TRACE("MPLS_IPTUNNEL_DST: %s\n", enc->data.mpls.dst);
 			}
 			if( mpls[MPLS_IPTUNNEL_TTL] && RTA_PAYLOAD(mpls[MPLS_IPTUNNEL_TTL]) >= sizeof(uint8_t) ) {
 				enc->data.mpls.ttl = RTA_UINT8_T(mpls[MPLS_IPTUNNEL_TTL]);
 				enc->data.mpls.valid.ttl = 1;
-				LOG_INFO("MPLS_IPTUNNEL_TTL: %d\n", enc->data.mpls.ttl);
+				LOG_TRACE("MPLS_IPTUNNEL_TTL: %d\n", enc->data.mpls.ttl);
 			}
 		}
 		}
@@ -1507,149 +2290,168 @@ int FillEncap(Encap * enc, struct rtattr * rta)
 	return res;
 }
 
+static int ReserveArena(void ** ptr, size_t * size, size_t need, size_t itemsize)
+{
+	size_t new_size = *size ? *size:64;
+	void * new_ptr;
+
+	if( need <= *size )
+		return TRUE;
+
+	while( new_size < need )
+		new_size *= 2;
+
+	new_ptr = realloc(*ptr, new_size*itemsize);
+	if( !new_ptr ) {
+		LOG_ERROR("malloc(%u) ... error (%s)\n", new_size*itemsize, errorname(errno));
+		return FALSE;
+	}
+	*ptr = new_ptr;
+	*size = new_size;
+	return TRUE;
+}
+
+// Fills attrs->present and returns total number of present attributes,
+// the first attribute of the same type is used as FillAttr() does
+static uint32_t IndexAttrTypes(struct rtattr *rta, int len, unsigned short max, AttrIndex * attrs)
+{
+	uint32_t total = 0;
+
+	memset(attrs->present, 0, sizeof(attrs->present));
+	while( RTA_OK(rta, len) ) {
+		unsigned short type = rta->rta_type & (unsigned short)(~NLA_F_NET_BYTEORDER);
+		uint64_t bit = (uint64_t)1 << (type % 64);
+		if( type <= max && !(attrs->present[type / 64] & bit) ) {
+			attrs->present[type / 64] |= bit;
+			total++;
+		}
+		rta = RTA_NEXT(rta, len);
+	}
+
+	if( len ) {
+		LOG_ERROR("left len=%d, rta_len=%d\n", len, rta->rta_len);
+		return (uint32_t)-1;
+	}
+	return total;
+}
+
+// offsets of attributes from info in order of types, offsets has total items from IndexAttrTypes()
+static void IndexAttrOffsets(const char * info, struct rtattr *rta, int len, unsigned short max, const AttrIndex * attrs, uint32_t * offsets, uint32_t total)
+{
+	memset(offsets, 0, sizeof(uint32_t) * total);
+	while( RTA_OK(rta, len) ) {
+		unsigned short type = rta->rta_type & (unsigned short)(~NLA_F_NET_BYTEORDER);
+		if( type <= max ) {
+			unsigned int word = type / 64, index = 0, i;
+			uint64_t bit = (uint64_t)1 << (type % 64);
+			for( i = 0; i < word; i++ )
+				index += __builtin_popcountll(attrs->present[i]);
+			index += __builtin_popcountll(attrs->present[word] & (bit - 1));
+			// attribute can`t have zero offset, header is before it
+			if( !offsets[index] )
+				offsets[index] = (uint32_t)((const char *)rta - info);
+		}
+		rta = RTA_NEXT(rta, len);
+	}
+}
+
 static int ProcessMsg(netlink_ctx * ctx, struct nlmsghdr * nlh)
 {
-	// +1 sizeof(void *) from struct UniversalRecord
-	size_t real_structsize = sizeof(UniversalRecord)+sizeof(void *)*ctx->max_tbl_items;
-	UniversalRecord * ur = (UniversalRecord *)(ctx->info.ptr+(ctx->currentMsg*real_structsize));
+	UniversalRecord * ur = &ctx->info.ur[ctx->currentMsg];
 	int total_len = nlh->nlmsg_len - NLMSG_LENGTH(ctx->infosize);
+	struct rtattr * rta = (struct rtattr *)((char *)NLMSG_DATA(nlh)+NLMSG_ALIGN(ctx->infosize));
+	uint32_t total;
 
 	assert( ctx->currentMsg < ctx->totalmsg );
-	assert( ctx->max_tbl_items >= 1 );
-
-	ur->info = (char *)NLMSG_DATA(nlh);
+	assert( ctx->max_tbl_items < NETLINK_ATTR_WORDS*64 );
 
 	if( total_len < 0 ) {
 		LOG_ERROR("nlh->nlmsg_len %d < NLMSG_LENGTH(ctx->infosize) %d\n", nlh->nlmsg_len, NLMSG_LENGTH(ctx->infosize));
 		return FALSE;
 	}
 
-	memmove(&ur->nlm, nlh, sizeof(struct nlmsghdr));
+	total = IndexAttrTypes(rta, total_len, ctx->max_tbl_items, &ur->attrs);
+	if( total != (uint32_t)-1 && ReserveArena((void **)&ctx->offsets, &ctx->offsets_size, ctx->offsets_used + total, sizeof(uint32_t)) ) {
+
+		IndexAttrOffsets((char *)NLMSG_DATA(nlh), rta, total_len, ctx->max_tbl_items, &ur->attrs, ctx->offsets + ctx->offsets_used, total);
 
-	if( FillAttr((struct rtattr *)(ur->info+NLMSG_ALIGN(ctx->infosize)), ur->tb, ctx->max_tbl_items, (short unsigned int)(~NLA_F_NET_BYTEORDER), total_len, ctx->typeprint ) )
+		// buf and arena can be moved by realloc while dump is receiving,
+		// so offsets are kept instead of pointers until FixupRecords()
+		memmove(&ur->nlm, nlh, sizeof(struct nlmsghdr));
+		ur->info = (char *)((char *)NLMSG_DATA(nlh) - ctx->buf);
+		ur->attrs.offset = (const uint32_t *)(uintptr_t)ctx->offsets_used;
+		ctx->offsets_used += total;
 		ctx->currentMsg++;
+	}
 
 	assert( ctx->totalmsg >= ctx->currentMsg );
 
-	// last record is always NULL (not last in case if error FillAttr)
-	ur = (UniversalRecord *)(ctx->info.ptr+(ctx->currentMsg*real_structsize));
-	ur->info = 0;
+	// last record is always NULL (not last in case if error)
+	ctx->info.ur[ctx->currentMsg].info = 0;
 
 	return TRUE;
 }
 
-static const void * ProcessRouteMsgs(netlink_ctx * ctx)
+static void FixupRecords(netlink_ctx * ctx)
 {
-	assert( ctx->totalmsg > 0 );
-
-	if( ctx->totalmsg > ctx->currentMsg ) {
-		// last record is always NULL
-		size_t total_size = sizeof(RouteRecord)*(ctx->totalmsg+1);
-		ctx->info.rt_recs = (RouteRecord *)realloc(ctx->info.rt_recs, total_size);
-		if( !ctx->info.rt_recs ) {
-			LOG_ERROR("malloc(%u) ... error (%s)\n", total_size, errorname(errno));
-			return 0;
-		}
+	int i;
+	for( i = 0; i < ctx->currentMsg; i++ ) {
+		UniversalRecord * ur = &ctx->info.ur[i];
+		ur->info = ctx->buf + (uintptr_t)ur->info;
+		ur->attrs.offset = ctx->offsets + (uintptr_t)ur->attrs.offset;
 	}
-	ctx->typeprint = rtatype;
-	ctx->max_tbl_items = RTA_MAX;
-	ctx->infosize = sizeof(struct rtmsg);
-	if( EnumMsg(ctx, ProcessMsg) )
-		return (const void *)ctx->info.rt_recs;
-	return 0;
 }
 
-static const void * ProcessAddrMsgs(netlink_ctx * ctx)
+static const void * ProcessMsgs(netlink_ctx * ctx, uint16_t max_tbl_items, size_t infosize)
 {
 	assert( ctx->totalmsg > 0 );
 
-	if( ctx->totalmsg > ctx->currentMsg ) {
-		// last record is always NULL
-		size_t total_size = sizeof(AddrRecord)*(ctx->totalmsg+1);
-		ctx->info.adr_recs = (AddrRecord *)realloc(ctx->info.adr_recs, total_size);
-		if( !ctx->info.adr_recs ) {
-			LOG_ERROR("malloc(%u) ... error (%s)\n", total_size, errorname(errno));
-			return 0;
-		}
-	}
+	// last record is always NULL
+	if( !ReserveArena((void **)&ctx->info.ptr, &ctx->records_size, ctx->totalmsg+1, sizeof(UniversalRecord)) )
+		return 0;
 
-	ctx->typeprint = ifatype;
-	ctx->max_tbl_items = IFA_MAX;
-	ctx->infosize = sizeof(struct ifaddrmsg);
+	ctx->max_tbl_items = max_tbl_items;
+	ctx->infosize = infosize;
 	if( EnumMsg(ctx, ProcessMsg) )
-		return (const void *)ctx->info.adr_recs;
+		return (const void *)ctx->info.ptr;
 	return 0;
 }
 
-static const void * ProcessRuleMsgs(netlink_ctx * ctx)
+static const void * ProcessRouteMsgs(netlink_ctx * ctx)
 {
-	assert( ctx->totalmsg > 0 );
+	return ProcessMsgs(ctx, RTA_MAX, sizeof(struct rtmsg));
+}
 
-	if( ctx->totalmsg > ctx->currentMsg ) {
-		// last record is always NULL
-		size_t total_size = sizeof(RuleRecord)*(ctx->totalmsg+1);
-		ctx->info.rule_recs = (RuleRecord *)realloc(ctx->info.rule_recs, total_size);
-		if( !ctx->info.rule_recs ) {
-			LOG_ERROR("malloc(%u) ... error (%s)\n", total_size, errorname(errno));
-			return 0;
-		}
-	}
+static const void * ProcessAddrMsgs(netlink_ctx * ctx)
+{
+	return ProcessMsgs(ctx, IFA_MAX, sizeof(struct ifaddrmsg));
+}
 
-	ctx->typeprint = fratype;
-	ctx->max_tbl_items = FRA_MAX;
-	ctx->infosize = sizeof(struct fib_rule_hdr);
-	if( EnumMsg(ctx, ProcessMsg) )
-		return (const void *)ctx->info.rule_recs;
-	return 0;
+static const void * ProcessRuleMsgs(netlink_ctx * ctx)
+{
+	return ProcessMsgs(ctx, FRA_MAX, sizeof(struct fib_rule_hdr));
 }
 
 static const void * ProcessLinkMsgs(netlink_ctx * ctx)
 {
-	assert( ctx->totalmsg > 0 );
-
-	if( ctx->totalmsg > ctx->currentMsg ) {
-		size_t total_size = sizeof(LinkRecord)*(ctx->totalmsg+1);
-		ctx->info.link_recs = (LinkRecord *)realloc(ctx->info.link_recs, total_size);
-		if( !ctx->info.link_recs ) {
-			LOG_ERROR("malloc(%u) ... error (%s)\n", total_size, errorname(errno));
-			return 0;
-		}
-	}
-
-	ctx->typeprint = iflatype;
-	ctx->max_tbl_items = IFLA_MAX;
-	ctx->infosize = sizeof(struct ifinfomsg);
-	if( EnumMsg(ctx, ProcessMsg) )
-		return (const void *)ctx->info.link_recs;
-	return 0;
+	return ProcessMsgs(ctx, IFLA_MAX, sizeof(struct ifinfomsg));
 }
 
 static const void * ProcessNeighborMsgs(netlink_ctx * ctx)
 {
-	assert( ctx->totalmsg > 0 );
-
-	if( ctx->totalmsg > ctx->currentMsg ) {
-		size_t total_size = sizeof(NeighborRecord)*(ctx->totalmsg+1);
-		ctx->info.neighbor_recs = (NeighborRecord *)realloc(ctx->info.neighbor_recs, total_size);
-		if( !ctx->info.neighbor_recs ) {
-			LOG_ERROR("malloc(%u) ... error (%s)\n", total_size, errorname(errno));
-			return 0;
-		}
-	}
+	return ProcessMsgs(ctx, NDA_MAX, sizeof(struct ndmsg));
+}
 
-	ctx->typeprint = ndatype;
-	ctx->max_tbl_items = NDA_MAX;
-	ctx->infosize = sizeof(struct ndmsg);
-	if( EnumMsg(ctx, ProcessMsg) )
-		return (const void *)ctx->info.neighbor_recs;
-	return 0;
+static const void * ProcessStatsMsgs(netlink_ctx * ctx)
+{
+	return ProcessMsgs(ctx, IFLA_STATS_MAX, sizeof(struct if_stats_msg));
 }
 
-static ssize_t __netlink_recvmsg(int fd, struct msghdr *msg, int flags)
+static ssize_t __netlink_recvmsg(netlink_ctx * ctx, struct msghdr *msg, int flags)
 {
 	ssize_t rcvsize;
 	do {
-		rcvsize = recvmsg(fd, msg, flags);
+		rcvsize = NetlinkRecvmsg(ctx, msg, flags);
 	} while( rcvsize < 0 && (errno == EINTR || errno == EAGAIN) );
 
 	if( rcvsize < 0 )
@@ -1662,116 +2464,180 @@ static ssize_t __netlink_recvmsg(int fd, struct msghdr *msg, int flags)
 	return rcvsize;
 }
 
+// Largest datagram received by any socket, kernel fills dump datagrams up to
+// 32 KB (or bigger if one message does not fit), so free space of receive buffer
+// is kept not less than it and datagram is received by one recvmsg()
+static size_t netlink_chunk = NETLINK_RECV_CHUNK;
+
+static void TuneChunk(size_t size)
+{
+	size_t chunk = __atomic_load_n(&netlink_chunk, __ATOMIC_RELAXED);
+	while( size > chunk && !__atomic_compare_exchange_n(&netlink_chunk, &chunk, size, FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+		;
+}
+
+// keep at least size free bytes after ctx->offset, buffer grows twice to avoid realloc per datagram
+static int ReserveRecvBuffer(netlink_ctx * ctx, size_t size)
+{
+	size_t need_size = ctx->offset + size;
+	size_t new_size;
+	char * buf;
+
+	if( need_size <= ctx->rcvbufsize )
+		return TRUE;
+
+	new_size = ctx->rcvbufsize * 2 > need_size ? ctx->rcvbufsize * 2:need_size;
+	buf = (char *)realloc(ctx->buf, ctx->sndbufsize > new_size ? ctx->sndbufsize:new_size);
+	if( !buf ) {
+		LOG_ERROR("realloc(%u) ... error (%s)\n", new_size, errorname(errno));
+		return FALSE;
+	}
+	ctx->buf = buf;
+	ctx->rcvbufsize = new_size;
+	return TRUE;
+}
+
 static ssize_t netlink_recvmsg(netlink_ctx * ctx)
 {
 	struct sockaddr_nl addr;
-	struct iovec iov = {
-		.iov_base	= ctx->buf + ctx->offset,
-		.iov_len	= ctx->rcvbufsize - ctx->offset,
-	};
-	struct msghdr msg = {
-		.msg_name	= &addr,
-		.msg_namelen	= sizeof(struct sockaddr_nl),
-		.msg_iov	= &iov,
-		.msg_iovlen	= 1,
-		.msg_control	= NULL,
-		.msg_controllen	= 0,
-		.msg_flags	= 0,
-	};
-
+	struct iovec iov;
+	struct msghdr msg;
 	ssize_t rcvsize;
 
-	while( (rcvsize = __netlink_recvmsg(ctx->netlink_socket, &msg, MSG_PEEK | MSG_TRUNC)) > 0 ) {
+	if( !ReserveRecvBuffer(ctx, __atomic_load_n(&netlink_chunk, __ATOMIC_RELAXED)) )
+		return -1;
 
-		// tune buffer
-		size_t need_size = (size_t)rcvsize + ctx->offset;
-		if( need_size > ctx->rcvbufsize ) {
-			char * buf = (char *)realloc(ctx->buf, ctx->sndbufsize > need_size ? ctx->sndbufsize:need_size);
-			if( !buf ) {
-				LOG_ERROR("malloc(%u) ... error (%s)\n", need_size, errorname(errno));
-				return -errno;
-			}
-			ctx->buf = buf;
-			ctx->rcvbufsize = need_size;
-			iov.iov_base = ctx->buf + ctx->offset;
-			iov.iov_len = ctx->rcvbufsize - ctx->offset;
-
-			if( setsockopt(ctx->netlink_socket,
-				SOL_SOCKET,
-				SO_RCVBUF,
-				&ctx->rcvbufsize,
-				sizeof(ctx->rcvbufsize)) < 0 ) {
-				LOG_ERROR("setsockopt(SOL_SOCKET, SO_RCVBUF %u) ... error (%s)\n", \
-						ctx->rcvbufsize, errorname(errno));
-				return -errno;
-			}
-			continue;
-		}
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = ctx->buf + ctx->offset;
+	iov.iov_len = ctx->rcvbufsize - ctx->offset;
+	msg.msg_name = &addr;
+	msg.msg_namelen = sizeof(struct sockaddr_nl);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+
+	// MSG_TRUNC gives real size of datagram even if it does not fit
+	rcvsize = __netlink_recvmsg(ctx, &msg, MSG_TRUNC);
+	if( rcvsize <= 0 )
+		return -1;
 
-		// recv data
-		rcvsize = __netlink_recvmsg(ctx->netlink_socket, &msg, 0);
-		if( rcvsize <= 0 )
-			break;
+	LOG_TRACE("recvmsg() ... size:             %d (%d)\n", rcvsize, NLMSG_ALIGN(sizeof(struct nlmsghdr)));
+	LOG_TRACE("recvmsg() ... msg.msg_flags:    0x%08X\n", msg.msg_flags);
 
-		LOG_INFO("recvmsg() ... size:             %d (%d)\n", rcvsize, NLMSG_ALIGN(sizeof(struct nlmsghdr)));
-		LOG_INFO("recvmsg() ... msg.msg_flags:    0x%08X\n", msg.msg_flags);
+	// check data
+	// strict condition with asserts
+	assert( msg.msg_namelen == sizeof(struct sockaddr_nl) );
 
-		// check data
-		// strict condition with asserts
-		assert( msg.msg_namelen == sizeof(struct sockaddr_nl) );
+	if( msg.msg_namelen != sizeof(struct sockaddr_nl) ) {
+		LOG_ERROR("unsupported AF_NETLINK socket size\n");
+		errno = EINVAL;
+		return -1;
+	}
 
-		errno = 0;
-		if( msg.msg_namelen != sizeof(struct sockaddr_nl) ) {
-			LOG_ERROR("unsupported AF_NETLINK socket size\n");
-			errno = EINVAL;
-			break;
-		}
+	if( (msg.msg_flags & MSG_TRUNC) == 0 && (size_t)rcvsize <= iov.iov_len )
+		return rcvsize;
 
-		// not strict condition
-		if( (msg.msg_flags & MSG_TRUNC) != 0 ) {
-			LOG_ERROR("truncate date\n");
-			errno = EINVAL;
+	// messages of datagram are lost. Kernel queues the next datagram of dump while
+	// the previous one is received, so the rest of reply is drained without blocking
+	// (request socket is blocking, truncated datagram may be the last one) and
+	// caller repeats request with chunk enough for this datagram
+	LOG_ERROR("truncate data %d > %u\n", rcvsize, iov.iov_len);
+	TuneChunk((size_t)rcvsize);
+	for( ;; ) {
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		rcvsize = NetlinkRecvmsg(ctx, &msg, MSG_DONTWAIT);
+		if( rcvsize < 0 && errno == EINTR )
+			continue;
+		if( rcvsize <= 0 )
 			break;
-		}
-
-		return rcvsize;
 	}
+
+	ctx->truncated = TRUE;
+	errno = EMSGSIZE;
 	return -1;
 }
 
+static const UniversalRecord empty_dump = {0};
+
+// chunk grows to the truncated datagram, so one repeat is usually enough
+#define NETLINK_TRUNCATED_RETRIES 2
+
 const void * GetInfo(netlink_ctx * ctx, const void * (* fn)(netlink_ctx * ctx))
 {
 	const void * info = 0;
+	char request[512];
+	uint32_t len;
+	uint64_t start;
+	int dump, saved, attempt;
 
 	assert( fn != 0 );
 	assert( ctx != 0 );
-	assert( ctx->netlink_socket >= 0 );
+	assert( ctx->transport != 0 );
 	assert( ctx->buf != 0 );
 
-	if( send(ctx->netlink_socket, ctx->buf, ctx->nlh->nlmsg_len, 0) < 0) {
-		LOG_ERROR("send(%u) ... error (%s)\n", ctx->nlh->nlmsg_type, errorname(errno));
-		return 0;
-	}
+	start = NetlinkNow();
+	// answer to request without NLM_F_DUMP is one datagram without NLMSG_DONE
+	dump = (ctx->nlh->nlmsg_flags & NLM_F_DUMP) == NLM_F_DUMP;
+	len = ctx->nlh->nlmsg_len;
+	// reply overwrites request, it is kept to repeat after truncated datagram
+	saved = len <= sizeof(request);
+	if( saved )
+		memcpy(request, ctx->buf, len);
+
+	for( attempt = 0; ; attempt++ ) {
+		if( NetlinkSend(ctx, ctx->buf, len) < 0) {
+			LOG_ERROR("send(%u) ... error (%s)\n", ctx->nlh->nlmsg_type, errorname(errno));
+			return 0;
+		}
 
-	ctx->totalmsg = 0;
-	ctx->currentMsg = 0;
-	ctx->rcvsize = 0;
-	ctx->offset = 0;
+		info = 0;
+		ctx->totalmsg = 0;
+		ctx->currentMsg = 0;
+		ctx->rcvsize = 0;
+		ctx->offset = 0;
+		ctx->offsets_used = 0;
+		ctx->dump_done = FALSE;
+		ctx->truncated = FALSE;
+
+		while( (ctx->rcvsize = netlink_recvmsg(ctx)) > 0 ) {
+			assert( ctx->rcvsize > 0 && (size_t)ctx->rcvsize <= ctx->rcvbufsize );
+			LOG_TRACE("1. ctx->totalmsg %d\n", ctx->totalmsg);
+			if( EnumMsg(ctx, IncrementTotalMsg) ) {
+				LOG_TRACE("2. ctx->totalmsg %d\n", ctx->totalmsg);
+				if( ctx->totalmsg ) {
+					info = fn(ctx);
+					ctx->offset += (size_t)ctx->rcvsize;
+					assert( ctx->rcvbufsize >= ctx->offset );
+				}
+			} else
+				break;
+			if( ctx->dump_done || !dump )
+				break;
+		}
 
-	while( (ctx->rcvsize = netlink_recvmsg(ctx)) > 0 ) {
-		assert( ctx->rcvsize > 0 && (size_t)ctx->rcvsize <= ctx->rcvbufsize );
-		LOG_INFO("1. ctx->totalmsg %d\n", ctx->totalmsg);
-		if( EnumMsg(ctx, IncrementTotalMsg) ) {
-			LOG_INFO("2. ctx->totalmsg %d\n", ctx->totalmsg);
-			if( ctx->totalmsg ) {
-				info = fn(ctx);
-				ctx->offset += (size_t)ctx->rcvsize;
-				assert( ctx->rcvbufsize >= ctx->offset );
-			}
-		} else
+		if( !ctx->truncated )
 			break;
+		// records of truncated datagram are lost, reply is inconsistent
+		if( !saved || attempt >= NETLINK_TRUNCATED_RETRIES ) {
+			ctx->dump_intr = TRUE;
+			break;
+		}
+		LOG_WARN("request %u is repeated after truncated datagram\n", ((struct nlmsghdr *)request)->nlmsg_type);
+		memcpy(ctx->buf, request, len);
+		ctx->nlh->nlmsg_seq = ++ctx->sequence_number;
 	}
 
+	if( info )
+		FixupRecords(ctx);
+
+	// successful dump without records
+	if( !info && ctx->dump_done && !ctx->totalmsg )
+		info = (const void *)&empty_dump;
+
+	__atomic_add_fetch(&netlink_stats.dumps, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&netlink_stats.dump_ns, NetlinkNow() - start, __ATOMIC_RELAXED);
+
 	LOG_INFO("ctx->offset = %u\n", ctx->offset);
 	return info;
 }
@@ -1782,10 +2648,11 @@ const RouteRecord * GetRoutes(void * nl, int family)
 	struct rtmsg * rtm = (struct rtmsg *)NLMSG_DATA(ctx->buf);
 
 	assert( ctx != 0 );
-	assert( ctx->netlink_socket >= 0 );
+	assert( ctx->transport != 0 );
 	assert( ctx->nlh != 0 );
 
-	memset( ctx->buf, 0, NLMSG_ALIGN(sizeof(struct nlmsghdr)) );
+	// request payload must not keep data of the previous dump
+	memset( ctx->buf, 0, NLMSG_SPACE(sizeof(struct rtmsg)) );
 	ctx->nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
 	ctx->nlh->nlmsg_type = RTM_GETROUTE;
 	ctx->nlh->nlmsg_seq = ++ctx->sequence_number;
@@ -1795,16 +2662,196 @@ const RouteRecord * GetRoutes(void * nl, int family)
 	return (const RouteRecord *)GetInfo(ctx, ProcessRouteMsgs);
 }
 
-const LinkRecord * GetLinks(void * nl)
+// Strict checking is switched on for filtered dumps only, other requests
+// (e.g. rtgenmsg of GetLinks()) are not valid with it
+static int SetStrictCheck(netlink_ctx * ctx, int on)
 {
-	netlink_ctx * ctx = (netlink_ctx *)nl;
-	struct rtgenmsg *rt = (struct rtgenmsg *)NLMSG_DATA(ctx->buf);
+	if( ctx->netlink_socket < 0 || ctx->no_strict_chk )
+		return FALSE;
 
-	assert( ctx != 0 );
-	assert( ctx->netlink_socket >= 0 );
+	if( setsockopt(ctx->netlink_socket,
+			SOL_NETLINK,
+			NETLINK_GET_STRICT_CHK,
+			&on,
+			sizeof(on)) < 0 ) {
+		LOG_WARN("setsockopt(SOL_NETLINK, NETLINK_GET_STRICT_CHK) ... warn (%s)\n", \
+			errorname(errno));
+		ctx->no_strict_chk = TRUE;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static int IsEmptyFilter(const RouteFilter * filter)
+{
+	return !filter->table && !filter->oif && !filter->protocol && !filter->type;
+}
+
+static int NexthopsUseDev(const RouteRecord * rr, uint32_t oif)
+{
+	const struct rtattr * mp = RECORD_TB(rr, RTA_MULTIPATH);
+	const struct rtnexthop * nh;
+	int len;
+
+	if( RECORD_TB(rr, RTA_OIF) && RTA_PAYLOAD(RECORD_TB(rr, RTA_OIF)) >= sizeof(uint32_t) &&
+		RTA_UINT32_T(RECORD_TB(rr, RTA_OIF)) == oif )
+		return TRUE;
+
+	if( !mp )
+		return FALSE;
+
+	nh = (const struct rtnexthop *)RTA_DATA(mp);
+	len = (int)RTA_PAYLOAD(mp);
+	for( ; RTNH_OK(nh, len); len -= NLMSG_ALIGN(nh->rtnh_len), nh = RTNH_NEXT(nh) ) {
+		if( (uint32_t)nh->rtnh_ifindex == oif )
+			return TRUE;
+	}
+	return FALSE;
+}
+
+int RouteMatches(const RouteRecord * rr, const RouteFilter * filter)
+{
+	uint32_t table = rr->rt->rtm_table;
+
+	if( RECORD_TB(rr, RTA_TABLE) && RTA_PAYLOAD(RECORD_TB(rr, RTA_TABLE)) >= sizeof(uint32_t) )
+		table = RTA_UINT32_T(RECORD_TB(rr, RTA_TABLE));
+
+	return (!filter->family || rr->rt->rtm_family == filter->family) &&
+		(!filter->table || table == filter->table) &&
+		(!filter->protocol || rr->rt->rtm_protocol == filter->protocol) &&
+		(!filter->type || rr->rt->rtm_type == filter->type) &&
+		(!filter->oif || NexthopsUseDev(rr, filter->oif));
+}
+
+int SameRouteFilter(const RouteFilter * a, const RouteFilter * b)
+{
+	return a->family == b->family && a->table == b->table && a->oif == b->oif &&
+		a->protocol == b->protocol && a->type == b->type;
+}
+
+// records which do not match are removed, order of the rest is kept
+static void FilterRoutes(netlink_ctx * ctx, const RouteFilter * filter)
+{
+	int i, count = 0;
+
+	for( i = 0; i < ctx->currentMsg; i++ ) {
+		if( RouteMatches(&ctx->info.rt_recs[i], filter) )
+			ctx->info.ur[count++] = ctx->info.ur[i];
+	}
+	memset(&ctx->info.ur[count], 0, sizeof(UniversalRecord));
+	LOG_INFO("%d of %d routes match filter\n", count, ctx->currentMsg);
+	ctx->currentMsg = count;
+}
+
+// returns TRUE if strict checking is switched on for request
+static int PrepareRouteRequest(netlink_ctx * ctx, const RouteFilter * filter)
+{
+	struct rtmsg * rtm = (struct rtmsg *)NLMSG_DATA(ctx->buf);
+	int strict = !IsEmptyFilter(filter) && SetStrictCheck(ctx, TRUE);
+
+	memset( ctx->buf, 0, NLMSG_SPACE(sizeof(struct rtmsg)) );
+	ctx->nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+	ctx->nlh->nlmsg_type = RTM_GETROUTE;
+	ctx->nlh->nlmsg_seq = ++ctx->sequence_number;
+	ctx->nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+
+	rtm->rtm_family = filter->family;
+	if( strict ) {
+		// kernel checks header of strict request, only these fields may be set
+		rtm->rtm_table = filter->table < 256 ? (uint8_t)filter->table:RT_TABLE_UNSPEC;
+		rtm->rtm_protocol = filter->protocol;
+		rtm->rtm_type = filter->type;
+		if( filter->table >= 256 ) {
+			struct rtattr * rta = (struct rtattr *)((char *)ctx->nlh + NLMSG_ALIGN(ctx->nlh->nlmsg_len));
+			rta->rta_type = RTA_TABLE;
+			rta->rta_len = RTA_LENGTH(sizeof(uint32_t));
+			memmove(RTA_DATA(rta), &filter->table, sizeof(uint32_t));
+			ctx->nlh->nlmsg_len = NLMSG_ALIGN(ctx->nlh->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+		}
+		if( filter->oif ) {
+			struct rtattr * rta = (struct rtattr *)((char *)ctx->nlh + NLMSG_ALIGN(ctx->nlh->nlmsg_len));
+			rta->rta_type = RTA_OIF;
+			rta->rta_len = RTA_LENGTH(sizeof(uint32_t));
+			memmove(RTA_DATA(rta), &filter->oif, sizeof(uint32_t));
+			ctx->nlh->nlmsg_len = NLMSG_ALIGN(ctx->nlh->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+		}
+	}
+	return strict;
+}
+
+const RouteRecord * GetRoutesFiltered(void * nl, const RouteFilter * filter)
+{
+	netlink_ctx * ctx = (netlink_ctx *)nl;
+	const RouteRecord * rr;
+	int strict;
+
+	assert( ctx != 0 );
+	assert( ctx->transport != 0 );
+	assert( ctx->nlh != 0 );
+	assert( filter != 0 );
+
+	if( IsEmptyFilter(filter) )
+		return GetRoutes(nl, filter->family);
+
+	strict = PrepareRouteRequest(ctx, filter);
+	rr = (const RouteRecord *)GetInfo(ctx, ProcessRouteMsgs);
+
+	// there is no such table in this family
+	if( !rr && strict && errno == ENOENT && filter->table )
+		rr = (const RouteRecord *)&empty_dump;
+
+	if( strict )
+		SetStrictCheck(ctx, FALSE);
+
+	// without strict checking nothing is filtered by kernel, and not every family
+	// supports every field of filter, so records are checked here anyway
+	if( rr && rr->rt )
+		FilterRoutes(ctx, filter);
+	return rr;
+}
+
+const RouteRecord * GetRouteTo(void * nl, int family, const void * addr)
+{
+	netlink_ctx * ctx = (netlink_ctx *)nl;
+	struct rtmsg * rtm = (struct rtmsg *)NLMSG_DATA(ctx->buf);
+	struct rtattr * rta;
+	size_t addrlen = family == AF_INET6 ? sizeof(struct in6_addr):sizeof(struct in_addr);
+
+	assert( ctx != 0 );
+	assert( ctx->transport != 0 );
+	assert( ctx->nlh != 0 );
+	assert( addr != 0 );
+
+	memset( ctx->buf, 0, NLMSG_SPACE(sizeof(struct rtmsg)) );
+	ctx->nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+	ctx->nlh->nlmsg_type = RTM_GETROUTE;
+	ctx->nlh->nlmsg_seq = ++ctx->sequence_number;
+	ctx->nlh->nlmsg_flags = NLM_F_REQUEST;
+
+	rtm->rtm_family = family;
+	rtm->rtm_dst_len = (unsigned char)(addrlen * 8);
+	// matched FIB entry with its prefix instead of resolved destination
+	rtm->rtm_flags = RTM_F_FIB_MATCH;
+
+	rta = (struct rtattr *)((char *)ctx->nlh + NLMSG_ALIGN(ctx->nlh->nlmsg_len));
+	rta->rta_type = RTA_DST;
+	rta->rta_len = RTA_LENGTH(addrlen);
+	memmove(RTA_DATA(rta), addr, addrlen);
+	ctx->nlh->nlmsg_len = NLMSG_ALIGN(ctx->nlh->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+
+	return (const RouteRecord *)GetInfo(ctx, ProcessRouteMsgs);
+}
+
+const LinkRecord * GetLinks(void * nl)
+{
+	netlink_ctx * ctx = (netlink_ctx *)nl;
+	struct rtgenmsg *rt = (struct rtgenmsg *)NLMSG_DATA(ctx->buf);
+
+	assert( ctx != 0 );
+	assert( ctx->transport != 0 );
 	assert( ctx->nlh != 0 );
 
-	memset( ctx->buf, 0, NLMSG_ALIGN(sizeof(struct nlmsghdr)) );
+	memset( ctx->buf, 0, NLMSG_SPACE(sizeof(struct rtgenmsg)) );
 	ctx->nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct rtgenmsg));
 	ctx->nlh->nlmsg_type = RTM_GETLINK;
 	ctx->nlh->nlmsg_seq = ++ctx->sequence_number;
@@ -1820,10 +2867,10 @@ const AddrRecord * GetAddr(void *nl, int family)
 	struct ifaddrmsg *ifam = (struct ifaddrmsg *)NLMSG_DATA(ctx->buf);
 
 	assert( ctx != 0 );
-	assert( ctx->netlink_socket >= 0 );
+	assert( ctx->transport != 0 );
 	assert( ctx->nlh != 0 );
 
-	memset( ctx->buf, 0, NLMSG_ALIGN(sizeof(struct nlmsghdr)) );
+	memset( ctx->buf, 0, NLMSG_SPACE(sizeof(struct ifaddrmsg)) );
 	ctx->nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct ifaddrmsg));
 	ctx->nlh->nlmsg_type = RTM_GETADDR;
 	ctx->nlh->nlmsg_seq = ++ctx->sequence_number;
@@ -1838,10 +2885,10 @@ const RuleRecord * GetRules(void *nl, int family)
 	struct fib_rule_hdr *frh =(struct fib_rule_hdr *)NLMSG_DATA(ctx->buf);
 
 	assert( ctx != 0 );
-	assert( ctx->netlink_socket >= 0 );
+	assert( ctx->transport != 0 );
 	assert( ctx->nlh != 0 );
 
-	memset( ctx->buf, 0, NLMSG_ALIGN(sizeof(struct nlmsghdr)) );
+	memset( ctx->buf, 0, NLMSG_SPACE(sizeof(struct fib_rule_hdr)) );
 	ctx->nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct fib_rule_hdr));
 	ctx->nlh->nlmsg_type = RTM_GETRULE;
 	ctx->nlh->nlmsg_seq = ++ctx->sequence_number;
@@ -1856,10 +2903,10 @@ const NeighborRecord * GetNeighbors(void *nl, int family, int ndm_flags)
 	struct ndmsg *ndm =(struct ndmsg *)NLMSG_DATA(ctx->buf);
 
 	assert( ctx != 0 );
-	assert( ctx->netlink_socket >= 0 );
+	assert( ctx->transport != 0 );
 	assert( ctx->nlh != 0 );
 
-	memset( ctx->buf, 0, NLMSG_ALIGN(sizeof(struct nlmsghdr)) );
+	memset( ctx->buf, 0, NLMSG_SPACE(sizeof(struct ndmsg)) );
 	ctx->nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct ndmsg));
 	ctx->nlh->nlmsg_type = RTM_GETNEIGH;
 	ctx->nlh->nlmsg_seq = ++ctx->sequence_number;
@@ -1870,6 +2917,457 @@ const NeighborRecord * GetNeighbors(void *nl, int family, int ndm_flags)
 
 	return (const NeighborRecord *)GetInfo(ctx, ProcessNeighborMsgs);
 }
+
+const StatsRecord * GetStats(void * nl, uint32_t filter_mask)
+{
+	netlink_ctx * ctx = (netlink_ctx *)nl;
+	struct if_stats_msg *ifsm = (struct if_stats_msg *)NLMSG_DATA(ctx->buf);
+
+	assert( ctx != 0 );
+	assert( ctx->transport != 0 );
+	assert( ctx->nlh != 0 );
+
+	memset( ctx->buf, 0, NLMSG_SPACE(sizeof(struct if_stats_msg)) );
+	ctx->nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct if_stats_msg));
+	ctx->nlh->nlmsg_type = RTM_GETSTATS;
+	ctx->nlh->nlmsg_seq = ++ctx->sequence_number;
+	ctx->nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+
+	ifsm->family = AF_UNSPEC;
+	ifsm->filter_mask = filter_mask;
+
+	return (const StatsRecord *)GetInfo(ctx, ProcessStatsMsgs);
+}
+
+void * AddRequest(void * nl, uint16_t type, uint16_t flags, const void * info, size_t infosize)
+{
+	netlink_ctx * ctx = (netlink_ctx *)nl;
+	size_t need = ctx->batch_used + NLMSG_SPACE(infosize);
+	struct nlmsghdr * nlh;
+
+	assert( ctx != 0 );
+	assert( ctx->transport != 0 );
+
+	if( !ReserveArena((void **)&ctx->batch, &ctx->batch_size, need, 1) )
+		return 0;
+
+	nlh = (struct nlmsghdr *)(ctx->batch + ctx->batch_used);
+	memset(nlh, 0, NLMSG_SPACE(infosize));
+	nlh->nlmsg_len = NLMSG_LENGTH(infosize);
+	nlh->nlmsg_type = type;
+	nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | flags;
+	nlh->nlmsg_seq = ++ctx->sequence_number;
+	if( info )
+		memcpy(NLMSG_DATA(nlh), info, infosize);
+
+	if( !ctx->batch_count )
+		ctx->batch_seq = nlh->nlmsg_seq;
+	ctx->batch_count++;
+	ctx->batch_last = ctx->batch_used;
+	ctx->batch_used = need;
+	return NLMSG_DATA(nlh);
+}
+
+int AddRequestAttr(void * nl, uint16_t type, const void * data, size_t len)
+{
+	netlink_ctx * ctx = (netlink_ctx *)nl;
+	size_t need = ctx->batch_used + RTA_SPACE(len);
+	struct nlmsghdr * nlh;
+	struct rtattr * rta;
+
+	assert( ctx != 0 );
+	assert( ctx->batch_count != 0 );
+
+	if( !ReserveArena((void **)&ctx->batch, &ctx->batch_size, need, 1) )
+		return FALSE;
+
+	nlh = (struct nlmsghdr *)(ctx->batch + ctx->batch_last);
+	rta = (struct rtattr *)(ctx->batch + ctx->batch_used);
+	memset(rta, 0, RTA_SPACE(len));
+	rta->rta_type = type;
+	rta->rta_len = RTA_LENGTH(len);
+	memcpy(RTA_DATA(rta), data, len);
+
+	nlh->nlmsg_len = NLMSG_ALIGN(nlh->nlmsg_len) + RTA_SPACE(len);
+	ctx->batch_used = need;
+	return TRUE;
+}
+
+size_t PendingRequests(void * nl)
+{
+	netlink_ctx * ctx = (netlink_ctx *)nl;
+	return ctx->batch_count;
+}
+
+void DropRequests(void * nl, size_t count)
+{
+	netlink_ctx * ctx = (netlink_ctx *)nl;
+	size_t used = 0, last = 0;
+	uint32_t i;
+
+	assert( ctx != 0 );
+	assert( count <= ctx->batch_count );
+
+	for( i = 0; i < count; i++ ) {
+		last = used;
+		used += NLMSG_ALIGN(((struct nlmsghdr *)(ctx->batch + used))->nlmsg_len);
+	}
+	// dropped requests were not sent, acknowledgements are indexed by contiguous sequence numbers
+	ctx->sequence_number -= ctx->batch_count - (uint32_t)count;
+	ctx->batch_count = (uint32_t)count;
+	ctx->batch_used = used;
+	ctx->batch_last = last;
+}
+
+// acknowledgements of requests [first, first + count), errors are indexed from ctx->batch_seq.
+// Returns number of failed requests, -1 if acknowledgements were not received
+static int ReceiveAcks(netlink_ctx * ctx, uint32_t first, uint32_t count, int * errors)
+{
+	struct sockaddr_nl addr;
+	struct iovec iov = {
+		.iov_base	= ctx->buf,
+		.iov_len	= ctx->rcvbufsize,
+	};
+	struct msghdr msg = {
+		.msg_name	= &addr,
+		.msg_namelen	= sizeof(struct sockaddr_nl),
+		.msg_iov	= &iov,
+		.msg_iovlen	= 1,
+	};
+	uint32_t acked = 0;
+	int failed = 0;
+
+	while( acked < count ) {
+		struct nlmsghdr * nlh = ctx->nlh;
+		ssize_t rcvsize = __netlink_recvmsg(ctx, &msg, 0);
+		int len;
+
+		if( rcvsize <= 0 )
+			return -1;
+
+		len = (int)rcvsize;
+		for( ; NLMSG_OK(nlh, (unsigned int)len); nlh = NLMSG_NEXT(nlh, len) ) {
+			const struct nlmsgerr * err = (const struct nlmsgerr *)NLMSG_DATA(nlh);
+			const char * text = "";
+
+			if( nlh->nlmsg_type != NLMSG_ERROR || nlh->nlmsg_len < NLMSG_LENGTH(sizeof(*err)) ||
+			    nlh->nlmsg_seq < first || nlh->nlmsg_seq - first >= count ) {
+				LOG_WARN("unexpected %s (seq %u)\n", nlmsgtype(nlh->nlmsg_type), nlh->nlmsg_seq);
+				continue;
+			}
+
+			// extended ack follows request, which is not echoed back if NLM_F_CAPPED
+			if( err->error && nlh->nlmsg_flags & NLM_F_ACK_TLVS ) {
+				unsigned int offset = NLMSG_ALIGN(sizeof(*err));
+				struct rtattr * rta;
+				int attrlen;
+
+				if( !(nlh->nlmsg_flags & NLM_F_CAPPED) )
+					offset += NLMSG_ALIGN(err->msg.nlmsg_len) - NLMSG_HDRLEN;
+				rta = (struct rtattr *)((char *)NLMSG_DATA(nlh) + offset);
+				attrlen = (int)NLMSG_PAYLOAD(nlh, 0) - (int)offset;
+				for( ; attrlen > 0 && RTA_OK(rta, attrlen); rta = RTA_NEXT(rta, attrlen) )
+					if( rta->rta_type == NLMSGERR_ATTR_MSG )
+						text = (const char *)RTA_DATA(rta);
+			}
+
+			if( err->error ) {
+				LOG_ERROR("%s (seq %u) ... error (%s) %s\n", nlmsgtype(err->msg.nlmsg_type), nlh->nlmsg_seq, errorname(-err->error), text);
+				failed++;
+			}
+
+			if( errors )
+				errors[nlh->nlmsg_seq - ctx->batch_seq] = -err->error;
+			acked++;
+		}
+	}
+	return failed;
+}
+
+int CommitRequests(void * nl, int * errors, size_t count)
+{
+	netlink_ctx * ctx = (netlink_ctx *)nl;
+	size_t offset = 0, index = 0, i;
+	int failed = 0, res;
+
+	assert( ctx != 0 );
+	assert( ctx->transport != 0 );
+	assert( !errors || count >= ctx->batch_count );
+
+	if( errors )
+		for( i = 0; i < ctx->batch_count; i++ )
+			errors[i] = EIO;
+
+	while( offset < ctx->batch_used ) {
+		// as many requests as socket send buffer allows, kernel processes them in order
+		size_t size = 0;
+		uint32_t n = 0;
+		while( offset + size < ctx->batch_used ) {
+			struct nlmsghdr * nlh = (struct nlmsghdr *)(ctx->batch + offset + size);
+			if( n && size + NLMSG_ALIGN(nlh->nlmsg_len) > ctx->sndbufsize )
+				break;
+			size += NLMSG_ALIGN(nlh->nlmsg_len);
+			n++;
+		}
+
+		if( NetlinkSend(ctx, ctx->batch + offset, size) < 0 ) {
+			LOG_ERROR("send(%u requests) ... error (%s)\n", n, errorname(errno));
+			if( errors )
+				for( i = index; i < ctx->batch_count; i++ )
+					errors[i] = errno;
+			failed = -1;
+			break;
+		}
+
+		if( (res = ReceiveAcks(ctx, ctx->batch_seq + (uint32_t)index, n, errors)) < 0 ) {
+			failed = -1;
+			break;
+		}
+		failed += res;
+
+		offset += size;
+		index += n;
+	}
+
+	LOG_INFO("requests %u bytes %u failed %d\n", ctx->batch_count, ctx->batch_used, failed);
+
+	ctx->batch_used = 0;
+	ctx->batch_last = 0;
+	ctx->batch_count = 0;
+	return failed;
+}
+
+// messages of one notification datagram, or of one datagram of dump if dump is set,
+// returns number of processed or -1
+static int ProcessNotifyDatagram(netlink_ctx * dump, struct nlmsghdr * nlh, int rcvsize, NotifyCallback fn, void * arg)
+{
+	int total = 0;
+
+	for( ; NLMSG_OK(nlh, (unsigned int)rcvsize); nlh = NLMSG_NEXT(nlh, rcvsize) ) {
+		UniversalRecord rec;
+		uint32_t offsets[NETLINK_ATTR_WORDS*64];
+		struct rtattr * rta;
+		uint32_t attrs;
+		size_t infosize = 0;
+		uint16_t max_tbl_items = 0;
+		int total_len;
+
+		if( dump ) {
+			// skip not our message
+			if( nlh->nlmsg_seq != dump->sequence_number )
+				continue;
+			if( nlh->nlmsg_flags & NLM_F_DUMP_INTR )
+				dump->dump_intr = TRUE;
+		}
+
+		switch( nlh->nlmsg_type ) {
+		case NLMSG_DONE:
+			if( dump )
+				dump->dump_done = TRUE;
+			return total;
+		case NLMSG_ERROR:
+		{
+			const struct nlmsgerr * err = (const struct nlmsgerr *)NLMSG_DATA(nlh);
+			LOG_ERROR("NLMSG_ERROR (Error) %d\n", err->error);
+			errno = err->error ? -err->error:EPROTO;
+			return -1;
+		}
+		case NLMSG_OVERRUN:
+			LOG_ERROR("NLMSG_OVERRUN (Data lost)\n");
+			errno = ENOBUFS;
+			return -1;
+		case RTM_NEWROUTE:
+		case RTM_DELROUTE:
+			infosize = sizeof(struct rtmsg);
+			max_tbl_items = RTA_MAX;
+			break;
+		case RTM_NEWLINK:
+		case RTM_DELLINK:
+			infosize = sizeof(struct ifinfomsg);
+			max_tbl_items = IFLA_MAX;
+			break;
+		case RTM_NEWADDR:
+		case RTM_DELADDR:
+			infosize = sizeof(struct ifaddrmsg);
+			max_tbl_items = IFA_MAX;
+			break;
+		case RTM_NEWRULE:
+		case RTM_DELRULE:
+			infosize = sizeof(struct fib_rule_hdr);
+			max_tbl_items = FRA_MAX;
+			break;
+		case RTM_NEWNEIGH:
+		case RTM_DELNEIGH:
+			infosize = sizeof(struct ndmsg);
+			max_tbl_items = NDA_MAX;
+			break;
+		default:
+			LOG_TRACE("skip nlh->nlmsg_type: %d (%s)\n", nlh->nlmsg_type, nlmsgtype(nlh->nlmsg_type));
+			continue;
+		}
+
+		total_len = nlh->nlmsg_len - NLMSG_LENGTH(infosize);
+		if( total_len < 0 ) {
+			LOG_ERROR("nlh->nlmsg_len %d < NLMSG_LENGTH(infosize) %d\n", nlh->nlmsg_len, NLMSG_LENGTH(infosize));
+			continue;
+		}
+
+		memmove(&rec.nlm, nlh, sizeof(struct nlmsghdr));
+		rec.info = (char *)NLMSG_DATA(nlh);
+		rec.attrs.offset = offsets;
+
+		LOG_TRACE("nlh->nlmsg_type: %d (%s)\n", nlh->nlmsg_type, nlmsgtype(nlh->nlmsg_type));
+
+		rta = (struct rtattr *)(rec.info+NLMSG_ALIGN(infosize));
+		attrs = IndexAttrTypes(rta, total_len, max_tbl_items, &rec.attrs);
+		if( attrs == (uint32_t)-1 )
+			continue;
+		IndexAttrOffsets(rec.info, rta, total_len, max_tbl_items, &rec.attrs, offsets, attrs);
+
+		total++;
+		if( !fn(arg, nlh, &rec) ) {
+			errno = ECANCELED;
+			return -1;
+		}
+	}
+	return total;
+}
+
+#define NETLINK_NOTIFY_BATCH 16
+
+int ProcessNotifications(void * nl, NotifyCallback fn, void * arg)
+{
+	netlink_ctx * ctx = (netlink_ctx *)nl;
+	struct mmsghdr msgs[NETLINK_NOTIFY_BATCH];
+	struct iovec iovs[NETLINK_NOTIFY_BATCH];
+	size_t chunk = __atomic_load_n(&netlink_chunk, __ATOMIC_RELAXED);
+	unsigned int vlen, i;
+	int total = 0;
+
+	assert( ctx != 0 );
+	assert( ctx->transport != 0 );
+	assert( ctx->buf != 0 );
+	assert( fn != 0 );
+
+	// burst of events (e.g. thousands of routes are added) is drained by
+	// recvmmsg() into slots of receive buffer, one datagram per slot
+	vlen = ctx->transport->recvmmsg ? (unsigned int)(ctx->rcvbufsize / chunk):1;
+	if( vlen > NETLINK_NOTIFY_BATCH )
+		vlen = NETLINK_NOTIFY_BATCH;
+	if( vlen < 1 ) {
+		vlen = 1;
+		chunk = ctx->rcvbufsize;
+	}
+
+	memset(msgs, 0, sizeof(msgs));
+	for( i = 0; i < vlen; i++ ) {
+		iovs[i].iov_base = ctx->buf + i * chunk;
+		iovs[i].iov_len = vlen > 1 ? chunk:ctx->rcvbufsize;
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	for( ;; ) {
+		// MSG_TRUNC gives real size of datagram even if it does not fit
+		int count = NetlinkRecvmmsg(ctx, msgs, vlen, MSG_DONTWAIT | MSG_TRUNC);
+
+		if( count < 0 ) {
+			if( errno == EINTR )
+				continue;
+			if( errno == EAGAIN || errno == EWOULDBLOCK )
+				break;
+			// ENOBUFS - socket receive queue was overrun, events are lost
+			LOG_ERROR("recv(netlink_socket) ... error (%s)\n", errorname(errno));
+			return -1;
+		}
+
+		for( i = 0; i < (unsigned int)count; i++ ) {
+			int res;
+
+			if( msgs[i].msg_len == 0 ) {
+				LOG_ERROR("recv(netlink_socket) ... EOF on netlink\n");
+				errno = ENODATA;
+				return -1;
+			}
+
+			if( (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) || msgs[i].msg_len > iovs[i].iov_len ) {
+				// event does not fit to slot, rest of it is lost
+				LOG_ERROR("recv(netlink_socket) ... truncate data %u > %u\n", msgs[i].msg_len, iovs[i].iov_len);
+				TuneChunk(msgs[i].msg_len);
+				errno = ENOBUFS;
+				return -1;
+			}
+
+			res = ProcessNotifyDatagram(0, (struct nlmsghdr *)iovs[i].iov_base, (int)msgs[i].msg_len, fn, arg);
+			if( res < 0 )
+				return -1;
+			total += res;
+		}
+
+		// queue is drained
+		if( (unsigned int)count < vlen )
+			break;
+	}
+
+	return total;
+}
+
+int WalkRoutes(void * nl, const RouteFilter * filter, NotifyCallback fn, void * arg)
+{
+	netlink_ctx * ctx = (netlink_ctx *)nl;
+	uint64_t start = NetlinkNow();
+	int total = 0, strict;
+
+	assert( ctx != 0 );
+	assert( ctx->transport != 0 );
+	assert( ctx->buf != 0 );
+	assert( filter != 0 );
+	assert( fn != 0 );
+
+	strict = PrepareRouteRequest(ctx, filter);
+	if( NetlinkSend(ctx, ctx->buf, ctx->nlh->nlmsg_len) < 0) {
+		LOG_ERROR("send(%u) ... error (%s)\n", ctx->nlh->nlmsg_type, errorname(errno));
+		total = -1;
+	}
+
+	// every datagram is received to the start of buffer and dropped after callbacks
+	ctx->offset = 0;
+	ctx->dump_done = FALSE;
+	ctx->truncated = FALSE;
+	while( total >= 0 && !ctx->dump_done ) {
+		ssize_t rcvsize = netlink_recvmsg(ctx);
+		int res;
+
+		if( rcvsize <= 0 ) {
+			// records before truncated datagram are already given to callback,
+			// caller repeats the whole dump
+			if( ctx->truncated )
+				ctx->dump_intr = TRUE;
+			total = -1;
+			break;
+		}
+
+		res = ProcessNotifyDatagram(ctx, ctx->nlh, (int)rcvsize, fn, arg);
+		total = res < 0 ? -1:total + res;
+	}
+
+	// there is no such table in this family
+	if( total < 0 && strict && errno == ENOENT && filter->table ) {
+		ctx->dump_done = TRUE;
+		total = 0;
+	}
+
+	// stopped by callback, rest of dump is still in socket
+	if( total < 0 && errno == ECANCELED )
+		ctx->dump_intr = TRUE;
+
+	if( strict )
+		SetStrictCheck(ctx, FALSE);
+
+	__atomic_add_fetch(&netlink_stats.dumps, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&netlink_stats.dump_ns, NetlinkNow() - start, __ATOMIC_RELAXED);
+	return total;
+}
 #endif // #if !defined(__APPLE__) && !defined(__FreeBSD__)
 
 #ifdef MAIN_COMMON_NETLINK
@@ -1900,3 +3398,491 @@ int main(int argc, char * argv[])
 }
 
 #endif //MAIN_COMMON_NETLINK
+
+#if defined(MAIN_COMMON_NETLINK_BENCH) || defined(MAIN_COMMON_NETLINK_REPLAY)
+
+#include <time.h>
+#include <sys/resource.h>
+
+#define BENCH_ROUTE_ATTRS 5
+
+static size_t BenchFillRoutes(char * buf, uint32_t routes, uint32_t seq)
+{
+	struct nlmsghdr * nlh = (struct nlmsghdr *)buf;
+	uint32_t i;
+
+	for( i = 0; i < routes; i++ ) {
+		struct rtmsg * rtm = (struct rtmsg *)NLMSG_DATA(nlh);
+		struct rtattr * rta = (struct rtattr *)((char *)rtm + NLMSG_ALIGN(sizeof(struct rtmsg)));
+		uint32_t values[BENCH_ROUTE_ATTRS] = { RT_TABLE_MAIN, htonl(0x0A000000 | (i << 8)), htonl(0xC0A80001), 2, i % 16 };
+		uint16_t types[BENCH_ROUTE_ATTRS] = { RTA_TABLE, RTA_DST, RTA_GATEWAY, RTA_OIF, RTA_PRIORITY };
+		int a;
+
+		memset(nlh, 0, NLMSG_LENGTH(sizeof(struct rtmsg)));
+		nlh->nlmsg_type = RTM_NEWROUTE;
+		nlh->nlmsg_flags = NLM_F_MULTI;
+		nlh->nlmsg_seq = seq;
+		rtm->rtm_family = AF_INET;
+		rtm->rtm_dst_len = 24;
+		rtm->rtm_table = RT_TABLE_MAIN;
+		rtm->rtm_protocol = RTPROT_BOOT;
+		rtm->rtm_type = RTN_UNICAST;
+
+		for( a = 0; a < BENCH_ROUTE_ATTRS; a++ ) {
+			rta->rta_type = types[a];
+			rta->rta_len = RTA_LENGTH(sizeof(uint32_t));
+			memmove(RTA_DATA(rta), &values[a], sizeof(uint32_t));
+			rta = (struct rtattr *)((char *)rta + RTA_ALIGN(rta->rta_len));
+		}
+		nlh->nlmsg_len = (uint32_t)((char *)rta - (char *)nlh);
+		nlh = (struct nlmsghdr *)((char *)nlh + NLMSG_ALIGN(nlh->nlmsg_len));
+	}
+	return (size_t)((char *)nlh - buf);
+}
+
+static double BenchNow(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static long BenchPeakRSS(void)
+{
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+	return ru.ru_maxrss;
+}
+#endif
+
+#ifdef MAIN_COMMON_NETLINK_BENCH
+
+// refresh of links, addresses and routes by new socket each time and by shared one
+static int SessionBench(int refreshes)
+{
+	int shared, run;
+
+	for( shared = 0; shared < 2; shared++ ) {
+		NetlinkStats before, after;
+		double start, elapsed;
+
+		if( shared && !OpenNetlinkSession() )
+			return 1;
+
+		GetNetlinkStats(&before);
+		start = BenchNow();
+		for( run = 0; run < refreshes; run++ ) {
+			void * nl = shared ? AcquireNetlink():OpenNetlink();
+			if( !nl || !GetLinks(nl) || !GetAddr(nl, AF_UNSPEC) || !GetRoutes(nl, AF_UNSPEC) ) {
+				fprintf(stderr, "dump failed\n");
+				return 1;
+			}
+			if( shared )
+				ReleaseNetlink(nl);
+			else
+				CloseNetlink(nl);
+		}
+		elapsed = BenchNow() - start;
+		GetNetlinkStats(&after);
+
+		printf("%s socket: %d refreshes %.3f ms each, %llu sockets opened %.3f ms each, dumps %.3f ms each\n",
+			shared ? "shared":"new   ", refreshes, elapsed*1e3/refreshes,
+			(unsigned long long)(after.opened - before.opened),
+			after.opened > before.opened ? (double)(after.open_ns - before.open_ns)/(after.opened - before.opened)/1e6:0,
+			(double)(after.dump_ns - before.dump_ns)/(after.dumps - before.dumps)/1e6);
+
+		if( shared )
+			CloseNetlinkSession();
+	}
+	return 0;
+}
+
+// route dump by one socket: receive syscalls per datagram and time of dump
+static int RecvBench(int dumps)
+{
+	void * nl = OpenNetlink();
+	NetlinkStats before, after;
+	int run;
+
+	if( !nl )
+		return 1;
+
+	for( run = 0; run < dumps; run++ ) {
+		const RouteRecord * rr;
+		int routes = 0;
+
+		GetNetlinkStats(&before);
+		rr = GetRoutes(nl, AF_UNSPEC);
+		GetNetlinkStats(&after);
+		if( !rr ) {
+			fprintf(stderr, "dump failed\n");
+			CloseNetlink(nl);
+			return 1;
+		}
+		for( ; rr->rt; rr++ )
+			routes++;
+
+		printf("run %d: %d routes %.3f ms, %llu datagrams by %llu receive syscalls\n",
+			run, routes, (double)(after.dump_ns - before.dump_ns)/1e6,
+			(unsigned long long)(after.datagrams - before.datagrams),
+			(unsigned long long)(after.recvs - before.recvs));
+	}
+	CloseNetlink(nl);
+	return 0;
+}
+
+// full route dump against dump of one table
+static int FilterBench(uint32_t table, int dumps)
+{
+	RouteFilter all = { 0 }, filter = { 0 };
+	void * nl = OpenNetlink();
+	int run, pass;
+
+	if( !nl )
+		return 1;
+
+	filter.family = AF_INET;
+	filter.table = table;
+	for( pass = 0; pass < 2; pass++ ) {
+		const RouteFilter * f = pass ? &filter:&all;
+		double start = BenchNow();
+		int routes = 0;
+
+		for( run = 0; run < dumps; run++ ) {
+			const RouteRecord * rr = GetRoutesFiltered(nl, f);
+			if( !rr ) {
+				fprintf(stderr, "dump failed\n");
+				CloseNetlink(nl);
+				return 1;
+			}
+			for( routes = 0; rr->rt; rr++ )
+				routes += RouteMatches(rr, &filter);
+		}
+		printf("%s: %d routes of table %u, %.3f ms per dump\n", pass ? "filtered":"full    ",
+			routes, table, (BenchNow() - start)*1e3/dumps);
+	}
+	CloseNetlink(nl);
+	return 0;
+}
+
+int main(int argc, char * argv[])
+{
+	if( argc > 1 && !strcmp(argv[1], "filter") )
+		return FilterBench(argc > 2 ? (uint32_t)strtoul(argv[2], 0, 10):RT_TABLE_MAIN, argc > 3 ? atoi(argv[3]):10);
+	if( argc > 1 && !strcmp(argv[1], "recv") )
+		return RecvBench(argc > 2 ? atoi(argv[2]):5);
+	if( argc > 1 && !strcmp(argv[1], "session") )
+		return SessionBench(argc > 2 ? atoi(argv[2]):1000);
+
+	uint32_t routes = argc > 1 ? (uint32_t)strtoul(argv[1], 0, 10):1000000;
+	netlink_ctx * ctx = (netlink_ctx *)OpenNetlink();
+	size_t size, legacy, used;
+	int run;
+
+	if( !ctx )
+		return 1;
+
+	size = routes * NLMSG_ALIGN(NLMSG_LENGTH(sizeof(struct rtmsg)) + BENCH_ROUTE_ATTRS*RTA_SPACE(sizeof(uint32_t)));
+	ctx->buf = (char *)realloc(ctx->buf, size);
+	if( !ctx->buf )
+		return 1;
+	ctx->rcvbufsize = size;
+
+	// the same dump is decoded several times, arena is allocated only once
+	for( run = 0; run < 3; run++ ) {
+		const RouteRecord * rr;
+		uint64_t sum = 0;
+		double start, decoded, walked;
+
+		ctx->rcvsize = (ssize_t)BenchFillRoutes(ctx->buf, routes, ++ctx->sequence_number);
+		ctx->totalmsg = 0;
+		ctx->currentMsg = 0;
+		ctx->offset = 0;
+		ctx->offsets_used = 0;
+
+		start = BenchNow();
+		if( !EnumMsg(ctx, IncrementTotalMsg) || !(rr = (const RouteRecord *)ProcessRouteMsgs(ctx)) ) {
+			fprintf(stderr, "decode failed\n");
+			return 1;
+		}
+		FixupRecords(ctx);
+		decoded = BenchNow();
+
+		for( ; rr->rt; rr++ ) {
+			struct rtattr * dst = RECORD_TB(rr, RTA_DST);
+			struct rtattr * oif = RECORD_TB(rr, RTA_OIF);
+			if( dst && oif )
+				sum += RTA_UINT32_T(dst) + RTA_UINT32_T(oif);
+		}
+		walked = BenchNow();
+
+		printf("run %d: %u routes decode %.3f ms (%.1f ns/route) lookup %.3f ms checksum %llu\n",
+			run, routes, (decoded - start)*1e3, (decoded - start)*1e9/routes,
+			(walked - decoded)*1e3, (unsigned long long)sum);
+	}
+
+	// before: nlmsghdr copy, info pointer and rtattr *tb[RTA_MAX+1] per record
+	legacy = (size_t)routes * (sizeof(struct nlmsghdr) + sizeof(void *) + sizeof(struct rtattr *)*(RTA_MAX+1));
+	used = (size_t)ctx->currentMsg*sizeof(UniversalRecord) + ctx->offsets_used*sizeof(uint32_t);
+	printf("records: %zu bytes used (%.1f per route), arena %zu bytes, full rtattr tables: %zu bytes (%.1f per route)\n",
+		used, (double)used/routes,
+		ctx->records_size*sizeof(UniversalRecord) + ctx->offsets_size*sizeof(uint32_t),
+		legacy, (double)legacy/routes);
+
+	printf("peak RSS: %ld KB (dump buffer %zu KB)\n", BenchPeakRSS(), size/1024);
+
+	CloseNetlink(ctx);
+	return 0;
+}
+#endif //MAIN_COMMON_NETLINK_BENCH
+
+#ifdef MAIN_COMMON_NETLINK_REPLAY
+
+static const void * ReplayLinks(void * nl) { return GetLinks(nl); }
+static const void * ReplayAddr(void * nl) { return GetAddr(nl, AF_UNSPEC); }
+static const void * ReplayRoutes(void * nl) { return GetRoutes(nl, AF_INET); }
+static const void * ReplayRoutes6(void * nl) { return GetRoutes(nl, AF_INET6); }
+static const void * ReplayRules(void * nl) { return GetRules(nl, AF_INET); }
+static const void * ReplayRules6(void * nl) { return GetRules(nl, AF_INET6); }
+static const void * ReplayNeighbors(void * nl) { return GetNeighbors(nl, AF_UNSPEC, 0); }
+static const void * ReplayProxyNeighbors(void * nl) { return GetNeighbors(nl, AF_UNSPEC, NTF_PROXY); }
+
+// the same dumps and order as NetInterfaces and NetRoutes request
+static const struct {
+	const char * name;
+	const void * (* get)(void * nl);
+} dumps[] = {
+	{ "link", ReplayLinks },
+	{ "addr", ReplayAddr },
+	{ "route", ReplayRoutes },
+	{ "route6", ReplayRoutes6 },
+	{ "rule", ReplayRules },
+	{ "rule6", ReplayRules6 },
+	{ "neigh", ReplayNeighbors },
+	{ "neigh proxy", ReplayProxyNeighbors },
+};
+
+// socket capture by RecordNetlink() or process wide by TraceNetlink()
+static int Record(const char * path, int process)
+{
+	void * nl = OpenNetlink();
+	size_t i;
+
+	if( !nl || !(process ? TraceNetlink(path):RecordNetlink(nl, path)) )
+		return 1;
+
+	for( i = 0; i < sizeof(dumps)/sizeof(dumps[0]); i++ ) {
+		const UniversalRecord * ur = (const UniversalRecord *)dumps[i].get(nl);
+		size_t msgs = 0;
+		for( ; ur && ur->info; ur++ )
+			msgs++;
+		printf("%-12s %zu messages%s\n", dumps[i].name, msgs, ur ? "":" (failed)");
+	}
+	CloseNetlink(nl);
+	if( process )
+		TraceNetlink(0);
+	return 0;
+}
+
+// synthetic route dump split to datagrams like kernel does
+static int Generate(const char * path, uint32_t routes)
+{
+	size_t size = routes * NLMSG_ALIGN(NLMSG_LENGTH(sizeof(struct rtmsg)) + BENCH_ROUTE_ATTRS*RTA_SPACE(sizeof(uint32_t)));
+	char * buf = (char *)malloc(size + NLMSG_SPACE(sizeof(int)));
+	netlink_ctx ctx;
+	struct nlmsghdr * nlh, * done;
+	char * start;
+	int len;
+	struct {
+		struct nlmsghdr nlh;
+		struct rtmsg rtm;
+	} req;
+
+	memset(&ctx, 0, sizeof(ctx));
+	if( !buf || !RecordNetlink(&ctx, path) )
+		return 1;
+
+	memset(&req, 0, sizeof(req));
+	req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+	req.nlh.nlmsg_type = RTM_GETROUTE;
+	req.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	req.rtm.rtm_family = AF_INET;
+	RecordPacket(ctx.record, &req, req.nlh.nlmsg_len, NLMON_PACKET_KERNEL, 0);
+
+	size = BenchFillRoutes(buf, routes, 1);
+	done = (struct nlmsghdr *)(buf + size);
+	memset(done, 0, NLMSG_SPACE(sizeof(int)));
+	done->nlmsg_len = NLMSG_LENGTH(sizeof(int));
+	done->nlmsg_type = NLMSG_DONE;
+	done->nlmsg_flags = NLM_F_MULTI;
+	size += NLMSG_SPACE(sizeof(int));
+
+	for( start = buf, nlh = (struct nlmsghdr *)buf, len = (int)size; NLMSG_OK(nlh, (unsigned int)len); ) {
+		struct nlmsghdr * next = NLMSG_NEXT(nlh, len);
+		if( (char *)next - start > NETLINK_SEND_BUFFER_SIZE ) {
+			RecordPacket(ctx.record, start, (size_t)((char *)nlh - start), NLMON_PACKET_USER, 0);
+			start = (char *)nlh;
+		}
+		nlh = next;
+	}
+	RecordPacket(ctx.record, start, (size_t)(buf + size - start), NLMON_PACKET_USER, 0);
+
+	RecordNetlink(&ctx, 0);
+	free(buf);
+	printf("%u routes, %zu bytes\n", routes, size);
+	return 0;
+}
+
+static int Replay(const char * path, int runs)
+{
+	netlink_ctx * ctx = (netlink_ctx *)OpenNetlinkReplay(path);
+	size_t i;
+
+	if( !ctx ) {
+		fprintf(stderr, "can`t load \"%s\"\n", path);
+		return 1;
+	}
+
+	printf("%-12s %10s %12s %14s %10s\n", "dump", "messages", "bytes", "messages/sec", "MB/sec");
+	for( i = 0; i < sizeof(dumps)/sizeof(dumps[0]); i++ ) {
+		uint64_t msgs = 0, bytes = ctx->replay->bytes;
+		double start = BenchNow(), elapsed;
+		int run;
+
+		for( run = 0; run < runs; run++ ) {
+			const UniversalRecord * ur = (const UniversalRecord *)dumps[i].get(ctx);
+			if( !ur )
+				break;
+			for( ; ur->info; ur++ )
+				msgs++;
+		}
+		if( run < runs ) {
+			printf("%-12s not recorded\n", dumps[i].name);
+			continue;
+		}
+
+		elapsed = BenchNow() - start;
+		bytes = ctx->replay->bytes - bytes;
+		printf("%-12s %10llu %12llu %14.0f %10.1f\n", dumps[i].name,
+			(unsigned long long)(msgs/runs), (unsigned long long)(bytes/runs),
+			msgs/elapsed, bytes/elapsed/(1024*1024));
+	}
+
+	printf("peak RSS: %ld KB\n", BenchPeakRSS());
+	CloseNetlink(ctx);
+	return 0;
+}
+
+static const char * (* DecodeAttrNames(uint16_t type, size_t * infosize))(uint16_t)
+{
+	switch( type ) {
+	case RTM_NEWLINK: case RTM_DELLINK: case RTM_GETLINK: case RTM_SETLINK:
+		*infosize = sizeof(struct ifinfomsg);
+		return iflatype;
+	case RTM_NEWADDR: case RTM_DELADDR: case RTM_GETADDR:
+		*infosize = sizeof(struct ifaddrmsg);
+		return ifatype;
+	case RTM_NEWROUTE: case RTM_DELROUTE: case RTM_GETROUTE:
+		*infosize = sizeof(struct rtmsg);
+		return rtatype;
+	case RTM_NEWRULE: case RTM_DELRULE: case RTM_GETRULE:
+		*infosize = sizeof(struct fib_rule_hdr);
+		return fratype;
+	case RTM_NEWNEIGH: case RTM_DELNEIGH: case RTM_GETNEIGH:
+		*infosize = sizeof(struct ndmsg);
+		return ndatype;
+	case RTM_NEWSTATS: case RTM_GETSTATS:
+		*infosize = sizeof(struct if_stats_msg);
+		return 0;
+	}
+	*infosize = 0;
+	return 0;
+}
+
+static void DecodeAttrs(struct rtattr * rta, int len, const char * (* name)(uint16_t))
+{
+	for( ; RTA_OK(rta, len); rta = RTA_NEXT(rta, len) ) {
+		uint16_t type = rta->rta_type & NLA_TYPE_MASK;
+		const unsigned char * data = (const unsigned char *)RTA_DATA(rta);
+		size_t i, size = RTA_PAYLOAD(rta);
+
+		printf("    %s (%u)%s len %zu", name ? name(type):"", type,
+			(rta->rta_type & NLA_F_NESTED) ? " nested":"", size);
+
+		for( i = 0; i + 1 < size && data[i] >= ' ' && data[i] < 0x7F; i++ );
+		if( size > 1 && i + 1 == size && !data[i] )
+			printf(" \"%s\"", (const char *)data);
+		else if( !(rta->rta_type & NLA_F_NESTED) && size <= 16 ) {
+			printf(" ");
+			for( i = 0; i < size; i++ )
+				printf("%02X", data[i]);
+		}
+		printf("\n");
+	}
+}
+
+// trace of TraceNetlink() or RecordNetlink() as text
+static int Decode(const char * path)
+{
+	netlink_ctx * ctx = (netlink_ctx *)OpenNetlinkReplay(path);
+	size_t i;
+
+	if( !ctx ) {
+		fprintf(stderr, "can`t load \"%s\"\n", path);
+		return 1;
+	}
+
+	for( i = 0; i < ctx->replay->count; i++ ) {
+		const ReplayPacket * pkt = &ctx->replay->packets[i];
+		struct nlmsghdr * nlh = (struct nlmsghdr *)pkt->data;
+		int len = (int)pkt->len;
+
+		printf("#%zu %u.%0*u %s portid %u %u bytes\n", i, pkt->ts_sec, ctx->replay->nsec ? 9:6, pkt->ts_frac,
+			pkt->request ? "request":"reply", pkt->portid, pkt->len);
+
+		for( ; len > 0 && NLMSG_OK(nlh, (unsigned int)len); nlh = NLMSG_NEXT(nlh, len) ) {
+			const char * (* name)(uint16_t);
+			size_t infosize;
+
+			printf("  %s (%u) len %u flags 0x%04X seq %u pid %u\n", nlmsgtype(nlh->nlmsg_type), nlh->nlmsg_type,
+				nlh->nlmsg_len, nlh->nlmsg_flags, nlh->nlmsg_seq, nlh->nlmsg_pid);
+
+			if( nlh->nlmsg_type == NLMSG_ERROR && nlh->nlmsg_len >= NLMSG_LENGTH(sizeof(struct nlmsgerr)) ) {
+				struct nlmsgerr * err = (struct nlmsgerr *)NLMSG_DATA(nlh);
+				printf("    error %d (%s) seq %u\n", err->error, err->error ? errorname(-err->error):"ACK", err->msg.nlmsg_seq);
+				continue;
+			}
+
+			name = DecodeAttrNames(nlh->nlmsg_type, &infosize);
+			if( !infosize || nlh->nlmsg_len < NLMSG_LENGTH(infosize) )
+				continue;
+			DecodeAttrs((struct rtattr *)((char *)NLMSG_DATA(nlh) + NLMSG_ALIGN(infosize)),
+				(int)(nlh->nlmsg_len - NLMSG_LENGTH(infosize)), name);
+		}
+	}
+
+	CloseNetlink(ctx);
+	return 0;
+}
+
+int main(int argc, char * argv[])
+{
+	if( argc == 3 && !strcmp(argv[1], "record") )
+		return Record(argv[2], FALSE);
+	if( argc == 3 && !strcmp(argv[1], "trace") )
+		return Record(argv[2], TRUE);
+	if( argc == 3 && !strcmp(argv[1], "decode") )
+		return Decode(argv[2]);
+	if( argc >= 3 && !strcmp(argv[1], "generate") )
+		return Generate(argv[2], argc > 3 ? (uint32_t)strtoul(argv[3], 0, 10):1000000);
+	if( argc >= 2 && strcmp(argv[1], "record") && strcmp(argv[1], "trace") && strcmp(argv[1], "generate") && strcmp(argv[1], "decode") )
+		return Replay(argv[1], argc > 2 ? atoi(argv[2]):10);
+
+	fprintf(stderr, "usage: %s record <file.pcap>            record dumps from kernel\n"
+			"       %s trace <file.pcap>             the same by process wide trace\n"
+			"       %s generate <file.pcap> [routes]  synthetic route dump\n"
+			"       %s decode <file.pcap>             print datagrams with attribute names\n"
+			"       %s <file.pcap> [runs]             replay dumps\n", argv[0], argv[0], argv[0], argv[0], argv[0]);
+	return 1;
+}
+#endif //MAIN_COMMON_NETLINK_REPLAY
@@ -450,36 +450,74 @@ const char * nlmsgtype(uint16_t type);
 #endif
 #endif
 
+// Attributes of dump record are not kept in full rtattr table (RTA_MAX+1 pointers),
+// but as bit per present attribute type and offsets from record info of present
+// attributes only, in order of types. Use RECORD_TB(record, type) to get attribute.
+#define NETLINK_ATTR_WORDS 2
+
+typedef struct {
+	uint64_t present[NETLINK_ATTR_WORDS];
+	const uint32_t * offset;
+} AttrIndex;
+
+typedef struct {
+	struct nlmsghdr nlm;
+	char * info;
+	AttrIndex attrs;
+} UniversalRecord;
+
 typedef struct {
 	struct nlmsghdr nlm;
 	struct rtmsg *rt;
-	struct rtattr *tb[RTA_MAX+1];
+	AttrIndex attrs;
 } RouteRecord;
 
 typedef struct {
 	struct nlmsghdr nlm;
 	struct ifinfomsg *ifm;
-	struct rtattr *tb[IFLA_MAX+1];
+	AttrIndex attrs;
 } LinkRecord;
 
 typedef struct {
 	struct nlmsghdr nlm;
 	struct ifaddrmsg *ifam;
-	struct rtattr *tb[IFA_MAX+1];
+	AttrIndex attrs;
 } AddrRecord;
 
 typedef struct {
 	struct nlmsghdr nlm;
 	struct fib_rule_hdr *frh;
-	struct rtattr *tb[FRA_MAX+1];
+	AttrIndex attrs;
 } RuleRecord;
 
 typedef struct {
 	struct nlmsghdr nlm;
 	struct ndmsg * ndm;
-	struct rtattr *tb[NDA_MAX+1];
+	AttrIndex attrs;
 } NeighborRecord;
 
+typedef struct {
+	struct nlmsghdr nlm;
+	struct if_stats_msg * ifsm;
+	AttrIndex attrs;
+} StatsRecord;
+
+static inline struct rtattr * GetRecordAttr(const UniversalRecord * ur, unsigned short type)
+{
+	unsigned int word = type / 64, index = 0, i;
+	uint64_t bit = (uint64_t)1 << (type % 64);
+
+	if( word >= NETLINK_ATTR_WORDS || !(ur->attrs.present[word] & bit) )
+		return 0;
+
+	for( i = 0; i < word; i++ )
+		index += __builtin_popcountll(ur->attrs.present[i]);
+	index += __builtin_popcountll(ur->attrs.present[word] & (bit - 1));
+
+	return (struct rtattr *)(ur->info + ur->attrs.offset[index]);
+}
+
+#define RECORD_TB(record, type) GetRecordAttr((const UniversalRecord *)(record), (type))
 
 #define RTA_UINT8_T(rta) *((uint8_t *)RTA_DATA(rta))
 #define RTA_UINT16_T(rta) *((uint16_t *)RTA_DATA(rta))
@@ -489,12 +527,108 @@ typedef struct {
 #define RTA_INT64_T(rta) *((int64_t *)RTA_DATA(rta))
 
 void * OpenNetlink(void);
+// dumps are served from capture file (pcap, LINKTYPE_NETLINK, e.g. recorded by nlmon
+// or RecordNetlink()) instead of kernel, for benchmarks and offline debugging
+void * OpenNetlinkReplay(const char * path);
+// write every sent request and received datagram to pcap file, NULL path stops recording
+int RecordNetlink(void * nl, const char * path);
+// the same for all rtnetlink sockets of process, opened before or after the call,
+// datagrams are only copied to buffer of trace file, "netlinkreplay decode" prints it
+int TraceNetlink(const char * path);
 void CloseNetlink(void * nl);
+
+// Request socket shared by all users of process, opened by first OpenNetlinkSession()
+// and closed by last CloseNetlinkSession(). AcquireNetlink() gives it to one user at
+// a time with receive buffer, records arena and sequence numbers of previous dumps,
+// another user or no open session gets new socket. ReleaseNetlink() returns it back,
+// or closes it if it was interrupted or has unread data.
+int OpenNetlinkSession(void);
+void CloseNetlinkSession(void);
+void * AcquireNetlink(void);
+void ReleaseNetlink(void * nl);
+
+typedef struct {
+	uint64_t opened;	// sockets opened by OpenNetlink()
+	uint64_t open_ns;	// time spent for it
+	uint64_t acquired;	// AcquireNetlink() calls
+	uint64_t reused;	// of them served by already open session socket
+	uint64_t dumps;		// requests with reply
+	uint64_t dump_ns;
+	uint64_t recvs;		// receive syscalls (recvmsg() or recvmmsg())
+	uint64_t datagrams;	// received by them
+} NetlinkStats;
+
+void GetNetlinkStats(NetlinkStats * stats);
+// TRUE if any dump on this socket was inconsistent (NLM_F_DUMP_INTR or records of
+// truncated datagram were lost), data must be requested again
+int DumpInterrupted(void * nl);
 const RouteRecord * GetRoutes(void * nl, int family);
+
+// Filter of route dump, zero fields match any route. Kernel with strict checking
+// (NETLINK_GET_STRICT_CHK, 4.20+) serializes matching routes only, e.g. 200 routes
+// of VRF table instead of full FIB. Without it all routes are dumped and filtered here.
+typedef struct {
+	uint8_t family;		// AF_UNSPEC - all
+	uint8_t protocol;	// RTPROT_*
+	uint8_t type;		// RTN_*
+	uint32_t table;		// RT_TABLE_*
+	uint32_t oif;		// any of nexthops uses this device
+} RouteFilter;
+
+const RouteRecord * GetRoutesFiltered(void * nl, const RouteFilter * filter);
+// TRUE if route matches all fields of filter
+int RouteMatches(const RouteRecord * rr, const RouteFilter * filter);
+int SameRouteFilter(const RouteFilter * a, const RouteFilter * b);
+// Route which kernel uses to reach addr (ip route get fibmatch), table is selected
+// by rules. One RTM_GETROUTE request per address, records end with zeroed record.
+const RouteRecord * GetRouteTo(void * nl, int family, const void * addr);
 const LinkRecord * GetLinks(void * nl);
 const AddrRecord * GetAddr(void *nl, int family);
 const RuleRecord * GetRules(void *nl, int family);
 const NeighborRecord * GetNeighbors(void *nl, int family, int ndm_flags);
+// RTM_GETSTATS dump (kernel 4.7+), only blocks selected by filter_mask are dumped,
+// e.g. IFLA_STATS_FILTER_BIT(IFLA_STATS_LINK_64) gives rtnl_link_stats64 of every link
+const StatsRecord * GetStats(void * nl, uint32_t filter_mask);
+
+// Change requests (RTM_NEWROUTE, RTM_DELNEIGH, ...) are packed into one batch and sent
+// by CommitRequests() with as few send() as socket buffer allows, every request is acknowledged.
+// AddRequest() returns pointer to the copy of info (rtmsg, ndmsg, ...) in the batch, 0 on error,
+// AddRequestAttr() appends attribute to the last added request
+void * AddRequest(void * nl, uint16_t type, uint16_t flags, const void * info, size_t infosize);
+int AddRequestAttr(void * nl, uint16_t type, const void * data, size_t len);
+size_t PendingRequests(void * nl);
+// DropRequests() removes requests added after the first count ones, e.g. partly built one
+void DropRequests(void * nl, size_t count);
+// CommitRequests() returns number of failed requests, -1 if batch was not sent completely.
+// errors (may be NULL, at least PendingRequests() items) receives errno or 0 for every request
+// in order of AddRequest() calls, batch is empty after commit
+int CommitRequests(void * nl, int * errors, size_t count);
+
+// rtnetlink multicast subscription (RTMGRP_*)
+#ifndef RTNLGRP_IPV6_RULE
+#define RTNLGRP_IPV6_RULE 19
+#endif
+
+// multicast forwarding cache (RTNL_FAMILY_IPMR/IP6MR routes) is notified by MROUTE groups only
+#define NETLINK_MONITOR_ROUTES (RTMGRP_LINK | RTMGRP_NEIGH | RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE | \
+				RTMGRP_IPV4_MROUTE | RTMGRP_IPV6_MROUTE | RTMGRP_IPV4_RULE)
+#define NETLINK_MONITOR_LINKS (RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR)
+
+// record points to RouteRecord, LinkRecord, AddrRecord, RuleRecord or NeighborRecord
+// by nlm->nlmsg_type and is valid only while callback is running, return 0 to stop processing
+typedef int (*NotifyCallback)(void * arg, const struct nlmsghdr * nlm, const void * record);
+
+void * OpenNetlinkMonitor(uint32_t groups);
+// ProcessNotifications() returns number of processed messages, 0 if no pending events.
+// On error -1 is returned and errno is set, ENOBUFS means that events were lost
+// and a full dump is required
+int ProcessNotifications(void * nl, NotifyCallback fn, void * arg);
+// WalkRoutes() requests route dump like GetRoutesFiltered(), but every record is
+// given to callback as soon as its datagram is received, so memory does not depend
+// on size of dump. Callback has to check RouteMatches() if kernel can not filter.
+// Returns number of processed records, -1 on error. Callback may stop walk only
+// by error, the rest of dump is still in socket then.
+int WalkRoutes(void * nl, const RouteFilter * filter, NotifyCallback fn, void * arg);
 /*
  * nla_type (16 bits)
  * +---+---+-------------------------------+
@@ -546,6 +680,8 @@ const char * iptunneloptserspantype( uint16_t type ); // LWTUNNEL_IP_OPT_ERSPAN_
 #define TUNNEL_GTP_OPT		__cpu_to_be16(0x8000)
 #endif
 
+#define TUNNELFLAGSNAME_SIZE sizeof("csum routing key seq strict rec version no key dont fragment oam crit_opts nocache gtp_opts geneve_opts vxlan_opts erspan_opts")
+const char * tunnelflagsname_r(uint16_t flags, char * buf, size_t size); // TUNNEL_
 const char * tunnelflagsname(uint16_t flags); // TUNNEL_
 
 /* Values of protocol >= RTPROT_STATIC are not interpreted by kernel;
@@ -577,6 +713,8 @@ const char * tunnelflagsname(uint16_t flags); // TUNNEL_
 #define RTPROT_ISIS		187	/* ISIS Routes */
 #endif
 
+#define RTPROTOCOLTYPE_SIZE sizeof("255")
+const char * rtprotocoltype_r(uint8_t type, char * buf, size_t size); // RTPROT_
 const char * rtprotocoltype( uint8_t type ); // RTPROT_
 
 //RT_SCOPE_UNIVERSE (0): глобальный адрес
@@ -585,7 +723,11 @@ const char * rtprotocoltype( uint8_t type ); // RTPROT_
 //RT_SCOPE_HOST (254): адрес хоста
 //RT_SCOPE_NOWHERE (255): неизвестный адрес
 
+#define RTSCOPETYPE_SIZE sizeof("255")
+const char * rtscopetype_r(uint8_t scope, char * buf, size_t size); //RT_SCOPE_
 const char * rtscopetype(uint8_t scope); //RT_SCOPE_
+#define RTICMP6PREF_SIZE sizeof("255")
+const char * rticmp6pref_r(uint8_t pref, char * buf, size_t size); // ICMPV6_ROUTER_PREF_
 const char * rticmp6pref(uint8_t pref); // ICMPV6_ROUTER_PREF_
 
 int FillAttr(struct rtattr *rta, struct rtattr **tb, unsigned short max, unsigned short flagsmask, int len, const char * (*typeprint)(uint16_t type));
@@ -675,11 +817,17 @@ typedef struct {
 int FillEncap(Encap * enc, struct rtattr * rta);
 
 const char * rttype(unsigned char rtm_type);
+#define RTRULETABLE_SIZE sizeof("4294967295")
+const char * rtruletable_r(uint32_t table, char * buf, size_t size);
 const char * rtruletable(uint32_t table);
 const char * fractionrule( uint8_t action ); // FR_ACT_ + RTN_
+#define FIBRULEFLAGSNAME_SIZE sizeof("PERMANENT, INVERT, UNRESOLVED, IIF_DETACHED, OIF_DETACHED, FIND_SADDR, 0xFFFFFFFF")
+const char * fibruleflagsname_r(uint32_t flags, char * buf, size_t size); // FIB_RULE_
 const char * fibruleflagsname(uint32_t flags); // FIB_RULE_
 const char * ndmsgstate(uint16_t state); // NUD_
 
+#define LWTUNNELENCAPTYPE_SIZE sizeof("65535")
+const char * lwtunnelencaptype_r(uint16_t type, char * buf, size_t size); // LWTUNNEL_ENCAP_
 const char * lwtunnelencaptype(uint16_t type); // LWTUNNEL_ENCAP_
 const char * mplsiptunneltype(uint16_t type); //MPLS_IPTUNNEL_
 
@@ -700,6 +848,8 @@ void mpls_ntop(const struct mpls_label *addr, char * buf, size_t destlen);
 #endif
 
 
+#define RTNHFLAGSNAME_SIZE sizeof("dead, onlink, pervasive, offload, trap, linkdown, unresolved, 0xFF")
+const char * rtnhflagsname_r(uint8_t flags, char * buf, size_t size); // RTNH_F_
 const char * rtnhflagsname(uint8_t flags); // RTNH_F_
 
 #ifndef NTF_STICKY
@@ -1,4 +1,5 @@
 #include "netutils.h"
+#include <ctype.h>
 
 const char * iprotocolname(uint8_t proto)
 {
@@ -189,38 +190,69 @@ const char * iprotocolname(uint8_t proto)
 	return "";
 }
 
-const char * ifflagsname(uint32_t flags)
+const char * flagsname_r(const FlagName * names, const char * separator, uint32_t flags, char * buf, size_t size)
 {
-	static char buf[sizeof("UP, BROADCAST, DEBUG, LOOPBACK, POINTOPOINT, NOTRAILERS, RUNNING, NOARP, PROMISC, ALLMULTI, OACTIVE, SIMPLEX, MULTICAST, PORTSEL, AUTOMEDIA, DYNAMIC, LOWER_UP, DORMANT, ECHO")] = {0};
+	size_t len = 0;
+	int res;
+
+	if( !size )
+		return buf;
 	buf[0] = '\0';
-	flags = addflag(buf, "UP", flags, IFF_UP);
-	flags = addflag(buf, "BROADCAST", flags, IFF_BROADCAST);
-	flags = addflag(buf, "DEBUG", flags, IFF_DEBUG);
-	flags = addflag(buf, "LOOPBACK", flags, IFF_LOOPBACK);
-	flags = addflag(buf, "POINTOPOINT", flags, IFF_POINTOPOINT);
-	flags = addflag(buf, "NOTRAILERS", flags, IFF_NOTRAILERS);
-	flags = addflag(buf, "RUNNING", flags, IFF_RUNNING);
-	flags = addflag(buf, "NOARP", flags, IFF_NOARP);
-	flags = addflag(buf, "PROMISC", flags, IFF_PROMISC);
-	flags = addflag(buf, "ALLMULTI", flags, IFF_ALLMULTI);
+	for( ; names->flag && flags && len < size; names++ ) {
+		if( !(flags & names->flag) )
+			continue;
+		flags &= ~names->flag;
+		res = snprintf(buf + len, size - len, "%s%s", len ? separator:"", names->name);
+		if( res < 0 )
+			break;
+		len += res;
+	}
+	// bits without name
+	if( flags && len < size )
+		snprintf(buf + len, size - len, "%s0x%X", len ? separator:"", flags);
+	return buf;
+}
+
+static const FlagName ifflags_names[] = {
+	{ IFF_UP, "UP" },
+	{ IFF_BROADCAST, "BROADCAST" },
+	{ IFF_DEBUG, "DEBUG" },
+	{ IFF_LOOPBACK, "LOOPBACK" },
+	{ IFF_POINTOPOINT, "POINTOPOINT" },
+	{ IFF_NOTRAILERS, "NOTRAILERS" },
+	{ IFF_RUNNING, "RUNNING" },
+	{ IFF_NOARP, "NOARP" },
+	{ IFF_PROMISC, "PROMISC" },
+	{ IFF_ALLMULTI, "ALLMULTI" },
 #if !defined(__APPLE__) && !defined(__FreeBSD__)
-	flags = addflag(buf, "MASTER", flags, IFF_MASTER);
-	flags = addflag(buf, "SLAVE", flags, IFF_SLAVE);
-	flags = addflag(buf, "PORTSEL", flags, IFF_PORTSEL);
-	flags = addflag(buf, "AUTOMEDIA", flags, IFF_AUTOMEDIA);
-	flags = addflag(buf, "DYNAMIC", flags, IFF_DYNAMIC);
-	flags = addflag(buf, "LOWER_UP", flags, IFF_LOWER_UP);
-	flags = addflag(buf, "DORMANT", flags, IFF_DORMANT);
-	flags = addflag(buf, "ECHO", flags, IFF_ECHO);
+	{ IFF_MASTER, "MASTER" },
+	{ IFF_SLAVE, "SLAVE" },
+	{ IFF_PORTSEL, "PORTSEL" },
+	{ IFF_AUTOMEDIA, "AUTOMEDIA" },
+	{ IFF_DYNAMIC, "DYNAMIC" },
+	{ IFF_LOWER_UP, "LOWER_UP" },
+	{ IFF_DORMANT, "DORMANT" },
+	{ IFF_ECHO, "ECHO" },
 #else
-	flags = addflag(buf, "OACTIVE", flags, IFF_OACTIVE); /* transmission in progress */
-	flags = addflag(buf, "SIMPLEX", flags, IFF_SIMPLEX); /* can't hear own transmissions */
-	flags = addflag(buf, "LINK0", flags, IFF_LINK0); /* per link layer defined bit */
-	flags = addflag(buf, "LINK1", flags, IFF_LINK1); /* per link layer defined bit */
-	flags = addflag(buf, "ALTPHYS", flags, IFF_ALTPHYS); /* use alternate physical connection #define IFF_ALTPHYS     IFF_LINK2 */
+	{ IFF_OACTIVE, "OACTIVE" }, /* transmission in progress */
+	{ IFF_SIMPLEX, "SIMPLEX" }, /* can't hear own transmissions */
+	{ IFF_LINK0, "LINK0" }, /* per link layer defined bit */
+	{ IFF_LINK1, "LINK1" }, /* per link layer defined bit */
+	{ IFF_ALTPHYS, "ALTPHYS" }, /* use alternate physical connection #define IFF_ALTPHYS     IFF_LINK2 */
 #endif
-	flags = addflag(buf, "MULTICAST", flags, IFF_MULTICAST);
-	return buf;
+	{ IFF_MULTICAST, "MULTICAST" },
+	{ 0, 0 }
+};
+
+const char * ifflagsname_r(uint32_t flags, char * buf, size_t size)
+{
+	return flagsname_r(ifflags_names, ", ", flags, buf, size);
+}
+
+const char * ifflagsname(uint32_t flags)
+{
+	static __thread char buf[IFFLAGSNAME_SIZE];
+	return ifflagsname_r(flags, buf, sizeof(buf));
 }
 
 const char * ipfamilyname(char family)
@@ -736,23 +768,31 @@ const char * inet6flags(uint32_t iflags)
 	return buf;
 }
 
+static const FlagName ifaddrflags_names[] = {
+	{ IFA_F_SECONDARY, "SECONDARY" },
+	{ IFA_F_NODAD, "NODAD" },
+	{ IFA_F_OPTIMISTIC, "OPTIMISTIC" },
+	{ IFA_F_DADFAILED, "DADFAILED" },
+	{ IFA_F_HOMEADDRESS, "HOMEADDRESS" },
+	{ IFA_F_DEPRECATED, "DEPRECATED" },
+	{ IFA_F_TENTATIVE, "TENTATIVE" },
+	{ IFA_F_PERMANENT, "PERMANENT" },
+	{ IFA_F_MANAGETEMPADDR, "MANAGETEMPADDR" },
+	{ IFA_F_NOPREFIXROUTE, "NOPREFIXROUTE" },
+	{ IFA_F_MCAUTOJOIN, "MCAUTOJOIN" },
+	{ IFA_F_STABLE_PRIVACY, "STABLE_PRIVACY" },
+	{ 0, 0 }
+};
+
+const char * ifaddrflags_r(uint32_t iflags, char * buf, size_t size)
+{
+	return flagsname_r(ifaddrflags_names, ", ", iflags, buf, size);
+}
+
 const char * ifaddrflags(uint32_t iflags)
 {
-	static char buf[sizeof("SECONDARY, NODAD, OPTIMISTIC, DADFAILED, HOMEADDRESS, DEPRECATED, TENTATIVE, PERMANENT, MANAGETEMPADDR, NOPREFIXROUTE, MCAUTOJOIN, STABLE_PRIVACY")] = {0};
-	buf[0] = '\0';
-	iflags = addflag(buf, "SECONDARY", iflags, IFA_F_SECONDARY);
-	iflags = addflag(buf, "NODAD", iflags, IFA_F_NODAD);
-	iflags = addflag(buf, "OPTIMISTIC", iflags, IFA_F_OPTIMISTIC);
-	iflags = addflag(buf, "DADFAILED", iflags, IFA_F_DADFAILED);
-	iflags = addflag(buf, "HOMEADDRESS", iflags, IFA_F_HOMEADDRESS);
-	iflags = addflag(buf, "DEPRECATED", iflags, IFA_F_DEPRECATED);
-	iflags = addflag(buf, "TENTATIVE", iflags, IFA_F_TENTATIVE);
-	iflags = addflag(buf, "PERMANENT", iflags, IFA_F_PERMANENT);
-	iflags = addflag(buf, "MANAGETEMPADDR", iflags, IFA_F_MANAGETEMPADDR);
-	iflags = addflag(buf, "NOPREFIXROUTE", iflags, IFA_F_NOPREFIXROUTE);
-	iflags = addflag(buf, "MCAUTOJOIN", iflags, IFA_F_MCAUTOJOIN);
-	iflags = addflag(buf, "STABLE_PRIVACY", iflags, IFA_F_STABLE_PRIVACY);
-	return buf;
+	static __thread char buf[IFADDRFLAGS_SIZE];
+	return ifaddrflags_r(iflags, buf, sizeof(buf));
 }
 
 const char * ipv6genmodeflags(uint8_t iflags) // IN6_ADDR_GEN_MODE_
@@ -848,6 +888,22 @@ const char * IpBitsToMask(uint32_t bits, char * buffer, size_t maxlen)
     return "0.0.0.0";
 }
 
+size_t MacToBin(const char * mac, uint8_t * buffer, size_t maxlen)
+{
+	size_t len = 0;
+	unsigned int byte;
+	int n;
+
+	while( len < maxlen && isxdigit((unsigned char)*mac) && sscanf(mac, "%2x%n", &byte, &n) == 1 ) {
+		buffer[len++] = (uint8_t)byte;
+		mac += n;
+		if( *mac != ':' )
+			break;
+		mac++;
+	}
+	return *mac ? 0:len;
+}
+
 #if !defined(__APPLE__) && !defined(__FreeBSD__)
 
 #define RTF_NOTCACHED   0x0400
@@ -855,7 +911,7 @@ const char * IpBitsToMask(uint32_t bits, char * buffer, size_t maxlen)
 
 const char * RouteFlagsToString(uint32_t iflags, int ipv6)
 {
-	static char flags[64] = {0};
+	static __thread char flags[64] = {0};
 	/* Decode the flags. */
 	flags[0] = '\0';
 
@@ -969,7 +1025,7 @@ const char * RouteFlagsToString(uint32_t iflags, int ipv6)
 		{ RTF_GLOBAL,	'g' },
 		{ 0 }
 	};
-	static char name[33];
+	static __thread char name[33];
 	char *flags;
 	const struct bits *p = bits;
 	for( flags = name; p->b_mask; p++)
@@ -993,7 +1049,11 @@ int main(int argc, char * argv[])
 	char buf[sizeof("255.255.255.255")] = {0};
 	LOG_INFO("familyname(AF_INET6) %s\n", familyname(AF_INET6));
 	LOG_INFO("familyname(255) %s\n", familyname((char)255));
+	char flags[IFFLAGSNAME_SIZE], small[sizeof("UP, BROAD")];
 	LOG_INFO("ifflagsname(-1) %s\n", ifflagsname((uint32_t)-1));
+	LOG_INFO("ifflagsname_r(-1) %s\n", ifflagsname_r((uint32_t)-1, flags, sizeof(flags)));
+	LOG_INFO("ifflagsname_r(0x3, small) \"%s\"\n", ifflagsname_r(0x3, small, sizeof(small)));
+	LOG_INFO("ifaddrflags_r(0x80000081) %s\n", ifaddrflags_r(0x80000081, flags, sizeof(flags)));
 	LOG_INFO("ethprotoname(0x0800) %s\n", ethprotoname(0x0800));
 	LOG_INFO("ethprotoname(0x86dd) %s\n", ethprotoname(0x86dd));
 	LOG_INFO("ethprotoname(0xdddd) %s\n", ethprotoname(0xdddd));
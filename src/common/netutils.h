@@ -235,13 +235,29 @@ extern "C" {
 #define ARPHRD_CAN	280		/* Controller Area Network      */
 #endif
 
+// flag and its name, table ends by { 0, 0 }
+typedef struct {
+	uint32_t flag;
+	const char * name;
+} FlagName;
+
+// Reentrant formatters (*_r) write to buf of size bytes and return it or constant name,
+// result is truncated by size, *_SIZE is enough for any value. Functions without _r
+// return buffer of calling thread, it is valid until next call of the same function.
+
+// names of set flags by separator, bits without name as hex number
+const char * flagsname_r(const FlagName * names, const char * separator, uint32_t flags, char * buf, size_t size);
+
+#define IFFLAGSNAME_SIZE sizeof("UP, BROADCAST, DEBUG, LOOPBACK, POINTOPOINT, NOTRAILERS, RUNNING, NOARP, PROMISC, ALLMULTI, MASTER, SLAVE, PORTSEL, AUTOMEDIA, DYNAMIC, LOWER_UP, DORMANT, ECHO, MULTICAST, 0xFFFFFFFF")
+const char * ifflagsname_r(uint32_t flags, char * buf, size_t size); // IFF_
 const char * ifflagsname(uint32_t flags); // IFF_
 uint32_t addflag(char * buf, const char * name, uint32_t flags, uint32_t flag);
 uint32_t addflag_space_separator(char * buf, const char * name, uint32_t flags, uint32_t flag);
-const char * ifflagsname(uint32_t flags);
 uint8_t Ip6MaskToBits(const char * mask);
 uint8_t IpMaskToBits(const char * mask);
 const char * IpBitsToMask(uint32_t bits, char * buffer, size_t maxlen);
+// "aa:bb:cc:dd:ee:ff" of any length to bytes, returns number of bytes, 0 on error
+size_t MacToBin(const char * mac, uint8_t * buffer, size_t maxlen);
 const char * RouteFlagsToString(uint32_t iflags, int is_ipv6 );
 
 #ifndef RTNL_FAMILY_IPMR
@@ -299,7 +315,9 @@ const char * vlanflags(uint32_t vflags); // VLAN_FLAG_ https://www.juniper.net/d
 // IFA_F_NOPREFIXROUTE - не использовать префикс маршрута.
 // IFA_F_MCAUTOJOIN означает, что адрес является адресом мультикаста и будет автоматически присоединен к соответствующей группе мультикаста при отправке пакетов на этот адрес
 // IFA_F_STABLE_PRIVACY означает, что адрес является стабильным и не изменится в течение жизни интерфейса. Это означает, что адрес не будет меняться при перезагрузке или перезапуске интерфейса.
-const char * ifaddrflags(uint32_t iflags); // IFA_F_ 
+#define IFADDRFLAGS_SIZE sizeof("SECONDARY, NODAD, OPTIMISTIC, DADFAILED, HOMEADDRESS, DEPRECATED, TENTATIVE, PERMANENT, MANAGETEMPADDR, NOPREFIXROUTE, MCAUTOJOIN, STABLE_PRIVACY, 0xFFFFFFFF")
+const char * ifaddrflags_r(uint32_t iflags, char * buf, size_t size); // IFA_F_
+const char * ifaddrflags(uint32_t iflags); // IFA_F_
 
 
 #ifndef IF_RA_OTHERCONF
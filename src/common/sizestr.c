@@ -11,60 +11,76 @@
     #error "Environment not 32 or 64-bit."
 #endif
 
-extern const char * size_to_str(unsigned long long size)
+static const char * units[] = {
+	"B",
+	"Kb",
+	"Mb",
+	"Gb",
+	"Tb",
+	"Eb",
+	"Zb"
+};
+
+static const struct {
+	const char * fmt;
+	uint64_t divider;
+} prtime[] = {
+	{LLFMT " days ", 86400000},
+	{LLFMT " hours ", 3600000},
+	{LLFMT " min ", 60000},
+	{LLFMT " sec ", 1000},
+	{LLFMT " ms", 1}
+};
+
+const char * size_to_str_r(unsigned long long size, char * buf, size_t maxlen)
 {
-	static const char * units[] = {
-		"B",
-		"Kb",
-		"Mb",
-		"Gb",
-		"Tb",
-		"Eb",
-		"Zb"
-	};
-	static char buf[sizeof("3.1415926535897932384626433832795028841971693993751058209749445923078 Zb")] = {0};
 	int offset = 0;
 	long double print_size = size;
 	while( (size/1024) && (print_size = print_size/1024.0) && (size = size/1024) && ++offset );
 
-	if( offset && snprintf(buf, sizeof(buf), "%.3Lg %s", print_size, units[offset]) > 0 )
+	if( offset && snprintf(buf, maxlen, "%.3Lg %s", print_size, units[offset]) > 0 )
 		return buf;
 
-	if( snprintf(buf, sizeof(buf), "%llu %s", size, units[offset]) > 0 )
+	if( snprintf(buf, maxlen, "%llu %s", size, units[offset]) > 0 )
 		return buf;
 
 	return "ERROR";
+}
 
+extern const char * size_to_str(unsigned long long size)
+{
+	static __thread char buf[SIZE_TO_STR_SIZE];
+	return size_to_str_r(size, buf, sizeof(buf));
 }
 
-const char * msec_to_str(uint64_t msec)
+const char * msec_to_str_r(uint64_t msec, char * buf, size_t maxlen)
 {
-	static char buf[sizeof("213503982334 days 24 hours 60 min 999 sec 999 ms")] = {0};
-	const static struct {
-		const char * fmt;
-		uint64_t divider;
-	} prtime[] = {
-		{LLFMT " days ", 86400000},
-		{LLFMT " hours ", 3600000},
-		{LLFMT " min ", 60000},
-		{LLFMT " sec ", 1000},
-		{LLFMT " ms", 1}
-	};
-	int i, offset = 0;
+	size_t i, offset = 0;
+	int res;
 
+	if( !maxlen )
+		return "";
 	buf[0] = 0;
-	for( i=0; i < sizeof(prtime)/sizeof(prtime[0]); i++ ) {
-		if( offset >= 0 && (msec / prtime[i].divider) ) {
-			offset += snprintf(buf + offset,
-					   sizeof(buf) - offset,
+	for( i=0; i < sizeof(prtime)/sizeof(prtime[0]) && offset < maxlen; i++ ) {
+		if( msec / prtime[i].divider ) {
+			if( (res = snprintf(buf + offset,
+					   maxlen - offset,
 					   prtime[i].fmt,
-					   msec/prtime[i].divider);
+					   msec/prtime[i].divider)) < 0 )
+				break;
+			offset += res;
 			msec = msec % prtime[i].divider;
 		}
 	}
 	return buf;
 }
 
+const char * msec_to_str(uint64_t msec)
+{
+	static __thread char buf[MSEC_TO_STR_SIZE];
+	return msec_to_str_r(msec, buf, sizeof(buf));
+}
+
 #ifdef MAIN_COMMON_SIZESTR
 
 #define LOG_FILE "/tmp/log.log"
@@ -98,6 +114,11 @@ int main(int argc, char * argv[])
 	LOG_INFO_CONSOLE("%s\n", msec_to_str(100000000003ull));
 	LOG_INFO_CONSOLE("%s\n", msec_to_str(17792387055516ull));
 	LOG_INFO_CONSOLE("%s\n", msec_to_str(18446744073709551615ull));
+
+	char buf[MSEC_TO_STR_SIZE], small[sizeof("1 days 3")];
+	LOG_INFO_CONSOLE("%s\n", size_to_str_r(18446744073709551615ull, buf, sizeof(buf)));
+	LOG_INFO_CONSOLE("%s\n", msec_to_str_r(18446744073709551615ull, buf, sizeof(buf)));
+	LOG_INFO_CONSOLE("\"%s\"\n", msec_to_str_r(100000000003ull, small, sizeof(small)));
 	return 0;
 }
 #endif // MAIN_COMMON_SIZESTR
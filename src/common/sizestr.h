@@ -6,8 +6,15 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <stddef.h>
 
+// *_r write to buf of maxlen bytes, functions without _r return buffer of calling thread
+#define SIZE_TO_STR_SIZE sizeof("1.02e+03 Zb")
+#define MSEC_TO_STR_SIZE sizeof("213503982334 days 24 hours 60 min 999 sec 999 ms")
+
+extern const char * size_to_str_r(unsigned long long size, char * buf, size_t maxlen);
 extern const char * size_to_str(unsigned long long size);
+extern const char * msec_to_str_r(uint64_t msec, char * buf, size_t maxlen);
 extern const char * msec_to_str(uint64_t msec);
 
 #define SEC_TO_MS(sec) (((uint64_t)sec)*1000)
@@ -0,0 +1,278 @@
+#include "widestr.h"
+#include <stdint.h>
+
+// SIMD kernels only for 32-bit wchar_t, short strings are converted by plain loop
+#if (defined(__x86_64__) || defined(__i386__)) && WCHAR_MAX > 0xFFFF
+#include <immintrin.h>
+#define WIDESTR_SIMD
+#define WIDESTR_SSE2_MIN 16
+#define WIDESTR_AVX2_MIN 32
+#endif
+
+static void widen_scalar(wchar_t * dst, const char * src, size_t len)
+{
+	for( size_t i = 0; i < len; i++ )
+		dst[i] = (wchar_t)(unsigned char)src[i];
+}
+
+static void narrow_scalar(char * dst, const wchar_t * src, size_t len)
+{
+	for( size_t i = 0; i < len; i++ )
+		dst[i] = (char)(src[i] & 0xFF);
+}
+
+#ifdef WIDESTR_SIMD
+__attribute__((target("sse2")))
+static void widen_sse2(wchar_t * dst, const char * src, size_t len)
+{
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+
+	for( ; i + 16 <= len; i += 16 ) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i lo = _mm_unpacklo_epi8(v, zero);
+		__m128i hi = _mm_unpackhi_epi8(v, zero);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_unpacklo_epi16(lo, zero));
+		_mm_storeu_si128((__m128i *)(dst + i + 4), _mm_unpackhi_epi16(lo, zero));
+		_mm_storeu_si128((__m128i *)(dst + i + 8), _mm_unpacklo_epi16(hi, zero));
+		_mm_storeu_si128((__m128i *)(dst + i + 12), _mm_unpackhi_epi16(hi, zero));
+	}
+	widen_scalar(dst + i, src + i, len - i);
+}
+
+__attribute__((target("sse2")))
+static void narrow_sse2(char * dst, const wchar_t * src, size_t len)
+{
+	const __m128i mask = _mm_set1_epi32(0xFF);
+	size_t i = 0;
+
+	for( ; i + 16 <= len; i += 16 ) {
+		__m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + i)), mask);
+		__m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + i + 4)), mask);
+		__m128i c = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + i + 8)), mask);
+		__m128i d = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + i + 12)), mask);
+		// values are 0...255, so saturation does not change them
+		__m128i v = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+		_mm_storeu_si128((__m128i *)(dst + i), v);
+	}
+	narrow_scalar(dst + i, src + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static void widen_avx2(wchar_t * dst, const char * src, size_t len)
+{
+	size_t i = 0;
+
+	for( ; i + 32 <= len; i += 32 ) {
+		_mm256_storeu_si256((__m256i *)(dst + i), _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(src + i))));
+		_mm256_storeu_si256((__m256i *)(dst + i + 8), _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(src + i + 8))));
+		_mm256_storeu_si256((__m256i *)(dst + i + 16), _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(src + i + 16))));
+		_mm256_storeu_si256((__m256i *)(dst + i + 24), _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(src + i + 24))));
+	}
+	widen_sse2(dst + i, src + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static void narrow_avx2(char * dst, const wchar_t * src, size_t len)
+{
+	const __m256i mask = _mm256_set1_epi32(0xFF);
+	// packs work inside of 128-bit lanes, dwords of result are restored to order of source
+	const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	size_t i = 0;
+
+	for( ; i + 32 <= len; i += 32 ) {
+		__m256i a = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(src + i)), mask);
+		__m256i b = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(src + i + 8)), mask);
+		__m256i c = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(src + i + 16)), mask);
+		__m256i d = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(src + i + 24)), mask);
+		__m256i v = _mm256_packus_epi16(_mm256_packus_epi32(a, b), _mm256_packus_epi32(c, d));
+		_mm256_storeu_si256((__m256i *)(dst + i), _mm256_permutevar8x32_epi32(v, order));
+	}
+	narrow_sse2(dst + i, src + i, len - i);
+}
+#endif
+
+void widen_ascii(wchar_t * dst, const char * src, size_t len)
+{
+#ifdef WIDESTR_SIMD
+	if( len >= WIDESTR_AVX2_MIN && __builtin_cpu_supports("avx2") ) {
+		widen_avx2(dst, src, len);
+		return;
+	}
+	if( len >= WIDESTR_SSE2_MIN && __builtin_cpu_supports("sse2") ) {
+		widen_sse2(dst, src, len);
+		return;
+	}
+#endif
+	widen_scalar(dst, src, len);
+}
+
+void narrow_ascii(char * dst, const wchar_t * src, size_t len)
+{
+#ifdef WIDESTR_SIMD
+	if( len >= WIDESTR_AVX2_MIN && __builtin_cpu_supports("avx2") ) {
+		narrow_avx2(dst, src, len);
+		return;
+	}
+	if( len >= WIDESTR_SSE2_MIN && __builtin_cpu_supports("sse2") ) {
+		narrow_sse2(dst, src, len);
+		return;
+	}
+#endif
+	narrow_scalar(dst, src, len);
+}
+
+#ifdef MAIN_COMMON_WIDESTR_BENCH
+// built by g++ to compare with former conversion by temporary std::string
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+
+static double BenchNow(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static std::wstring towstr_old(const char * name)
+{
+	std::string _s(name);
+	return std::wstring(_s.begin(), _s.end());
+}
+
+static std::string tostr_old(const wchar_t * name)
+{
+	std::wstring _s(name);
+	return std::string(_s.begin(), _s.end());
+}
+
+typedef void (* WidenFn)(wchar_t * dst, const char * src, size_t len);
+typedef void (* NarrowFn)(char * dst, const wchar_t * src, size_t len);
+
+static const struct {
+	const char * name;
+	WidenFn widen;
+	NarrowFn narrow;
+	bool avx2;
+} kernels[] = {
+	{"scalar", widen_scalar, narrow_scalar, false},
+#ifdef WIDESTR_SIMD
+	{"sse2", widen_sse2, narrow_sse2, false},
+	{"avx2", widen_avx2, narrow_avx2, true},
+#endif
+	{"dispatch", widen_ascii, narrow_ascii, false}
+};
+
+#define KERNELS (sizeof(kernels)/sizeof(kernels[0]))
+#define MAX_LEN 256
+
+// every kernel on all byte values, lengths and offsets
+static int Check(void)
+{
+	char src[MAX_LEN + 8], back[MAX_LEN + 8];
+	wchar_t wide[MAX_LEN + 8];
+
+	for( size_t k = 0; k < KERNELS; k++ ) {
+#ifdef WIDESTR_SIMD
+		if( kernels[k].avx2 && !__builtin_cpu_supports("avx2") )
+			continue;
+#endif
+		for( size_t off = 0; off < 4; off++ ) {
+			for( size_t len = 0; len <= MAX_LEN; len++ ) {
+				for( size_t i = 0; i < sizeof(src); i++ )
+					src[i] = (char)(i * 7 + len + off);
+				wmemset(wide, L'#', MAX_LEN + 8);
+				memset(back, '#', sizeof(back));
+
+				kernels[k].widen(wide + off, src + off, len);
+				for( size_t i = 0; i < len; i++ ) {
+					if( wide[off + i] != (wchar_t)(unsigned char)src[off + i] ) {
+						fprintf(stderr, "%s widen len %u off %u at %u\n", kernels[k].name, (unsigned)len, (unsigned)off, (unsigned)i);
+						return 1;
+					}
+				}
+				if( wide[off + len] != L'#' || (off && wide[off - 1] != L'#') ) {
+					fprintf(stderr, "%s widen len %u off %u out of bounds\n", kernels[k].name, (unsigned)len, (unsigned)off);
+					return 1;
+				}
+
+				// high bits are dropped
+				for( size_t i = 0; i < len; i++ )
+					wide[off + i] |= (wchar_t)(i << 8);
+				kernels[k].narrow(back + off, wide + off, len);
+				if( memcmp(back + off, src + off, len) || back[off + len] != '#' || (off && back[off - 1] != '#') ) {
+					fprintf(stderr, "%s narrow len %u off %u\n", kernels[k].name, (unsigned)len, (unsigned)off);
+					return 1;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+// widestrbench [iterations] - ns per string by length
+int main(int argc, char * argv[])
+{
+	int iterations = argc > 1 ? atoi(argv[1]):2000000;
+	static const size_t lengths[] = { 4, 15, 39, 64, 256 };
+	char src[MAX_LEN + 1], back[MAX_LEN + 1];
+	wchar_t wide[MAX_LEN + 1];
+	volatile size_t sink = 0;
+
+	if( Check() )
+		return 1;
+	printf("check ok, avx2 %s\n", __builtin_cpu_supports("avx2") ? "yes":"no");
+
+	for( auto len : lengths ) {
+		for( size_t i = 0; i < len; i++ )
+			src[i] = "0123456789abcdef:./"[i % 19];
+		src[len] = 0;
+		widen_ascii(wide, src, len + 1);
+
+		double start = BenchNow();
+		for( int n = 0; n < iterations; n++ )
+			sink += towstr_old(src).size();
+		double widen = BenchNow() - start;
+		start = BenchNow();
+		for( int n = 0; n < iterations; n++ )
+			sink += tostr_old(wide).size();
+		double narrow = BenchNow() - start;
+		printf("len %3u %-9s widen %7.2f ns, narrow %7.2f ns\n", (unsigned)len, "old", widen * 1e9 / iterations, narrow * 1e9 / iterations);
+
+		start = BenchNow();
+		for( int n = 0; n < iterations; n++ )
+			sink += towstr(src).size();
+		widen = BenchNow() - start;
+		start = BenchNow();
+		for( int n = 0; n < iterations; n++ )
+			sink += tostr(wide).size();
+		narrow = BenchNow() - start;
+		printf("len %3u %-9s widen %7.2f ns, narrow %7.2f ns\n", (unsigned)len, "towstr", widen * 1e9 / iterations, narrow * 1e9 / iterations);
+
+		// into preallocated buffers
+		for( size_t k = 0; k < KERNELS; k++ ) {
+#ifdef WIDESTR_SIMD
+			if( kernels[k].avx2 && !__builtin_cpu_supports("avx2") )
+				continue;
+#endif
+			start = BenchNow();
+			for( int n = 0; n < iterations; n++ ) {
+				kernels[k].widen(wide, src, len);
+				sink += wide[n % len];
+			}
+			widen = BenchNow() - start;
+			start = BenchNow();
+			for( int n = 0; n < iterations; n++ ) {
+				kernels[k].narrow(back, wide, len);
+				sink += back[n % len];
+			}
+			narrow = BenchNow() - start;
+			printf("len %3u %-9s widen %7.2f ns, narrow %7.2f ns\n", (unsigned)len, kernels[k].name, widen * 1e9 / iterations, narrow * 1e9 / iterations);
+		}
+	}
+	return 0;
+}
+#endif // MAIN_COMMON_WIDESTR_BENCH
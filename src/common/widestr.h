@@ -0,0 +1,41 @@
+#ifndef __COMMON_WIDESTR_H__
+#define __COMMON_WIDESTR_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <wchar.h>
+
+// Conversion of ASCII strings (interface names, addresses, kernel names of
+// tables and protocols) without locale: byte is widened by zero extension and
+// wide char is narrowed to its low byte. len chars are written, no terminator.
+extern void widen_ascii(wchar_t * dst, const char * src, size_t len);
+extern void narrow_ascii(char * dst, const wchar_t * src, size_t len);
+
+#ifdef __cplusplus
+}
+
+#include <string.h>
+#include <string>
+
+// towstr/tostr can use only for ASCII symbols
+inline std::wstring towstr(const char * name)
+{
+	size_t len = strlen(name);
+	std::wstring s(len, L'\0');
+	widen_ascii(&s[0], name, len);
+	return s;
+}
+
+inline std::string tostr(const wchar_t * name)
+{
+	size_t len = wcslen(name);
+	std::string s(len, '\0');
+	narrow_ascii(&s[0], name, len);
+	return s;
+}
+#endif
+
+#endif // __COMMON_WIDESTR_H__
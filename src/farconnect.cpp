@@ -59,6 +59,7 @@ SHAREDSYMBOL int WINAPI _export ProcessEventW(HANDLE hPlugin,int event,void *par
 		clock_t t1 = clock();
 		LOG_INFO("FE_IDLE %p time %f\n", param, ((double)t1 - t) / CLOCKS_PER_SEC);
 		t = t1;
+		gNet->ProcessIdle(hPlugin);
 		res = FALSE;
 		}
 		break;
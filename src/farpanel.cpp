@@ -112,6 +112,11 @@ void FarPanel::GetOpenPluginInfo(struct OpenPluginInfo * info)
 	*info = data->openInfo;
 }
 
+bool FarPanel::ProcessIdle(void)
+{
+	return false;
+}
+
 const wchar_t * FarPanel::GetPanelTitle(void)
 {
 	ReloadPanelString(data.get(), index);
@@ -165,18 +170,6 @@ void FarPanel::FreeFindData(struct PluginPanelItem * panelItem, int itemsNumber)
 	free((void *)panelItem);
 }
 
-std::wstring FarPanel::towstr(const char * name) const
-{
-	std::string _s(name);
-	return std::wstring(_s.begin(), _s.end());
-}
-
-std::string FarPanel::tostr(const wchar_t * name) const
-{
-	std::wstring _s(name);
-	return std::string(_s.begin(), _s.end());
-}
-
 const wchar_t * FarPanel::DublicateCountString(int64_t value) const
 {
 	wchar_t max64[sizeof("18446744073709551615")] = {0};
@@ -193,6 +186,31 @@ const wchar_t * FarPanel::DublicateCountString(int64_t value) const
 	return wcsdup(L"");
 }
 
+DWORD FarPanel::ChangedItemAttributes(SnapshotChanges::RowState state)
+{
+	switch( state ) {
+	case SnapshotChanges::RowAdded:
+		return ADDED_ITEM_ATTRIBUTE;
+	case SnapshotChanges::RowModified:
+		return MODIFIED_ITEM_ATTRIBUTE;
+	default:
+		return 0;
+	}
+}
+
+void FarPanel::AppendChanges(std::wstring & title, const SnapshotChanges & changes)
+{
+	wchar_t buf[sizeof(" +18446744073709551615 -18446744073709551615 ~18446744073709551615 1.8e+19/s")] = {0};
+
+	if( !changes.Total() )
+		return;
+
+	if( NetCfgPlugin::FSF.snprintf(buf, ARRAYSIZE(buf), L" +%llu -%llu ~%llu %.1f/s",
+			(unsigned long long)changes.added, (unsigned long long)changes.removed,
+			(unsigned long long)changes.modified, changes.churn) > 0 )
+		title += buf;
+}
+
 const wchar_t * FarPanel::DublicateFileSizeString(uint64_t value) const
 {
 	if( value > 100 * 1024 ) {
@@ -3,10 +3,17 @@
 
 #include <farplug-wide.h>
 #include <memory>
+#include <common/widestr.h>
+#include <netif/snapshotdiff.h>
 #include "plugincfg.h"
 
 #define NO_PANEL_INDEX (PanelIndex)(-1)
 
+// rows added and modified by the last update, far2l colors them
+// by highlighting groups of these attributes
+#define ADDED_ITEM_ATTRIBUTE FILE_ATTRIBUTE_TEMPORARY
+#define MODIFIED_ITEM_ATTRIBUTE FILE_ATTRIBUTE_ARCHIVE
+
 struct PanelData {
 	struct PanelMode panelModesArray[PanelModeMax];
 	struct KeyBarTitles keyBar;
@@ -31,14 +38,16 @@ public:
 	virtual int GetFindData(struct PluginPanelItem **pPanelItem, int *pItemsNumber) = 0;
 	virtual void GetOpenPluginInfo(struct OpenPluginInfo * info);
 	virtual void FreeFindData(struct PluginPanelItem * panelItem, int itemsNumber);
-
-	// towstr can use only for ASCII symbols
-	std::wstring towstr(const char * name) const;
-	std::string tostr(const wchar_t * name) const;
+	// called on FE_IDLE, returns true if panel must be updated
+	virtual bool ProcessIdle(void);
 
 	const wchar_t * DublicateCountString(int64_t value) const;
 	const wchar_t * DublicateFileSizeString(uint64_t value) const;
 
+	static DWORD ChangedItemAttributes(SnapshotChanges::RowState state);
+	// counts of added, removed and modified rows and their rate for panel title
+	static void AppendChanges(std::wstring & title, const SnapshotChanges & changes);
+
 	void GetPanelInfo(PanelInfo & pi);
 	const wchar_t * GetPanelTitle(void);
 	const wchar_t * GetPanelTitleKey(int key, unsigned int controlState = 0) const;
@@ -23,9 +23,11 @@
 extern const char * LOG_FILE;
 #define LOG_SOURCE_FILE "netcfgarp.cpp"
 
-NetcfgArpRoute::NetcfgArpRoute(uint32_t index_, std::deque<ArpRouteInfo> & arp_, std::map<uint32_t, std::wstring> & ifs_):
+NetcfgArpRoute::NetcfgArpRoute(uint32_t index_, std::deque<ArpRouteInfo> & arp_, IfIndexTable<const wchar_t *> & ifs_, const uint32_t & version_, const std::shared_ptr<const SnapshotChanges> & changes_):
 	NetFarPanel(index_, ifs_),
-	arp(arp_)
+	arp(arp_),
+	version(version_),
+	changes(changes_)
 {
 	LOG_INFO("index_ %u this %p\n", index_, this);
 }
@@ -73,7 +75,7 @@ bool NetcfgArpRoute::DeleteArp(void)
 				_a += L" ";
 				_a += r->mac.empty() ? L"00:00:00:00:00:00":r->mac;
 				_a += L" ";
-				_a += r->iface;
+				_a += GetInterfaceName(r->iface, r->valid.ifnameIndex, r->ifnameIndex);
 
 				if( _a.size() > (DIALOG_WIDTH - 10) ) {
 					_a.resize(DIALOG_WIDTH - 13);
@@ -97,8 +99,7 @@ bool NetcfgArpRoute::DeleteArp(void)
 		if( dlg.Run() != static_cast<int>(offSufix) + WinSuffixOkIndex )
 			break;
 
-		for( auto & r : delarps )
-			change |= r->Delete();
+		change = ArpRouteInfo::Delete(delarps) != 0;
 
 	} while(0);
 
@@ -551,53 +552,61 @@ int NetcfgArpRoute::ProcessKey(HANDLE hPlugin, int key, unsigned int controlStat
 }
 
 
-int NetcfgArpRoute::GetFindData(struct PluginPanelItem **pPanelItem, int *pItemsNumber)
+void NetcfgArpRoute::BuildItems(void)
 {
-	const static wchar_t * empty_string = L"";
+	#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	std::map<uint8_t, const wchar_t *> types;
+	std::map<uint16_t, const wchar_t *> states;
+	#endif
 
-	LOG_INFO("\n");
-	*pItemsNumber = arp.size();
-	*pPanelItem = (struct PluginPanelItem *)malloc((*pItemsNumber) * sizeof(PluginPanelItem));
-	memset(*pPanelItem, 0, (*pItemsNumber) * sizeof(PluginPanelItem));
-	PluginPanelItem * pi = *pPanelItem;
+	items.Begin(version, 0, ArpRoutesColumnMaxIndex, arp.size());
 	for( const auto & item : arp ) {
-		pi->FindData.lpwszFileName = item.ip.c_str();
+		PluginPanelItem & pi = items.Append();
+		pi.FindData.lpwszFileName = item.ip.c_str();
 
 		#if !defined(__APPLE__) && !defined(__FreeBSD__)				
-		pi->FindData.dwFileAttributes = (item.valid.type && item.type == RTN_UNICAST) ? FILE_ATTRIBUTE_EXECUTABLE:0;
+		pi.FindData.dwFileAttributes = (item.valid.type && item.type == RTN_UNICAST) ? FILE_ATTRIBUTE_EXECUTABLE:0;
+		#endif
+		pi.FindData.dwFileAttributes |= ChangedItemAttributes(changes->Get(NetRoutes::NeighborKey(item)));
+
+		items.UserData().data.arp = const_cast<ArpRouteInfo*>(&item);
+
+		if( item.valid.mac )
+			items.SetColumn(ArpRoutesColumnMacIndex, item.mac.c_str());
+		items.SetColumn(ArpRoutesColumnDevIndex, GetInterfaceName(item.iface, item.valid.ifnameIndex, item.ifnameIndex));
+		#if !defined(__APPLE__) && !defined(__FreeBSD__)
+		// few types and states, their names are shared by all rows
+		auto type = types.find(item.type);
+		if( type == types.end() )
+			type = types.emplace(item.type, items.Keep(rttype(item.type))).first;
+		items.SetColumn(ArpRoutesColumnTypeIndex, type->second);
+
+		auto state = states.find(item.state);
+		if( state == states.end() )
+			state = states.emplace(item.state, items.Keep(ndmsgstate(item.state))).first;
+		items.SetColumn(ArpRoutesColumnStateIndex, state->second);
 		#else
-		pi->FindData.dwFileAttributes = 0;
+		if( item.valid.flags )
+			items.SetColumn(ArpRoutesColumnFlagsIndex, items.Keep(RouteFlagsToString(item.flags, 0)));
 		#endif
+	}
+	items.End();
+}
 
-		pi->FindData.nFileSize = 0;
+int NetcfgArpRoute::GetFindData(struct PluginPanelItem **pPanelItem, int *pItemsNumber)
+{
+	LOG_INFO("\n");
 
-		PluginUserData * user_data = (PluginUserData *)malloc(sizeof(PluginUserData));
-		if( user_data ) {
-			user_data->size = sizeof(PluginUserData);
-			user_data->data.arp = const_cast<ArpRouteInfo*>(&item);
-			pi->Flags = PPIF_USERDATA;
-			pi->UserData = (DWORD_PTR)user_data;
-		}
+	// column strings are built once per routes update
+	if( !items.IsValid(version, 0) )
+		BuildItems();
 
-		const wchar_t ** CustomColumnData = (const wchar_t **)malloc(ArpRoutesColumnMaxIndex*sizeof(const wchar_t *));
-		if( CustomColumnData ) {
-			memset(CustomColumnData, 0, ArpRoutesColumnMaxIndex*sizeof(const wchar_t *));
-			CustomColumnData[ArpRoutesColumnMacIndex] = wcsdup(item.valid.mac ? item.mac.c_str():empty_string);
-			CustomColumnData[ArpRoutesColumnDevIndex] = wcsdup(item.valid.iface ? item.iface.c_str():empty_string);
-			#if !defined(__APPLE__) && !defined(__FreeBSD__)				
-			CustomColumnData[ArpRoutesColumnTypeIndex] = wcsdup(towstr(rttype(item.type)).c_str());
-			CustomColumnData[ArpRoutesColumnStateIndex] = wcsdup(towstr(ndmsgstate(item.state)).c_str());
-			#else
-			if( item.valid.flags )
-				CustomColumnData[ArpRoutesColumnFlagsIndex] = wcsdup(towstr(RouteFlagsToString(item.flags, 0)).c_str());
-			else
-				CustomColumnData[ArpRoutesColumnFlagsIndex] = wcsdup(empty_string);
-			CustomColumnData[ArpRoutesColumnStateIndex] = wcsdup(empty_string);
-			#endif
-			pi->CustomColumnNumber = ArpRoutesColumnMaxIndex;
-			pi->CustomColumnData = CustomColumnData;
-		}
-		pi++;
-	}
+	items.Get(pPanelItem, pItemsNumber);
 	return int(true);
 }
+
+void NetcfgArpRoute::FreeFindData(struct PluginPanelItem * panelItem, int itemsNumber)
+{
+	if( !items.Free(panelItem) )
+		LOG_ERROR("unknown panel items %p\n", panelItem);
+}
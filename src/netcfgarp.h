@@ -3,6 +3,7 @@
 
 #include "farpanel.h"
 #include "netroute/netroutes.h"
+#include "panelitems.h"
 #include <memory>
 
 enum {
@@ -21,6 +22,12 @@ class NetcfgArpRoute : public NetFarPanel
 {
 private:
 	std::deque<ArpRouteInfo> & arp;
+	const uint32_t & version;
+	// rows of the last update are highlighted
+	const std::shared_ptr<const SnapshotChanges> & changes;
+
+	PanelItems items;
+	void BuildItems(void);
 
 	ArpRouteInfo * a;
 	ArpRouteInfo new_a;
@@ -35,7 +42,8 @@ private:
 public:
 	int ProcessKey(HANDLE hPlugin, int key, unsigned int controlState, bool & change) override;
 	int GetFindData(struct PluginPanelItem **pPanelItem, int *pItemsNumber) override;
-	explicit NetcfgArpRoute(uint32_t index, std::deque<ArpRouteInfo> & arp, std::map<uint32_t, std::wstring> & ifs);
+	void FreeFindData(struct PluginPanelItem * panelItem, int itemsNumber) override;
+	explicit NetcfgArpRoute(uint32_t index, std::deque<ArpRouteInfo> & arp, IfIndexTable<const wchar_t *> & ifs, const uint32_t & version, const std::shared_ptr<const SnapshotChanges> & changes);
 	~NetcfgArpRoute();
 };
 
@@ -32,7 +32,9 @@ NetcfgInterfaces::NetcfgInterfaces(PanelIndex index):FarPanel(index)
 {
 	LOG_INFO("\n");
 	nifs = std::make_unique<NetInterfaces>();
+	nifs->SetStatsInterval(PluginCfg::interfacesStatsInterval);
 	change = true;
+	shownStats = 0;
 }
 
 NetcfgInterfaces::~NetcfgInterfaces()
@@ -48,6 +50,7 @@ int NetcfgInterfaces::GetFindData(struct PluginPanelItem **pPanelItem, int *pIte
 		change = false;
 	}
 
+	shownStats = nifs->StatsFingerprint();
 	*pItemsNumber = nifs->size();
 	*pPanelItem = (struct PluginPanelItem *)malloc((*pItemsNumber) * sizeof(PluginPanelItem));
 
@@ -60,6 +63,7 @@ int NetcfgInterfaces::GetFindData(struct PluginPanelItem **pPanelItem, int *pIte
 		pi->FindData.lpwszFileName = name.c_str();
 
 		pi->FindData.dwFileAttributes = net_if->IsCarrierOn() ? FILE_ATTRIBUTE_EXECUTABLE:(FILE_ATTRIBUTE_OFFLINE|FILE_ATTRIBUTE_HIDDEN);
+		pi->FindData.dwFileAttributes |= ChangedItemAttributes(nifs->changes->Get(NetInterfaces::InterfaceKey(net_if->ifindex)));
 		pi->FindData.nFileSize = net_if->recv_bytes+net_if->send_bytes;
 
 		PluginUserData * user_data = (PluginUserData *)malloc(sizeof(PluginUserData));
@@ -114,6 +118,19 @@ int NetcfgInterfaces::GetFindData(struct PluginPanelItem **pPanelItem, int *pIte
 
 		CustomColumnData[InterfaceColumnPermanentMacIndex] = wcsdup(net_if->permanent_mac.c_str());
 
+		NetStatsSampler::Rates rates;
+		if( nifs->GetRates(net_if->ifindex, rates) ) {
+			CustomColumnData[InterfaceColumnRecvBytesRateIndex] = DublicateFileSizeString(rates.recv_bytes);
+			CustomColumnData[InterfaceColumnSendBytesRateIndex] = DublicateFileSizeString(rates.send_bytes);
+			CustomColumnData[InterfaceColumnRecvPktsRateIndex] = DublicateCountString(rates.recv_packets);
+			CustomColumnData[InterfaceColumnSendPktsRateIndex] = DublicateCountString(rates.send_packets);
+			CustomColumnData[InterfaceColumnRecvErrsRateIndex] = DublicateCountString(rates.recv_errors);
+			CustomColumnData[InterfaceColumnSendErrsRateIndex] = DublicateCountString(rates.send_errors);
+		} else {
+			for( int index = InterfaceColumnRecvBytesRateIndex; index <= InterfaceColumnSendErrsRateIndex; index++ )
+				CustomColumnData[index] = wcsdup(L"");
+		}
+
 		pi->CustomColumnData = CustomColumnData;
 		pi->CustomColumnNumber = InterfaceColumnMaxIndex;
 		pi++;
@@ -121,6 +138,30 @@ int NetcfgInterfaces::GetFindData(struct PluginPanelItem **pPanelItem, int *pIte
 	return int(true);
 }
 
+void NetcfgInterfaces::GetOpenPluginInfo(struct OpenPluginInfo * info)
+{
+	FarPanel::GetOpenPluginInfo(info);
+
+	if( info->PanelTitle && nifs->changes->Total() ) {
+		title = info->PanelTitle;
+		AppendChanges(title, *nifs->changes);
+		info->PanelTitle = (TCHAR*)title.c_str();
+	}
+}
+
+bool NetcfgInterfaces::ProcessIdle(void)
+{
+	if( change || !nifs->SampleStats() )
+		return false;
+
+	// redraw only if some shown counter or rate differs from the shown ones
+	uint64_t stats = nifs->StatsFingerprint();
+	if( stats == shownStats )
+		return false;
+	shownStats = stats;
+	return true;
+}
+
 const int DIALOG_WIDTH = 78;
 
 enum {
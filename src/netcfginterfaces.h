@@ -19,6 +19,12 @@ enum {
 	InterfaceColumnMulticastIndex,
 	InterfaceColumnCollisionsIndex,
 	InterfaceColumnPermanentMacIndex,
+	InterfaceColumnRecvBytesRateIndex,
+	InterfaceColumnSendBytesRateIndex,
+	InterfaceColumnRecvPktsRateIndex,
+	InterfaceColumnSendPktsRateIndex,
+	InterfaceColumnRecvErrsRateIndex,
+	InterfaceColumnSendErrsRateIndex,
 	InterfaceColumnMaxIndex
 };
 
@@ -28,6 +34,8 @@ private:
 	std::unique_ptr<NetInterfaces> nifs;
 
 	bool change;
+	uint64_t shownStats;
+	std::wstring title;
 	
 	// copy and assignment not allowed
 	NetcfgInterfaces(const NetcfgInterfaces&) = delete;
@@ -43,6 +51,8 @@ private:
 public:
 	int ProcessKey(HANDLE hPlugin, int key, unsigned int controlState, bool & change) override;
 	int GetFindData(struct PluginPanelItem **pPanelItem, int *pItemsNumber) override;
+	void GetOpenPluginInfo(struct OpenPluginInfo * info) override;
+	bool ProcessIdle(void) override;
 	explicit NetcfgInterfaces(PanelIndex index);
 	virtual ~NetcfgInterfaces();
 };
@@ -16,6 +16,7 @@
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <arpa/inet.h>
 
 #include <memory>
 #include <map>
@@ -24,28 +25,33 @@ extern const char * LOG_FILE;
 #define LOG_SOURCE_FILE "netcfgiproutes.cpp"
 
 #if !defined(__APPLE__) && !defined(__FreeBSD__)
-NetcfgIpRoute::NetcfgIpRoute(uint32_t index_, uint8_t family_, std::deque<IpRouteInfo> & inet_, std::deque<RuleRouteInfo> & rule_, std::map<uint32_t, std::wstring> & ifs_):
+NetcfgIpRoute::NetcfgIpRoute(uint32_t index_, uint8_t family_, std::deque<IpRouteInfo> & inet_, std::deque<RuleRouteInfo> & rule_, std::map<uint32_t, uint32_t> & tables_, IfIndexTable<const wchar_t *> & ifs_, const uint32_t & version_, const std::shared_ptr<const SnapshotChanges> & changes_, NetRoutes & routes_):
 	NetFarPanel(index_, ifs_),
 	inet(inet_),
 	ifs(ifs_),
-	family(family_)
+	version(version_),
+	changes(changes_),
+	family(family_),
+	routes(routes_)
 {
 
 	table = 0;
 	rt = nullptr;
 
 	rule = std::make_unique<NetcfgIpRule>(RouteRuleInetPanelIndex, family_, rule_, ifs_);
-	tables = std::make_unique<NetcfgTablesRoute>(RouteIpTablesPanelIndex, inet_);
+	tables = std::make_unique<NetcfgTablesRoute>(RouteIpTablesPanelIndex, tables_);
 
 	panel = PanelTables;
 
 	LOG_INFO("index_ %u this %p\n", index_, this);
 }
 #else
-NetcfgIpRoute::NetcfgIpRoute(uint32_t index_, uint8_t family_, std::deque<IpRouteInfo> & inet_, std::map<uint32_t, std::wstring> & ifs_):
+NetcfgIpRoute::NetcfgIpRoute(uint32_t index_, uint8_t family_, std::deque<IpRouteInfo> & inet_, IfIndexTable<const wchar_t *> & ifs_, const uint32_t & version_, const std::shared_ptr<const SnapshotChanges> & changes_):
 	NetFarPanel(index_, ifs_),
 	inet(inet_),
 	ifs(ifs_),
+	version(version_),
+	changes(changes_),
 	family(family_)
 {
 	rt = nullptr;
@@ -90,11 +96,12 @@ bool NetcfgIpRoute::DeleteIpRoute(void)
 
 				auto off = fdc.Append(&route);
 				std::wstring _rt(std::to_wstring(i+1)+L". ");
-				_rt += rt->destIpandMask.empty() ? L"default":rt->destIpandMask;
+				_rt += rt->destIpandMask.empty() ? L"default":rt->destIpandMask.str();
 				if( !rt->gateway.empty() )
-					_rt += L" via " + rt->gateway;
-				if( !rt->iface.empty() )
-					_rt += L" dev " + rt->iface;
+					_rt += L" via " + rt->gateway.str();
+				std::wstring dev(GetInterfaceName(rt->iface, rt->valid.ifnameIndex, rt->ifnameIndex));
+				if( !dev.empty() )
+					_rt += L" dev " + dev;
 
 				#if !defined(__APPLE__) && !defined(__FreeBSD__)
 				if( rt->osdep.table )
@@ -124,8 +131,7 @@ bool NetcfgIpRoute::DeleteIpRoute(void)
 		if( dlg.Run() != static_cast<int>(offSufix) + WinSuffixOkIndex )
 			break;
 
-		for( auto & rt : delroutes )
-			change |= rt->DeleteIpRoute();
+		change = IpRouteInfo::DeleteIpRoutes(delroutes) != 0;
 
 	} while(0);
 
@@ -707,7 +713,7 @@ LONG_PTR WINAPI EditIpRouteDialogProc(HANDLE hDlg, int msg, int param1, LONG_PTR
 			return true;
 		}
 		case WinEditIpEncapButtonIndex:
-			rtCfg->SelectEncap(hDlg, rtCfg->new_rt.osdep.enc);
+			rtCfg->SelectEncap(hDlg, rtCfg->new_rt.osdep.enc.Set());
 			return true;
 		};
 		} else {
@@ -720,8 +726,8 @@ LONG_PTR WINAPI EditIpRouteDialogProc(HANDLE hDlg, int msg, int param1, LONG_PTR
 			auto & nh = rindex < rtCfg->new_rt.osdep.nhs.size() ? rtCfg->new_rt.osdep.nhs[rindex]:rtCfg->new_nh;
 			switch( iindex ) {
 			case WinEditIpNextHopeEncapButtonIndex:
-				rtCfg->SelectEncap(hDlg, nh.enc);
-				nh.valid.encap = nh.enc.type != LWTUNNEL_ENCAP_NONE;
+				rtCfg->SelectEncap(hDlg, nh.enc.Set());
+				nh.valid.encap = nh.enc->type != LWTUNNEL_ENCAP_NONE;
 				break;
 			case WinEditIpNextHopeFamilyButtonIndex:
 				nh.rtvia_family = rtCfg->SelectFamily(hDlg, base + WinEditIpNextHopeFamilyButtonIndex);
@@ -818,20 +824,20 @@ bool NetcfgIpRoute::FillNewIpRoute(void)
 
 	FarDlgConstructor fdc(&dialog[0]);
 
-	fdc.SetText(WinEditIpDestMaskEditIndex, new_rt.valid.destIpandMask ? new_rt.destIpandMask.c_str():L"default");
+	fdc.SetText(WinEditIpDestMaskEditIndex, new_rt.valid.destIpandMask ? new_rt.destIpandMask.str().c_str():L"default", true);
 
 	if( new_rt.valid.iface )
 		fdc.SetText(WinEditIpDeviceButtonIndex, new_rt.iface.c_str());
 
 	if( new_rt.valid.prefsrc )
-		fdc.SetText(WinEditIpPrefsrcEditIndex, new_rt.prefsrc.c_str());
+		fdc.SetText(WinEditIpPrefsrcEditIndex, new_rt.prefsrc.str().c_str(), true);
 
 	if( new_rt.valid.fromsrcIpandMask )
-		fdc.SetText(WinEditIpSrcMaskEditIndex, new_rt.osdep.fromsrcIpandMask.c_str());
+		fdc.SetText(WinEditIpSrcMaskEditIndex, new_rt.osdep.fromsrcIpandMask.str().c_str(), true);
 	if( new_rt.valid.rtvia )
-		fdc.SetText(WinEditIpGatewayEditIndex, new_rt.osdep.rtvia_addr.c_str());
+		fdc.SetText(WinEditIpGatewayEditIndex, new_rt.osdep.rtvia_addr.str().c_str(), true);
 	else if( new_rt.valid.gateway )
-		fdc.SetText(WinEditIpGatewayEditIndex, new_rt.gateway.c_str());
+		fdc.SetText(WinEditIpGatewayEditIndex, new_rt.gateway.str().c_str(), true);
 
 	fdc.SetText(WinEditIpFamilyButtonIndex, towstr(ipfamilyname(new_rt.sa_family)).c_str(), true);
 
@@ -864,10 +870,9 @@ bool NetcfgIpRoute::FillNewIpRoute(void)
 		fdc.SetSelected(off+WinEditIpNextHopeNextHopeCheckBoxIndex, true);
 		fdc.SetSelected(off+WinEditIpNextHopeOnlinkCheckBoxIndex, (item.flags & RTNH_F_ONLINK) != 0);
 		fdc.SetText(off+WinEditIpNextHopeFamilyButtonIndex, item.valid.rtvia ? towstr(ipfamilyname(item.rtvia_family)).c_str():0, true);
-		fdc.SetText(off+WinEditIpNextHopeViaEditIndex, item.valid.rtvia ? item.rtvia_addr.c_str():item.gateway.c_str());
-		auto it = ifs.find(item.ifindex);
-		if( it != ifs.end() )
-			fdc.SetText(off+WinEditIpNextHopeDeviceButtonIndex, it->second.c_str());
+		fdc.SetText(off+WinEditIpNextHopeViaEditIndex, (item.valid.rtvia ? item.rtvia_addr:item.gateway).str().c_str(), true);
+		if( const wchar_t * const * name = ifs.Find(item.ifindex) )
+			fdc.SetText(off+WinEditIpNextHopeDeviceButtonIndex, *name);
 		fdc.SetCountText(off+WinEditIpNextHopeWeightEditIndex, item.weight);
 
 		if( !item.valid.encap )
@@ -921,6 +926,8 @@ bool NetcfgIpRoute::FillNewIpRoute(void)
 				case WinEditIpDeviceButtonIndex:
 					new_rt.iface = item.newVal.ptrData;
 					new_rt.valid.iface = !item.empty;
+					if( item.empty )
+						new_rt.valid.ifnameIndex = 0;
 					break;
 				case WinEditIpMetricEditIndex:
 					new_rt.osdep.metric = NetCfgPlugin::FSF.atoi(item.newVal.ptrData);
@@ -1086,25 +1093,25 @@ bool NetcfgIpRoute::FillNewIpRoute(void)
 
 	FarDlgConstructor fdc(&dialog[0]);
 
-	fdc.SetText(WinEditIpDestMaskEditIndex, new_rt.valid.destIpandMask ? new_rt.destIpandMask.c_str():L"default");
+	fdc.SetText(WinEditIpDestMaskEditIndex, new_rt.valid.destIpandMask ? new_rt.destIpandMask.str().c_str():L"default", true);
 
 	if( new_rt.valid.prefsrc )
-		fdc.SetText(WinEditIpPrefsrcEditIndex, new_rt.prefsrc.c_str());
+		fdc.SetText(WinEditIpPrefsrcEditIndex, new_rt.prefsrc.str().c_str(), true);
 
 	if( new_rt.valid.gateway )
 		switch( new_rt.osdep.gateway_type ) {
 		case IpRouteInfo::OtherGatewayType:
 		case IpRouteInfo::IpGatewayType:
 			fdc.SetSelected(WinEditIpGatewayIpRadiobuttonIndex, true);
-			fdc.SetText(WinEditIpGatewayIpEditIndex, new_rt.gateway.c_str());
+			fdc.SetText(WinEditIpGatewayIpEditIndex, new_rt.gateway.str().c_str(), true);
 			break;
 		case IpRouteInfo::MacGatewayType:
 			fdc.SetSelected(WinEditIpGatewayMacRadiobuttonIndex, true);
-			fdc.SetText(WinEditIpGatewayMacEditIndex, new_rt.gateway.c_str());
+			fdc.SetText(WinEditIpGatewayMacEditIndex, new_rt.gateway.str().c_str(), true);
 			break;
 		case IpRouteInfo::InterfaceGatewayType:
 			fdc.SetSelected(WinEditIpGatewayInterfaceRadiobuttonIndex, true);
-			fdc.SetText(WinEditIpGatewayInterfaceButtonIndex, new_rt.gateway.c_str());
+			fdc.SetText(WinEditIpGatewayInterfaceButtonIndex, new_rt.gateway.str().c_str(), true);
 			break;
 		};
 
@@ -1284,6 +1291,19 @@ bool NetcfgIpRoute::EditIpRoute(void)
 			assert(ppi->UserData && ((PluginUserData *)ppi->UserData)->size == sizeof(PluginUserData));
 			rt = ((PluginUserData *)ppi->UserData)->data.inet;
 			new_rt = *rt;
+			// dialog and ip utility work with names, dumped routes keep interface indexes only
+			if( new_rt.iface.empty() && new_rt.valid.ifnameIndex ) {
+				new_rt.iface = GetInterfaceByIndex(new_rt.ifnameIndex);
+				new_rt.valid.iface = !new_rt.iface.empty();
+			}
+			#if !defined(__APPLE__) && !defined(__FreeBSD__)
+			for( auto & nh : new_rt.osdep.nhs ) {
+				if( nh.iface.empty() && nh.ifindex ) {
+					nh.iface = GetInterfaceByIndex(nh.ifindex);
+					nh.valid.iface = !nh.iface.empty();
+				}
+			}
+			#endif
 			if( FillNewIpRoute() )
 				change = rt->ChangeIpRoute(new_rt);
 			rt = nullptr;
@@ -1382,6 +1402,13 @@ int NetcfgIpRoute::ProcessKey(HANDLE hPlugin, int key, unsigned int controlState
 		return TRUE;
 	}
 
+	#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	if( controlState == PKF_SHIFT && key == VK_F7 ) {
+		ShowRouteTo();
+		return TRUE;
+	}
+	#endif
+
 	return IsPanelProcessKey(key, controlState);
 }
 
@@ -1399,9 +1426,11 @@ void NetcfgIpRoute::GetOpenPluginInfo(struct OpenPluginInfo * info)
 
 	FarPanel::GetOpenPluginInfo(info);
 }
+#endif
 
 void NetcfgIpRoute::FreeFindData(struct PluginPanelItem * panelItem, int itemsNumber)
 {
+	#if !defined(__APPLE__) && !defined(__FreeBSD__)
 	if( panel == PanelRules ) {
 		rule->FreeFindData(panelItem, itemsNumber);
 		return;
@@ -1411,24 +1440,127 @@ void NetcfgIpRoute::FreeFindData(struct PluginPanelItem * panelItem, int itemsNu
 		tables->FreeFindData(panelItem, itemsNumber);
 		return;
 	}
+	#endif
 
-	auto freeNumber = itemsNumber;
-	while( freeNumber-- ) {
-		if( (panelItem+freeNumber)->FindData.dwFileAttributes & FILE_FLAG_DELETE_ON_CLOSE )
-			free((void *)(panelItem+freeNumber)->FindData.lpwszFileName);
+	if( !items.Free(panelItem) )
+		LOG_ERROR("unknown panel items %p\n", panelItem);
+}
+
+void NetcfgIpRoute::BuildItems(uint32_t filter)
+{
+	const static wchar_t * default_route = L"default";
+	std::map<uint8_t, const wchar_t *> protocols;
+
+	items.Begin(version, filter, RoutesColumnDataMaxIndex, inet.size());
+	for( const auto & item : inet ) {
+
+		#if !defined(__APPLE__) && !defined(__FreeBSD__)
+		if( filter && item.osdep.table != filter )
+			continue;
+		#endif
+
+		PluginPanelItem & pi = items.Append();
+		pi.FindData.lpwszFileName = item.destIpandMask.empty() ? default_route:items.Keep(item.destIpandMask.str());
+		pi.FindData.dwFileAttributes = ChangedItemAttributes(changes->Get(NetRoutes::RouteKey(item)));
+		items.UserData().data.inet = const_cast<IpRouteInfo*>(&item);
+
+		#if !defined(__APPLE__) && !defined(__FreeBSD__)
+		if( item.valid.gateway )
+			items.SetColumn(RoutesColumnViaIndex, items.Keep(item.gateway.str()));
+		else if( item.valid.rtvia )
+			items.SetColumn(RoutesColumnViaIndex, items.Keep(item.osdep.rtvia_addr.str()));
+		#else
+		if( item.valid.gateway )
+			items.SetColumn(RoutesColumnViaIndex, items.Keep(item.gateway.str()));
+		#endif
+
+		items.SetColumn(RoutesColumnDevIndex, GetInterfaceName(item.iface, item.valid.ifnameIndex, item.ifnameIndex));
+		if( !item.prefsrc.empty() )
+			items.SetColumn(RoutesColumnPrefsrcIndex, items.Keep(item.prefsrc.str()));
+		#if !defined(__APPLE__) && !defined(__FreeBSD__)
+		if( item.valid.protocol ) {
+			// only a few protocols, their names are shared by all rows
+			auto it = protocols.find(item.osdep.protocol);
+			if( it == protocols.end() )
+				it = protocols.emplace(item.osdep.protocol, items.Keep(rtprotocoltype(item.osdep.protocol))).first;
+			items.SetColumn(RoutesColumnTypeIndex, it->second);
+		}
+		if( item.valid.metric )
+			items.SetColumn(RoutesColumnMetricIndex, items.Keep(std::to_wstring(item.osdep.metric)));
+		#else
+		if( item.valid.flags )
+			items.SetColumn(RoutesColumnFlagsIndex, items.Keep(RouteFlagsToString(item.flags, 0)));
+		items.SetColumn(RoutesColumnMetricIndex, items.Keep(std::to_wstring(item.osdep.expire)));
+		#endif
 	}
+	items.End();
+}
 
-	FarPanel::FreeFindData(panelItem, itemsNumber);
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+bool NetcfgIpRoute::GetRouteFilter(RouteFilter & filter) const
+{
+	memset(&filter, 0, sizeof(filter));
+	filter.family = family;
+	if( panel == PanelRoutes || (panel == PanelRules && oldPanel == PanelRoutes) )
+		filter.table = table;
+	// directory of tables needs route counts only, routes of table are loaded on enter
+	return panel == PanelTables || (panel == PanelRules && oldPanel == PanelTables);
 }
 #endif
 
+bool NetcfgIpRoute::ShowRouteTo(void)
+{
+	static wchar_t addr[INET6_ADDRSTRLEN] = {0};
+	unsigned char dst[sizeof(struct in6_addr)];
+
+	// multicast routes are looked up by source and group
+	if( family != AF_INET && family != AF_INET6 )
+		return false;
+
+	if( !NetCfgPlugin::psi.InputBox(GetMsg(MRouteToTitle), GetMsg(MRouteToAddress), 0, addr, addr, ARRAYSIZE(addr), 0, FIB_NOUSELASTHISTORY) )
+		return false;
+
+	if( inet_pton(family, tostr(addr).c_str(), dst) != 1 ) {
+		const wchar_t * msgItems[] = { GetMsg(MRouteToTitle), GetMsg(MRouteToInvalid), addr, GetMsg(MOk) };
+		NetCfgPlugin::psi.Message(NetCfgPlugin::psi.ModuleNumber, FMSG_WARNING, NULL, msgItems, ARRAYSIZE(msgItems), 1);
+		return false;
+	}
+
+	// shown table, or tables of default rules in their order
+	const IpRouteInfo * ipr = nullptr;
+	if( table )
+		ipr = routes.LookupRoute(family, table, dst);
+	else {
+		for( uint32_t t : { RT_TABLE_LOCAL, RT_TABLE_MAIN, RT_TABLE_DEFAULT } ) {
+			if( (ipr = routes.LookupRoute(family, t, dst)) != nullptr )
+				break;
+		}
+	}
+
+	if( !ipr ) {
+		const wchar_t * msgItems[] = { GetMsg(MRouteToTitle), GetMsg(MRouteToNotFound), addr, GetMsg(MOk) };
+		NetCfgPlugin::psi.Message(NetCfgPlugin::psi.ModuleNumber, 0, NULL, msgItems, ARRAYSIZE(msgItems), 1);
+		return false;
+	}
+
+	std::wstring route = ipr->destIpandMask.empty() ? L"default":ipr->destIpandMask.str();
+	if( ipr->valid.gateway )
+		route += L" via " + ipr->gateway.str();
+	const wchar_t * dev = GetInterfaceName(ipr->iface, ipr->valid.ifnameIndex, ipr->ifnameIndex);
+	if( dev && *dev )
+		route += std::wstring(L" dev ") + dev;
+	route += L" table " + towstr(rtruletable(ipr->osdep.table));
+
+	const wchar_t * msgItems[] = { GetMsg(MRouteToTitle), addr, route.c_str(), GetMsg(MOk) };
+	NetCfgPlugin::psi.Message(NetCfgPlugin::psi.ModuleNumber, 0, NULL, msgItems, ARRAYSIZE(msgItems), 1);
+	return true;
+}
+
 int NetcfgIpRoute::GetFindData(struct PluginPanelItem **pPanelItem, int *pItemsNumber)
 {
 	LOG_INFO("\n");
 
-	const static wchar_t * default_route = L"default";
-	const static wchar_t * empty_string = L"";
-	*pItemsNumber = inet.size();
+	uint32_t filter = 0;
 
 	#if !defined(__APPLE__) && !defined(__FreeBSD__)
 	if( panel == PanelRules )
@@ -1437,61 +1569,13 @@ int NetcfgIpRoute::GetFindData(struct PluginPanelItem **pPanelItem, int *pItemsN
 	if( panel == PanelTables )
 		return tables->GetFindData(pPanelItem, pItemsNumber);
 
-	if( table )
-		for( const auto & item : inet ) {
-			if( item.osdep.table != table )
-				(*pItemsNumber)--;
-		}
+	filter = table;
 	#endif
 
-	*pPanelItem = (struct PluginPanelItem *)malloc((*pItemsNumber) * sizeof(PluginPanelItem));
-	memset(*pPanelItem, 0, (*pItemsNumber) * sizeof(PluginPanelItem));
-	PluginPanelItem * pi = *pPanelItem;
-	for( const auto & item : inet ) {
+	// column strings are built once per routes update and table
+	if( !items.IsValid(version, filter) )
+		BuildItems(filter);
 
-		#if !defined(__APPLE__) && !defined(__FreeBSD__)
-		if( table && item.osdep.table != table )
-			continue;
-		#endif
-
-		pi->FindData.lpwszFileName = item.destIpandMask.empty() ? default_route:item.destIpandMask.c_str();
-		pi->FindData.dwFileAttributes = 0;
-		pi->FindData.nFileSize = 0;
-
-		PluginUserData * user_data = (PluginUserData *)malloc(sizeof(PluginUserData));
-		if( user_data ) {
-			user_data->size = sizeof(PluginUserData);
-			user_data->data.inet = const_cast<IpRouteInfo*>(&item);
-			pi->Flags = PPIF_USERDATA;
-			pi->UserData = (DWORD_PTR)user_data;
-		}
-
-		const wchar_t ** CustomColumnData = (const wchar_t **)malloc(RoutesColumnDataMaxIndex*sizeof(const wchar_t *));
-		if( CustomColumnData ) {
-			memset(CustomColumnData, 0, RoutesColumnDataMaxIndex*sizeof(const wchar_t *));
-
-			#if !defined(__APPLE__) && !defined(__FreeBSD__)				
-			CustomColumnData[RoutesColumnViaIndex] = wcsdup(item.valid.gateway ? item.gateway.c_str(): (item.valid.rtvia ? item.osdep.rtvia_addr.c_str():empty_string));
-			#else
-			CustomColumnData[RoutesColumnViaIndex] = wcsdup(item.valid.gateway ? item.gateway.c_str():empty_string);
-			#endif
-
-			CustomColumnData[RoutesColumnDevIndex] = wcsdup(item.iface.c_str());
-			CustomColumnData[RoutesColumnPrefsrcIndex] = wcsdup(item.prefsrc.c_str());
-			#if !defined(__APPLE__) && !defined(__FreeBSD__)
-			CustomColumnData[RoutesColumnTypeIndex] = wcsdup(item.valid.protocol ? towstr(rtprotocoltype(item.osdep.protocol)).c_str():empty_string);
-			CustomColumnData[RoutesColumnMetricIndex] = item.valid.metric ? DublicateCountString(item.osdep.metric):wcsdup(empty_string);
-			#else
-			if( item.valid.flags )
-				CustomColumnData[RoutesColumnFlagsIndex] = wcsdup(towstr(RouteFlagsToString(item.flags, 0)).c_str());
-			else
-				CustomColumnData[RoutesColumnFlagsIndex] = wcsdup(empty_string);
-			CustomColumnData[RoutesColumnMetricIndex] = DublicateCountString(item.osdep.expire);
-			#endif
-			pi->CustomColumnNumber = RoutesColumnDataMaxIndex;
-			pi->CustomColumnData = CustomColumnData;
-		}
-		pi++;
-	}
+	items.Get(pPanelItem, pItemsNumber);
 	return int(true);
 }
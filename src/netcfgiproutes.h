@@ -10,6 +10,7 @@
 #endif
 
 #include "netcfgarp.h"
+#include "panelitems.h"
 #include <memory>
 
 enum {
@@ -31,7 +32,13 @@ class NetcfgIpRoute : public NetFarPanel
 {
 private:
 	std::deque<IpRouteInfo> & inet;
-	std::map<uint32_t, std::wstring> & ifs;
+	IfIndexTable<const wchar_t *> & ifs;
+	const uint32_t & version;
+	// rows of the last update are highlighted
+	const std::shared_ptr<const SnapshotChanges> & changes;
+
+	PanelItems items;
+	void BuildItems(uint32_t filter);
 
 	uint8_t family;
 
@@ -52,6 +59,10 @@ private:
 
 	uint32_t table;
 
+	// prefix index of routes for "which route is used for address"
+	NetRoutes & routes;
+	bool ShowRouteTo(void);
+
 	void FillNextHope(uint32_t iindex, ItemChange & item, NextHope & nh);
 
 	NextHope new_nh;
@@ -74,12 +85,15 @@ private:
 public:
 	int ProcessKey(HANDLE hPlugin, int key, unsigned int controlState, bool & change) override;
 	int GetFindData(struct PluginPanelItem **pPanelItem, int *pItemsNumber) override;
+	void FreeFindData(struct PluginPanelItem * panelItem, int itemsNumber) override;
 	#if !defined(__APPLE__) && !defined(__FreeBSD__)
 	void GetOpenPluginInfo(struct OpenPluginInfo * info) override;
-	void FreeFindData(struct PluginPanelItem * panelItem, int itemsNumber) override;
-	explicit NetcfgIpRoute(uint32_t index, uint8_t family, std::deque<IpRouteInfo> & inet, std::deque<RuleRouteInfo> & rule, std::map<uint32_t, std::wstring> & ifs);
+	// routes needed by current view: family, and table if routes of one table are shown,
+	// returns true if directory of tables is shown and routes are only counted
+	bool GetRouteFilter(RouteFilter & filter) const;
+	explicit NetcfgIpRoute(uint32_t index, uint8_t family, std::deque<IpRouteInfo> & inet, std::deque<RuleRouteInfo> & rule, std::map<uint32_t, uint32_t> & tables, IfIndexTable<const wchar_t *> & ifs, const uint32_t & version, const std::shared_ptr<const SnapshotChanges> & changes, NetRoutes & routes);
 	#else
-	explicit NetcfgIpRoute(uint32_t index, uint8_t family, std::deque<IpRouteInfo> & inet, std::map<uint32_t, std::wstring> & ifs);
+	explicit NetcfgIpRoute(uint32_t index, uint8_t family, std::deque<IpRouteInfo> & inet, IfIndexTable<const wchar_t *> & ifs, const uint32_t & version, const std::shared_ptr<const SnapshotChanges> & changes);
 	#endif
 	virtual ~NetcfgIpRoute();
 };
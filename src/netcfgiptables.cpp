@@ -25,9 +25,9 @@ extern const char * LOG_FILE;
 
 #if !defined(__APPLE__) && !defined(__FreeBSD__)
 
-NetcfgTablesRoute::NetcfgTablesRoute(uint32_t index_, std::deque<IpRouteInfo> & inet_):
+NetcfgTablesRoute::NetcfgTablesRoute(uint32_t index_, std::map<uint32_t, uint32_t> & tables_):
 	FarPanel(index_),
-	inet(inet_)
+	tables(tables_)
 {
 	LOG_INFO("\n");
 }
@@ -61,17 +61,16 @@ int NetcfgTablesRoute::ProcessKey(HANDLE hPlugin, int key, unsigned int controlS
 int NetcfgTablesRoute::GetFindData(struct PluginPanelItem **pPanelItem, int *pItemsNumber)
 {
 	LOG_INFO("\n");
-	std::map<int, int> tables{{0,0},{253,0},{254,0},{255,0}};
-	for( const auto & item : inet ) {
-		auto [it, success] = tables.try_emplace(item.osdep.table, 0);
-		tables[0]++;
-		it->second++;
+	std::map<uint32_t, uint32_t> dirs{{0,0},{253,0},{254,0},{255,0}};
+	for( const auto & [table, count] : tables ) {
+		dirs[table] += count;
+		dirs[0] += count;
 	}
-	*pItemsNumber = tables.size();
+	*pItemsNumber = dirs.size();
 	*pPanelItem = (struct PluginPanelItem *)malloc((*pItemsNumber) * sizeof(PluginPanelItem));
 	memset(*pPanelItem, 0, (*pItemsNumber) * sizeof(PluginPanelItem));
 	PluginPanelItem * pi = *pPanelItem;
-	for( const auto & item : tables ) {
+	for( const auto & item : dirs ) {
 		pi->FindData.dwFileAttributes = FILE_ATTRIBUTE_DIRECTORY;
 		pi->FindData.nFileSize = item.first;
 
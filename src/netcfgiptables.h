@@ -6,6 +6,7 @@
 #include "netcfgrules.h"
 #include "netcfgarp.h"
 #include <memory>
+#include <map>
 
 enum {
 	RouteIpTablesColumnTotalIndex,
@@ -15,7 +16,8 @@ enum {
 class NetcfgTablesRoute : public FarPanel
 {
 private:
-	std::deque<IpRouteInfo> & inet;
+	// routes per table, counted without loading routes
+	std::map<uint32_t, uint32_t> & tables;
 	uint32_t dirIndex;
 	uint32_t topIndex;
 public:
@@ -24,7 +26,7 @@ public:
 	void FreeFindData(struct PluginPanelItem * panelItem, int itemsNumber) override;
 	uint32_t GetTable(void);
 	void SetLastPosition(HANDLE hPlugin);
-	explicit NetcfgTablesRoute(uint32_t index, std::deque<IpRouteInfo> & inet);
+	explicit NetcfgTablesRoute(uint32_t index, std::map<uint32_t, uint32_t> & tables);
 	~NetcfgTablesRoute();
 };
 
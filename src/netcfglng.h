@@ -54,6 +54,13 @@ enum {
 
 	MConfigPluginSettings,
 	MConfigSaveSettings,
+
+	MPanelUpdating,
+
+	MRouteToTitle,
+	MRouteToAddress,
+	MRouteToInvalid,
+	MRouteToNotFound,
 	MMaxString
 };
 
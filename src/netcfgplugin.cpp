@@ -43,6 +43,11 @@ NetCfgPlugin::NetCfgPlugin(const PluginStartupInfo * info)
 
 	cfg = new PluginCfg();
 
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	// one request socket for all panels and refreshes
+	OpenNetlinkSession();
+#endif
+
 	panel.push_back(std::make_shared<NetcfgInterfaces>(IfcsPanelIndex));
 	panel.push_back(std::make_shared<NetcfgRoutes>());
 
@@ -55,6 +60,18 @@ NetCfgPlugin::~NetCfgPlugin()
 
 	panel.clear();
 
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	CloseNetlinkSession();
+
+	NetlinkStats stats;
+	GetNetlinkStats(&stats);
+	double open_ms = stats.opened ? (double)stats.open_ns / stats.opened / 1e6:0;
+	LOG_INFO("netlink: %llu sockets opened, %.3f ms each, %llu of %llu acquires reused session (%.3f ms saved), %llu dumps, %.3f ms each, %llu datagrams by %llu receive syscalls\n",
+		(unsigned long long)stats.opened, open_ms, (unsigned long long)stats.reused, (unsigned long long)stats.acquired,
+		open_ms * stats.reused, (unsigned long long)stats.dumps, stats.dumps ? (double)stats.dump_ns / stats.dumps / 1e6:0,
+		(unsigned long long)stats.datagrams, (unsigned long long)stats.recvs);
+#endif
+
 	delete cfg;
 	cfg = nullptr;
 
@@ -124,3 +141,12 @@ int NetCfgPlugin::ProcessKey(HANDLE hPlugin,int key,unsigned int controlState)
 	}
 	return res;
 }
+
+void NetCfgPlugin::ProcessIdle(HANDLE hPlugin)
+{
+	if( static_cast<FarPanel *>(hPlugin)->ProcessIdle() ) {
+		LOG_INFO("NetCfgPlugin::ProcessIdle() redraw\n");
+		psi.Control(hPlugin, FCTL_UPDATEPANEL, TRUE, 0);
+		psi.Control(hPlugin, FCTL_REDRAWPANEL, 0, 0);
+	}
+}
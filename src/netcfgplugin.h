@@ -56,6 +56,7 @@ class NetCfgPlugin {
 		void ClosePlugin(HANDLE hPlugin);
 		void GetOpenPluginInfo(HANDLE hPlugin, struct OpenPluginInfo *info);
 		int ProcessKey(HANDLE hPlugin,int key,unsigned int controlState);
+		void ProcessIdle(HANDLE hPlugin);
 		int Configure(int itemNumber);
 };
 
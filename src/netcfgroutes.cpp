@@ -29,24 +29,29 @@ NetcfgRoutes::NetcfgRoutes():
 	LOG_INFO("\n");
 
 	nrts = std::make_unique<NetRoutes>();
+	updater = std::make_unique<NetRoutesUpdater>();
 
 	change = true;
+	updating = false;
 
 	#if !defined(__APPLE__) && !defined(__FreeBSD__)
-	panels.push_back(std::make_unique<NetcfgIpRoute>(RouteInetPanelIndex, AF_INET, nrts->inet, nrts->rule, nrts->ifs));
-	panels.push_back(std::make_unique<NetcfgIpRoute>(RouteInet6PanelIndex, AF_INET6, nrts->inet6, nrts->rule6, nrts->ifs));
+	memset(&routeFilter, 0, sizeof(routeFilter));
+	tablesOnly = false;
+	AddPanel(std::make_unique<NetcfgIpRoute>(RouteInetPanelIndex, AF_INET, nrts->inet, nrts->rule, nrts->inetTables, nrts->ifs, nrts->version, nrts->changes, *nrts));
+	AddPanel(std::make_unique<NetcfgIpRoute>(RouteInet6PanelIndex, AF_INET6, nrts->inet6, nrts->rule6, nrts->inet6Tables, nrts->ifs, nrts->version, nrts->changes, *nrts));
 	#else
-	panels.push_back(std::make_unique<NetcfgIpRoute>(RouteInetPanelIndex, AF_INET, nrts->inet, nrts->ifs));
-	panels.push_back(std::make_unique<NetcfgIpRoute>(RouteInet6PanelIndex, AF_INET6, nrts->inet6, nrts->ifs));
+	panels.push_back(std::make_unique<NetcfgIpRoute>(RouteInetPanelIndex, AF_INET, nrts->inet, nrts->ifs, nrts->version, nrts->changes));
+	panels.push_back(std::make_unique<NetcfgIpRoute>(RouteInet6PanelIndex, AF_INET6, nrts->inet6, nrts->ifs, nrts->version, nrts->changes));
 	#endif
 
-	panels.push_back(std::make_unique<NetcfgArpRoute>(RouteArpPanelIndex, nrts->arp, nrts->ifs));
+	panels.push_back(std::make_unique<NetcfgArpRoute>(RouteArpPanelIndex, nrts->arp, nrts->ifs, nrts->version, nrts->changes));
 
 	#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	routePanels.push_back(nullptr);
 	if( mcinetPanelValid )
-		panels.push_back(std::make_unique<NetcfgIpRoute>(RouteMcInetPanelIndex, RTNL_FAMILY_IPMR, nrts->mcinet, nrts->mcrule, nrts->ifs));
+		AddPanel(std::make_unique<NetcfgIpRoute>(RouteMcInetPanelIndex, RTNL_FAMILY_IPMR, nrts->mcinet, nrts->mcrule, nrts->mcinetTables, nrts->ifs, nrts->version, nrts->changes, *nrts));
 	if( mcinet6PanelValid )
-		panels.push_back(std::make_unique<NetcfgIpRoute>(RouteMcInet6PanelIndex, RTNL_FAMILY_IP6MR, nrts->mcinet6, nrts->mcrule6, nrts->ifs));
+		AddPanel(std::make_unique<NetcfgIpRoute>(RouteMcInet6PanelIndex, RTNL_FAMILY_IP6MR, nrts->mcinet6, nrts->mcrule6, nrts->mcinet6Tables, nrts->ifs, nrts->version, nrts->changes, *nrts));
 	#endif
 
 	active = 0;
@@ -58,6 +63,14 @@ NetcfgRoutes::~NetcfgRoutes()
 
 }
 
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+void NetcfgRoutes::AddPanel(std::unique_ptr<NetcfgIpRoute> panel)
+{
+	routePanels.push_back(panel.get());
+	panels.push_back(std::move(panel));
+}
+#endif
+
 const int EDIT_SETTINGS_DIALOG_WIDTH = 84;
 
 enum {
@@ -185,11 +198,29 @@ int NetcfgRoutes::ProcessKey(HANDLE hPlugin, int key, unsigned int controlState,
 
 int NetcfgRoutes::GetFindData(struct PluginPanelItem **pPanelItem, int *pItemsNumber)
 {
-	if( change && nrts->Update() ) {
-		nrts->Log();
+	#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	// kernel dumps only routes of shown family and table, directory of tables
+	// gets counts only, other panels keep filter of the last routes view
+	if( routePanels[active] ) {
+		RouteFilter filter;
+		bool counts = routePanels[active]->GetRouteFilter(filter);
+		if( !SameRouteFilter(&filter, &routeFilter) || counts != tablesOnly ) {
+			routeFilter = filter;
+			tablesOnly = counts;
+			updater->SetRouteFilter(filter, counts);
+			change = true;
+		}
+	}
+	#endif
+
+	if( change ) {
+		updater->Request();
 		change = false;
 	}
 
+	if( updater->Exchange(*nrts) )
+		nrts->Log();
+
 	LOG_INFO("active %u\n", active);
 	return panels[active]->GetFindData(pPanelItem, pItemsNumber);
 }
@@ -204,4 +235,19 @@ void NetcfgRoutes::GetOpenPluginInfo(struct OpenPluginInfo * info)
 {
 	LOG_INFO("NetcfgRoutes::GetOpenPluginInfo()\n");
 	panels[active]->GetOpenPluginInfo(info);
+
+	updating = updater->IsUpdating();
+	if( info->PanelTitle && (updating || nrts->changes->Total()) ) {
+		title = info->PanelTitle;
+		AppendChanges(title, *nrts->changes);
+		if( updating )
+			title += GetMsg(MPanelUpdating);
+		info->PanelTitle = (TCHAR*)title.c_str();
+	}
+}
+
+bool NetcfgRoutes::ProcessIdle(void)
+{
+	// new snapshot is ready or "updating" marker must be removed
+	return updater->IsReady() || (updating && !updater->IsUpdating());
 }
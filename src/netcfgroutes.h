@@ -3,6 +3,7 @@
 
 #include "farpanel.h"
 #include "netroute/netroutes.h"
+#include "netroute/netroutesupdater.h"
 #include "netcfgiproutes.h"
 #include "netcfgarp.h"
 #include <memory>
@@ -13,10 +14,21 @@
 class NetcfgRoutes : public FarPanel
 {
 private:
+	// panels show nrts only, new data is exchanged with updater buffer
 	std::unique_ptr<NetRoutes> nrts;
+	std::unique_ptr<NetRoutesUpdater> updater;
+	bool updating;
+	std::wstring title;
 
 	uint32_t active;
 	std::vector<std::unique_ptr<FarPanel>> panels;
+	#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	// the same panels if they show routes, nullptr otherwise
+	std::vector<NetcfgIpRoute *> routePanels;
+	RouteFilter routeFilter;
+	bool tablesOnly;
+	void AddPanel(std::unique_ptr<NetcfgIpRoute> panel);
+	#endif
 
 	bool change;
 
@@ -32,6 +44,7 @@ public:
 	int GetFindData(struct PluginPanelItem **pPanelItem, int *pItemsNumber) override;
 	void FreeFindData(struct PluginPanelItem * panelItem, int itemsNumber) override;
 	void GetOpenPluginInfo(struct OpenPluginInfo * info) override;
+	bool ProcessIdle(void) override;
 	explicit NetcfgRoutes();
 	virtual ~NetcfgRoutes();
 };
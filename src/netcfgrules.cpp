@@ -24,7 +24,7 @@ extern const char * LOG_FILE;
 #define LOG_SOURCE_FILE "netcfgrules.cpp"
 
 #if !defined(__APPLE__) && !defined(__FreeBSD__)
-NetcfgIpRule::NetcfgIpRule(uint32_t index_, uint8_t family_, std::deque<RuleRouteInfo> & rule_, std::map<uint32_t, std::wstring> & ifs_):
+NetcfgIpRule::NetcfgIpRule(uint32_t index_, uint8_t family_, std::deque<RuleRouteInfo> & rule_, IfIndexTable<const wchar_t *> & ifs_):
 	NetFarPanel(index_, ifs_),
 	rule(rule_),
 	family(family_)
@@ -97,8 +97,7 @@ bool NetcfgIpRule::DeleteRule(void)
 		if( dlg.Run() != static_cast<int>(offSufix) + WinSuffixOkIndex )
 			break;
 
-		for( auto & r : delrules )
-			change |= r->DeleteRule();
+		change = RuleRouteInfo::DeleteRules(delrules) != 0;
 
 	} while(0);
 
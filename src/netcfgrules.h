@@ -30,7 +30,7 @@ public:
 	int ProcessKey(HANDLE hPlugin, int key, unsigned int controlState, bool & change) override;
 	int GetFindData(struct PluginPanelItem **pPanelItem, int *pItemsNumber) override;
 	void FreeFindData(struct PluginPanelItem * panelItem, int itemsNumber) override;
-	explicit NetcfgIpRule(uint32_t index, uint8_t family, std::deque<RuleRouteInfo> & rule, std::map<uint32_t, std::wstring> & ifs);
+	explicit NetcfgIpRule(uint32_t index, uint8_t family, std::deque<RuleRouteInfo> & rule, IfIndexTable<const wchar_t *> & ifs);
 	~NetcfgIpRule();
 };
 
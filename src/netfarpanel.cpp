@@ -21,7 +21,7 @@
 extern const char * LOG_FILE;
 #define LOG_SOURCE_FILE "netfarpanel.cpp"
 
-NetFarPanel::NetFarPanel(uint32_t index_, std::map<uint32_t, std::wstring> & ifs_):
+NetFarPanel::NetFarPanel(uint32_t index_, IfIndexTable<const wchar_t *> & ifs_):
 	FarPanel(index_),
 	ifs(ifs_)
 {
@@ -35,21 +35,30 @@ NetFarPanel::~NetFarPanel()
 
 const wchar_t * NetFarPanel::GetInterfaceByIndex(uint32_t ifindex)
 {
-		auto it = ifs.find(ifindex);
-		if( it != ifs.end() )
-			return it->second.c_str();
+		const wchar_t * const * name = ifs.Find(ifindex);
+		if( name )
+			return *name;
 		return L"";
 }
 
+const wchar_t * NetFarPanel::GetInterfaceName(const std::wstring & iface, bool validIndex, uint32_t ifindex)
+{
+	if( !iface.empty() || !validIndex )
+		return iface.c_str();
+	return GetInterfaceByIndex(ifindex);
+}
+
 bool NetFarPanel::SelectInterface(HANDLE hDlg, uint32_t setIndex, uint32_t *ifindex)
 {
-	int if_count = ifs.size()+1, index = 0;
+	int if_count = ifs.Size()+1, index = 0;
 	auto menuElements = std::make_unique<FarMenuItem[]>(if_count);
+	auto menuIndexes = std::make_unique<uint32_t[]>(if_count);
 	memset(menuElements.get(), 0, sizeof(FarMenuItem)*if_count);
-	for( const auto& [if_index, name] : ifs ) {
-		menuElements[index].Text = name.c_str();
+	ifs.ForEach([&](uint32_t if_index, const wchar_t * name) {
+		menuElements[index].Text = name;
+		menuIndexes[index] = if_index;
 		index++;
-	}
+	});
 
 	menuElements[index].Text = L"";
 	index++;
@@ -60,12 +69,11 @@ bool NetFarPanel::SelectInterface(HANDLE hDlg, uint32_t setIndex, uint32_t *ifin
 
 	if( index >= 0 && index < if_count ) {
 		NetCfgPlugin::psi.SendDlgMessage(hDlg, DM_SETTEXTPTR, setIndex, (LONG_PTR)menuElements[index].Text);
-		for( auto & [ if_index, name ]: ifs ) {
-			if( name == menuElements[index].Text ) {
-				if( ifindex )
-					*ifindex = if_index;
-				return true;
-			}
+		// last empty item clears interface
+		if( index < if_count - 1 ) {
+			if( ifindex )
+				*ifindex = menuIndexes[index];
+			return true;
 		}
 	}
 	return false;
@@ -2,23 +2,26 @@
 #define __NETFARPANEL_H__
 
 #include "farpanel.h"
+#include "netif/ifindextable.h"
 #include <memory>
 #include <map>
 
 class NetFarPanel : public FarPanel {
 private:
-	std::map<uint32_t, std::wstring> & ifs;
+	IfIndexTable<const wchar_t *> & ifs;
 public:
 
 	bool SelectInterface(HANDLE hDlg, uint32_t setIndex, uint32_t *ifindex);
 	const wchar_t * GetInterfaceByIndex(uint32_t ifindex);
+	// name kept by item itself (set by user or parsed from text) or found by index
+	const wchar_t * GetInterfaceName(const std::wstring & iface, bool validIndex, uint32_t ifindex);
 	uint8_t SelectFamily(HANDLE hDlg, uint32_t setIndex);
 #if !defined(__APPLE__) && !defined(__FreeBSD__)
 	uint8_t SelectProto(HANDLE hDlg, uint32_t setIndex, uint8_t old_proto);
 	uint32_t SelectTable(HANDLE hDlg, uint32_t setIndex, uint32_t old_table);
 #endif
 
-	explicit NetFarPanel(uint32_t index, std::map<uint32_t, std::wstring> & ifs);
+	explicit NetFarPanel(uint32_t index, IfIndexTable<const wchar_t *> & ifs);
 	virtual ~NetFarPanel();
 };
 
@@ -0,0 +1,97 @@
+#ifndef __IFINDEXTABLE_H__
+#define __IFINDEXTABLE_H__
+
+#include <stdint.h>
+#include <vector>
+#include <map>
+
+// Values by interface index. Kernel gives indexes one by one starting from 1,
+// so they are kept in vector and lookup is one access instead of map or list walk.
+// Far indexes (ip link add ... index N) are kept in map.
+template<typename T>
+class IfIndexTable {
+	private:
+		static const uint32_t DenseLimit = 1 << 16;
+
+		std::vector<T> dense;
+		std::vector<bool> present;
+		std::map<uint32_t, T> sparse;
+		size_t count;
+
+	public:
+		IfIndexTable(): count(0) {};
+
+		// nullptr if ifindex is absent
+		T * Find(uint32_t ifindex)
+		{
+			if( ifindex < DenseLimit )
+				return ifindex < present.size() && present[ifindex] ? &dense[ifindex]:nullptr;
+			auto it = sparse.find(ifindex);
+			return it != sparse.end() ? &it->second:nullptr;
+		};
+
+		const T * Find(uint32_t ifindex) const
+		{
+			return const_cast<IfIndexTable *>(this)->Find(ifindex);
+		};
+
+		// default value is inserted if ifindex is absent
+		T & operator[](uint32_t ifindex)
+		{
+			if( ifindex >= DenseLimit ) {
+				auto res = sparse.emplace(ifindex, T());
+				count += res.second;
+				return res.first->second;
+			}
+
+			if( ifindex >= present.size() ) {
+				dense.resize(ifindex + 1);
+				present.resize(ifindex + 1);
+			}
+			if( !present[ifindex] ) {
+				present[ifindex] = true;
+				count++;
+			}
+			return dense[ifindex];
+		};
+
+		bool Erase(uint32_t ifindex)
+		{
+			if( ifindex >= DenseLimit ) {
+				bool res = sparse.erase(ifindex) != 0;
+				count -= res;
+				return res;
+			}
+
+			if( ifindex >= present.size() || !present[ifindex] )
+				return false;
+			present[ifindex] = false;
+			dense[ifindex] = T();
+			count--;
+			return true;
+		};
+
+		void Clear(void)
+		{
+			dense.clear();
+			present.clear();
+			sparse.clear();
+			count = 0;
+		};
+
+		size_t Size(void) const { return count; };
+
+		// fn(ifindex, value) in order of indexes
+		template<typename F>
+		void ForEach(F fn) const
+		{
+			for( uint32_t ifindex = 0; ifindex < present.size(); ifindex++ ) {
+				if( present[ifindex] )
+					fn(ifindex, dense[ifindex]);
+			}
+			for( const auto & [ifindex, value] : sparse )
+				fn(ifindex, value);
+		};
+};
+
+#endif /* __IFINDEXTABLE_H__ */
@@ -0,0 +1,106 @@
+#ifndef __NAMEPOOL_H__
+#define __NAMEPOOL_H__
+
+#include <stddef.h>
+#include <string.h>
+#include <wchar.h>
+#include <common/widestr.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Distinct names (interfaces, tables, protocols) kept once. Intern() returns
+// zero terminated copy which is not moved until Clear(), so equal names have
+// equal pointers and are compared as pointers. Copies are placed one after another
+// in blocks, so pool of thousands of names is a few allocations released at once.
+class NamePool {
+	private:
+		static const size_t BlockSize = 4096;
+		// narrow names up to this length are widened without allocation
+		static const size_t ShortName = 64;
+
+		std::vector<std::unique_ptr<wchar_t[]>> blocks;
+		wchar_t * next;
+		size_t left;
+		size_t memory;
+		std::unordered_set<std::wstring_view> names;
+
+		wchar_t * Allocate(size_t len)
+		{
+			if( len > BlockSize / 4 ) {
+				// long name gets its own block, current one is filled further
+				blocks.emplace_back(new wchar_t[len]);
+				memory += len * sizeof(wchar_t);
+				return blocks.back().get();
+			}
+			if( len > left ) {
+				blocks.emplace_back(new wchar_t[BlockSize]);
+				memory += BlockSize * sizeof(wchar_t);
+				next = blocks.back().get();
+				left = BlockSize;
+			}
+			wchar_t * ptr = next;
+			next += len;
+			left -= len;
+			return ptr;
+		};
+
+		// copy and assignment not allowed, names of copy would point to blocks of original
+		NamePool(const NamePool&) = delete;
+		void operator=(const NamePool&) = delete;
+
+	public:
+		NamePool(): next(nullptr), left(0), memory(0) {};
+
+		const wchar_t * Intern(std::wstring_view name)
+		{
+			auto it = names.find(name);
+			if( it != names.end() )
+				return it->data();
+
+			wchar_t * copy = Allocate(name.size() + 1);
+			wmemcpy(copy, name.data(), name.size());
+			copy[name.size()] = L'\0';
+			names.emplace(copy, name.size());
+			return copy;
+		};
+
+		// ASCII name, e.g. from netlink or if_indextoname()
+		const wchar_t * Intern(const char * name)
+		{
+			size_t len = strlen(name);
+			if( len > ShortName )
+				return Intern(towstr(name));
+
+			wchar_t wide[ShortName];
+			widen_ascii(wide, name, len);
+			return Intern(std::wstring_view(wide, len));
+		};
+
+		// kept names do not move, pointers given by other stay valid
+		void Swap(NamePool & other)
+		{
+			blocks.swap(other.blocks);
+			names.swap(other.names);
+			std::swap(next, other.next);
+			std::swap(left, other.left);
+			std::swap(memory, other.memory);
+		};
+
+		void Clear(void)
+		{
+			names.clear();
+			blocks.clear();
+			next = nullptr;
+			left = 0;
+			memory = 0;
+		};
+
+		size_t Size(void) const { return names.size(); };
+		size_t Memory(void) const { return memory; };
+};
+
+#endif /* __NAMEPOOL_H__ */
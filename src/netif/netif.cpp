@@ -7,6 +7,8 @@
 #include <common/netlink.h>
 #include <common/sizestr.h>
 
+#include <vector>
+
 #define LOG_SOURCE_FILE "netif.cpp"
 #ifndef MAIN_NETIF
 extern const char * LOG_FILE;
@@ -54,6 +56,10 @@ extern "C" {
 #define IFF_ECHO 0x40000
 #endif //IFF_ECHO
 
+#ifndef MAX_ADDR_LEN
+#define MAX_ADDR_LEN 32
+#endif //MAX_ADDR_LEN
+
 #if !defined(__APPLE__) && !defined(__FreeBSD__)
 bool NetInterface::HasAcceptRaRtTable(void)
 {
@@ -512,6 +518,49 @@ void NetInterface::Log(void)
 	#endif
 }
 
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+// ethtool fallback for kernels without IFLA_PERM_ADDRESS, asked once per interface
+void NetInterface::UpdatePermanentMac(void)
+{
+	std::string iface(name.begin(), name.end());
+
+	if( osdep.valid.perm_addr_asked )
+		return;
+	osdep.valid.perm_addr_asked = 1;
+
+	int isocket = socket(AF_INET, SOCK_DGRAM, 0);
+	if( isocket < 0 ) {
+		LOG_ERROR("socket(AF_INET, SOCK_STREAM, 0) ... error (%s)\n", errorname(errno));
+		return;
+	}
+
+	struct ifreq paifr;
+	memset(&paifr, 0, sizeof(paifr));
+	strncpy(paifr.ifr_name, iface.c_str(), iface.size());
+
+	struct ethtool_perm_addr * epa = (struct ethtool_perm_addr*)malloc(sizeof(struct ethtool_perm_addr) + IFHWADDRLEN);
+	if( epa ) {
+		epa->cmd = ETHTOOL_GPERMADDR;
+		epa->size = IFHWADDRLEN;
+		paifr.ifr_data = (caddr_t)epa;
+		if( ioctl(isocket, SIOCETHTOOL, &paifr) >= 0 ) {
+			char s[INET6_ADDRSTRLEN > INET_ADDRSTRLEN ? INET6_ADDRSTRLEN : INET_ADDRSTRLEN] = {0};
+			if( snprintf(s, sizeof(s), "%02x:%02x:%02x:%02x:%02x:%02x", \
+					epa->data[0], epa->data[1], epa->data[2], \
+					epa->data[3],epa->data[4],epa->data[5]) > 0 ) {
+				std::string _name(s);
+				permanent_mac = std::wstring(_name.begin(), _name.end());
+			}
+		} else
+			LOG_ERROR("ioctl(SIOCETHTOOL) ... error (%s)\n", errorname(errno));
+
+		free(epa);
+	}
+
+	close(isocket);
+}
+#endif
+
 bool NetInterface::UpdateStats(void)
 {
 	std::string iface(name.begin(), name.end());
@@ -579,27 +628,10 @@ bool NetInterface::UpdateStats(void)
 	else
 		LOG_ERROR("ioctl(SIOCGIFMTU) ... error (%s)\n", errorname(errno));
 
-	struct ethtool_perm_addr * epa = (struct ethtool_perm_addr*)malloc(sizeof(struct ethtool_perm_addr) + IFHWADDRLEN);
-	if( epa ) {
-		epa->cmd = ETHTOOL_GPERMADDR;
-		epa->size = IFHWADDRLEN;
-		paifr.ifr_data = (caddr_t)epa;
-		if( ioctl(isocket, SIOCETHTOOL, &paifr) >= 0 ) {
-			char s[INET6_ADDRSTRLEN > INET_ADDRSTRLEN ? INET6_ADDRSTRLEN : INET_ADDRSTRLEN] = {0};
-			if( snprintf(s, sizeof(s), "%02x:%02x:%02x:%02x:%02x:%02x", \
-					epa->data[0], epa->data[1], epa->data[2], \
-					epa->data[3],epa->data[4],epa->data[5]) > 0 ) {
-				std::string _name(s);
-				permanent_mac = std::wstring(_name.begin(), _name.end());
-			}
-		} else
-			LOG_ERROR("ioctl(SIOCETHTOOL) ... error (%s)\n", errorname(errno));
-
-		free(epa);
-	}
-
 	close(isocket);
 
+	UpdatePermanentMac();
+
 	#else
 
 	int mib[6] = {CTL_NET, PF_ROUTE, 0, 0, NET_RT_IFLIST2, 0};
@@ -688,14 +720,176 @@ bool NetInterface::IsEcho() { return ifa_flags & IFF_ECHO; };
 
 extern int RootExec(const char * cmd);
 
+// Steps of one change (link down, new address, link up) are rtnetlink requests
+// sent by one batch and acknowledged together, so link is down only for one round-trip.
+// Shell command is executed only if netlink can`t be used or requests were not permitted.
+class LinkChange {
+private:
+	void * nl;
+	uint32_t ifindex;
+	bool valid;
+
+	// copy and assignment not allowed
+	LinkChange(const LinkChange&) = delete;
+	void operator=(const LinkChange&) = delete;
+
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	bool Link(void) {
+		struct ifinfomsg ifi = {0};
+		ifi.ifi_family = AF_UNSPEC;
+		ifi.ifi_index = ifindex;
+		return AddRequest(nl, RTM_NEWLINK, 0, &ifi, sizeof(ifi)) != 0;
+	}
+
+	bool Addr(uint16_t type, uint16_t flags, int family, const wchar_t * ip, int prefixlen, const wchar_t * broadcast) {
+		struct ifaddrmsg ifa = {0};
+		struct in6_addr addr, brd;
+		std::string _ip(ip, ip+wcslen(ip));
+		size_t size = family == AF_INET6 ? sizeof(struct in6_addr):sizeof(struct in_addr);
+
+		if( inet_pton(family, _ip.c_str(), &addr) != 1 )
+			return false;
+		if( broadcast ) {
+			std::string _brd(broadcast, broadcast+wcslen(broadcast));
+			if( inet_pton(family, _brd.c_str(), &brd) != 1 )
+				return false;
+		}
+
+		ifa.ifa_family = family;
+		ifa.ifa_prefixlen = prefixlen;
+		ifa.ifa_index = ifindex;
+		if( !AddRequest(nl, type, flags, &ifa, sizeof(ifa)) )
+			return false;
+
+		bool res = AddRequestAttr(nl, IFA_LOCAL, &addr, size);
+		res &= AddRequestAttr(nl, IFA_ADDRESS, &addr, size);
+		if( broadcast )
+			res &= AddRequestAttr(nl, IFA_BROADCAST, &brd, size);
+		return res;
+	}
+#endif
+public:
+	explicit LinkChange(uint32_t ifindex_):
+		nl(0),
+		ifindex(ifindex_),
+		valid(ifindex_ != 0)
+	{
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+		if( valid )
+			nl = AcquireNetlink();
+#endif
+	}
+
+	~LinkChange()
+	{
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+		if( nl )
+			ReleaseNetlink(nl);
+#endif
+	}
+
+	LinkChange & Flags(uint32_t flag, bool on)
+	{
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+		if( nl && valid ) {
+			struct ifinfomsg ifi = {0};
+			ifi.ifi_family = AF_UNSPEC;
+			ifi.ifi_index = ifindex;
+			ifi.ifi_change = flag;
+			ifi.ifi_flags = on ? flag:0;
+			valid = AddRequest(nl, RTM_NEWLINK, 0, &ifi, sizeof(ifi)) != 0;
+		}
+#endif
+		return *this;
+	}
+
+	LinkChange & Mtu(uint32_t mtu)
+	{
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+		if( nl && valid )
+			valid = Link() && AddRequestAttr(nl, IFLA_MTU, &mtu, sizeof(mtu));
+#endif
+		return *this;
+	}
+
+	LinkChange & Name(const wchar_t * name)
+	{
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+		std::string _name(name, name+wcslen(name));
+		if( _name.empty() || _name.size() >= IFNAMSIZ )
+			valid = false;
+		if( nl && valid )
+			valid = Link() && AddRequestAttr(nl, IFLA_IFNAME, _name.c_str(), _name.size() + 1);
+#endif
+		return *this;
+	}
+
+	LinkChange & Mac(const wchar_t * mac)
+	{
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+		std::string _mac(mac, mac+wcslen(mac));
+		uint8_t lladdr[MAX_ADDR_LEN];
+		size_t len = MacToBin(_mac.c_str(), lladdr, sizeof(lladdr));
+		if( !len )
+			valid = false;
+		if( nl && valid )
+			valid = Link() && AddRequestAttr(nl, IFLA_ADDRESS, lladdr, len);
+#endif
+		return *this;
+	}
+
+	LinkChange & AddAddr(int family, const wchar_t * ip, int prefixlen, const wchar_t * broadcast)
+	{
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+		if( nl && valid )
+			valid = Addr(RTM_NEWADDR, NLM_F_CREATE | NLM_F_EXCL, family, ip, prefixlen, broadcast);
+#endif
+		return *this;
+	}
+
+	LinkChange & DelAddr(int family, const wchar_t * ip, int prefixlen)
+	{
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+		if( nl && valid )
+			valid = Addr(RTM_DELADDR, 0, family, ip, prefixlen, 0);
+#endif
+		return *this;
+	}
+
+	bool Commit(const char * cmd)
+	{
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+		size_t total = nl ? PendingRequests(nl):0;
+		if( valid && total ) {
+			std::vector<int> errors(total);
+			int failed = CommitRequests(nl, errors.data(), total);
+			if( !failed )
+				return true;
+			// permissions are checked for each request, all of them are refused in this case
+			if( failed > 0 && errors[0] != EPERM && errors[0] != EACCES )
+				return false;
+		}
+#endif
+		return RootExec(cmd) == 0;
+	}
+};
+
 bool NetInterface::SetInterfaceName(const wchar_t * newname)
 {
 	if( name == newname )
 		return false;
 
+	bool up = IsUp();
+	LinkChange change(ifindex);
+	if( up )
+		change.Flags(IFF_UP, false);
+	change.Name(newname);
+	if( up )
+		change.Flags(IFF_UP, true);
+
 	char buffer[MAX_CMD_LEN];
 	if( snprintf(buffer, MAX_CMD_LEN, CHANGEIFNAME_CMD, name.c_str(), name.c_str(), newname, newname) > 0 )
-		if( RootExec(buffer) == 0 ) {
+		if( change.Commit(buffer) ) {
 			name = newname; // we need update ifname for next commands
 			return true;
 		}
@@ -708,12 +902,21 @@ bool NetInterface::SetMac(const wchar_t * newmac)
 		return false;
 	char buffer[MAX_CMD_LEN];
 
+	// most drivers change address only while link is down
+	bool up = IsUp();
+	LinkChange change(ifindex);
+	if( up )
+		change.Flags(IFF_UP, false);
+	change.Mac(newmac);
+	if( up )
+		change.Flags(IFF_UP, true);
+
 #if !defined(__APPLE__) && !defined(__FreeBSD__)
 	if( snprintf(buffer, MAX_CMD_LEN, CHANGEMAC_CMD, name.c_str(), name.c_str(), newmac, name.c_str()) > 0 )
 #else
 	if( snprintf(buffer, MAX_CMD_LEN, CHANGEMAC_CMD, name.c_str(), newmac, name.c_str(), name.c_str()) > 0 )
 #endif
-		if( RootExec(buffer) == 0 )
+		if( change.Commit(buffer) )
 			return true;
 	return false;
 }
@@ -725,7 +928,7 @@ bool NetInterface::SetUp(bool on)
 
 	char buffer[MAX_CMD_LEN];
 	if( snprintf(buffer, MAX_CMD_LEN, on ? SETUP_CMD:SETDOWN_CMD, name.c_str()) > 0 )
-		if( RootExec(buffer) == 0 )
+		if( LinkChange(ifindex).Flags(IFF_UP, on).Commit(buffer) )
 			return true;
 	return false;
 }
@@ -736,7 +939,7 @@ bool NetInterface::SetMulticast(bool on)
 		return false;
 	char buffer[MAX_CMD_LEN];
 	if( snprintf(buffer, MAX_CMD_LEN, on ? SETMULTICASTON_CMD:SETMULTICASTOFF_CMD, name.c_str()) > 0 )
-		if( RootExec(buffer) == 0 )
+		if( LinkChange(ifindex).Flags(IFF_MULTICAST, on).Commit(buffer) )
 			return true;
 	return false;
 }
@@ -747,7 +950,7 @@ bool NetInterface::SetAllmulticast(bool on)
 		return false;
 	char buffer[MAX_CMD_LEN];
 	if( snprintf(buffer, MAX_CMD_LEN, on ? SETALLMULTICASTON_CMD:SETALLMULTICASTOFF_CMD, name.c_str()) > 0 )
-		if( RootExec(buffer) == 0 )
+		if( LinkChange(ifindex).Flags(IFF_ALLMULTI, on).Commit(buffer) )
 			return true;
 	return false;
 }
@@ -758,7 +961,7 @@ bool NetInterface::SetNoARP(bool on)
 		return false;
 	char buffer[MAX_CMD_LEN];
 	if( snprintf(buffer, MAX_CMD_LEN, on ? SETARPON_CMD:SETARPOFF_CMD, name.c_str()) > 0 )
-		if( RootExec(buffer) == 0 )
+		if( LinkChange(ifindex).Flags(IFF_NOARP, on).Commit(buffer) )
 			return true;
 	return false;
 }
@@ -769,7 +972,7 @@ bool NetInterface::SetPromisc(bool on)
 		return false;
 	char buffer[MAX_CMD_LEN];
 	if( snprintf(buffer, MAX_CMD_LEN, on ? SETPROMISCON_CMD:SETPROMISCOFF_CMD, name.c_str()) > 0 )
-		if( RootExec(buffer) == 0 )
+		if( LinkChange(ifindex).Flags(IFF_PROMISC, on).Commit(buffer) )
 			return true;
 	return false;
 }
@@ -780,7 +983,7 @@ bool NetInterface::SetMtu(uint32_t newmtu)
 		return false;
 	char buffer[MAX_CMD_LEN];
 	if( snprintf(buffer, MAX_CMD_LEN, SETMTU_CMD, name.c_str(), newmtu) > 0 )
-		if( RootExec(buffer) == 0 )
+		if( LinkChange(ifindex).Mtu(newmtu).Commit(buffer) )
 			return true;
 	return false;
 }
@@ -800,7 +1003,7 @@ bool NetInterface::DeleteIp(const wchar_t * delip)
 #else
 	if( snprintf(buffer, MAX_CMD_LEN, DELETEIP_CMD, name.c_str(), delip, maskbits) > 0 )
 #endif
-		if( RootExec(buffer) == 0 ) {
+		if( LinkChange(ifindex).DelAddr(AF_INET, delip, maskbits).Commit(buffer) ) {
 			ip.erase(it);
 			return true;
 		}
@@ -822,7 +1025,7 @@ bool NetInterface::DeleteIp6(const wchar_t * delip)
 #else
 	if( snprintf(buffer, MAX_CMD_LEN, DELETEIP6_CMD, name.c_str(), delip, maskbits) > 0 )
 #endif
-		if( RootExec(buffer) == 0 ) {
+		if( LinkChange(ifindex).DelAddr(AF_INET6, delip, maskbits).Commit(buffer) ) {
 			ip6.erase(it);
 			return true;
 		}
@@ -849,7 +1052,7 @@ bool NetInterface::AddIp(const wchar_t * newip, const wchar_t * mask, const wcha
 #else
 	if( snprintf(buffer, MAX_CMD_LEN, ADDIP_CMD, name.c_str(), newip, maskbits, bcip) > 0 )
 #endif
-		if( RootExec(buffer) == 0 ) {
+		if( LinkChange(ifindex).AddAddr(AF_INET, newip, maskbits, bcip).Commit(buffer) ) {
 			// we need update ip and mask for next commands
 			IpAddressInfo _ip;
 			_ip.flags = IFF_BROADCAST;
@@ -875,7 +1078,7 @@ bool NetInterface::AddIp6(const wchar_t * newip, const wchar_t * mask)
 #else
 	if( snprintf(buffer, MAX_CMD_LEN, ADDIP6_CMD, name.c_str(), newip, maskbits) > 0 )
 #endif
-		if( RootExec(buffer) == 0 ) {
+		if( LinkChange(ifindex).AddAddr(AF_INET6, newip, maskbits, 0).Commit(buffer) ) {
 			// we need update ip and mask for next commands
 			IpAddressInfo _ip;
 			_ip.flags = 0;
@@ -914,7 +1117,7 @@ bool NetInterface::ChangeIp(const wchar_t * oldip, const wchar_t * newip, const
 #else
 	if( snprintf(buffer, MAX_CMD_LEN, CHANGEIP_CMD, name.c_str(), oldip, oldmaskbits, name.c_str(), newip, maskbits, bcip) > 0 )
 #endif
-		if( RootExec(buffer) == 0 ) {
+		if( LinkChange(ifindex).DelAddr(AF_INET, oldip, oldmaskbits).AddAddr(AF_INET, newip, maskbits, bcip).Commit(buffer) ) {
 			// we need update ip and mask for next commands
 			IpAddressInfo _ip;
 			_ip.flags = it->second.flags;
@@ -948,7 +1151,7 @@ bool NetInterface::ChangeIp6(const wchar_t * oldip, const wchar_t * newip, const
 #else
 	if( snprintf(buffer, MAX_CMD_LEN, CHANGEIP6_CMD, name.c_str(), oldip, oldmaskbits, name.c_str(), newip, maskbits) > 0 )
 #endif
-		if( RootExec(buffer) == 0 ) {
+		if( LinkChange(ifindex).DelAddr(AF_INET6, oldip, oldmaskbits).AddAddr(AF_INET6, newip, maskbits, 0).Commit(buffer) ) {
 			// we need update ip and mask for next commands
 			IpAddressInfo _ip;
 			_ip.flags = it->second.flags;
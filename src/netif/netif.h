@@ -584,6 +584,7 @@ fq_codel является одной из наиболее эффективны
 			unsigned int master:1;
 			unsigned int parentdev_name:1;
 			unsigned int parentdev_busname:1;
+			unsigned int perm_addr_asked:1;	// ethtool was asked for permanent_mac
 		} valid;
 
 		uint32_t master; // ifmasterindex
@@ -757,6 +758,9 @@ fq_codel является одной из наиболее эффективны
 	void TcpDumpStop(void);
 
 	bool UpdateStats(void);
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	void UpdatePermanentMac(void);
+#endif
 
 	void Log(void);
 	void LogStats(void);
@@ -2,18 +2,42 @@
 #define __NETIFS_H__
 
 #include "netif.h"
+#include "netstats.h"
+#include "ifindextable.h"
+#include "snapshotdiff.h"
 #include <vector>
 
 class NetInterfaces {
 	private:
 		std::map<std::wstring, NetInterface *> ifs;
+		// the same interfaces by ifindex
+		IfIndexTable<NetInterface *> byindex;
 
 		bool UpdateByProcNet(void);
 #if !defined(__APPLE__) && !defined(__FreeBSD__)
 		bool UpdateByNetlink(void);
+
+		// rtnetlink multicast subscription, after full dump
+		// links and addresses are changed by events only
+		void * monitor;
+		bool synced;
+		static int OnNotify(void * arg, const struct nlmsghdr * nlm, const void * record);
+		bool UpdateByNotifications(void);
+		bool UpdateStatsByNetlink(void);
+
+		NetInterface * SetLink(const LinkRecord * lr);
+		void SetAddr(const AddrRecord * ar);
+		void Remove(uint32_t ifindex);
 #endif
 
-		NetInterface * Add(const char * name);
+		// stats - read counters, mtu and permanent mac of new interface by NetInterface::UpdateStats()
+		NetInterface * Add(const char * name, bool stats = true);
+
+		NetStatsSampler sampler;
+
+		// interfaces are compared with previous update
+		SnapshotDiff diff;
+		void UpdateChanges(void);
 
 		// copy and assignment not allowed
 		NetInterfaces(const NetInterfaces&) = delete;
@@ -38,6 +62,19 @@ class NetInterfaces {
 		void TcpDumpStop(const wchar_t * iface);
 
 		bool Update(void);
+
+		// interfaces added, removed and modified by the last Update(), never nullptr
+		std::shared_ptr<const SnapshotChanges> changes;
+		static uint64_t InterfaceKey(uint32_t ifindex) { return RowHash().Add(ifindex).Value(); };
+
+		// counters of all interfaces are refreshed by one dump, not often than once per interval,
+		// returns true if new sample is taken
+		bool SampleStats(void);
+		void SetStatsInterval(uint32_t interval) { sampler.SetInterval(interval); };
+		bool GetRates(uint32_t ifindex, NetStatsSampler::Rates & rates) const { return sampler.GetRates(ifindex, rates); };
+		// counters and rates shown by panel, equal values give equal fingerprint
+		uint64_t StatsFingerprint(void) const;
+
 		void Log(void);
 		void Clear(void);
 };
@@ -333,7 +333,7 @@ extern int RootExec(const char * cmd);
 //   id 42 dev eth0 group 239.0.0.1 dstport 4789
 //После этого нужно поднять линк и либо соединить его с другим интерфейсом, либо присвоить ему адрес.
 
-
+// commands below are executed only if rtnetlink requests were not permitted (see LinkChange in netif.cpp)
 #define SETMULTICASTON_CMD     "ip link set dev %S multicast on"
 #define SETMULTICASTOFF_CMD    "ip link set dev %S multicast off"
 
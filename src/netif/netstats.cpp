@@ -0,0 +1,158 @@
+#include "netstats.h"
+#include "netif.h"
+
+#include <common/log.h>
+
+#include <time.h>
+
+#ifndef MAIN_NETSTATS
+extern const char * LOG_FILE;
+#else
+const char * LOG_FILE = "";
+#endif
+
+#define LOG_SOURCE_FILE "netstats.cpp"
+
+NetStatsSampler::NetStatsSampler(uint32_t interval_):
+	interval(interval_),
+	generation(0),
+	last(0),
+	now(0)
+{
+}
+
+uint64_t NetStatsSampler::Now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+bool NetStatsSampler::IsDue(void) const
+{
+	return interval && (!last || Now() - last >= interval);
+}
+
+void NetStatsSampler::Begin(void)
+{
+	now = Now();
+	generation++;
+}
+
+static bool IsDecreased(const NetStatsSampler::Rates & prev, const NetStatsSampler::Rates & cur)
+{
+	return cur.recv_bytes < prev.recv_bytes || cur.send_bytes < prev.send_bytes ||
+		cur.recv_packets < prev.recv_packets || cur.send_packets < prev.send_packets ||
+		cur.recv_errors < prev.recv_errors || cur.send_errors < prev.send_errors;
+}
+
+void NetStatsSampler::Add(const NetInterface * net_if)
+{
+	Ring & ring = rings[net_if->ifindex];
+	Sample & sample = ring.samples[ring.head];
+
+	sample.time = now;
+	sample.counters.recv_bytes = net_if->recv_bytes;
+	sample.counters.send_bytes = net_if->send_bytes;
+	sample.counters.recv_packets = net_if->recv_packets;
+	sample.counters.send_packets = net_if->send_packets;
+	sample.counters.recv_errors = net_if->recv_errors;
+	sample.counters.send_errors = net_if->send_errors;
+
+	// counters are reset (ifindex reused or driver reloaded), old samples are useless
+	if( ring.count && IsDecreased(ring.samples[(ring.head + RingSize - 1) % RingSize].counters, sample.counters) ) {
+		LOG_INFO("%S: counters are reset\n", net_if->name.c_str());
+		ring.samples[0] = sample;
+		ring.head = 0;
+		ring.count = 0;
+	}
+
+	ring.head = (ring.head + 1) % RingSize;
+	if( ring.count < RingSize )
+		ring.count++;
+	ring.generation = generation;
+}
+
+void NetStatsSampler::End(void)
+{
+	for( auto it = rings.begin(); it != rings.end(); ) {
+		if( it->second.generation != generation )
+			it = rings.erase(it);
+		else
+			++it;
+	}
+	last = now;
+}
+
+bool NetStatsSampler::GetRates(uint32_t ifindex, Rates & rates, uint32_t span) const
+{
+	auto it = rings.find(ifindex);
+	if( it == rings.end() || it->second.count < 2 )
+		return false;
+
+	const Ring & ring = it->second;
+	if( span < 1 )
+		span = 1;
+	if( span > ring.count - 1 )
+		span = ring.count - 1;
+
+	const Sample & newest = ring.samples[(ring.head + RingSize - 1) % RingSize];
+	const Sample & oldest = ring.samples[(ring.head + RingSize - 1 - span) % RingSize];
+	uint64_t elapsed = newest.time - oldest.time;
+	if( !elapsed )
+		return false;
+
+	rates.recv_bytes = (newest.counters.recv_bytes - oldest.counters.recv_bytes) * 1000 / elapsed;
+	rates.send_bytes = (newest.counters.send_bytes - oldest.counters.send_bytes) * 1000 / elapsed;
+	rates.recv_packets = (newest.counters.recv_packets - oldest.counters.recv_packets) * 1000 / elapsed;
+	rates.send_packets = (newest.counters.send_packets - oldest.counters.send_packets) * 1000 / elapsed;
+	rates.recv_errors = (newest.counters.recv_errors - oldest.counters.recv_errors) * 1000 / elapsed;
+	rates.send_errors = (newest.counters.send_errors - oldest.counters.send_errors) * 1000 / elapsed;
+	return true;
+}
+
+void NetStatsSampler::Clear(void)
+{
+	rings.clear();
+	last = 0;
+}
+
+#ifdef MAIN_NETSTATS
+#include "netifs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+int RootExec(const char * cmd)
+{
+	return system(cmd);
+}
+
+// netstats [samples] [interval ms]
+int main(int argc, char * argv[])
+{
+	int samples = argc > 1 ? atoi(argv[1]) : 5;
+	uint32_t interval = argc > 2 ? (uint32_t)atoi(argv[2]) : 1000;
+
+	NetInterfaces nifs;
+	nifs.SetStatsInterval(interval);
+	if( !nifs.Update() )
+		return -1;
+
+	while( samples > 0 ) {
+		if( !nifs.SampleStats() ) {
+			usleep(10000);
+			continue;
+		}
+		samples--;
+		for( const auto & [name, net_if] : nifs ) {
+			NetStatsSampler::Rates rates;
+			if( nifs.GetRates(net_if->ifindex, rates) )
+				printf("%-16S rx %10lu B/s %8lu pps %4lu err/s  tx %10lu B/s %8lu pps %4lu err/s\n", name.c_str(),
+					(unsigned long)rates.recv_bytes, (unsigned long)rates.recv_packets, (unsigned long)rates.recv_errors,
+					(unsigned long)rates.send_bytes, (unsigned long)rates.send_packets, (unsigned long)rates.send_errors);
+		}
+	}
+	return 0;
+}
+#endif //MAIN_NETSTATS
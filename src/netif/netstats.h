@@ -0,0 +1,68 @@
+#ifndef __NETSTATS_H__
+#define __NETSTATS_H__
+
+#include <stdint.h>
+#include <unordered_map>
+
+struct NetInterface;
+
+// Samples of interface counters taken not often than once per interval,
+// last samples of every ifindex are kept in ring buffer, rates are computed
+// between the newest sample and the sample taken span intervals before.
+class NetStatsSampler {
+	public:
+		struct Rates {
+			uint64_t recv_bytes;
+			uint64_t send_bytes;
+			uint64_t recv_packets;
+			uint64_t send_packets;
+			uint64_t recv_errors;
+			uint64_t send_errors;
+		};
+
+		static const uint32_t RingSize = 16;
+
+	private:
+		struct Sample {
+			uint64_t time;	// ms, monotonic
+			Rates counters;
+		};
+
+		struct Ring {
+			Sample samples[RingSize];
+			uint32_t head;	// next sample position
+			uint32_t count;
+			uint32_t generation;
+		};
+
+		std::unordered_map<uint32_t, Ring> rings;
+		uint32_t interval;
+		uint32_t generation;
+		uint64_t last;
+		uint64_t now;
+
+	public:
+		// 0 interval disables sampling
+		explicit NetStatsSampler(uint32_t interval = 1000);
+
+		void SetInterval(uint32_t interval_) { interval = interval_; };
+		uint32_t Interval(void) const { return interval; };
+
+		// true if interval passed since last sample
+		bool IsDue(void) const;
+
+		// one sample of all interfaces: Begin(), Add() per interface, End()
+		void Begin(void);
+		void Add(const NetInterface * net_if);
+		// rings of interfaces not added since Begin() are removed
+		void End(void);
+
+		// per second, false if ifindex has less than two samples
+		bool GetRates(uint32_t ifindex, Rates & rates, uint32_t span = 1) const;
+
+		void Clear(void);
+
+		static uint64_t Now(void);
+};
+
+#endif /* __NETSTATS_H__ */
@@ -0,0 +1,179 @@
+#ifndef __SNAPSHOTDIFF_H__
+#define __SNAPSHOTDIFF_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 64-bit hash of row fields, used for stable keys and for fingerprints of content
+class RowHash {
+	private:
+		uint64_t h;
+	public:
+		RowHash(): h(0x84222325CBF29CE4ULL) {};
+
+		RowHash & Add(uint64_t v)
+		{
+			h = (h ^ v) * 0x9E3779B97F4A7C15ULL;
+			h ^= h >> 29;
+			return *this;
+		};
+		RowHash & Add(std::wstring_view s) { return Add(std::hash<std::wstring_view>()(s)).Add(s.size()); };
+		uint64_t Value(void) const { return h; };
+};
+
+// Rows added and modified by the last update (rows of the new snapshot by their key)
+// and count of removed ones, rows which are not here are the same as before.
+struct SnapshotChanges {
+	typedef enum {
+		RowSame,
+		RowAdded,
+		RowModified
+	} RowState;
+
+	std::unordered_map<uint64_t, RowState> rows;
+	size_t added;
+	size_t removed;
+	size_t modified;
+	// changes per second between the previous snapshot and this one
+	double churn;
+
+	SnapshotChanges(): added(0), removed(0), modified(0), churn(0.0) {};
+
+	RowState Get(uint64_t key) const
+	{
+		auto it = rows.find(key);
+		return it != rows.end() ? it->second:RowSame;
+	};
+	size_t Total(void) const { return added + removed + modified; };
+};
+
+// Compares consecutive snapshots in O(n). Every row of new snapshot is given to Row()
+// between Begin() and End() with hash of its stable key and fingerprint of its content,
+// only key and fingerprint of previous snapshot are kept. Rows with equal key (e.g.
+// IPv6 multipath given as separate routes) are one row with sum of fingerprints.
+// The first snapshot and the first after Reset() have nothing to compare with,
+// they have no changes.
+class SnapshotDiff {
+	private:
+		struct Slot {
+			// 0 for free slot
+			uint64_t key;
+			uint64_t fingerprint;
+		};
+
+		// open addressing table of keys, table of big snapshot is a few allocations
+		// instead of node per row
+		struct Table {
+			std::vector<Slot> slots;
+			size_t count;
+
+			Table(): count(0) {};
+
+			void Reset(size_t rows)
+			{
+				size_t size = 64;
+				while( size < rows + rows / 2 )
+					size <<= 1;
+				slots.assign(size, Slot{0, 0});
+				count = 0;
+			};
+
+			// slot of key or free slot for it
+			Slot & Get(uint64_t key)
+			{
+				size_t mask = slots.size() - 1;
+				size_t i = (size_t)(key ^ (key >> 32)) & mask;
+				while( slots[i].key && slots[i].key != key )
+					i = (i + 1) & mask;
+				return slots[i];
+			};
+		};
+
+		Table last;
+		Table current;
+		std::chrono::steady_clock::time_point lastTime;
+		bool baseline;
+
+		void Grow(void)
+		{
+			Table bigger;
+			bigger.Reset(current.slots.size());
+			for( const auto & slot : current.slots ) {
+				if( slot.key )
+					bigger.Get(slot.key) = slot;
+			}
+			bigger.count = current.count;
+			std::swap(current, bigger);
+		};
+
+		// copy and assignment not allowed
+		SnapshotDiff(const SnapshotDiff&) = delete;
+		void operator=(const SnapshotDiff&) = delete;
+
+	public:
+		SnapshotDiff(): baseline(true) {};
+
+		// next snapshot is not comparable with previous one, e.g. other rows are requested
+		void Reset(void) { baseline = true; };
+
+		void Begin(void) { current.Reset(last.count); };
+
+		void Row(uint64_t key, uint64_t fingerprint)
+		{
+			if( !key )
+				key = 1;
+			if( (current.count + 1) * 3 > current.slots.size() * 2 )
+				Grow();
+			Slot & slot = current.Get(key);
+			if( !slot.key ) {
+				slot.key = key;
+				current.count++;
+			}
+			slot.fingerprint += fingerprint;
+		};
+
+		std::shared_ptr<const SnapshotChanges> End(void)
+		{
+			auto changes = std::make_shared<SnapshotChanges>();
+			auto now = std::chrono::steady_clock::now();
+
+			if( !baseline ) {
+				size_t matched = 0;
+				for( const auto & slot : current.slots ) {
+					if( !slot.key )
+						continue;
+					const Slot & old = last.Get(slot.key);
+					if( !old.key ) {
+						changes->rows.emplace(slot.key, SnapshotChanges::RowAdded);
+						changes->added++;
+						continue;
+					}
+					matched++;
+					if( old.fingerprint != slot.fingerprint ) {
+						changes->rows.emplace(slot.key, SnapshotChanges::RowModified);
+						changes->modified++;
+					}
+				}
+				changes->removed = last.count - matched;
+
+				double elapsed = std::chrono::duration<double>(now - lastTime).count();
+				if( elapsed > 0.0 )
+					changes->churn = changes->Total() / elapsed;
+			}
+
+			std::swap(last, current);
+			current = Table();
+			lastTime = now;
+			baseline = false;
+			return changes;
+		};
+};
+
+#endif /* __SNAPSHOTDIFF_H__ */
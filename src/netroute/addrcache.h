@@ -0,0 +1,111 @@
+#ifndef __ADDRCACHE_H__
+#define __ADDRCACHE_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <string>
+#include <vector>
+#include <netif/namepool.h>
+
+// Text of IPv4 and IPv6 addresses by their bytes. Gateways, preferred sources and
+// neighbors repeat across thousands of routes, so inet_ntop() and widening are done
+// once per address, next time it is one probe of open addressing table. Table has
+// fixed size and is cleared when it is filled, so unique addresses of big dump
+// do not grow it. Not thread safe, every decoding thread has its own cache.
+class AddrCache {
+	private:
+		static const unsigned int SlotBits = 11;
+		static const size_t Slots = 1 << SlotBits;
+		static const size_t MaxUsed = Slots / 4 * 3;
+
+		struct Slot {
+			uint8_t addr[16];
+			// nullptr for free slot
+			const wchar_t * text;
+			uint32_t len;
+			uint8_t family;
+		};
+
+		std::vector<Slot> slots;
+		size_t used;
+		NamePool texts;
+
+		static size_t Hash(uint8_t family, const uint8_t * addr)
+		{
+			uint64_t hi, lo;
+			memcpy(&hi, addr, sizeof(hi));
+			memcpy(&lo, addr + sizeof(hi), sizeof(lo));
+			uint64_t h = (hi ^ (lo * 0x9E3779B97F4A7C15ULL) ^ family) * 0x9E3779B97F4A7C15ULL;
+			return (size_t)(h >> (64 - SlotBits));
+		};
+
+		// copy and assignment not allowed, slots point to texts
+		AddrCache(const AddrCache&) = delete;
+		void operator=(const AddrCache&) = delete;
+
+	public:
+		AddrCache(): used(0) {};
+
+		// false if inet_ntop() can not format address
+		bool Format(uint8_t family, const void * addr, std::wstring & text)
+		{
+			const size_t maxlen = INET6_ADDRSTRLEN > INET_ADDRSTRLEN ? INET6_ADDRSTRLEN : INET_ADDRSTRLEN;
+			char s[maxlen+1] = {0};
+			size_t addrlen = family == AF_INET ? 4:(family == AF_INET6 ? 16:0);
+
+			// other families are rare (e.g. RTA_VIA), they are not cached
+			if( !addrlen ) {
+				if( !inet_ntop(family, addr, s, maxlen) )
+					return false;
+				text = towstr(s);
+				return true;
+			}
+
+			uint8_t key[16] = {0};
+			memcpy(key, addr, addrlen);
+
+			// table is allocated by first address, threads which never format do not pay for it
+			if( slots.empty() )
+				slots.resize(Slots);
+
+			size_t i = Hash(family, key);
+			for( ; slots[i].text; i = (i + 1) & (Slots - 1) ) {
+				const Slot & slot = slots[i];
+				if( slot.family == family && !memcmp(slot.addr, key, sizeof(key)) ) {
+					text.assign(slot.text, slot.len);
+					return true;
+				}
+			}
+
+			if( !inet_ntop(family, key, s, maxlen) )
+				return false;
+
+			if( used >= MaxUsed ) {
+				Clear();
+				i = Hash(family, key);
+			}
+
+			Slot & slot = slots[i];
+			memcpy(slot.addr, key, sizeof(key));
+			slot.family = family;
+			slot.text = texts.Intern(s);
+			slot.len = (uint32_t)strlen(s);
+			used++;
+			text.assign(slot.text, slot.len);
+			return true;
+		};
+
+		void Clear(void)
+		{
+			slots.assign(slots.size(), Slot());
+			used = 0;
+			texts.Clear();
+		};
+
+		size_t Size(void) const { return used; };
+};
+
+#endif /* __ADDRCACHE_H__ */
@@ -0,0 +1,183 @@
+#include "netdumpcollector.h"
+
+#include <common/log.h>
+#include <common/netlink.h>
+
+#define LOG_SOURCE_FILE "netdumpcollector.cpp"
+#ifndef MAIN_NETDUMPCOLLECTOR
+extern const char * LOG_FILE;
+#else
+const char * LOG_FILE = "/dev/null";
+#endif
+
+NetDumpCollector::NetDumpCollector(unsigned int threads):
+job(0),
+count(0),
+next(0),
+finished(0),
+generation(0),
+interrupted(false),
+stop(false)
+{
+	if( !threads ) {
+		threads = std::thread::hardware_concurrency();
+		if( threads > DefaultThreads )
+			threads = DefaultThreads;
+	}
+
+	// caller thread is one of them
+	for( unsigned int i = 1; i < threads; i++ )
+		workers.emplace_back(&NetDumpCollector::Worker, this);
+	LOG_INFO("threads %u\n", Threads());
+}
+
+NetDumpCollector::~NetDumpCollector()
+{
+	{
+		std::lock_guard<std::mutex> lck(lock);
+		stop = true;
+	}
+	cv.notify_all();
+
+	for( auto & worker : workers )
+		worker.join();
+
+	for( auto netlink : sockets ) {
+		if( netlink )
+			CloseNetlink(netlink);
+	}
+	LOG_INFO("\n");
+}
+
+void NetDumpCollector::Process(std::unique_lock<std::mutex> & lck)
+{
+	while( next < count ) {
+		size_t i = next++;
+		const std::function<void(size_t)> & fn = *job;
+		lck.unlock();
+
+		fn(i);
+
+		lck.lock();
+		if( ++finished == count )
+			done_cv.notify_all();
+	}
+}
+
+void NetDumpCollector::Worker(void)
+{
+	std::unique_lock<std::mutex> lck(lock);
+	uint32_t seen = generation;
+
+	for( ;; ) {
+		cv.wait(lck, [this, seen] { return generation != seen || stop; });
+		if( stop )
+			break;
+		seen = generation;
+		Process(lck);
+	}
+}
+
+void NetDumpCollector::Parallel(size_t count_, const std::function<void(size_t)> & fn)
+{
+	std::unique_lock<std::mutex> lck(lock);
+
+	job = &fn;
+	count = count_;
+	next = 0;
+	finished = 0;
+	generation++;
+	cv.notify_all();
+
+	Process(lck);
+	done_cv.wait(lck, [this] { return finished == count; });
+	job = 0;
+}
+
+void NetDumpCollector::Run(const NetDumpRequest * requests, void * arg, const void ** records, size_t count_)
+{
+	{
+		std::lock_guard<std::mutex> lck(lock);
+		if( sockets.size() < count_ )
+			sockets.resize(count_, nullptr);
+		interrupted = false;
+	}
+
+	// every slot is used by one thread only
+	Parallel(count_, [this, requests, arg, records](size_t i) {
+		void * netlink = sockets[i];
+
+		// rest of interrupted dump may be still in socket
+		if( netlink && DumpInterrupted(netlink) ) {
+			CloseNetlink(netlink);
+			netlink = 0;
+		}
+		if( !netlink )
+			netlink = OpenNetlink();
+
+		records[i] = netlink ? requests[i](netlink, arg):0;
+		sockets[i] = netlink;
+		if( netlink && DumpInterrupted(netlink) ) {
+			std::lock_guard<std::mutex> lck(lock);
+			interrupted = true;
+		}
+	});
+}
+
+#ifdef MAIN_NETDUMPCOLLECTOR
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <linux/neighbour.h>
+
+static double BenchNow(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static const NetDumpRequest benchRequests[] = {
+	[](void * netlink, void *) { return (const void *)GetRoutes(netlink, AF_UNSPEC); },
+	[](void * netlink, void *) { return (const void *)GetRules(netlink, AF_UNSPEC); },
+	[](void * netlink, void *) { return (const void *)GetNeighbors(netlink, AF_UNSPEC, 0); },
+	[](void * netlink, void *) { return (const void *)GetNeighbors(netlink, AF_UNSPEC, NTF_PROXY); },
+	[](void * netlink, void *) { return (const void *)GetLinks(netlink); }
+};
+
+#define BENCH_REQUESTS (sizeof(benchRequests)/sizeof(benchRequests[0]))
+
+// netdumpcollector [runs] - time of all dumps by 1, 2, 4 and 5 threads
+int main(int argc, char * argv[])
+{
+	int runs = argc > 1 ? atoi(argv[1]):10;
+	unsigned int threads[] = { 1, 2, 4, BENCH_REQUESTS };
+
+	printf("%u CPUs\n", std::thread::hardware_concurrency());
+	for( auto n : threads ) {
+		NetDumpCollector collector(n);
+		const void * records[BENCH_REQUESTS];
+		double best = 0, total = 0;
+
+		// sockets are opened and buffers are grown by first run
+		collector.Run(benchRequests, 0, records, BENCH_REQUESTS);
+		for( int run = 0; run < runs; run++ ) {
+			double start = BenchNow();
+			collector.Run(benchRequests, 0, records, BENCH_REQUESTS);
+			double elapsed = BenchNow() - start;
+			for( size_t i = 0; i < BENCH_REQUESTS; i++ ) {
+				if( !records[i] ) {
+					fprintf(stderr, "dump %u failed\n", (unsigned int)i);
+					return 1;
+				}
+			}
+			total += elapsed;
+			if( !run || elapsed < best )
+				best = elapsed;
+		}
+		printf("%u threads: %.3f ms avg, %.3f ms best\n", n, total*1e3/runs, best*1e3);
+	}
+	return 0;
+}
+#endif //MAIN_NETDUMPCOLLECTOR
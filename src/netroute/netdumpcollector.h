@@ -0,0 +1,59 @@
+#ifndef __NETDUMPCOLLECTOR_H__
+#define __NETDUMPCOLLECTOR_H__
+
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// dump by netlink socket, e.g. GetRoutes(netlink, AF_UNSPEC), arg is given to Run()
+typedef const void * (* NetDumpRequest)(void * netlink, void * arg);
+
+// Independent dumps (routes, rules, neighbors, links) are requested at the same
+// time, every one on its own netlink socket, and kernel serializes them in parallel.
+// Caller thread takes part in work, so pool of N threads runs N dumps at once.
+// Sockets are kept between runs, records of every dump are valid until next Run().
+// The same threads decode big dumps by chunks, see Parallel().
+class NetDumpCollector {
+private:
+	std::vector<std::thread> workers;
+	std::mutex lock;
+	std::condition_variable cv;
+	std::condition_variable done_cv;
+
+	// socket per request slot, so records of all dumps are alive at the same time
+	std::vector<void *> sockets;
+	// work of current generation, items 0...count-1
+	const std::function<void(size_t)> * job;
+	size_t count;
+	size_t next;
+	size_t finished;
+	uint32_t generation;
+	bool interrupted;
+	bool stop;
+
+	void Worker(void);
+	// runs items of current generation until there is no one left
+	void Process(std::unique_lock<std::mutex> & lck);
+
+	// copy and assignment not allowed
+	NetDumpCollector(const NetDumpCollector&) = delete;
+	void operator=(const NetDumpCollector&) = delete;
+public:
+	// 0 threads - by number of CPUs, but not more than DefaultThreads
+	static const unsigned int DefaultThreads = 4;
+	explicit NetDumpCollector(unsigned int threads = 0);
+	~NetDumpCollector();
+
+	// records[i] is result of requests[i], 0 if dump failed
+	void Run(const NetDumpRequest * requests, void * arg, const void ** records, size_t count);
+	// fn(i) for every i < count on all threads, returns when all are done
+	void Parallel(size_t count, const std::function<void(size_t)> & fn);
+	// TRUE if any dump of last Run() was inconsistent (NLM_F_DUMP_INTR)
+	bool Interrupted(void) const { return interrupted; };
+	unsigned int Threads(void) const { return (unsigned int)workers.size() + 1; };
+};
+
+#endif /* __NETDUMPCOLLECTOR_H__ */
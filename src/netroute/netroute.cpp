@@ -1,10 +1,12 @@
 #include "netroute.h"
 #include "netrouteset.h"
+#include "addrcache.h"
 
 #include <common/log.h>
 #include <common/errname.h>
 #include <common/netutils.h>
 #include <common/sizestr.h>
+#include <common/widestr.h>
 
 #include <memory>
 
@@ -18,7 +20,11 @@ extern "C" {
 }
 
 #define LOG_SOURCE_FILE "netroute.cpp"
+#ifndef MAIN_NETROUTE_BATCH
 extern const char * LOG_FILE;
+#else
+const char * LOG_FILE = "/dev/null";
+#endif
 
 #if INTPTR_MAX == INT32_MAX
 #define LLFMT "%lld"
@@ -28,6 +34,136 @@ extern const char * LOG_FILE;
     #error "Environment not 32 or 64-bit."
 #endif
 
+// text of addresses shown in rows of panel and decoded from dumps, every thread
+// has its own as routes are decoded by threads of pool
+thread_local AddrCache routeAddrs;
+
+static size_t AddrSize(int family)
+{
+	return family == AF_INET6 ? sizeof(struct in6_addr):sizeof(struct in_addr);
+}
+
+RouteAddr::RouteAddr(const RouteAddr & o):
+	family(o.family), len(o.len), text(o.text ? new std::wstring(*o.text):nullptr)
+{
+	memcpy(addr, o.addr, sizeof(addr));
+}
+
+RouteAddr & RouteAddr::operator=(const RouteAddr & o)
+{
+	if( this != &o ) {
+		family = o.family;
+		len = o.len;
+		memcpy(addr, o.addr, sizeof(addr));
+		text.reset(o.text ? new std::wstring(*o.text):nullptr);
+	}
+	return *this;
+}
+
+RouteAddr & RouteAddr::operator=(const std::wstring & s)
+{
+	clear();
+	if( s.empty() )
+		return *this;
+
+	char _s[INET6_ADDRSTRLEN + sizeof("/128")] = {0};
+	size_t slash = s.find(L'/');
+	bool ascii = s.size() < sizeof(_s);
+	for( size_t i = 0; ascii && i < s.size(); i++ ) {
+		ascii = s[i] > 0 && s[i] < 0x80;
+		_s[i] = (char)s[i];
+	}
+
+	if( ascii ) {
+		unsigned long bits = NoPrefix;
+		if( slash != std::wstring::npos ) {
+			char * end = 0;
+			bits = strtoul(_s + slash + 1, &end, 10);
+			if( *end || end == _s + slash + 1 || bits > 128 )
+				bits = 0xFFFF;
+			_s[slash] = 0;
+		}
+		for( uint8_t f : { AF_INET, AF_INET6 } ) {
+			if( (bits == NoPrefix || bits <= AddrSize(f) * 8) && inet_pton(f, _s, addr) == 1 ) {
+				family = f;
+				len = (uint8_t)bits;
+				return *this;
+			}
+		}
+		memset(addr, 0, sizeof(addr));
+	}
+	text.reset(new std::wstring(s));
+	return *this;
+}
+
+void RouteAddr::Set(uint8_t family_, const void * addr_, uint8_t len_)
+{
+	clear();
+	family = family_;
+	len = len_;
+	memcpy(addr, addr_, AddrSize(family));
+}
+
+void RouteAddr::clear(void)
+{
+	family = 0;
+	len = NoPrefix;
+	memset(addr, 0, sizeof(addr));
+	text.reset();
+}
+
+bool RouteAddr::Get(uint8_t family_, void * addr_, uint8_t * len_) const
+{
+	if( !family || family != family_ )
+		return false;
+	memcpy(addr_, addr, AddrSize(family));
+	*len_ = len != NoPrefix ? len:(uint8_t)(AddrSize(family) * 8);
+	return true;
+}
+
+std::wstring RouteAddr::str(void) const
+{
+	if( text )
+		return *text;
+	std::wstring s;
+	if( !family || !routeAddrs.Format(family, addr, s) )
+		return std::wstring();
+	if( len != NoPrefix )
+		s += L"/" + std::to_wstring(len);
+	return s;
+}
+
+uint64_t RouteAddr::Hash(void) const
+{
+	if( text )
+		return std::hash<std::wstring>()(*text);
+
+	uint64_t h = 0xCBF29CE484222325ULL ^ ((uint64_t)family << 8 | len);
+	for( size_t i = 0; family && i < AddrSize(family); i++ )
+		h = (h ^ addr[i]) * 0x100000001B3ULL;
+	return h;
+}
+
+bool RouteAddr::operator==(const RouteAddr & o) const
+{
+	if( text || o.text )
+		return text && o.text && *text == *o.text;
+	return family == o.family && len == o.len && !memcmp(addr, o.addr, AddrSize(family));
+}
+
+bool RouteAddr::operator<(const RouteAddr & o) const
+{
+	if( family != o.family )
+		return family < o.family;
+	if( len != o.len )
+		return len < o.len;
+	if( int res = memcmp(addr, o.addr, AddrSize(family)) )
+		return res < 0;
+	if( !text || !o.text )
+		return !text && o.text;
+	return *text < *o.text;
+}
+
 IpRouteInfo::IpRouteInfo()
 {
 	hoplimit = (uint32_t)-1;
@@ -41,9 +177,6 @@ IpRouteInfo::IpRouteInfo()
 	osdep.scope = 0;
 	osdep.type = 0;
 	osdep.icmp6pref = 0;
-	memset(&osdep.enc, 0, sizeof(osdep.enc));
-	memset(&osdep.rtcache, 0, sizeof(osdep.rtcache));
-	memset(&osdep.rtmetrics, 0, sizeof(osdep.rtmetrics));
 #else
 	osdep.expire = 0;
 	osdep.gateway_type = IpRouteInfo::IpGatewayType;
@@ -74,7 +207,7 @@ ArpRouteInfo::~ArpRouteInfo()
 #if !defined(__APPLE__) && !defined(__FreeBSD__)
 const char * IpRouteInfo::GetEncap(const Encap & enc) const
 {
-	static char buf[256];
+	static __thread char buf[256];
 	char * ptr = buf;
 	size_t size = sizeof(buf), res = 0;
 	buf[0] = 0;
@@ -185,7 +318,7 @@ const char * IpRouteInfo::GetEncap(const Encap & enc) const
 
 const char * IpRouteInfo::GetNextHopes(void) const
 {
-	static char buf[1024];
+	static __thread char buf[1024];
 	char * ptr = buf;
 	size_t size = sizeof(buf), res = 0;
 	buf[0] = 0;
@@ -206,7 +339,7 @@ const char * IpRouteInfo::GetNextHopes(void) const
 		res = 0;
 		
 
-		if( item.valid.encap && ((res = snprintf(ptr, size, " encap %s", GetEncap(item.enc))) < 0 || size < res) )
+		if( item.valid.encap && ((res = snprintf(ptr, size, " encap %s", GetEncap(*item.enc))) < 0 || size < res) )
 			break;
 
 		ptr += res;
@@ -214,7 +347,7 @@ const char * IpRouteInfo::GetNextHopes(void) const
 		res = 0;
 
 		if( item.valid.rtvia ) {
-			if( (res = snprintf(ptr, size, " via %s %S", ipfamilyname(item.rtvia_family), item.rtvia_addr.c_str() )) < 0 || size < res )
+			if( (res = snprintf(ptr, size, " via %s %S", ipfamilyname(item.rtvia_family), item.rtvia_addr.str().c_str() )) < 0 || size < res )
 				break;
 
 		ptr += res;
@@ -222,7 +355,7 @@ const char * IpRouteInfo::GetNextHopes(void) const
 		res = 0;
 
 		} else if( item.valid.gateway )
-			if( (res = snprintf(ptr, size, " via %S", item.gateway.c_str() )) < 0 || size < res )
+			if( (res = snprintf(ptr, size, " via %S", item.gateway.str().c_str() )) < 0 || size < res )
 				break;
 
 		ptr += res;
@@ -268,11 +401,11 @@ void IpRouteInfo::Log(void) const
 		"from: %15S to: %18S via: %15S dev: %17S prefsrc: %15S table: %5s type: %11s proto: %6s scope: %7s metric: %4d perf: %6s tos: %3u flags: 0x%08X(%s) encap: %s %s\n":
 		"from: %15S to: %29S via: %15S dev: %17S prefsrc: %29S table: %5s type: %11s proto: %6s scope: %7s metric: %4d perf: %6s tos: %3u flags: 0x%08X(%s) encap: %s %s\n";
 	LOG_INFO(fmt,
-		osdep.fromsrcIpandMask.empty() ? L"any":osdep.fromsrcIpandMask.c_str(),
-		!destIpandMask.empty() ? destIpandMask.c_str():L"default",
-		gateway.empty() ? L"default":gateway.c_str(),
+		osdep.fromsrcIpandMask.empty() ? L"any":osdep.fromsrcIpandMask.str().c_str(),
+		!destIpandMask.empty() ? destIpandMask.str().c_str():L"default",
+		gateway.empty() ? L"default":gateway.str().c_str(),
 		iface.c_str(),
-		prefsrc.empty() ?	L"any":prefsrc.c_str(),
+		prefsrc.empty() ?	L"any":prefsrc.str().c_str(),
 		rtruletable(osdep.table),
 		rttype(osdep.type),
 		rtprotocoltype(osdep.protocol),
@@ -280,7 +413,7 @@ void IpRouteInfo::Log(void) const
 		osdep.metric,
 		rticmp6pref(osdep.icmp6pref),
 		osdep.tos,
-		flags, RouteFlagsToString(flags, sa_family == AF_INET6), valid.encap ? GetEncap(osdep.enc):"none", GetNextHopes());
+		flags, RouteFlagsToString(flags, sa_family == AF_INET6), valid.encap ? GetEncap(*osdep.enc):"none", GetNextHopes());
 
 	//LogRtCache();
 #else
@@ -288,10 +421,10 @@ void IpRouteInfo::Log(void) const
 		"to: %18S via: %15S dev: %17S prefsrc: %15S expire: %4d flags: 0x%08X(%s) family %d(%s)\n":
 		"to: %29S via: %15S dev: %17S prefsrc: %29S expire: %4d flags: 0x%08X(%s) family %d(%s)\n";
 	LOG_INFO(fmt,
-		!destIpandMask.empty() ? destIpandMask.c_str():L"default",
-		gateway.empty() ? L"default":gateway.c_str(),
+		!destIpandMask.empty() ? destIpandMask.str().c_str():L"default",
+		gateway.empty() ? L"default":gateway.str().c_str(),
 		iface.c_str(),
-		prefsrc.empty() ?	L"any":prefsrc.c_str(),
+		prefsrc.empty() ?	L"any":prefsrc.str().c_str(),
 		osdep.expire,
 		flags, RouteFlagsToString(flags, sa_family == AF_INET6), sa_family, familyname(sa_family));
 
@@ -304,11 +437,13 @@ void RuleRouteInfo::Log(void) const
 	LOG_INFO("%s) %5d: %S\n", familyname(family), priority, rule.c_str());
 }
 
-// towstr can use only for ASCII symbols
-static std::wstring towstr(const char * name)
+// routes and neighbors of dump keep only interface index, name is asked for ip utility
+static std::wstring DevName(const std::wstring & iface, bool valid_index, uint32_t ifindex)
 {
-	std::string _s(name);
-	return std::wstring(_s.begin(), _s.end());
+	char ifname[IF_NAMESIZE] = {0};
+	if( !iface.empty() || !valid_index || !if_indextoname(ifindex, ifname) )
+		return iface;
+	return towstr(ifname);
 }
 
 RuleRouteInfo::RuleRouteInfo()
@@ -452,26 +587,26 @@ void IpRouteInfo::LogRtCache(void) const
 	if( !hz )
 		hz = 100;
 
-	if( osdep.rtcache.rta_clntref ||
-	    osdep.rtcache.rta_lastuse ||
-	    osdep.rtcache.rta_expires ||
-	    osdep.rtcache.rta_error ||
-	    osdep.rtcache.rta_used ||
-	    osdep.rtcache.rta_id ||
-	    osdep.rtcache.rta_ts ||
-	    osdep.rtcache.rta_tsage ) {
-	LOG_INFO("    rta_clntref: %u\n", osdep.rtcache.rta_clntref);
-	LOG_INFO("    rta_lastuse: %u ( %s)\n", osdep.rtcache.rta_lastuse, msec_to_str(SEC_TO_MS(osdep.rtcache.rta_lastuse/hz)));
-	LOG_INFO("    rta_expires: %d ( %s)\n", osdep.rtcache.rta_expires, msec_to_str(SEC_TO_MS(osdep.rtcache.rta_expires/hz)));
-	LOG_INFO("    rta_error:   %d (%s)\n", osdep.rtcache.rta_error, errorname(osdep.rtcache.rta_error < 0 ? (-osdep.rtcache.rta_error):osdep.rtcache.rta_error));
-	LOG_INFO("    rta_used:    %u\n", osdep.rtcache.rta_used);
-	LOG_INFO("    rta_id:      0x%08X\n", osdep.rtcache.rta_id);
-	LOG_INFO("    rta_ts:      %u\n", osdep.rtcache.rta_ts);
-	LOG_INFO("    rta_tsage:   %u ( %s)\n", osdep.rtcache.rta_tsage, msec_to_str(SEC_TO_MS(osdep.rtcache.rta_tsage)));
+	if( osdep.rtcache->rta_clntref ||
+	    osdep.rtcache->rta_lastuse ||
+	    osdep.rtcache->rta_expires ||
+	    osdep.rtcache->rta_error ||
+	    osdep.rtcache->rta_used ||
+	    osdep.rtcache->rta_id ||
+	    osdep.rtcache->rta_ts ||
+	    osdep.rtcache->rta_tsage ) {
+	LOG_INFO("    rta_clntref: %u\n", osdep.rtcache->rta_clntref);
+	LOG_INFO("    rta_lastuse: %u ( %s)\n", osdep.rtcache->rta_lastuse, msec_to_str(SEC_TO_MS(osdep.rtcache->rta_lastuse/hz)));
+	LOG_INFO("    rta_expires: %d ( %s)\n", osdep.rtcache->rta_expires, msec_to_str(SEC_TO_MS(osdep.rtcache->rta_expires/hz)));
+	LOG_INFO("    rta_error:   %d (%s)\n", osdep.rtcache->rta_error, errorname(osdep.rtcache->rta_error < 0 ? (-osdep.rtcache->rta_error):osdep.rtcache->rta_error));
+	LOG_INFO("    rta_used:    %u\n", osdep.rtcache->rta_used);
+	LOG_INFO("    rta_id:      0x%08X\n", osdep.rtcache->rta_id);
+	LOG_INFO("    rta_ts:      %u\n", osdep.rtcache->rta_ts);
+	LOG_INFO("    rta_tsage:   %u ( %s)\n", osdep.rtcache->rta_tsage, msec_to_str(SEC_TO_MS(osdep.rtcache->rta_tsage)));
 	}
 }
 
-bool IpRouteInfo::CreateIpRoute(void)
+bool IpRouteInfo::CreateIpRouteExec(void)
 {
 	LOG_INFO("\n");
 
@@ -510,7 +645,7 @@ bool IpRouteInfo::CreateIpRoute(void)
 		size -= res;
 		res = 0;
 
-		if( (res = snprintf(ptr, size, " %S", valid.destIpandMask ? destIpandMask.c_str():L"default")) < 0 || size < res )
+		if( (res = snprintf(ptr, size, " %S", valid.destIpandMask ? destIpandMask.str().c_str():L"default")) < 0 || size < res )
 			break;
 
 		ptr += res;
@@ -565,21 +700,22 @@ bool IpRouteInfo::CreateIpRoute(void)
 
 		} else {
 
-		if( valid.encap && ((res = snprintf(ptr, size, " encap %s", GetEncap(osdep.enc))) < 0 || size < res) )
+		if( valid.encap && ((res = snprintf(ptr, size, " encap %s", GetEncap(*osdep.enc))) < 0 || size < res) )
 			break;
 
 		ptr += res;
 		size -= res;
 		res = 0;
 
-		if( valid.gateway && ((res = snprintf(ptr, size, " via %s %S", ipfamilyname(sa_family), gateway.c_str())) < 0 || size < res) )
+		if( valid.gateway && ((res = snprintf(ptr, size, " via %s %S", ipfamilyname(sa_family), gateway.str().c_str())) < 0 || size < res) )
 			break;
 
 		ptr += res;
 		size -= res;
 		res = 0;
 
-		if( valid.iface && ((res = snprintf(ptr, size, " dev %S", iface.c_str())) < 0 || size < res) )
+		std::wstring dev = DevName(iface, valid.ifnameIndex, ifnameIndex);
+		if( !dev.empty() && ((res = snprintf(ptr, size, " dev %S", dev.c_str())) < 0 || size < res) )
 			break;
 
 		ptr += res;
@@ -611,7 +747,7 @@ bool IpRouteInfo::CreateIpRoute(void)
 	return false;
 }
 
-bool IpRouteInfo::DeleteIpRoute(void)
+bool IpRouteInfo::DeleteIpRouteExec(void)
 {
 
 	auto buf = std::make_unique<char[]>(MAX_CMD_LEN+1);
@@ -647,7 +783,7 @@ bool IpRouteInfo::DeleteIpRoute(void)
 		ptr += res;
 		size -= res;
 		res = 0;
-		if( (res = snprintf(ptr, size, " %S", valid.destIpandMask ? destIpandMask.c_str():L"default")) < 0 || size < res )
+		if( (res = snprintf(ptr, size, " %S", valid.destIpandMask ? destIpandMask.str().c_str():L"default")) < 0 || size < res )
 			break;
 
 		ptr += res;
@@ -674,7 +810,7 @@ bool IpRouteInfo::DeleteIpRoute(void)
 	return false;
 }
 
-bool RuleRouteInfo::DeleteRule(void)
+bool RuleRouteInfo::DeleteRuleExec(void)
 {
 	auto buf = std::make_unique<char[]>(MAX_CMD_LEN+1);
 	const size_t size = MAX_CMD_LEN+1;
@@ -697,7 +833,7 @@ bool RuleRouteInfo::DeleteRule(void)
 	return res > 0 ? (RootExec(buf.get()) == 0):false;
 }
 
-bool RuleRouteInfo::CreateRule(void)
+bool RuleRouteInfo::CreateRuleExec(void)
 {
 	auto buf = std::make_unique<char[]>(MAX_CMD_LEN+1);
 	const size_t size = MAX_CMD_LEN+1;
@@ -732,7 +868,7 @@ bool RuleRouteInfo::ChangeRule(RuleRouteInfo & ipr)
 	return false;
 }
 
-bool ArpRouteInfo::Create(void)
+bool ArpRouteInfo::CreateExec(void)
 {
 	auto buf = std::make_unique<char[]>(MAX_CMD_LEN+1);
 	char * ptr = buf.get();
@@ -776,7 +912,8 @@ bool ArpRouteInfo::Create(void)
 		size -= res;
 		res = 0;
 
-		if( valid.iface && ((res = snprintf(ptr, size, " dev %S", iface.c_str())) < 0 || size < res) )
+		std::wstring dev = DevName(iface, valid.ifnameIndex, ifnameIndex);
+		if( !dev.empty() && ((res = snprintf(ptr, size, " dev %S", dev.c_str())) < 0 || size < res) )
 			break;
 
 		ptr += res;
@@ -822,7 +959,7 @@ bool ArpRouteInfo::Create(void)
 	return false;
 }
 
-bool ArpRouteInfo::Delete(void)
+bool ArpRouteInfo::DeleteExec(void)
 {
 	auto buf = std::make_unique<char[]>(MAX_CMD_LEN+1);
 	char * ptr = buf.get();
@@ -844,12 +981,338 @@ bool ArpRouteInfo::Delete(void)
 	size -= res;
 	res = 0;
 
-	if( valid.iface && ((res = snprintf(ptr, size, " dev %S", iface.c_str())) < 0 || size < res) )
+	std::wstring dev = DevName(iface, valid.ifnameIndex, ifnameIndex);
+	if( !dev.empty() && ((res = snprintf(ptr, size, " dev %S", dev.c_str())) < 0 || size < res) )
 		return false;
 
 	return RootExec(buf.get()) == 0;
 }
 
+
+// "addr/len" or "addr" of family, len is full length of address if it is absent,
+// address of neighbor (withLen false) must not have /len
+static bool ParsePrefix(const std::wstring & prefix, int family, void * addr, uint8_t * len, bool withLen = true)
+{
+	std::string _s(prefix.begin(), prefix.end());
+	unsigned long bits = family == AF_INET6 ? 128:32;
+	size_t slash = _s.find('/');
+
+	if( slash != std::string::npos ) {
+		if( !withLen )
+			return false;
+		char * end = 0;
+		unsigned long maxbits = bits;
+		bits = strtoul(_s.c_str() + slash + 1, &end, 10);
+		if( *end || end == _s.c_str() + slash + 1 || bits > maxbits )
+			return false;
+		_s.resize(slash);
+	}
+	*len = (uint8_t)bits;
+	return inet_pton(family, _s.c_str(), addr) == 1;
+}
+
+static uint32_t IfIndex(const std::wstring & iface)
+{
+	std::string _s(iface.begin(), iface.end());
+	return if_nametoindex(_s.c_str());
+}
+
+// Changes are done by rtnetlink requests packed in one batch. ip utility (RootExec())
+// is kept for items without native request and for requests rejected
+// for lack of privileges, there sudo may still help
+template <typename T>
+static size_t CommitBatch(const std::vector<T *> & items, uint16_t type, bool (T::* exec)(void))
+{
+	const int notSent = -1;
+	std::vector<int> errors(items.size(), notSent);
+	std::vector<size_t> sent;
+	size_t done = 0;
+
+	if( void * nl = AcquireNetlink() ) {
+		for( size_t index = 0; index < items.size(); index++ ) {
+			// partly built request could delete other route or rule, it is dropped
+			// and the item is left to ip utility
+			if( !items[index]->BuildRequest(nl, type) ) {
+				DropRequests(nl, sent.size());
+				continue;
+			}
+			sent.push_back(index);
+		}
+		if( !sent.empty() ) {
+			std::vector<int> res(sent.size());
+			CommitRequests(nl, res.data(), res.size());
+			for( size_t index = 0; index < sent.size(); index++ )
+				errors[sent[index]] = res[index];
+		}
+		ReleaseNetlink(nl);
+	}
+
+	for( size_t index = 0; index < items.size(); index++ ) {
+		switch( errors[index] ) {
+		case 0:
+			done++;
+			break;
+		case notSent:
+		case EPERM:
+		case EACCES:
+		case EOPNOTSUPP:
+			done += (items[index]->*exec)();
+			break;
+		default:
+			// already logged with extended ack
+			break;
+		}
+	}
+	LOG_INFO("%s: %u of %u (native %u)\n", nlmsgtype(type), done, items.size(), sent.size());
+	return done;
+}
+
+bool IpRouteInfo::BuildRequest(void * nl, uint16_t type) const
+{
+	struct rtmsg rtm = {0};
+	struct in6_addr dst, gw, src;
+	uint8_t len = 0;
+	uint32_t oif = 0;
+	bool create = type == RTM_NEWROUTE;
+	bool gateway_ok = valid.gateway && !gateway.empty() && !valid.nhid;
+	bool prefsrc_ok = create && valid.prefsrc && !prefsrc.empty();
+
+	if( sa_family != AF_INET && sa_family != AF_INET6 )
+		return false;
+
+	// encapsulation, multipath and gateway of other family are left to ip utility
+	if( create && !valid.nhid && (valid.encap || valid.rtnexthop || valid.rtvia) )
+		return false;
+
+	bool dst_ok = valid.destIpandMask && destIpandMask.str() != L"default";
+	if( dst_ok && !destIpandMask.Get(sa_family, &dst, &rtm.rtm_dst_len) )
+		return false;
+	if( gateway_ok && (gateway.HasPrefix() || !gateway.Get(sa_family, &gw, &len)) )
+		return false;
+	if( prefsrc_ok && (prefsrc.HasPrefix() || !prefsrc.Get(sa_family, &src, &len)) )
+		return false;
+	if( valid.iface && !valid.nhid && !iface.empty() ) {
+		if( !(oif = IfIndex(iface)) )
+			return false;
+	} else if( valid.ifnameIndex && !valid.nhid )
+		oif = ifnameIndex;
+
+	rtm.rtm_family = sa_family;
+	rtm.rtm_tos = valid.tos ? osdep.tos:0;
+	rtm.rtm_table = !valid.table ? RT_TABLE_MAIN:(osdep.table < 256 ? osdep.table:RT_TABLE_UNSPEC);
+	rtm.rtm_type = valid.type ? osdep.type:(create ? RTN_UNICAST:RTN_UNSPEC);
+
+	if( create ) {
+		rtm.rtm_protocol = valid.protocol ? osdep.protocol:RTPROT_BOOT;
+		// the same defaults as ip utility has
+		if( valid.scope )
+			rtm.rtm_scope = osdep.scope;
+		else if( rtm.rtm_type == RTN_LOCAL || rtm.rtm_type == RTN_NAT )
+			rtm.rtm_scope = RT_SCOPE_HOST;
+		else if( rtm.rtm_type == RTN_BROADCAST || rtm.rtm_type == RTN_MULTICAST || rtm.rtm_type == RTN_ANYCAST )
+			rtm.rtm_scope = RT_SCOPE_LINK;
+		else if( !gateway_ok && !valid.nhid )
+			rtm.rtm_scope = RT_SCOPE_LINK;
+		else
+			rtm.rtm_scope = RT_SCOPE_UNIVERSE;
+		if( valid.flags )
+			rtm.rtm_flags = flags & (RTNH_F_ONLINK | RTNH_F_PERVASIVE);
+	} else
+		rtm.rtm_scope = RT_SCOPE_NOWHERE;
+
+	if( !::AddRequest(nl, type, create ? NLM_F_CREATE | NLM_F_EXCL:0, &rtm, sizeof(rtm)) )
+		return false;
+
+	bool res = true;
+	if( dst_ok )
+		res &= AddRequestAttr(nl, RTA_DST, &dst, AddrSize(sa_family));
+	if( valid.table )
+		res &= AddRequestAttr(nl, RTA_TABLE, &osdep.table, sizeof(osdep.table));
+	if( valid.metric )
+		res &= AddRequestAttr(nl, RTA_PRIORITY, &osdep.metric, sizeof(osdep.metric));
+	if( valid.nhid )
+		res &= AddRequestAttr(nl, RTA_NH_ID, &osdep.nhid, sizeof(osdep.nhid));
+	if( gateway_ok )
+		res &= AddRequestAttr(nl, RTA_GATEWAY, &gw, AddrSize(sa_family));
+	if( oif )
+		res &= AddRequestAttr(nl, RTA_OIF, &oif, sizeof(oif));
+	if( prefsrc_ok )
+		res &= AddRequestAttr(nl, RTA_PREFSRC, &src, AddrSize(sa_family));
+	return res;
+}
+
+bool IpRouteInfo::CreateIpRoute(void)
+{
+	LOG_INFO("\n");
+	return CommitBatch<IpRouteInfo>({this}, RTM_NEWROUTE, &IpRouteInfo::CreateIpRouteExec) == 1;
+}
+
+bool IpRouteInfo::DeleteIpRoute(void)
+{
+	return CommitBatch<IpRouteInfo>({this}, RTM_DELROUTE, &IpRouteInfo::DeleteIpRouteExec) == 1;
+}
+
+size_t IpRouteInfo::DeleteIpRoutes(const std::vector<IpRouteInfo *> & routes)
+{
+	return CommitBatch(routes, RTM_DELROUTE, &IpRouteInfo::DeleteIpRouteExec);
+}
+
+bool RuleRouteInfo::BuildRequest(void * nl, uint16_t type) const
+{
+	struct fib_rule_hdr frh = {0};
+	struct in6_addr src, dst;
+	int addr_family = (family == AF_INET6 || family == RTNL_FAMILY_IP6MR) ? AF_INET6:AF_INET;
+	bool create = type == RTM_NEWRULE;
+
+	// NAT rules are not supported by kernel for a long time, let ip utility report it
+	if( action == RTN_NAT )
+		return false;
+
+	if( valid.fromIpandMask && !ParsePrefix(fromIpandMask, addr_family, &src, &frh.src_len) )
+		return false;
+	if( valid.toIpandMask && !ParsePrefix(toIpandMask, addr_family, &dst, &frh.dst_len) )
+		return false;
+
+	frh.family = family;
+	frh.tos = tos;
+	frh.flags = flags & FIB_RULE_INVERT;
+	frh.action = action ? action:FR_ACT_TO_TBL;
+	if( table )
+		frh.table = table < 256 ? table:RT_TABLE_UNSPEC;
+	else if( create && frh.action == FR_ACT_TO_TBL )
+		frh.table = RT_TABLE_MAIN;
+
+	if( !::AddRequest(nl, type, create ? NLM_F_CREATE | NLM_F_EXCL:0, &frh, sizeof(frh)) )
+		return false;
+
+	bool res = true;
+	if( valid.fromIpandMask )
+		res &= AddRequestAttr(nl, FRA_SRC, &src, AddrSize(addr_family));
+	if( valid.toIpandMask )
+		res &= AddRequestAttr(nl, FRA_DST, &dst, AddrSize(addr_family));
+	if( valid.priority )
+		res &= AddRequestAttr(nl, FRA_PRIORITY, &priority, sizeof(priority));
+	if( valid.fwmark || valid.fwmask )
+		res &= AddRequestAttr(nl, FRA_FWMARK, &fwmark, sizeof(fwmark));
+	if( valid.fwmask )
+		res &= AddRequestAttr(nl, FRA_FWMASK, &fwmask, sizeof(fwmask));
+	if( valid.iiface ) {
+		std::string name(iiface.begin(), iiface.end());
+		res &= AddRequestAttr(nl, FRA_IIFNAME, name.c_str(), name.size() + 1);
+	}
+	if( valid.oiface ) {
+		std::string name(oiface.begin(), oiface.end());
+		res &= AddRequestAttr(nl, FRA_OIFNAME, name.c_str(), name.size() + 1);
+	}
+	if( valid.l3mdev ) {
+		uint8_t on = 1;
+		res &= AddRequestAttr(nl, FRA_L3MDEV, &on, sizeof(on));
+	}
+	if( valid.uid_range )
+		res &= AddRequestAttr(nl, FRA_UID_RANGE, &uid_range, sizeof(uid_range));
+	if( valid.ip_protocol )
+		res &= AddRequestAttr(nl, FRA_IP_PROTO, &ip_protocol, sizeof(ip_protocol));
+	if( valid.sport_range )
+		res &= AddRequestAttr(nl, FRA_SPORT_RANGE, &sport_range, sizeof(sport_range));
+	if( valid.dport_range )
+		res &= AddRequestAttr(nl, FRA_DPORT_RANGE, &dport_range, sizeof(dport_range));
+	if( valid.tun_id ) {
+		uint64_t id = htonll(tun_id);
+		res &= AddRequestAttr(nl, FRA_TUN_ID, &id, sizeof(id));
+	}
+	if( table ) {
+		if( table >= 256 )
+			res &= AddRequestAttr(nl, FRA_TABLE, &table, sizeof(table));
+		if( valid.suppress_prefixlength )
+			res &= AddRequestAttr(nl, FRA_SUPPRESS_PREFIXLEN, &suppress_prefixlength, sizeof(suppress_prefixlength));
+		if( valid.suppress_ifgroup )
+			res &= AddRequestAttr(nl, FRA_SUPPRESS_IFGROUP, &suppress_ifgroup, sizeof(suppress_ifgroup));
+	}
+	if( valid.flowto ) {
+		uint32_t realms = ((valid.flowfrom ? flowfrom:0) << 16) | flowto;
+		res &= AddRequestAttr(nl, FRA_FLOW, &realms, sizeof(realms));
+	}
+	if( frh.action == FR_ACT_GOTO && valid.goto_priority )
+		res &= AddRequestAttr(nl, FRA_GOTO, &goto_priority, sizeof(goto_priority));
+	if( valid.protocol && protocol )
+		res &= AddRequestAttr(nl, FRA_PROTOCOL, &protocol, sizeof(protocol));
+	return res;
+}
+
+bool RuleRouteInfo::DeleteRule(void)
+{
+	return CommitBatch<RuleRouteInfo>({this}, RTM_DELRULE, &RuleRouteInfo::DeleteRuleExec) == 1;
+}
+
+bool RuleRouteInfo::CreateRule(void)
+{
+	return CommitBatch<RuleRouteInfo>({this}, RTM_NEWRULE, &RuleRouteInfo::CreateRuleExec) == 1;
+}
+
+size_t RuleRouteInfo::DeleteRules(const std::vector<RuleRouteInfo *> & rules)
+{
+	return CommitBatch(rules, RTM_DELRULE, &RuleRouteInfo::DeleteRuleExec);
+}
+
+bool ArpRouteInfo::BuildRequest(void * nl, uint16_t type) const
+{
+	struct ndmsg ndm = {0};
+	struct in6_addr dst;
+	uint8_t len, lladdr[32];
+	size_t lladdr_len = 0;
+	bool create = type == RTM_NEWNEIGH;
+	bool proxy = valid.flags && flags & NTF_PROXY;
+
+	if( !valid.ip || !ParsePrefix(ip, sa_family, &dst, &len, false) )
+		return false;
+	if( valid.iface && !iface.empty() ) {
+		if( !(ndm.ndm_ifindex = IfIndex(iface)) )
+			return false;
+	} else if( valid.ifnameIndex )
+		ndm.ndm_ifindex = ifnameIndex;
+
+	if( create && !proxy && valid.mac && !mac.empty() ) {
+		std::string _s(mac.begin(), mac.end());
+		if( !(lladdr_len = MacToBin(_s.c_str(), lladdr, sizeof(lladdr))) )
+			return false;
+	}
+
+	ndm.ndm_family = sa_family;
+	ndm.ndm_state = (create && !proxy && valid.state) ? state:NUD_PERMANENT;
+	if( proxy )
+		ndm.ndm_flags |= NTF_PROXY;
+	if( create && valid.flags )
+		ndm.ndm_flags |= flags & (NTF_ROUTER | NTF_USE | NTF_EXT_LEARNED);
+
+	if( !::AddRequest(nl, type, create ? NLM_F_CREATE | NLM_F_EXCL:0, &ndm, sizeof(ndm)) )
+		return false;
+
+	bool res = AddRequestAttr(nl, NDA_DST, &dst, AddrSize(sa_family));
+	if( lladdr_len )
+		res &= AddRequestAttr(nl, NDA_LLADDR, lladdr, lladdr_len);
+	if( create && valid.protocol )
+		res &= AddRequestAttr(nl, NDA_PROTOCOL, &protocol, sizeof(protocol));
+	if( create && valid.flags_ext && flags_ext & NTF_EXT_MANAGED ) {
+		uint32_t ext = NTF_EXT_MANAGED;
+		res &= AddRequestAttr(nl, NDA_FLAGS_EXT, &ext, sizeof(ext));
+	}
+	return res;
+}
+
+bool ArpRouteInfo::Create(void)
+{
+	return CommitBatch<ArpRouteInfo>({this}, RTM_NEWNEIGH, &ArpRouteInfo::CreateExec) == 1;
+}
+
+bool ArpRouteInfo::Delete(void)
+{
+	return CommitBatch<ArpRouteInfo>({this}, RTM_DELNEIGH, &ArpRouteInfo::DeleteExec) == 1;
+}
+
+size_t ArpRouteInfo::Delete(const std::vector<ArpRouteInfo *> & arps)
+{
+	return CommitBatch(arps, RTM_DELNEIGH, &ArpRouteInfo::DeleteExec);
+}
 #else
 bool IpRouteInfo::CreateIpRoute(void)
 {
@@ -861,11 +1324,11 @@ bool IpRouteInfo::CreateIpRoute(void)
 
 	switch(sa_family) {
 	case AF_INET:
-		if( (res = snprintf(ptr, size, "route -n add -inet %S", destIpandMask.c_str())) < 0 || size < res )
+		if( (res = snprintf(ptr, size, "route -n add -inet %S", destIpandMask.str().c_str())) < 0 || size < res )
 			return false;
 		break;
 	case AF_INET6:
-		if( (res = snprintf(ptr, size, "route -n add -inet6 %S", destIpandMask.c_str())) < 0 || size < res )
+		if( (res = snprintf(ptr, size, "route -n add -inet6 %S", destIpandMask.str().c_str())) < 0 || size < res )
 			return false;
 		break;
 	default:
@@ -880,15 +1343,15 @@ bool IpRouteInfo::CreateIpRoute(void)
 	if( valid.gateway ) {
 		switch( osdep.gateway_type ) {
 		case IpGatewayType:
-			if( (res = snprintf(ptr, size, " %S", gateway.c_str())) < 0 || size < res )
+			if( (res = snprintf(ptr, size, " %S", gateway.str().c_str())) < 0 || size < res )
 				return false;
 			break;
 		case InterfaceGatewayType:
-			if( (res = snprintf(ptr, size, " -interface %S", gateway.c_str())) < 0 || size < res )
+			if( (res = snprintf(ptr, size, " -interface %S", gateway.str().c_str())) < 0 || size < res )
 				return false;
 			break;
 		case MacGatewayType:
-			if( (res = snprintf(ptr, size, " -link %S", gateway.c_str())) < 0 || size < res )
+			if( (res = snprintf(ptr, size, " -link %S", gateway.str().c_str())) < 0 || size < res )
 				return false;
 			break;
 		default:
@@ -932,11 +1395,11 @@ bool IpRouteInfo::DeleteIpRoute(void)
 
 	switch(sa_family) {
 	case AF_INET:
-		if( (res = snprintf(ptr, size, "route -n delete -inet %S", destIpandMask.c_str() )) < 0 || size < res )
+		if( (res = snprintf(ptr, size, "route -n delete -inet %S", destIpandMask.str().c_str() )) < 0 || size < res )
 			return false;
 		break;
 	case AF_INET6:
-		if( (res = snprintf(ptr, size, "route -n delete -inet6 %S", destIpandMask.c_str() )) < 0 || size < res )
+		if( (res = snprintf(ptr, size, "route -n delete -inet6 %S", destIpandMask.str().c_str() )) < 0 || size < res )
 			return false;
 		break;
 	default:
@@ -951,15 +1414,15 @@ bool IpRouteInfo::DeleteIpRoute(void)
 	if( valid.gateway ) {
 		switch( osdep.gateway_type ) {
 		case IpGatewayType:
-			if( (res = snprintf(ptr, size, " %S", gateway.c_str())) < 0 || size < res )
+			if( (res = snprintf(ptr, size, " %S", gateway.str().c_str())) < 0 || size < res )
 				return false;
 			break;
 		case InterfaceGatewayType:
-			if( (res = snprintf(ptr, size, " -interface %S", gateway.c_str())) < 0 || size < res )
+			if( (res = snprintf(ptr, size, " -interface %S", gateway.str().c_str())) < 0 || size < res )
 				return false;
 			break;
 		case MacGatewayType:
-			if( (res = snprintf(ptr, size, " -link %S", gateway.c_str())) < 0 || size < res )
+			if( (res = snprintf(ptr, size, " -link %S", gateway.str().c_str())) < 0 || size < res )
 				return false;
 			break;
 		default:
@@ -1082,6 +1545,22 @@ bool ArpRouteInfo::Delete(void)
 	return RootExec(buf.get()) == 0;
 }
 
+
+size_t IpRouteInfo::DeleteIpRoutes(const std::vector<IpRouteInfo *> & routes)
+{
+	size_t done = 0;
+	for( auto & rt : routes )
+		done += rt->DeleteIpRoute();
+	return done;
+}
+
+size_t ArpRouteInfo::Delete(const std::vector<ArpRouteInfo *> & arps)
+{
+	size_t done = 0;
+	for( auto & arp : arps )
+		done += arp->Delete();
+	return done;
+}
 #endif
 
 bool ArpRouteInfo::Change(ArpRouteInfo & arpr)
@@ -1134,3 +1613,72 @@ void ArpRouteInfo::LogCacheInfo(void) const
 	}
 }
 #endif
+
+#ifdef MAIN_NETROUTE_BATCH
+// netroutebatch <iface> [routes] [table]
+// adds and deletes /32 routes via 10.255.255.254 by one batch each, needs CAP_NET_ADMIN
+
+#include <chrono>
+
+static int execs = 0;
+
+int RootExec(const char * cmd)
+{
+	execs++;
+	return system(cmd);
+}
+
+static double BatchNow(void)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char * argv[])
+{
+	if( argc < 2 ) {
+		fprintf(stderr, "usage: %s <iface> [routes] [table]\n", argv[0]);
+		return 1;
+	}
+
+	int total = argc > 2 ? atoi(argv[2]):5000;
+	uint32_t table = argc > 3 ? (uint32_t)atoi(argv[3]):100;
+	std::vector<IpRouteInfo> routes(total);
+	std::vector<IpRouteInfo *> batch;
+
+	for( int i = 0; i < total; i++ ) {
+		IpRouteInfo & rt = routes[i];
+		rt.sa_family = AF_INET;
+		rt.destIpandMask = L"10." + std::to_wstring(100 + i / 65536) + L"." + std::to_wstring((i / 256) % 256) + L"." + std::to_wstring(i % 256) + L"/32";
+		rt.valid.destIpandMask = true;
+		rt.iface = towstr(argv[1]);
+		rt.valid.iface = true;
+		rt.gateway = L"10.255.255.254";
+		rt.valid.gateway = true;
+		rt.valid.flags = true;
+		rt.flags = RTNH_F_ONLINK;
+		rt.osdep.table = table;
+		rt.valid.table = true;
+		batch.push_back(&rt);
+	}
+
+	// as plugin does, both batches go through one socket
+	OpenNetlinkSession();
+
+	double start = BatchNow();
+	size_t created = CommitBatch(batch, RTM_NEWROUTE, &IpRouteInfo::CreateIpRouteExec);
+	double middle = BatchNow();
+	size_t deleted = IpRouteInfo::DeleteIpRoutes(batch);
+	double end = BatchNow();
+
+	printf("created %zu of %d in %.1f ms\n", created, total, middle - start);
+	printf("deleted %zu of %d in %.1f ms\n", deleted, total, end - middle);
+	printf("ip utility calls %d\n", execs);
+
+	NetlinkStats stats;
+	GetNetlinkStats(&stats);
+	printf("sockets opened %llu, acquires %llu reused %llu\n", (unsigned long long)stats.opened,
+		(unsigned long long)stats.acquired, (unsigned long long)stats.reused);
+	CloseNetlinkSession();
+	return created == (size_t)total && deleted == (size_t)total ? 0:1;
+}
+#endif //MAIN_NETROUTE_BATCH
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 #include <stdint.h>
 
 // permanent   static routes:
@@ -10,8 +11,109 @@
 //             RHEL/CentOS/Scientifix: /etc/sysconfig/network-scripts/route-<interface name>
 //             Gentoo: /etc/conf.d/net
 
+// Address or prefix of route kept as raw bytes, text is made only when it is shown.
+// Text which is not IPv4/IPv6 address (link and interface gateways of BSD,
+// wrong input of dialog) is kept as is.
+class RouteAddr {
+	uint8_t family;			// AF_INET or AF_INET6 when addr is valid
+	uint8_t len;			// prefix length or NoPrefix for plain address
+	unsigned char addr[16];
+	std::unique_ptr<std::wstring> text;
+public:
+	enum { NoPrefix = 0xFF };
+
+	RouteAddr(): family(0), len(NoPrefix), addr{0} {};
+	RouteAddr(const RouteAddr & o);
+	RouteAddr(RouteAddr &&) = default;
+	RouteAddr & operator=(const RouteAddr & o);
+	RouteAddr & operator=(RouteAddr &&) = default;
+
+	// parses "address[/len]", anything else is stored as text
+	RouteAddr & operator=(const std::wstring & s);
+	RouteAddr & operator=(const wchar_t * s) { return *this = std::wstring(s ? s:L""); }
+	void Set(uint8_t family, const void * addr, uint8_t len = NoPrefix);
+	void clear(void);
+
+	bool empty(void) const { return !family && !text; }
+	bool HasPrefix(void) const { return family && len != NoPrefix; }
+	// address in network order and prefix length (full one for plain address),
+	// false for text or other family
+	bool Get(uint8_t family, void * addr, uint8_t * len) const;
+	std::wstring str(void) const;
+	uint64_t Hash(void) const;
+
+	bool operator==(const RouteAddr & o) const;
+	bool operator!=(const RouteAddr & o) const { return !(*this == o); }
+	bool operator<(const RouteAddr & o) const;
+};
+
 #if !defined(__APPLE__) && !defined(__FreeBSD__)
 #include <common/netlink.h>
+
+// Optional block stored out of line: route without it costs only a pointer.
+// Reading an absent block gives zeroed T, Set() allocates it on first write.
+// Copies are deep, so routes keep value semantics.
+template <typename T>
+class OutOfLine {
+	std::unique_ptr<T> ptr;
+public:
+	const T & operator*() const { static const T none = {}; return ptr ? *ptr:none; }
+	const T * operator->() const { return &**this; }
+	T & Set(void) { if( !ptr ) ptr.reset(new T()); return *ptr; }
+	void Reset(void) { ptr.reset(); }
+
+	OutOfLine() = default;
+	OutOfLine(OutOfLine &&) = default;
+	OutOfLine & operator=(OutOfLine &&) = default;
+	OutOfLine(const OutOfLine & o): ptr(o.ptr ? new T(*o.ptr):nullptr) {};
+	OutOfLine & operator=(const OutOfLine & o) { ptr.reset(o.ptr ? new T(*o.ptr):nullptr); return *this; }
+};
+
+struct RtCacheInfo {
+	uint32_t rta_clntref;			// количество клиентов, использующих маршрут
+	uint32_t rta_lastuse;			// время последнего использования маршрута
+	int32_t	rta_expires;			// время жизни маршрута
+	int32_t rta_error;			// код ошибки со знаком минус
+	uint32_t rta_used;			// количество использований маршрута
+	uint32_t rta_id;			// идентификатор маршрута (это идентификатор IP-пакета)
+	uint32_t rta_ts;			// временная метка
+	uint32_t rta_tsage;			// это возраст временной метки, содержит информацию о времени последнего обновления маршрута в секундах
+};
+
+struct RtMetrics {
+	uint32_t unspec;               // RTAX_UNSPEC
+	uint32_t lock;                 // RTAX_LOCK				
+	uint32_t mtu;                  // RTAX_MTU				
+	uint32_t window;               // RTAX_WINDOW			
+	uint32_t rtt;                  // RTAX_RTT			Время приема-передачи (англ. round-trip time, RTT) — 
+								// это время, затраченное на отправку сигнала, плюс 
+								// время, которое требуется для подтверждения, 
+								// что сигнал был получен. Это время задержки, 
+								// следовательно, состоит из времени передачи сигнала
+								// между двумя точками.
+	uint32_t rttvar;               // RTAX_RTTVAR		это оценка дисперсии времени задержки передачи
+	uint32_t ssthresh;             // RTAX_SSTHRESH		это порог медленного старта. Медленный старт — часть стратегии управления окном перегрузки 
+								// алгоритм медленного старта работает за счёт увеличения
+								// окна TCP каждый раз когда получено подтверждение, 
+								// то есть увеличивает размер окна в зависимости от количества
+								// подтверждённых сегментов. Это происходит до тех пор,
+								// пока для какого-то сегмента не будет получено подтверждение или будет достигнуто какое-то заданное пороговое значение.
+								// сначала с размером окна перегрузки (congestion window — CWND) 1, 2 или 10[2] сегментов и увеличивает его на один размер сегмента (segment size — SS) для каждого полученного ACK.
+								// Когда происходит потеря, половина текущего CWND сохраняется в виде порога медленного старта (SSThresh) и медленный старт начинается снова от своего первоначального CWND. Как только CWND достигает SSThresh, TCP переходит в режим предотвращения перегрузки, где каждый ACK увеличивает CWND на SS * SS / CWND. Это приводит к линейному увеличению CWND.
+								// https://ru.wikipedia.org/wiki/Медленный_старт
+	uint32_t cwnd;                 // RTAX_CWND		это размер окна перегрузки
+	uint32_t advmss;               // RTAX_ADVMSS		это максимальный размер сегмента TCP (MSS (англ. Maximum segment size) является параметром протокола TCP и определяет максимальный размер полезного блока данных в байтах для TCP-пакета (сегмента). Таким образом этот параметр не учитывает длину заголовков TCP и IP)
+	uint32_t reordering;           // RTAX_REORDERING	это метрика переупорядочивания
+	uint32_t hoplimit;             // RTAX_HOPLIMIT		это предельное количество прыжков для пакета
+	uint32_t initcwnd;             // RTAX_INITCWND		начальный размер окна перегрузки (congestion window — CWND)
+	uint32_t features;             // RTAX_FEATURES			
+	uint32_t rto_min;              // RTAX_RTO_MIN			
+	uint32_t initrwnd;             // RTAX_INITRWND			
+	uint32_t quickack;             // RTAX_QUICKACK			
+	uint32_t congctl;              // RTAX_CC_ALGO			
+	uint32_t fastopen_no_cookie;   // RTAX_FASTOPEN_NO_COOKIE это флаг быстрого открытия 
+};
+
 struct NextHope {
 	uint8_t flags;
 	uint8_t weight; // ttl for rtm_flags & RTM_F_CLONED && rtm_type == RTN_MULTICAST
@@ -26,15 +128,15 @@ struct NextHope {
 		unsigned char rtvia:1;
 		unsigned char iface:1;
 	} valid;
-	Encap enc;
-	std::wstring gateway;
+	OutOfLine<Encap> enc;
+	RouteAddr gateway;
 	uint32_t flowfrom;
 	uint32_t flowto;
 
 	uint8_t rtvia_family;
-	std::wstring rtvia_addr;
+	RouteAddr rtvia_addr;
 
-	NextHope(): flags(0), weight(0), ifindex(0), valid({0}), enc({0}) {};
+	NextHope(): flags(0), weight(0), ifindex(0), valid({0}) {};
 	~NextHope() {};
 
 };
@@ -42,9 +144,9 @@ struct NextHope {
 
 struct IpRouteInfo {
 	std::wstring iface;
-	std::wstring destIpandMask;
-	std::wstring gateway;
-	std::wstring prefsrc;		// Предпочтительный исходный адрес для маршрута
+	RouteAddr destIpandMask;
+	RouteAddr gateway;
+	RouteAddr prefsrc;		// Предпочтительный исходный адрес для маршрута
 					// в случаях где более одного исходного адреса может быть использовано (несколько сетевых интерфейсов).
 	uint32_t flags;
 	uint8_t sa_family;
@@ -94,7 +196,7 @@ struct IpRouteInfo {
 
 	struct {
 #if !defined(__APPLE__) && !defined(__FreeBSD__)
-		std::wstring fromsrcIpandMask;
+		RouteAddr fromsrcIpandMask;
 		uint32_t metric;
 		uint32_t table;
 		uint32_t nhid;
@@ -105,54 +207,13 @@ struct IpRouteInfo {
 		uint8_t type;
 		uint8_t icmp6pref;
 
-		Encap enc;
+		OutOfLine<Encap> enc;
 
 		uint8_t rtvia_family;
-		std::wstring rtvia_addr;
-
-		struct {
-			uint32_t rta_clntref;			// количество клиентов, использующих маршрут
-			uint32_t rta_lastuse;			// время последнего использования маршрута
-			int32_t	rta_expires;			// время жизни маршрута
-			int32_t rta_error;			// код ошибки со знаком минус
-			uint32_t rta_used;			// количество использований маршрута
-			uint32_t rta_id;			// идентификатор маршрута (это идентификатор IP-пакета)
-			uint32_t rta_ts;			// временная метка
-			uint32_t rta_tsage;			// это возраст временной метки, содержит информацию о времени последнего обновления маршрута в секундах
-		} rtcache;
-		struct {
-			uint32_t unspec;               // RTAX_UNSPEC
-			uint32_t lock;                 // RTAX_LOCK				
-			uint32_t mtu;                  // RTAX_MTU				
-			uint32_t window;               // RTAX_WINDOW			
-			uint32_t rtt;                  // RTAX_RTT			Время приема-передачи (англ. round-trip time, RTT) — 
-										// это время, затраченное на отправку сигнала, плюс 
-										// время, которое требуется для подтверждения, 
-										// что сигнал был получен. Это время задержки, 
-										// следовательно, состоит из времени передачи сигнала
-										// между двумя точками.
-			uint32_t rttvar;               // RTAX_RTTVAR		это оценка дисперсии времени задержки передачи
-			uint32_t ssthresh;             // RTAX_SSTHRESH		это порог медленного старта. Медленный старт — часть стратегии управления окном перегрузки 
-										// алгоритм медленного старта работает за счёт увеличения
-										// окна TCP каждый раз когда получено подтверждение, 
-										// то есть увеличивает размер окна в зависимости от количества
-										// подтверждённых сегментов. Это происходит до тех пор,
-										// пока для какого-то сегмента не будет получено подтверждение или будет достигнуто какое-то заданное пороговое значение.
-										// сначала с размером окна перегрузки (congestion window — CWND) 1, 2 или 10[2] сегментов и увеличивает его на один размер сегмента (segment size — SS) для каждого полученного ACK.
-										// Когда происходит потеря, половина текущего CWND сохраняется в виде порога медленного старта (SSThresh) и медленный старт начинается снова от своего первоначального CWND. Как только CWND достигает SSThresh, TCP переходит в режим предотвращения перегрузки, где каждый ACK увеличивает CWND на SS * SS / CWND. Это приводит к линейному увеличению CWND.
-										// https://ru.wikipedia.org/wiki/Медленный_старт
-			uint32_t cwnd;                 // RTAX_CWND		это размер окна перегрузки
-			uint32_t advmss;               // RTAX_ADVMSS		это максимальный размер сегмента TCP (MSS (англ. Maximum segment size) является параметром протокола TCP и определяет максимальный размер полезного блока данных в байтах для TCP-пакета (сегмента). Таким образом этот параметр не учитывает длину заголовков TCP и IP)
-			uint32_t reordering;           // RTAX_REORDERING	это метрика переупорядочивания
-			uint32_t hoplimit;             // RTAX_HOPLIMIT		это предельное количество прыжков для пакета
-			uint32_t initcwnd;             // RTAX_INITCWND		начальный размер окна перегрузки (congestion window — CWND)
-			uint32_t features;             // RTAX_FEATURES			
-			uint32_t rto_min;              // RTAX_RTO_MIN			
-			uint32_t initrwnd;             // RTAX_INITRWND			
-			uint32_t quickack;             // RTAX_QUICKACK			
-			uint32_t congctl;              // RTAX_CC_ALGO			
-			uint32_t fastopen_no_cookie;   // RTAX_FASTOPEN_NO_COOKIE это флаг быстрого открытия 
-		} rtmetrics;
+		RouteAddr rtvia_addr;
+
+		OutOfLine<RtCacheInfo> rtcache;
+		OutOfLine<RtMetrics> rtmetrics;
 
 		std::vector<NextHope> nhs;
 #else
@@ -165,10 +226,17 @@ struct IpRouteInfo {
 	bool CreateIpRoute(void);
 	bool DeleteIpRoute(void);
 	bool ChangeIpRoute(IpRouteInfo & ipr);
+	// all routes are deleted by one batch, returns number of deleted routes
+	static size_t DeleteIpRoutes(const std::vector<IpRouteInfo *> & routes);
 
 	void Log(void) const;
 #if !defined(__APPLE__) && !defined(__FreeBSD__)
 	void LogRtCache(void) const;
+
+	// adds rtnetlink request to batch, false if it can be done only by ip utility
+	bool BuildRequest(void * nl, uint16_t type) const;
+	bool CreateIpRouteExec(void);
+	bool DeleteIpRouteExec(void);
 #endif
 	IpRouteInfo();
 	~IpRouteInfo();
@@ -234,6 +302,14 @@ struct ArpRouteInfo {
 	bool Create(void);
 	bool Delete(void);
 	bool Change(ArpRouteInfo & arpr);
+	// all entries are deleted by one batch, returns number of deleted entries
+	static size_t Delete(const std::vector<ArpRouteInfo *> & arps);
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	// adds rtnetlink request to batch, false if it can be done only by ip utility
+	bool BuildRequest(void * nl, uint16_t type) const;
+	bool CreateExec(void);
+	bool DeleteExec(void);
+#endif
 
 	void Log(void) const;
 
@@ -326,6 +402,13 @@ struct RuleRouteInfo {
 	bool DeleteRule(void);
 	bool CreateRule(void);
 	bool ChangeRule(RuleRouteInfo & ipr);
+	// all rules are deleted by one batch, returns number of deleted rules
+	static size_t DeleteRules(const std::vector<RuleRouteInfo *> & rules);
+
+	// adds rtnetlink request to batch, false if it can be done only by ip utility
+	bool BuildRequest(void * nl, uint16_t type) const;
+	bool DeleteRuleExec(void);
+	bool CreateRuleExec(void);
 
 	void ToRuleString(bool skipExtInfo = false);
 	void Log(void) const;
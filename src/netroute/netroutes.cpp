@@ -1,9 +1,14 @@
 #include "netroutes.h"
 #include "netrouteset.h"
+#include "addrcache.h"
 
 #include <common/log.h>
 #include <common/errname.h>
 #include <common/netutils.h>
+#include <common/widestr.h>
+
+#include <algorithm>
+#include <tuple>
 
 extern "C" {
 #include <sys/types.h>
@@ -48,13 +53,171 @@ const char * LOG_FILE = "";
 
 NetRoutes::NetRoutes():
 ipv4_forwarding(false),
-ipv6_forwarding(false)
+ipv6_forwarding(false),
+version(0),
+changes(std::make_shared<const SnapshotChanges>())
+{
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	monitor = 0;
+	synced = false;
+	appliedValid = false;
+	collector = 0;
+	memset(&routeFilter, 0, sizeof(routeFilter));
+	tablesOnly = false;
+	prefixesVersion = 0;
+	prefixesValid = false;
+#endif
+	LOG_INFO("\n");
+}
+
+NetRoutes::NetRoutes(const NetRoutes & other):
+arp(other.arp),
+inet(other.inet),
+inet6(other.inet6),
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+mcinet(other.mcinet),
+mcinet6(other.mcinet6),
+rule(other.rule),
+rule6(other.rule6),
+mcrule(other.mcrule),
+mcrule6(other.mcrule6),
+inetTables(other.inetTables),
+inet6Tables(other.inet6Tables),
+mcinetTables(other.mcinetTables),
+mcinet6Tables(other.mcinet6Tables),
+#endif
+ipv4_forwarding(other.ipv4_forwarding),
+ipv6_forwarding(other.ipv6_forwarding),
+version(other.version),
+changes(other.changes)
 {
+	// names of other live as long as other
+	other.ifs.ForEach([this](uint32_t ifindex, const wchar_t * name) {
+		ifs[ifindex] = names.Intern(name);
+	});
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	monitor = 0;
+	synced = false;
+	appliedValid = false;
+	collector = 0;
+	// snapshot keeps filter of its data
+	routeFilter = other.routeFilter;
+	tablesOnly = other.tablesOnly;
+	counted = other.counted;
+	// index points to routes of other
+	prefixesVersion = 0;
+	prefixesValid = false;
+#endif
 	LOG_INFO("\n");
 }
 
+void NetRoutes::Swap(NetRoutes & other)
+{
+	names.Swap(other.names);
+	std::swap(ifs, other.ifs);
+	arp.swap(other.arp);
+	inet.swap(other.inet);
+	inet6.swap(other.inet6);
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	mcinet.swap(other.mcinet);
+	mcinet6.swap(other.mcinet6);
+	rule.swap(other.rule);
+	rule6.swap(other.rule6);
+	mcrule.swap(other.mcrule);
+	mcrule6.swap(other.mcrule6);
+	inetTables.swap(other.inetTables);
+	inet6Tables.swap(other.inet6Tables);
+	mcinetTables.swap(other.mcinetTables);
+	mcinet6Tables.swap(other.mcinet6Tables);
+	counted.swap(other.counted);
+#endif
+	std::swap(ipv4_forwarding, other.ipv4_forwarding);
+	std::swap(ipv6_forwarding, other.ipv6_forwarding);
+	changes.swap(other.changes);
+	version++;
+	other.version++;
+}
+
+uint64_t NetRoutes::RouteKey(const IpRouteInfo & ipr)
+{
+	RowHash key;
+	key.Add(ipr.sa_family).Add(ipr.destIpandMask.Hash());
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	key.Add(ipr.osdep.table).Add(ipr.osdep.tos).Add(ipr.valid.metric ? ipr.osdep.metric:0);
+	if( ipr.valid.fromsrcIpandMask )
+		key.Add(ipr.osdep.fromsrcIpandMask.Hash());
+#endif
+	return key.Value();
+}
+
+uint64_t NetRoutes::NeighborKey(const ArpRouteInfo & ari)
+{
+	// neighbor and route of the same address are different rows
+	return RowHash().Add(AF_UNSPEC).Add(ari.sa_family).Add(ari.ip).Add(ari.ifnameIndex).Value();
+}
+
+// shown content of route, counters and timers of cache are not compared
+static uint64_t RouteFingerprint(const IpRouteInfo & ipr)
+{
+	RowHash fp;
+	fp.Add(ipr.gateway.Hash()).Add(ipr.prefsrc.Hash()).Add(ipr.flags);
+	// routes of dump are resolved by ifnameIndex, /proc/net/route and BSD give name only
+	if( ipr.valid.ifnameIndex )
+		fp.Add(ipr.ifnameIndex);
+	else
+		fp.Add(ipr.iface);
+	fp.Add(ipr.valid.hoplimit ? ipr.hoplimit:0);
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	fp.Add(ipr.osdep.protocol).Add(ipr.osdep.scope).Add(ipr.osdep.type).Add(ipr.osdep.rtvia_addr.Hash());
+	fp.Add(ipr.valid.encap ? ipr.osdep.enc->type:0).Add(ipr.valid.nhid ? ipr.osdep.nhid:0);
+	if( ipr.valid.rtmetrics ) {
+		const RtMetrics & m = *ipr.osdep.rtmetrics;
+		fp.Add(m.mtu).Add(m.advmss).Add(m.initcwnd).Add(m.initrwnd).Add(m.lock);
+	}
+	for( const auto & nh : ipr.osdep.nhs )
+		fp.Add(nh.gateway.Hash()).Add(nh.rtvia_addr.Hash()).Add(nh.ifindex).Add(nh.weight).Add(nh.flags);
+#else
+	fp.Add(ipr.osdep.parentflags);
+#endif
+	return fp.Value();
+}
+
+static uint64_t NeighborFingerprint(const ArpRouteInfo & ari)
+{
+	RowHash fp;
+	fp.Add(ari.mac).Add(ari.flags);
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	fp.Add(ari.state).Add(ari.type).Add(ari.valid.vlan ? ari.vlan:0).Add(ari.valid.master ? ari.master:0);
+#endif
+	return fp.Value();
+}
+
+void NetRoutes::UpdateChanges(SnapshotDiff & diff)
+{
+	diff.Begin();
+	for( auto routes : { &inet, &inet6
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+			, &mcinet, &mcinet6
+#endif
+			} ) {
+		for( const auto & ipr : *routes )
+			diff.Row(RouteKey(ipr), RouteFingerprint(ipr));
+	}
+	for( const auto & ari : arp )
+		diff.Row(NeighborKey(ari), NeighborFingerprint(ari));
+	changes = diff.End();
+
+	if( changes->Total() )
+		LOG_INFO("added %u removed %u modified %u, %.1f per second\n", changes->added, changes->removed, changes->modified, changes->churn);
+}
+
 NetRoutes::~NetRoutes()
 {
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	if( monitor )
+		CloseNetlink(monitor);
+	delete collector;
+#endif
 	Clear();
 	LOG_INFO("\n");
 }
@@ -62,14 +225,14 @@ NetRoutes::~NetRoutes()
 #define MAX_INTERFACE_NAME_LEN 16
 
 #if defined(__APPLE__) || defined(__FreeBSD__)
-static std::wstring get_sockaddr_str(const struct sockaddr *sa, bool ismask = false)
+static std::string get_sockaddr_cstr(const struct sockaddr *sa, bool ismask = false)
 {
 	const size_t maxlen = INET6_ADDRSTRLEN > INET_ADDRSTRLEN ? INET6_ADDRSTRLEN : INET_ADDRSTRLEN;
 	char s[maxlen+1] = {0};
 	std::string addr;
 
 	if( !sa )
-		return std::wstring();
+		return std::string();
 
 	switch( sa->sa_family ) {
 	case AF_INET:
@@ -153,7 +316,12 @@ static std::wstring get_sockaddr_str(const struct sockaddr *sa, bool ismask = fa
 		LOG_ERROR("unsupported sa_family: %u\n", sa->sa_family);
 		break;
 	}
-	return std::wstring(addr.begin(), addr.end());
+	return addr;
+}
+
+static std::wstring get_sockaddr_str(const struct sockaddr *sa, bool ismask = false)
+{
+	return towstr(get_sockaddr_cstr(sa, ismask).c_str());
 }
 
 const char * GetRtmAddrs(uint8_t rtm_addrs)
@@ -277,21 +445,8 @@ const char * GetRtmFlags(uint32_t rtm_flags)
 	return buf;
 }
 
-static std::string tostr(const wchar_t * name)
-{
-	std::wstring _s(name);
-	return std::string(_s.begin(), _s.end());
-}
-
 #endif
 
-// towstr can use only for ASCII symbols
-static std::wstring towstr(const char * name)
-{
-	std::string _s(name);
-	return std::wstring(_s.begin(), _s.end());
-}
-
 static std::wstring destIpandMask(uint8_t family, void * adr, uint8_t maskbits)
 {
 	char addr_mask[sizeof("FFFF:FFFF:FFFF:FFFF:FFFF:FFFF:FFFF:FFFF:255.255.255.255/128")] = {0};
@@ -506,45 +661,145 @@ bool NetRoutes::UpdateByProcNet(void)
 	return true;
 }
 
-void NetRoutes::SetNameByIndex(const char *ifname, uint32_t ifnameIndex)
+// text of gateways, sources and neighbors, shared with RouteAddr::str()
+extern thread_local AddrCache routeAddrs;
+
+static bool FillArpRoute(const NeighborRecord * nb, ArpRouteInfo & ari)
 {
-	for( auto & route : inet ) {
-		if( route.valid.ifnameIndex && route.ifnameIndex == ifnameIndex ) {
-			route.iface = towstr(ifname);
-			route.valid.iface = 1;
-		}
+	LOG_TRACE("---------------- NeighborRecord ---------------------\n");
+	LOG_TRACE("nlh.nlmsg_type: %d (%s)\n", nb->nlm.nlmsg_type, nlmsgtype(nb->nlm.nlmsg_type));
+	LOG_TRACE("ndm_family:  %d (%s)\n", nb->ndm->ndm_family, familyname(nb->ndm->ndm_family));
+	LOG_TRACE("ndm_ifindex: %d\n", nb->ndm->ndm_ifindex);
+	LOG_TRACE("ndm_state:   0x%04X (%s)\n", nb->ndm->ndm_state, ndmsgstate(nb->ndm->ndm_state));
+	LOG_TRACE("ndm_flags:   0x%02X (%s)\n", nb->ndm->ndm_flags, ndmsgflagsname(nb->ndm->ndm_flags));
+	LOG_TRACE("ndm_type:    0x%02X (%s)\n", nb->ndm->ndm_type, rttype(nb->ndm->ndm_type));
+
+	ari.sa_family = nb->ndm->ndm_family;
+	ari.ifnameIndex = nb->ndm->ndm_ifindex;
+	ari.flags = nb->ndm->ndm_flags;
+	ari.type = nb->ndm->ndm_type;
+	ari.state = nb->ndm->ndm_state;
+	ari.valid.state = 1;
+	ari.valid.type = 1;
+	ari.valid.flags = 1;
+	ari.valid.ifnameIndex = (ari.ifnameIndex != (uint32_t)-1);
+
+	uint32_t addrlen = 0;
+	uint32_t family = nb->ndm->ndm_family;
+	const size_t maxlen = INET6_ADDRSTRLEN > INET_ADDRSTRLEN ? INET6_ADDRSTRLEN : INET_ADDRSTRLEN;
+	char s[maxlen+1] = {0};
 
-		if( route.valid.rtnexthop )
-			for( auto & item : route.osdep.nhs ) {
-				if( item.ifindex == ifnameIndex ) {
-					item.iface = std::move(towstr(ifname));
-					item.valid.iface = 1;
-				}
+	switch( ari.sa_family ) {
+	case AF_INET:
+	case RTNL_FAMILY_IPMR:
+		addrlen = sizeof(uint32_t);
+		family = AF_INET;
+		break;
+	case AF_INET6:
+	case RTNL_FAMILY_IP6MR:
+		addrlen = sizeof(struct in6_addr);
+		family = AF_INET6;
+		break;
+	case AF_BRIDGE:
+		if( RECORD_TB(nb, NDA_DST) ) {
+			if( RTA_PAYLOAD(RECORD_TB(nb, NDA_DST)) == sizeof(struct in6_addr) ) {
+				addrlen = sizeof(struct in6_addr);
+				family = AF_INET6;
+			} else {
+				addrlen = sizeof(uint32_t);
+				family = AF_INET;
 			}
+		}
+		break;
+	//case AF_MCTP:
+	//	addrlen = sizeof(uint8_t);
+	//	break;
+	default:
+		LOG_ERROR("unsupported family %u\n", ari.sa_family);
+		return false;
+	};
 
+	if( RECORD_TB(nb, NDA_DST) && RTA_PAYLOAD(RECORD_TB(nb, NDA_DST)) >= addrlen ) {
+		if( routeAddrs.Format(family, RTA_DATA(RECORD_TB(nb, NDA_DST)), ari.ip) )
+			ari.valid.ip = 1;
+		LOG_TRACE("NDA_DST:    %S\n", ari.ip.c_str());
 	}
-	for( auto & route : inet6 ) {
-		if( route.valid.ifnameIndex && route.ifnameIndex == ifnameIndex ) {
-			route.iface = towstr(ifname);
-			route.valid.iface = 1;
+
+	if( RECORD_TB(nb, NDA_LLADDR) && RTA_PAYLOAD(RECORD_TB(nb, NDA_LLADDR)) >= ETH_ALEN ) {
+		unsigned char * mac = (unsigned char *)RTA_DATA(RECORD_TB(nb, NDA_LLADDR));
+		if( snprintf(s, maxlen, "%02x:%02x:%02x:%02x:%02x:%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]) > 0 ) {
+			ari.mac = towstr(s);
+			ari.valid.mac = 1;
 		}
+		LOG_TRACE("NDA_LLADDR: %S\n", ari.mac.c_str());
+	}
 
-		if( route.valid.rtnexthop )
-			for( auto & item : route.osdep.nhs ) {
-				if( item.ifindex == ifnameIndex ) {
-					item.iface = std::move(towstr(ifname));
-					item.valid.iface = 1;
-				}
-			}
+	if( RECORD_TB(nb, NDA_PROBES) && RTA_PAYLOAD(RECORD_TB(nb, NDA_PROBES)) >= sizeof(uint32_t) ) {
+		ari.probes = RTA_UINT32_T(RECORD_TB(nb, NDA_PROBES));
+		ari.valid.probes = 1;
+		LOG_TRACE("NDA_PROBES: %d\n", ari.probes);
 	}
 
-	for( auto & route : arp ) {
-		if( route.valid.ifnameIndex && route.ifnameIndex == ifnameIndex ) {
-			route.iface = towstr(ifname);
-			route.valid.iface = 1;
-		}
+	if( RECORD_TB(nb, NDA_CACHEINFO) && RTA_PAYLOAD(RECORD_TB(nb, NDA_CACHEINFO)) >= sizeof(arproute_cacheinfo) ) {
+		ari.ci = *(arproute_cacheinfo *)RTA_DATA(RECORD_TB(nb, NDA_CACHEINFO));
+		ari.valid.ci = 1;
+		LOG_TRACE("NDA_CACHEINFO: ndm_confirmed %d\n", ari.ci.ndm_confirmed);
+		LOG_TRACE("NDA_CACHEINFO: ndm_used      %d\n", ari.ci.ndm_used);
+		LOG_TRACE("NDA_CACHEINFO: ndm_updated   %d\n", ari.ci.ndm_updated);
+		LOG_TRACE("NDA_CACHEINFO: ndm_refcnt    %d\n", ari.ci.ndm_refcnt);
+		ari.LogCacheInfo();
 	}
-	return;
+
+	if( RECORD_TB(nb, NDA_VLAN) && RTA_PAYLOAD(RECORD_TB(nb, NDA_VLAN)) >= sizeof(uint16_t) ) {
+		ari.vlan = RTA_UINT16_T(RECORD_TB(nb, NDA_VLAN));
+		ari.valid.vlan = 1;
+		LOG_TRACE("NDA_VLAN:   %d\n", ari.vlan);
+	}
+
+	if( RECORD_TB(nb, NDA_PORT) && RTA_PAYLOAD(RECORD_TB(nb, NDA_PORT)) >= sizeof(uint16_t) ) {
+		ari.port = RTA_UINT16_T(RECORD_TB(nb, NDA_PORT));
+		ari.valid.port = 1;
+		LOG_TRACE("NDA_PORT:   %d\n", ari.port);
+	}
+
+	if( RECORD_TB(nb, NDA_PROTOCOL) && RTA_PAYLOAD(RECORD_TB(nb, NDA_PROTOCOL)) >= sizeof(uint8_t) ) {
+		ari.protocol = RTA_UINT8_T(RECORD_TB(nb, NDA_PROTOCOL));
+		ari.valid.protocol = 1;
+		LOG_TRACE("NDA_PROTOCOL: %d (%s)\n", ari.protocol, rtprotocoltype(ari.protocol));
+	}
+
+	if( RECORD_TB(nb, NDA_IFINDEX) && RTA_PAYLOAD(RECORD_TB(nb, NDA_IFINDEX)) >= sizeof(uint32_t) ) {
+		ari.ifnameIndex = RTA_UINT32_T(RECORD_TB(nb, NDA_IFINDEX));
+		ari.valid.ifnameIndex = 1;
+		LOG_TRACE("NDA_IFINDEX: %d\n", ari.ifnameIndex);
+	}
+
+	if( RECORD_TB(nb, NDA_NH_ID) && RTA_PAYLOAD(RECORD_TB(nb, NDA_NH_ID)) >= sizeof(uint32_t) ) {
+		ari.nh_id = RTA_UINT32_T(RECORD_TB(nb, NDA_NH_ID));
+		ari.valid.nh_id = 1;
+		LOG_TRACE("NDA_NH_ID: %d\n", ari.nh_id);
+	}
+
+	if( RECORD_TB(nb, NDA_FLAGS_EXT) && RTA_PAYLOAD(RECORD_TB(nb, NDA_FLAGS_EXT)) >= sizeof(uint32_t) ) {
+		ari.flags_ext = RTA_UINT32_T(RECORD_TB(nb, NDA_FLAGS_EXT));
+		ari.valid.flags_ext = 1;
+		LOG_TRACE("NDA_FLAGS_EXT: %d\n", ari.flags_ext, ndmsgflags_extname(ari.flags_ext));
+	}
+
+	if( RECORD_TB(nb, NDA_VNI) && RTA_PAYLOAD(RECORD_TB(nb, NDA_VNI)) >= sizeof(uint32_t) ) {
+		ari.vni = RTA_UINT32_T(RECORD_TB(nb, NDA_VNI));
+		ari.valid.vni = 1;
+		LOG_TRACE("NDA_VNI:       %d\n", ari.vni);
+	}
+
+	if( RECORD_TB(nb, NDA_MASTER) && RTA_PAYLOAD(RECORD_TB(nb, NDA_MASTER)) >= sizeof(uint32_t) ) {
+		ari.master = RTA_UINT32_T(RECORD_TB(nb, NDA_MASTER));
+		ari.valid.master = 1;
+		LOG_TRACE("NDA_MASTER:    %d\n", ari.master);
+	}
+
+	//TODO: [NDA_FDB_EXT_ATTRS]	= { .type = NLA_NESTED }, NFEA_ACTIVITY_NOTIFY (FDB_NOTIFY_BIT)
+	return true;
 }
 
 bool NetRoutes::UpdateNeigbours(const NeighborRecord * nb)
@@ -552,719 +807,1124 @@ bool NetRoutes::UpdateNeigbours(const NeighborRecord * nb)
 	if( !nb )
 		return false;
 
-	while( nb->ndm ) {
-		LOG_INFO("---------------- NeighborRecord ---------------------\n");
-		LOG_INFO("nlh.nlmsg_type: %d (%s)\n", nb->nlm.nlmsg_type, nlmsgtype(nb->nlm.nlmsg_type));
-		LOG_INFO("ndm_family:  %d (%s)\n", nb->ndm->ndm_family, familyname(nb->ndm->ndm_family));
-		LOG_INFO("ndm_ifindex: %d\n", nb->ndm->ndm_ifindex);
-		LOG_INFO("ndm_state:   0x%04X (%s)\n", nb->ndm->ndm_state, ndmsgstate(nb->ndm->ndm_state));
-		LOG_INFO("ndm_flags:   0x%02X (%s)\n", nb->ndm->ndm_flags, ndmsgflagsname(nb->ndm->ndm_flags));
-		LOG_INFO("ndm_type:    0x%02X (%s)\n", nb->ndm->ndm_type, rttype(nb->ndm->ndm_type));
-
+	for( ; nb->ndm; nb++ ) {
 		ArpRouteInfo ari;
-		ari.sa_family = nb->ndm->ndm_family;
-		ari.ifnameIndex = nb->ndm->ndm_ifindex;
-		ari.flags = nb->ndm->ndm_flags;
-		ari.type = nb->ndm->ndm_type;
-		ari.state = nb->ndm->ndm_state;
-		ari.valid.state = 1;
-		ari.valid.type = 1;
-		ari.valid.flags = 1;
-		ari.valid.ifnameIndex = (ari.ifnameIndex != (uint32_t)-1);
-
-		uint32_t addrlen = 0;
-		uint32_t family = nb->ndm->ndm_family;
-		const size_t maxlen = INET6_ADDRSTRLEN > INET_ADDRSTRLEN ? INET6_ADDRSTRLEN : INET_ADDRSTRLEN;
-		char s[maxlen+1] = {0};
+		if( FillArpRoute(nb, ari) )
+			arp.push_back(ari);
+	}
+	return true;
+}
 
-		switch( ari.sa_family ) {
-		case AF_INET:
-		case RTNL_FAMILY_IPMR:
-			addrlen = sizeof(uint32_t);
-			family = AF_INET;
-			break;
-		case AF_INET6:
-		case RTNL_FAMILY_IP6MR:
-			addrlen = sizeof(struct in6_addr);
-			family = AF_INET6;
-			break;
-		case AF_BRIDGE:
-			if( nb->tb[NDA_DST] ) {
-				if( RTA_PAYLOAD(nb->tb[NDA_DST]) == sizeof(struct in6_addr) ) {
-					addrlen = sizeof(struct in6_addr);
-					family = AF_INET6;
-				} else {
-					addrlen = sizeof(uint32_t);
-					family = AF_INET;
+// gateway of RTA_VIA may be of other family than route, only IPv4 and IPv6 are kept
+static bool ViaAddr(const struct rtattr * rta, RouteAddr & addr)
+{
+	const struct rtvia *via = (const struct rtvia *)RTA_DATA(rta);
+	size_t len = via->rtvia_family == AF_INET ? sizeof(struct in_addr):(via->rtvia_family == AF_INET6 ? sizeof(struct in6_addr):0);
+	if( !len || RTA_PAYLOAD(rta) < sizeof(*via) + len )
+		return false;
+	addr.Set(via->rtvia_family, via->rtvia_addr);
+	return true;
+}
+
+static bool FillIpRoute(const RouteRecord * rr, IpRouteInfo & ipr)
+{
+	// routes are filled by several threads, trace names are formatted here
+	char name[RTNHFLAGSNAME_SIZE];
+	static_assert(sizeof(name) >= RTRULETABLE_SIZE && sizeof(name) >= RTPROTOCOLTYPE_SIZE && \
+		sizeof(name) >= RTSCOPETYPE_SIZE && sizeof(name) >= RTICMP6PREF_SIZE, "trace name buffer is too small");
+
+	LOG_TRACE("-------------------------------------\n");
+	LOG_TRACE("nlh.nlmsg_type: %d (%s)\n", rr->nlm.nlmsg_type, nlmsgtype(rr->nlm.nlmsg_type));
+	LOG_TRACE("rtm_family:   %u (%s)\n", rr->rt->rtm_family, familyname(rr->rt->rtm_family));
+	LOG_TRACE("rtm_dst_len:  %u\n", rr->rt->rtm_dst_len );
+	LOG_TRACE("rtm_src_len:  %u\n", rr->rt->rtm_src_len );
+	LOG_TRACE("rtm_tos:      %u\n", rr->rt->rtm_tos );
+	LOG_TRACE("rtm_table:    %u (%s)\n", rr->rt->rtm_table, rtruletable_r(rr->rt->rtm_table, name, sizeof(name)) );
+	LOG_TRACE("rtm_protocol: %u (%s)\n", rr->rt->rtm_protocol, rtprotocoltype_r(rr->rt->rtm_protocol, name, sizeof(name)));
+	LOG_TRACE("rtm_scope:    %u (%s)\n", rr->rt->rtm_scope, rtscopetype_r(rr->rt->rtm_scope, name, sizeof(name))); // Address scope
+	LOG_TRACE("rtm_type:     %u (%s)\n", rr->rt->rtm_type, rttype(rr->rt->rtm_type) );
+	LOG_TRACE("rtm_flags:    0x%08X\n", rr->rt->rtm_flags );
+
+	ipr.sa_family = rr->rt->rtm_family;
+	ipr.valid.flags = 1;
+	ipr.flags = rr->rt->rtm_flags;
+	ipr.valid.dstprefixlen = 1;
+	ipr.dstprefixlen = rr->rt->rtm_dst_len;
+	ipr.osdep.table = rr->rt->rtm_table;
+	ipr.valid.table = (bool)ipr.osdep.table;
+
+	ipr.valid.protocol = 1;
+	ipr.osdep.protocol = rr->rt->rtm_protocol;
+	ipr.valid.scope = 1;
+	ipr.osdep.scope = rr->rt->rtm_scope;
+	ipr.valid.type = 1;
+	ipr.osdep.type = rr->rt->rtm_type;
+	ipr.valid.tos = 1;
+	ipr.osdep.tos = rr->rt->rtm_tos;
+
+	uint32_t addrlen = 0;
+
+	switch( ipr.sa_family ) {
+	case AF_INET:
+		addrlen = sizeof(uint32_t);
+		break;
+	case AF_INET6:
+		addrlen = sizeof(struct in6_addr);
+		break;
+	//case AF_MCTP:
+	//	addrlen = sizeof(uint8_t);
+	//	break;
+	default:
+		LOG_ERROR("unsupported family %u\n", ipr.sa_family);
+		return false;
+	};
+
+	if( RECORD_TB(rr, RTA_OIF) && RTA_PAYLOAD(RECORD_TB(rr, RTA_OIF)) >= sizeof(uint32_t) ) {
+		ipr.ifnameIndex = RTA_UINT32_T(RECORD_TB(rr, RTA_OIF));
+		ipr.valid.ifnameIndex = 1;
+		LOG_TRACE("RTA_OIF: %u\n", ipr.ifnameIndex);
+	}
+
+	if( RECORD_TB(rr, RTA_TABLE) && RTA_PAYLOAD(RECORD_TB(rr, RTA_TABLE)) >= sizeof(uint32_t) ) {
+		ipr.osdep.table = RTA_UINT32_T(RECORD_TB(rr, RTA_TABLE));
+		ipr.valid.table = 1;
+		LOG_TRACE("RTA_TABLE %u (%s)\n", ipr.osdep.table, rtruletable_r(ipr.osdep.table, name, sizeof(name)));
+	}
+	if( RECORD_TB(rr, RTA_GATEWAY) && RTA_PAYLOAD(RECORD_TB(rr, RTA_GATEWAY)) >= addrlen ) {
+		ipr.gateway.Set(ipr.sa_family, RTA_DATA(RECORD_TB(rr, RTA_GATEWAY)));
+		ipr.valid.gateway = 1;
+		LOG_TRACE("RTA_GATEWAY: %S\n", ipr.gateway.str().c_str());
+	}
+	if( RECORD_TB(rr, RTA_DST) && RTA_PAYLOAD(RECORD_TB(rr, RTA_DST)) >= addrlen ) {
+		ipr.destIpandMask.Set(ipr.sa_family, RTA_DATA(RECORD_TB(rr, RTA_DST)), ipr.dstprefixlen);
+		ipr.valid.destIpandMask = 1;
+		LOG_TRACE("RTA_DST: %S\n", ipr.destIpandMask.str().c_str());
+	}
+	if( RECORD_TB(rr, RTA_PRIORITY) && RTA_PAYLOAD(RECORD_TB(rr, RTA_PRIORITY)) >= sizeof(int32_t) ) {
+		ipr.osdep.metric = RTA_INT32_T(RECORD_TB(rr, RTA_PRIORITY));
+		ipr.valid.metric = 1;
+		LOG_TRACE("RTA_PRIORITY: %d\n", ipr.osdep.metric);
+	}
+	if( RECORD_TB(rr, RTA_PREFSRC) && RTA_PAYLOAD(RECORD_TB(rr, RTA_PREFSRC)) >= addrlen ) {
+		ipr.prefsrc.Set(ipr.sa_family, RTA_DATA(RECORD_TB(rr, RTA_PREFSRC)));
+		ipr.valid.prefsrc = 1;
+		LOG_TRACE("RTA_PREFSRC: %S\n", ipr.prefsrc.str().c_str());
+	}
+	if( RECORD_TB(rr, RTA_PREF) && RTA_PAYLOAD(RECORD_TB(rr, RTA_PREF)) >= sizeof(uint8_t) ) {
+		ipr.osdep.icmp6pref = RTA_UINT8_T(RECORD_TB(rr, RTA_PREF));
+		ipr.valid.icmp6pref = 1;
+		LOG_TRACE("RTA_PREF: %u (%s)\n", ipr.osdep.icmp6pref, rticmp6pref_r(ipr.osdep.icmp6pref, name, sizeof(name)));
+	}
+
+	if( RECORD_TB(rr, RTA_CACHEINFO) && RTA_PAYLOAD(RECORD_TB(rr, RTA_CACHEINFO)) >= sizeof(struct rta_cacheinfo) ) {
+		const size_t size = sizeof(RtCacheInfo) <= sizeof(struct rta_cacheinfo) ? \
+			sizeof(RtCacheInfo):sizeof(struct rta_cacheinfo);
+		memmove(&ipr.osdep.rtcache.Set(), RTA_DATA(RECORD_TB(rr, RTA_CACHEINFO)), size);
+		ipr.valid.rtcache = 1;
+		LOG_TRACE("RTA_CACHEINFO: size %u\n", RTA_PAYLOAD(RECORD_TB(rr, RTA_CACHEINFO)));
+		ipr.LogRtCache();
+	}
+
+	if( RECORD_TB(rr, RTA_METRICS) && RTA_PAYLOAD(RECORD_TB(rr, RTA_METRICS)) >= sizeof(struct rtattr) ) {
+		struct rtattr * mrta[RTAX_MAX+1];
+		if( FillAttr((struct rtattr*)RTA_DATA(RECORD_TB(rr, RTA_METRICS)),
+					mrta,
+					RTAX_MAX,
+					(short unsigned int)(~NLA_F_NESTED),
+					RTA_PAYLOAD(RECORD_TB(rr, RTA_METRICS)),
+					rtaxtype) ) {
+			//static_assert( (sizeof(RtMetrics)/sizeof(uint32_t)) == (RTAX_MAX+1) );
+			RtMetrics & rtmetrics = ipr.osdep.rtmetrics.Set();
+			for(uint32_t index = 0; index < sizeof(RtMetrics)/sizeof(uint32_t); index++ ) {
+				if( mrta[index] && RTA_PAYLOAD(mrta[index]) >= sizeof(uint32_t) ) {
+					((uint32_t *)&rtmetrics)[index] = RTA_UINT32_T(mrta[index]);
+					LOG_TRACE("%s: %d\n", rtaxtype(index), ((uint32_t *)&rtmetrics)[index]);
 				}
 			}
-			break;
-		//case AF_MCTP:
-		//	addrlen = sizeof(uint8_t);
-		//	break;
-		default:
-			LOG_ERROR("unsupported family %u\n", ari.sa_family);
-			continue;
-		};
-
-		if( nb->tb[NDA_DST] && RTA_PAYLOAD(nb->tb[NDA_DST]) >= addrlen ) {
-			if( inet_ntop(family, RTA_DATA(nb->tb[NDA_DST]), s, maxlen) ) {
-				ari.ip = towstr(s);
-				ari.valid.ip = 1;
-			}
-			LOG_INFO("NDA_DST:    %S\n", ari.ip.c_str());
+			ipr.valid.rtmetrics = 1;
+			ipr.valid.hoplimit = 1;
+			ipr.hoplimit = rtmetrics.hoplimit;
 		}
+		LOG_TRACE("RTA_METRICS: ... ok\n");
+	}
+
+	if( RECORD_TB(rr, RTA_SRC) && RTA_PAYLOAD(RECORD_TB(rr, RTA_SRC)) >= addrlen ) {
+		ipr.osdep.fromsrcIpandMask.Set(ipr.sa_family, RTA_DATA(RECORD_TB(rr, RTA_SRC)), rr->rt->rtm_src_len);
+		ipr.valid.fromsrcIpandMask = 1;
+		LOG_TRACE("RTA_SRC: %S\n", ipr.osdep.fromsrcIpandMask.str().c_str());
+	}
+
+	if( RECORD_TB(rr, RTA_VIA) && RTA_PAYLOAD(RECORD_TB(rr, RTA_VIA)) >= sizeof(struct rtvia) ) {
+		const struct rtvia *via = (const struct rtvia *)RTA_DATA(RECORD_TB(rr, RTA_VIA));
+		ipr.osdep.rtvia_family = via->rtvia_family;
+		if( ViaAddr(RECORD_TB(rr, RTA_VIA), ipr.osdep.rtvia_addr) )
+			ipr.valid.rtvia = 1;
+		LOG_TRACE("RTA_VIA:     %S\n", ipr.osdep.rtvia_addr.str().c_str());
+	}
 
-		if( nb->tb[NDA_LLADDR] && RTA_PAYLOAD(nb->tb[NDA_LLADDR]) >= ETH_ALEN ) {
-			unsigned char * mac = (unsigned char *)RTA_DATA(nb->tb[NDA_LLADDR]);
-			if( snprintf(s, maxlen, "%02x:%02x:%02x:%02x:%02x:%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]) > 0 ) {
-				ari.mac = towstr(s);
-				ari.valid.mac = 1;
+	if( RECORD_TB(rr, RTA_ENCAP_TYPE) && RECORD_TB(rr, RTA_ENCAP) && RTA_PAYLOAD(RECORD_TB(rr, RTA_ENCAP_TYPE)) >= sizeof(uint16_t) ) {
+		Encap & enc = ipr.osdep.enc.Set();
+		enc.type = RTA_UINT16_T(RECORD_TB(rr, RTA_ENCAP_TYPE));
+		if( FillEncap(&enc, RECORD_TB(rr, RTA_ENCAP) ) )
+			ipr.valid.encap = 1;
+		else
+			ipr.osdep.enc.Reset();
+	}
+
+	if( RECORD_TB(rr, RTA_MULTIPATH) && RTA_PAYLOAD(RECORD_TB(rr, RTA_MULTIPATH)) >= sizeof(struct rtnexthop) ) {
+		const struct rtnexthop *nh = (struct rtnexthop *)RTA_DATA(RECORD_TB(rr, RTA_MULTIPATH));
+		int len = RTA_PAYLOAD(RECORD_TB(rr, RTA_MULTIPATH));
+
+		ipr.valid.rtnexthop = 1;
+
+		while( len >= static_cast<int>(sizeof(*nh)) ) {
+			LOG_TRACE("RTA_MULTIPATH: rtnh_len     %d\n", nh->rtnh_len);
+			LOG_TRACE("RTA_MULTIPATH: rtnh_flags   0x%02X (%s)\n", nh->rtnh_flags, rtnhflagsname_r(nh->rtnh_flags, name, sizeof(name)));
+			LOG_TRACE("RTA_MULTIPATH: rtnh_hops    %d\n", nh->rtnh_hops);
+			LOG_TRACE("RTA_MULTIPATH: rtnh_ifindex %d\n", nh->rtnh_ifindex);
+
+			NextHope netHope;
+			netHope.valid.nexthope = 1;
+			netHope.flags = nh->rtnh_flags;
+			netHope.weight = nh->rtnh_hops;
+			netHope.ifindex = nh->rtnh_ifindex;
+
+			if (nh->rtnh_len > len) {
+				ipr.osdep.nhs.push_back(netHope);
+				break;
 			}
-			LOG_INFO("NDA_LLADDR: %S\n", ari.mac.c_str());
-		}
 
-		if( nb->tb[NDA_PROBES] && RTA_PAYLOAD(nb->tb[NDA_PROBES]) >= sizeof(uint32_t) ) {
-			ari.probes = RTA_UINT32_T(nb->tb[NDA_PROBES]);
-			ari.valid.probes = 1;
-			LOG_INFO("NDA_PROBES: %d\n", ari.probes);
-		}
+			struct rtattr * rta[RTA_MAX + 1];
+
+			if( nh->rtnh_len > sizeof(*nh) && FillAttr((struct rtattr*)RTNH_DATA(nh),
+					rta,
+					RTA_MAX,
+					(short unsigned int)(~NLA_F_NESTED),
+					nh->rtnh_len - sizeof(*nh),
+					rtatype) ) {
+
+				if( rta[RTA_ENCAP_TYPE] && rta[RTA_ENCAP] && RTA_PAYLOAD(rta[RTA_ENCAP_TYPE]) >= sizeof(uint16_t) ) {
+					Encap & enc = netHope.enc.Set();
+					enc.type = RTA_UINT16_T(rta[RTA_ENCAP_TYPE]);
+					if( FillEncap(&enc, rta[RTA_ENCAP] ) )
+						netHope.valid.encap = 1;
+					else
+						netHope.enc.Reset();
+				}
 
-		if( nb->tb[NDA_CACHEINFO] && RTA_PAYLOAD(nb->tb[NDA_CACHEINFO]) >= sizeof(arproute_cacheinfo) ) {
-			ari.ci = *(arproute_cacheinfo *)RTA_DATA(nb->tb[NDA_CACHEINFO]);
-			ari.valid.ci = 1;
-			LOG_INFO("NDA_CACHEINFO: ndm_confirmed %d\n", ari.ci.ndm_confirmed);
-			LOG_INFO("NDA_CACHEINFO: ndm_used      %d\n", ari.ci.ndm_used);
-			LOG_INFO("NDA_CACHEINFO: ndm_updated   %d\n", ari.ci.ndm_updated);
-			LOG_INFO("NDA_CACHEINFO: ndm_refcnt    %d\n", ari.ci.ndm_refcnt);
-			ari.LogCacheInfo();
-		}
+				if( rta[RTA_GATEWAY] && RTA_PAYLOAD(rta[RTA_GATEWAY]) >= addrlen ) {
+					netHope.gateway.Set(ipr.sa_family, RTA_DATA(rta[RTA_GATEWAY]));
+					netHope.valid.gateway = 1;
+					LOG_TRACE("RTA_GATEWAY: %S\n", netHope.gateway.str().c_str());
+				}
 
-		if( nb->tb[NDA_VLAN] && RTA_PAYLOAD(nb->tb[NDA_VLAN]) >= sizeof(uint16_t) ) {
-			ari.vlan = RTA_UINT16_T(nb->tb[NDA_VLAN]);
-			ari.valid.vlan = 1;
-			LOG_INFO("NDA_VLAN:   %d\n", ari.vlan);
-		}
+				if( rta[RTA_VIA] && RTA_PAYLOAD(rta[RTA_VIA]) >= sizeof(struct rtvia) ) {
+					const struct rtvia *via = (const struct rtvia *)RTA_DATA(rta[RTA_VIA]);
+					netHope.rtvia_family = via->rtvia_family;
+					if( ViaAddr(rta[RTA_VIA], netHope.rtvia_addr) )
+						netHope.valid.rtvia = 1;
+					LOG_TRACE("RTA_VIA:     %S\n", netHope.rtvia_addr.str().c_str());
+				}
 
-		if( nb->tb[NDA_PORT] && RTA_PAYLOAD(nb->tb[NDA_PORT]) >= sizeof(uint16_t) ) {
-			ari.port = RTA_UINT16_T(nb->tb[NDA_PORT]);
-			ari.valid.port = 1;
-			LOG_INFO("NDA_PORT:   %d\n", ari.port);
-		}
+				if( rta[RTA_FLOW] && RTA_PAYLOAD(rta[RTA_FLOW]) >= sizeof(uint32_t) ) {
+					uint32_t flow = RTA_UINT32_T(rta[RTA_FLOW]);
+					netHope.flowto = flow & 0xFFFF;
+					netHope.flowfrom = flow >> 16;
+					netHope.valid.flowto = 1;
+					netHope.valid.flowfrom = (netHope.flowfrom != 0);
+					LOG_TRACE("RTA_FLOW:    %d/%d\n", netHope.flowfrom, netHope.flowto);
+				}
 
-		if( nb->tb[NDA_PROTOCOL] && RTA_PAYLOAD(nb->tb[NDA_PROTOCOL]) >= sizeof(uint8_t) ) {
-			ari.protocol = RTA_UINT8_T(nb->tb[NDA_PROTOCOL]);
-			ari.valid.protocol = 1;
-			LOG_INFO("NDA_PROTOCOL: %d (%s)\n", ari.protocol, rtprotocoltype(ari.protocol));
-		}
+				// TODO: RTA_NEWDST
+			}
 
-		if( nb->tb[NDA_IFINDEX] && RTA_PAYLOAD(nb->tb[NDA_IFINDEX]) >= sizeof(uint32_t) ) {
-			ari.ifnameIndex = RTA_UINT32_T(nb->tb[NDA_IFINDEX]);
-			ari.valid.ifnameIndex = 1;
-			LOG_INFO("NDA_IFINDEX: %d\n", ari.ifnameIndex);
+			ipr.osdep.nhs.push_back(netHope);
+			len -= NLMSG_ALIGN(nh->rtnh_len);
+			nh = RTNH_NEXT(nh);
 		}
+		LOG_TRACE("RTA_MULTIPATH ... ok\n");
+	}
 
-		if( nb->tb[NDA_NH_ID] && RTA_PAYLOAD(nb->tb[NDA_NH_ID]) >= sizeof(uint32_t) ) {
-			ari.nh_id = RTA_UINT32_T(nb->tb[NDA_NH_ID]);
-			ari.valid.nh_id = 1;
-			LOG_INFO("NDA_NH_ID: %d\n", ari.nh_id);
-		}
+	if( RECORD_TB(rr, RTA_NH_ID) && RTA_PAYLOAD(RECORD_TB(rr, RTA_NH_ID)) >= sizeof(uint32_t) ) {
+		ipr.osdep.nhid = RTA_UINT32_T(RECORD_TB(rr, RTA_NH_ID));
+		ipr.valid.nhid = 1;
+		LOG_TRACE("RTA_NH_ID:    %u\n", ipr.osdep.nhid);
+	}
 
-		if( nb->tb[NDA_FLAGS_EXT] && RTA_PAYLOAD(nb->tb[NDA_FLAGS_EXT]) >= sizeof(uint32_t) ) {
-			ari.flags_ext = RTA_UINT32_T(nb->tb[NDA_FLAGS_EXT]);
-			ari.valid.flags_ext = 1;
-			LOG_INFO("NDA_FLAGS_EXT: %d\n", ari.flags_ext, ndmsgflags_extname(ari.flags_ext));
+// TODO:
+
+/*const struct nla_policy rtm_ipv4_policy[RTA_MAX + 1] = {
+[RTA_UNSPEC]		= { .strict_start_type = RTA_DPORT + 1 },
+[RTA_DST]		= { .type = NLA_U32 },
+[RTA_SRC]		= { .type = NLA_U32 },
+[RTA_IIF]		= { .type = NLA_U32 },
+[RTA_OIF]		= { .type = NLA_U32 },
+[RTA_GATEWAY]		= { .type = NLA_U32 },
+[RTA_PRIORITY]		= { .type = NLA_U32 },
+[RTA_PREFSRC]		= { .type = NLA_U32 },
+[RTA_METRICS]		= { .type = NLA_NESTED },
+[RTA_MULTIPATH]		= { .len = sizeof(struct rtnexthop) },
+[RTA_FLOW]		= { .type = NLA_U32 },
+[RTA_ENCAP_TYPE]	= { .type = NLA_U16 },
+[RTA_ENCAP]		= { .type = NLA_NESTED },
+[RTA_UID]		= { .type = NLA_U32 },
+[RTA_MARK]		= { .type = NLA_U32 },
+[RTA_TABLE]		= { .type = NLA_U32 },
+[RTA_IP_PROTO]		= { .type = NLA_U8 },
+[RTA_SPORT]		= { .type = NLA_U16 },
+[RTA_DPORT]		= { .type = NLA_U16 },
+[RTA_NH_ID]		= { .type = NLA_U32 },
+};
+
+static const struct nla_policy rtm_ipv6_policy[RTA_MAX+1] = {
+[RTA_UNSPEC]		= { .strict_start_type = RTA_DPORT + 1 },
+[RTA_GATEWAY]           = { .len = sizeof(struct in6_addr) },
+[RTA_PREFSRC]		= { .len = sizeof(struct in6_addr) },
+[RTA_OIF]               = { .type = NLA_U32 },
+[RTA_IIF]		= { .type = NLA_U32 },
+[RTA_PRIORITY]          = { .type = NLA_U32 },
+[RTA_METRICS]           = { .type = NLA_NESTED },
+[RTA_MULTIPATH]		= { .len = sizeof(struct rtnexthop) },
+[RTA_PREF]              = { .type = NLA_U8 },
+[RTA_ENCAP_TYPE]	= { .type = NLA_U16 },
+[RTA_ENCAP]		= { .type = NLA_NESTED },
+[RTA_EXPIRES]		= { .type = NLA_U32 },
+[RTA_UID]		= { .type = NLA_U32 },
+[RTA_MARK]		= { .type = NLA_U32 },
+[RTA_TABLE]		= { .type = NLA_U32 },
+[RTA_IP_PROTO]		= { .type = NLA_U8 },
+[RTA_SPORT]		= { .type = NLA_U16 },
+[RTA_DPORT]		= { .type = NLA_U16 },
+[RTA_NH_ID]		= { .type = NLA_U32 },
+};
+*/
+	return true;
+}
+
+void NetRoutes::AddIpRoute(IpRouteInfo ipr)
+{
+	if( ipr.valid.gateway || ipr.valid.rtvia ) {
+		LOG_TRACE("push GATEWAY\n");
+		if( ipr.sa_family == AF_INET )
+			inet.push_front(std::move(ipr));
+		else if( ipr.sa_family == AF_INET6 )
+			inet6.push_front(std::move(ipr));
+	} else  {
+		LOG_TRACE("push NORMAL\n");
+		if( ipr.sa_family == AF_INET )
+			inet.push_back(std::move(ipr));
+		else if( ipr.sa_family == AF_INET6 )
+			inet6.push_back(std::move(ipr));
+	}
+}
+
+// smaller dump is converted faster by one thread than threads are woken up
+#define PARALLEL_DECODE_MIN_RECORDS 8192
+// a few chunks per thread, so slow chunk (multipath, encap) does not keep others waiting
+#define PARALLEL_DECODE_CHUNKS 4
+
+void NetRoutes::AddIpRoutes(const RouteRecord * rr, NetDumpCollector & pool)
+{
+	size_t total = 0;
+	while( rr[total].rt )
+		total++;
+
+	if( pool.Threads() < 2 || total < PARALLEL_DECODE_MIN_RECORDS ) {
+		for( ; rr->rt; rr++ ) {
+			IpRouteInfo ipr;
+			if( FillIpRoute(rr, ipr) )
+				AddIpRoute(std::move(ipr));
 		}
+		return;
+	}
 
-		if( nb->tb[NDA_VNI] && RTA_PAYLOAD(nb->tb[NDA_VNI]) >= sizeof(uint32_t) ) {
-			ari.vni = RTA_UINT32_T(nb->tb[NDA_VNI]);
-			ari.valid.vni = 1;
-			LOG_INFO("NDA_VNI:       %d\n", ari.vni);
+	size_t chunks = pool.Threads() * PARALLEL_DECODE_CHUNKS;
+	size_t size = (total + chunks - 1) / chunks;
+	std::vector<std::vector<IpRouteInfo>> parts(chunks);
+
+	pool.Parallel(chunks, [rr, total, size, &parts](size_t chunk) {
+		size_t begin = chunk * size, end = std::min(total, begin + size);
+		auto & part = parts[chunk];
+		part.reserve(end > begin ? end - begin:0);
+		for( size_t i = begin; i < end; i++ ) {
+			part.emplace_back();
+			if( !FillIpRoute(&rr[i], part.back()) )
+				part.pop_back();
 		}
+	});
+
+	for( auto & part : parts )
+		for( auto & ipr : part )
+			AddIpRoute(std::move(ipr));
+}
+
+static bool FillRuleRoute(const RuleRecord * r, RuleRouteInfo & rri)
+{
+	LOG_TRACE("---------------- RuleRecord ---------------------\n");
+	LOG_TRACE("nlh.nlmsg_type: %d (%s)\n", r->nlm.nlmsg_type, nlmsgtype(r->nlm.nlmsg_type));
+	LOG_TRACE("family:  %d (%s)\n", r->frh->family, familyname(r->frh->family));
+	LOG_TRACE("dst_len: %d\n", r->frh->dst_len);
+	LOG_TRACE("src_len: %d\n", r->frh->src_len);
+	LOG_TRACE("tos:     0x%02X\n", r->frh->tos);
+	LOG_TRACE("table:   %d (%s)\n", r->frh->table, rtruletable(r->frh->table));
+	LOG_TRACE("res1:    %d\n", r->frh->res1);
+	LOG_TRACE("res2:    %d\n", r->frh->res2);
+	LOG_TRACE("action:  %d (%s)\n", r->frh->action, fractionrule(r->frh->action));
+	LOG_TRACE("flags:   0x%08X (%s)\n", r->frh->flags, fibruleflagsname(r->frh->flags));
+
+	rri.family = r->frh->family;
+	rri.fwmark = 0;
+	rri.fwmask = 0;
+	rri.valid = {0};
+	rri.tos = r->frh->tos;
+	rri.flags = r->frh->flags;
+	rri.type = r->nlm.nlmsg_type;
+	rri.priority = 0;
+	rri.table = r->frh->table;
+	rri.action = r->frh->action;
+
+	uint32_t addrlen = 0;
+	uint32_t family = r->frh->family;
+	const size_t maxlen = INET6_ADDRSTRLEN > INET_ADDRSTRLEN ? INET6_ADDRSTRLEN : INET_ADDRSTRLEN;
+	char s[maxlen+1] = {0};
+
+	switch( rri.family ) {
+	case AF_INET:
+	case RTNL_FAMILY_IPMR:
+		addrlen = sizeof(uint32_t);
+		family = AF_INET;
+		break;
+	case AF_INET6:
+	case RTNL_FAMILY_IP6MR:
+		addrlen = sizeof(struct in6_addr);
+		family = AF_INET6;
+		break;
+	//case AF_MCTP:
+	//	addrlen = sizeof(uint8_t);
+	//	break;
+	default:
+		LOG_ERROR("unsupported family %u\n", rri.family);
+		return false;
+	};
 
-		if( nb->tb[NDA_MASTER] && RTA_PAYLOAD(nb->tb[NDA_MASTER]) >= sizeof(uint32_t) ) {
-			ari.master = RTA_UINT32_T(nb->tb[NDA_MASTER]);
-			ari.valid.master = 1;
-			LOG_INFO("NDA_MASTER:    %d\n", ari.master);
+	if( RECORD_TB(r, FRA_PRIORITY) && RTA_PAYLOAD(RECORD_TB(r, FRA_PRIORITY)) >= sizeof(uint32_t) ) {
+		rri.priority = RTA_UINT32_T(RECORD_TB(r, FRA_PRIORITY));
+		rri.valid.priority = 1;
+		LOG_TRACE("FRA_PRIORITY:           %d\n", rri.priority);
+	}
+
+	if( RECORD_TB(r, FRA_SRC) && RTA_PAYLOAD(RECORD_TB(r, FRA_SRC)) >= addrlen ) {
+		rri.fromIpandMask = destIpandMask(family, RTA_DATA(RECORD_TB(r, FRA_SRC)), r->frh->src_len);
+		LOG_TRACE("FRA_SRC:                %S\n", rri.fromIpandMask.c_str());
+	} else if( r->frh->src_len ) {
+		rri.fromIpandMask = L"0/";
+		rri.fromIpandMask += std::to_wstring(r->frh->src_len);
+	} else
+		rri.fromIpandMask = L"all";
+
+	rri.valid.fromIpandMask = 1;
+
+
+	if( RECORD_TB(r, FRA_DST) && RTA_PAYLOAD(RECORD_TB(r, FRA_DST)) >= addrlen ) {
+		rri.toIpandMask = destIpandMask(family, RTA_DATA(RECORD_TB(r, FRA_DST)), r->frh->dst_len);
+		LOG_TRACE("FRA_DST:                %S\n", rri.toIpandMask.c_str());
+		rri.valid.toIpandMask = 1;
+	} else if( r->frh->dst_len ) {
+		rri.toIpandMask = L"to 0/" + std::to_wstring(r->frh->dst_len);
+		rri.valid.toIpandMask = 1;
+	}
+
+	if( RECORD_TB(r, FRA_FWMARK) && RTA_PAYLOAD(RECORD_TB(r, FRA_FWMARK)) >= sizeof(uint32_t) ) {
+		rri.fwmark = RTA_UINT32_T(RECORD_TB(r, FRA_FWMARK));
+		rri.valid.fwmark = 1;
+		LOG_TRACE("FRA_FWMARK:             0x%08X\n", rri.fwmark);
+	}
+	if( RECORD_TB(r, FRA_FWMASK) && RTA_PAYLOAD(RECORD_TB(r, FRA_FWMASK)) >= sizeof(uint32_t) ) {
+		rri.fwmask = RTA_UINT32_T(RECORD_TB(r, FRA_FWMASK));
+		rri.valid.fwmask = (rri.fwmask != 0xFFFFFFFF);
+		LOG_TRACE("FRA_FWMARK/FRA_FWMASK:  0x%08X/0x%08X\n", rri.fwmark, rri.fwmask);
+	}
+
+	if( RECORD_TB(r, FRA_IIFNAME) && RTA_PAYLOAD(RECORD_TB(r, FRA_IIFNAME)) >= sizeof(uint8_t) ) {
+		rri.iiface = towstr((const char *)RTA_DATA(RECORD_TB(r, FRA_IIFNAME)));
+		rri.valid.iiface = 1;
+		LOG_TRACE("FRA_IIFNAME:            %S\n", rri.iiface.c_str());
+	}
+	if( RECORD_TB(r, FRA_OIFNAME) && RTA_PAYLOAD(RECORD_TB(r, FRA_OIFNAME)) >= sizeof(uint8_t) ) {
+		rri.oiface = towstr((const char *)RTA_DATA(RECORD_TB(r, FRA_OIFNAME)));
+		rri.valid.oiface = 1;
+		LOG_TRACE("FRA_OIFNAME:            %S\n", rri.oiface.c_str());
+	}
+
+	// on android #define FRA_UID_START FRA_PAD and #define FRA_UID_END FRA_L3MDEV
+	if( RECORD_TB(r, FRA_L3MDEV) && !RECORD_TB(r, FRA_PAD) && RTA_PAYLOAD(RECORD_TB(r, FRA_L3MDEV)) >= sizeof(uint8_t) ) {
+		rri.l3mdev = RTA_UINT8_T(RECORD_TB(r, FRA_L3MDEV));
+		rri.valid.l3mdev = 1;
+		LOG_TRACE("FRA_L3MDEV:             %d\n", rri.l3mdev);
+	}
+
+	if( RECORD_TB(r, FRA_UID_START) && RECORD_TB(r, FRA_UID_END) && \
+			RTA_PAYLOAD(RECORD_TB(r, FRA_UID_START)) >= sizeof(uint32_t) &&
+			RTA_PAYLOAD(RECORD_TB(r, FRA_UID_END)) >= sizeof(uint32_t) ) {
+		rri.uid_range.start = RTA_UINT32_T(RECORD_TB(r, FRA_UID_START));
+		rri.uid_range.end = RTA_UINT32_T(RECORD_TB(r, FRA_UID_END));
+		assert( !rri.valid.l3mdev );
+		rri.valid.uid_range = 1;
+		LOG_TRACE("FRA_UID_START:          %d\n", rri.uid_range.start);
+		LOG_TRACE("FRA_UID_END:            %d\n", rri.uid_range.end);
+	}
+
+	if( RECORD_TB(r, FRA_UID_RANGE) && RTA_PAYLOAD(RECORD_TB(r, FRA_UID_RANGE)) >= sizeof(struct uid_range) ) {
+		rri.uid_range = *(struct uid_range *)RTA_DATA(RECORD_TB(r, FRA_UID_RANGE));
+		assert( !rri.valid.uid_range );
+		rri.valid.uid_range = 1;
+		LOG_TRACE("FRA_UID_RANGE:          %d-%d\n", rri.uid_range.start, rri.uid_range.end);
+	}
+
+	if( RECORD_TB(r, FRA_IP_PROTO) && RTA_PAYLOAD(RECORD_TB(r, FRA_IP_PROTO)) >= sizeof(uint8_t) ) {
+		rri.ip_protocol = RTA_UINT8_T(RECORD_TB(r, FRA_IP_PROTO));
+		rri.valid.ip_protocol = 1;
+		LOG_TRACE("FRA_IP_PROTO:           %d (%s)\n", rri.ip_protocol, iprotocolname(rri.ip_protocol));
+	}
+
+	if( RECORD_TB(r, FRA_SPORT_RANGE) && RTA_PAYLOAD(RECORD_TB(r, FRA_SPORT_RANGE)) >= sizeof(struct port_range) ) {
+		rri.sport_range = *(struct port_range *)RTA_DATA(RECORD_TB(r, FRA_SPORT_RANGE));
+		rri.valid.sport_range = 1;
+		LOG_TRACE("FRA_SPORT_RANGE:        %u-%u\n", rri.sport_range.start, rri.sport_range.end);
+	}
+	if( RECORD_TB(r, FRA_DPORT_RANGE) && RTA_PAYLOAD(RECORD_TB(r, FRA_DPORT_RANGE)) >= sizeof(struct port_range) ) {
+		rri.dport_range = *(struct port_range *)RTA_DATA(RECORD_TB(r, FRA_DPORT_RANGE));
+		rri.valid.dport_range = 1;
+		LOG_TRACE("FRA_DPORT_RANGE:        %u-%u\n", rri.dport_range.start, rri.dport_range.end);
+	}
+
+	if( RECORD_TB(r, FRA_TUN_ID) && RTA_PAYLOAD(RECORD_TB(r, FRA_TUN_ID)) >= sizeof(uint64_t) ) {
+		rri.tun_id = ntohll(RTA_UINT64_T(RECORD_TB(r, FRA_TUN_ID)));
+		rri.valid.tun_id = 1;
+		LOG_TRACE("FRA_TUN_ID:             %lld\n", rri.tun_id);
+	}
+	if( RECORD_TB(r, FRA_TABLE) && RTA_PAYLOAD(RECORD_TB(r, FRA_TABLE)) >= sizeof(uint32_t) ) {
+		rri.table = RTA_UINT32_T(RECORD_TB(r, FRA_TABLE));
+		rri.valid.table = 1;
+		LOG_TRACE("FRA_TABLE:              %d\n", rri.table);
+	}
+
+	if( RECORD_TB(r, FRA_SUPPRESS_PREFIXLEN) && RTA_PAYLOAD(RECORD_TB(r, FRA_SUPPRESS_PREFIXLEN)) >= sizeof(uint32_t) ) {
+		rri.suppress_prefixlength = RTA_UINT32_T(RECORD_TB(r, FRA_SUPPRESS_PREFIXLEN));
+		rri.valid.suppress_prefixlength = (rri.suppress_prefixlength != (uint32_t)-1);
+		LOG_TRACE("FRA_SUPPRESS_PREFIXLEN: %d\n", rri.suppress_prefixlength);
+	}
+	if( RECORD_TB(r, FRA_SUPPRESS_IFGROUP) && RTA_PAYLOAD(RECORD_TB(r, FRA_SUPPRESS_IFGROUP)) >= sizeof(uint32_t) ) {
+		rri.suppress_ifgroup = RTA_UINT32_T(RECORD_TB(r, FRA_SUPPRESS_IFGROUP));
+		rri.valid.suppress_ifgroup = (rri.suppress_ifgroup != (uint32_t)-1);
+		LOG_TRACE("FRA_SUPPRESS_IFGROUP:   %d\n", rri.suppress_ifgroup);
+	}
+
+	if( RECORD_TB(r, FRA_FLOW) && RTA_PAYLOAD(RECORD_TB(r, FRA_FLOW)) >= sizeof(uint32_t) ) {
+		uint32_t flow = RTA_UINT32_T(RECORD_TB(r, FRA_FLOW));
+		rri.flowto = flow & 0xFFFF;
+		rri.flowfrom = flow >> 16;
+		rri.valid.flowto = 1;
+		rri.valid.flowfrom = (rri.flowfrom != 0);
+		LOG_TRACE("FRA_FLOW:               %d/%d\n", rri.flowfrom, rri.flowto);
+	}
+	if( RECORD_TB(r, FRA_GOTO) && RTA_PAYLOAD(RECORD_TB(r, FRA_GOTO)) >= sizeof(uint32_t) ) {
+		rri.goto_priority = RTA_UINT32_T(RECORD_TB(r, FRA_GOTO));
+		rri.valid.goto_priority = 1;
+		LOG_TRACE("FRA_GOTO:               %d\n", rri.goto_priority);
+	}
+
+	if( r->frh->action == RTN_NAT && RECORD_TB(r, RTA_GATEWAY) && RTA_PAYLOAD(RECORD_TB(r, RTA_GATEWAY)) ) {
+		if( inet_ntop(family, RTA_DATA(RECORD_TB(r, RTA_GATEWAY)), s, maxlen) ) {
+			rri.gateway = towstr(s);
+			rri.valid.gateway = 1;
 		}
+		LOG_TRACE("RTA_GATEWAY: %S\n", rri.gateway.c_str());
+	}
 
-		//TODO: [NDA_FDB_EXT_ATTRS]	= { .type = NLA_NESTED }, NFEA_ACTIVITY_NOTIFY (FDB_NOTIFY_BIT)
-		arp.push_back(ari);
-		nb++;
+	if( RECORD_TB(r, FRA_PROTOCOL) && RTA_PAYLOAD(RECORD_TB(r, FRA_PROTOCOL)) >= sizeof(uint8_t) ) {
+		rri.protocol = RTA_UINT8_T(RECORD_TB(r, FRA_PROTOCOL));
+		rri.valid.protocol = 1;
+		LOG_TRACE("FRA_PROTOCOL:           %d (%s)\n", rri.protocol, rtprotocoltype(rri.protocol));
 	}
+
+	rri.ToRuleString();
 	return true;
 }
 
-bool NetRoutes::UpdateByNetlink(void * netlink, unsigned char af_family)
+static bool SameRule(const RuleRouteInfo & a, const RuleRouteInfo & b)
 {
-	const RouteRecord * rr = GetRoutes(netlink, af_family);
+	return a.family == b.family && a.table == b.table && a.rule == b.rule &&
+		a.valid.priority == b.valid.priority && (!a.valid.priority || a.priority == b.priority);
+}
 
-	if( rr )
-	while( rr->rt ) {
+void NetRoutes::AddRule(const RuleRouteInfo & rri)
+{
+	switch( rri.family ) {
+	case AF_INET:
+		rule.push_back(rri);
+		break;
+	case AF_INET6:
+		rule6.push_back(rri);
+		break;
+	case RTNL_FAMILY_IPMR:
+		mcrule.push_back(rri);
+		break;
+	case RTNL_FAMILY_IP6MR:
+		mcrule6.push_back(rri);
+		break;
+	};
+}
 
-		char ifname[MAX_INTERFACE_NAME_LEN] = {0};
+void NetRoutes::ApplyRule(uint16_t type, const RuleRouteInfo & rri)
+{
+	std::deque<RuleRouteInfo> * rules = 0;
+	switch( rri.family ) {
+	case AF_INET: rules = &rule; break;
+	case AF_INET6: rules = &rule6; break;
+	case RTNL_FAMILY_IPMR: rules = &mcrule; break;
+	case RTNL_FAMILY_IP6MR: rules = &mcrule6; break;
+	}
+	if( !rules )
+		return;
 
-		LOG_INFO("-------------------------------------\n");
-		LOG_INFO("nlh.nlmsg_type: %d (%s)\n", rr->nlm.nlmsg_type, nlmsgtype(rr->nlm.nlmsg_type));
-		LOG_INFO("rtm_family:   %u (%s)\n", rr->rt->rtm_family, familyname(rr->rt->rtm_family));
-		LOG_INFO("rtm_dst_len:  %u\n", rr->rt->rtm_dst_len );
-		LOG_INFO("rtm_src_len:  %u\n", rr->rt->rtm_src_len );
-		LOG_INFO("rtm_tos:      %u\n", rr->rt->rtm_tos );
-		LOG_INFO("rtm_table:    %u (%s)\n", rr->rt->rtm_table, rtruletable(rr->rt->rtm_table) );
-		LOG_INFO("rtm_protocol: %u (%s)\n", rr->rt->rtm_protocol, rtprotocoltype(rr->rt->rtm_protocol));
-		LOG_INFO("rtm_scope:    %u (%s)\n", rr->rt->rtm_scope, rtscopetype(rr->rt->rtm_scope)); // Address scope
-		LOG_INFO("rtm_type:     %u (%s)\n", rr->rt->rtm_type, rttype(rr->rt->rtm_type) );
-		LOG_INFO("rtm_flags:    0x%08X\n", rr->rt->rtm_flags );
+	rules->erase(std::remove_if(rules->begin(), rules->end(), [&rri](const RuleRouteInfo & item) {
+		return SameRule(item, rri);
+	}), rules->end());
 
-		IpRouteInfo ipr;
-		ipr.sa_family = rr->rt->rtm_family;
-		ipr.valid.flags = 1;
-		ipr.flags = rr->rt->rtm_flags;
-		ipr.valid.dstprefixlen = 1;
-		ipr.dstprefixlen = rr->rt->rtm_dst_len;
-		ipr.osdep.table = rr->rt->rtm_table;
-		ipr.valid.table = (bool)ipr.osdep.table;
-
-		ipr.valid.protocol = 1;
-		ipr.osdep.protocol = rr->rt->rtm_protocol;
-		ipr.valid.scope = 1;
-		ipr.osdep.scope = rr->rt->rtm_scope;
-		ipr.valid.type = 1;
-		ipr.osdep.type = rr->rt->rtm_type;
-		ipr.valid.tos = 1;
-		ipr.osdep.tos = rr->rt->rtm_tos;
-
-		uint32_t addrlen = 0;
-		const size_t maxlen = INET6_ADDRSTRLEN > INET_ADDRSTRLEN ? INET6_ADDRSTRLEN : INET_ADDRSTRLEN;
-		char s[maxlen+1] = {0};
+	if( type == RTM_NEWRULE )
+		AddRule(rri);
+}
 
-		switch( ipr.sa_family ) {
-		case AF_INET:
-			addrlen = sizeof(uint32_t);
-			break;
-		case AF_INET6:
-			addrlen = sizeof(struct in6_addr);
-			break;
-		//case AF_MCTP:
-		//	addrlen = sizeof(uint8_t);
-		//	break;
-		default:
-			LOG_ERROR("unsupported family %u\n", ipr.sa_family);
-			continue;
-		};
-
-		if( rr->tb[RTA_OIF] && RTA_PAYLOAD(rr->tb[RTA_OIF]) >= sizeof(uint32_t) ) {
-			ipr.ifnameIndex = RTA_UINT32_T(rr->tb[RTA_OIF]);
-			ipr.valid.ifnameIndex = 1;
-			if_indextoname(ipr.ifnameIndex, ifname);
-			ipr.iface = towstr(ifname);
-			ipr.valid.iface = !ipr.iface.empty();
-			LOG_INFO("RTA_OIF: %s (%u)\n", ifname, ipr.ifnameIndex);
-		}
+void NetRoutes::SetLink(const LinkRecord * lr)
+{
+	LOG_TRACE("-------------------------------------\n");
+	LOG_TRACE("rtm_family:   %u (%s)\n", lr->ifm->ifi_family, familyname(lr->ifm->ifi_family));
+	LOG_TRACE("ifi_type:     %u\n", lr->ifm->ifi_type); // ARPHRD_
+	LOG_TRACE("ifi_index:    %u\n", lr->ifm->ifi_index); // Link index
+	LOG_TRACE("ifi_flags:    0x%08X\n", lr->ifm->ifi_flags); // IFF_* flags
+	LOG_TRACE("ifi_change:   0x%08X\n", lr->ifm->ifi_change); // IFF_* change mask
+
+	if( RECORD_TB(lr, IFLA_IFNAME) && RTA_PAYLOAD(RECORD_TB(lr, IFLA_IFNAME)) >= sizeof(uint8_t) ) {
+		LOG_TRACE("set index: %u name: %s\n", lr->ifm->ifi_index, (const char *)RTA_DATA(RECORD_TB(lr, IFLA_IFNAME)));
+		ifs[lr->ifm->ifi_index] = names.Intern((const char *)RTA_DATA(RECORD_TB(lr, IFLA_IFNAME)));
+	}
+	linkFlags[lr->ifm->ifi_index] = lr->ifm->ifi_flags;
+}
 
-		if( rr->tb[RTA_TABLE] && RTA_PAYLOAD(rr->tb[RTA_TABLE]) >= sizeof(uint32_t) ) {
-			ipr.osdep.table = RTA_UINT32_T(rr->tb[RTA_TABLE]);
-			ipr.valid.table = 1;
-			LOG_INFO("RTA_TABLE %u (%s)\n", ipr.osdep.table, rtruletable(ipr.osdep.table));
-		}
-		if( rr->tb[RTA_GATEWAY] && RTA_PAYLOAD(rr->tb[RTA_GATEWAY]) >= addrlen ) {
-			if( inet_ntop(ipr.sa_family, RTA_DATA(rr->tb[RTA_GATEWAY]), s, maxlen) ) {
-				ipr.gateway = towstr(s);
-				ipr.valid.gateway = 1;
-			}
-			LOG_INFO("RTA_GATEWAY: %S\n", ipr.gateway.c_str());
-		}
-		if( rr->tb[RTA_DST] && RTA_PAYLOAD(rr->tb[RTA_DST]) >= addrlen ) {
-			ipr.destIpandMask = destIpandMask(ipr.sa_family, RTA_DATA(rr->tb[RTA_DST]), ipr.dstprefixlen);
-			ipr.valid.destIpandMask = 1;
-			LOG_INFO("RTA_DST: %S\n", ipr.destIpandMask.c_str());
-		}
-		if( rr->tb[RTA_PRIORITY] && RTA_PAYLOAD(rr->tb[RTA_PRIORITY]) >= sizeof(int32_t) ) {
-			ipr.osdep.metric = RTA_INT32_T(rr->tb[RTA_PRIORITY]);
-			ipr.valid.metric = 1;
-			LOG_INFO("RTA_PRIORITY: %d\n", ipr.osdep.metric);
-		}
-		if( rr->tb[RTA_PREFSRC] && RTA_PAYLOAD(rr->tb[RTA_PREFSRC]) >= addrlen ) {
-			if( inet_ntop(ipr.sa_family, RTA_DATA(rr->tb[RTA_PREFSRC]), s, maxlen) ) {
-				ipr.prefsrc = towstr(s);
-				ipr.valid.prefsrc = 1;
-			}
-			LOG_INFO("RTA_PREFSRC: %S\n", ipr.prefsrc.c_str());
-		}
-		if( rr->tb[RTA_PREF] && RTA_PAYLOAD(rr->tb[RTA_PREF]) >= sizeof(uint8_t) ) {
-			ipr.osdep.icmp6pref = RTA_UINT8_T(rr->tb[RTA_PREF]);
-			ipr.valid.icmp6pref = 1;
-			LOG_INFO("RTA_PREF: %u (%s)\n", ipr.osdep.icmp6pref, rticmp6pref(ipr.osdep.icmp6pref));
-		}
+enum {
+	DumpRoutes,
+	DumpRules,
+	DumpNeighbors,
+	DumpProxies,
+	DumpLinks,
+	DumpCount
+};
 
-		if( rr->tb[RTA_CACHEINFO] && RTA_PAYLOAD(rr->tb[RTA_CACHEINFO]) >= sizeof(struct rta_cacheinfo) ) {
-			const size_t size = sizeof(ipr.osdep.rtcache) <= sizeof(struct rta_cacheinfo) ? \
-				sizeof(ipr.osdep.rtcache):sizeof(struct rta_cacheinfo);
-			memmove(&ipr.osdep.rtcache, RTA_DATA(rr->tb[RTA_CACHEINFO]), size);
-			ipr.valid.rtcache = 1;
-			LOG_INFO("RTA_CACHEINFO: size %u\n", RTA_PAYLOAD(rr->tb[RTA_CACHEINFO]));
-			ipr.LogRtCache();
-		}
+// routes are only counted in tables mode, no one is kept
+static const RouteRecord empty_routes = {};
 
-		if( rr->tb[RTA_METRICS] && RTA_PAYLOAD(rr->tb[RTA_METRICS]) >= sizeof(struct rtattr) ) {
-			struct rtattr * mrta[RTAX_MAX+1];
-			if( FillAttr((struct rtattr*)RTA_DATA(rr->tb[RTA_METRICS]),
-						mrta,
-						RTAX_MAX,
-						(short unsigned int)(~NLA_F_NESTED),
-						RTA_PAYLOAD(rr->tb[RTA_METRICS]),
-						rtaxtype) ) {
-				//static_assert( (sizeof(ipr.osdep.rtmetrics)/sizeof(uint32_t)) == (RTAX_MAX+1) );
-				for(uint32_t index = 0; index < sizeof(ipr.osdep.rtmetrics)/sizeof(uint32_t); index++ ) {
-					if( mrta[index] && RTA_PAYLOAD(mrta[index]) >= sizeof(uint32_t) ) {
-						((uint32_t *)&ipr.osdep.rtmetrics)[index] = RTA_UINT32_T(mrta[index]);
-						LOG_INFO("%s: %d\n", rtaxtype(index), ((uint32_t *)&ipr.osdep.rtmetrics)[index]);
-					}
-				}
-				ipr.valid.rtmetrics = 1;
-				ipr.valid.hoplimit = 1;
-				ipr.hoplimit = ipr.osdep.rtmetrics.hoplimit;
-			}
-			LOG_INFO("RTA_METRICS: ... ok\n");
-		}
+std::map<uint32_t, uint32_t> * NetRoutes::TableCounts(uint8_t family)
+{
+	switch( family ) {
+	case AF_INET: return &inetTables;
+	case AF_INET6: return &inet6Tables;
+	case RTNL_FAMILY_IPMR: return &mcinetTables;
+	case RTNL_FAMILY_IP6MR: return &mcinet6Tables;
+	}
+	return nullptr;
+}
 
-		if( rr->tb[RTA_SRC] && RTA_PAYLOAD(rr->tb[RTA_SRC]) >= addrlen ) {
-			if( inet_ntop(ipr.sa_family, RTA_DATA(rr->tb[RTA_SRC]), s, maxlen) ) {
-				ipr.osdep.fromsrcIpandMask = (towstr(s) + L"/" + std::to_wstring(rr->rt->rtm_src_len));
-				ipr.valid.fromsrcIpandMask = 1;
-			}
-			LOG_INFO("RTA_SRC: %S\n", ipr.osdep.fromsrcIpandMask.c_str());
-		}
+static uint32_t RecordTable(const RouteRecord * rr)
+{
+	if( RECORD_TB(rr, RTA_TABLE) && RTA_PAYLOAD(RECORD_TB(rr, RTA_TABLE)) >= sizeof(uint32_t) )
+		return RTA_UINT32_T(RECORD_TB(rr, RTA_TABLE));
+	return rr->rt->rtm_table;
+}
+
+static RowHash & AddAttr(RowHash & key, const struct rtattr * rta)
+{
+	if( !rta )
+		return key.Add(0);
+
+	const unsigned char * data = (const unsigned char *)RTA_DATA(rta);
+	size_t size = RTA_PAYLOAD(rta);
+	for( size_t offset = 0; offset < size; offset += sizeof(uint64_t) ) {
+		uint64_t word = 0;
+		memcpy(&word, data + offset, std::min(size - offset, sizeof(word)));
+		key.Add(word);
+	}
+	return key.Add(size + 1);
+}
 
-		if( rr->tb[RTA_VIA] && RTA_PAYLOAD(rr->tb[RTA_VIA]) >= sizeof(struct rtvia) ) {
-			const struct rtvia *via = (const struct rtvia *)RTA_DATA(rr->tb[RTA_VIA]);
-			ipr.osdep.rtvia_family = via->rtvia_family;
-			if( inet_ntop(ipr.osdep.rtvia_family, &via->rtvia_addr, s, maxlen) ) {
-				ipr.osdep.rtvia_addr = towstr(s);
-				ipr.valid.rtvia = 1;
+static NetRoutesEvents::Count RecordCount(uint16_t type, uint16_t flags, const RouteRecord * rr)
+{
+	NetRoutesEvents::Count count = { type, flags, rr->rt->rtm_family, RecordTable(rr), 0, 0 };
+
+	// fields which kernel finds route by: IPv4 by tos and metric, IPv6 by source and metric
+	RowHash route;
+	route.Add(count.family).Add(count.table).Add(rr->rt->rtm_dst_len).Add(rr->rt->rtm_src_len).Add(rr->rt->rtm_tos);
+	AddAttr(route, RECORD_TB(rr, RTA_DST));
+	AddAttr(route, RECORD_TB(rr, RTA_SRC));
+	AddAttr(route, RECORD_TB(rr, RTA_PRIORITY));
+	count.route = route.Value();
+
+	// IPv4 keeps appended routes with the same keys as aliases,
+	// nexthops of IPv6 route are merged to one multipath route
+	if( count.family == AF_INET ) {
+		RowHash alias;
+		alias.Add(rr->rt->rtm_type);
+		AddAttr(alias, RECORD_TB(rr, RTA_GATEWAY));
+		AddAttr(alias, RECORD_TB(rr, RTA_VIA));
+		AddAttr(alias, RECORD_TB(rr, RTA_OIF));
+		AddAttr(alias, RECORD_TB(rr, RTA_NH_ID));
+		count.alias = alias.Value();
+	}
+	return count;
+}
+
+void NetRoutes::CountRoute(const NetRoutesEvents::Count & count)
+{
+	auto counts = TableCounts(count.family);
+	if( !counts )
+		return;
+
+	// events received during dump can be included in it already,
+	// so added route is counted only if it is not counted yet
+	auto range = counted.equal_range(count.route);
+	auto it = std::find_if(range.first, range.second, [&count](const std::pair<const uint64_t, uint64_t> & item) {
+		return item.second == count.alias;
+	});
+
+	if( count.type == RTM_NEWROUTE ) {
+		if( it != range.second )
+			return;
+		if( range.first != range.second ) {
+			// kernel adds route with NLM_F_EXCL only if there is no other one
+			// with its keys, so the event is older than dump, which has seen
+			// the route replaced
+			if( count.flags & NLM_F_EXCL )
+				return;
+			// replaced alias is removed without RTM_DELROUTE
+			if( count.flags & NLM_F_REPLACE ) {
+				range.first->second = count.alias;
+				return;
 			}
-			LOG_INFO("RTA_VIA:     %S\n", ipr.osdep.rtvia_addr.c_str());
 		}
+		counted.emplace(count.route, count.alias);
+		(*counts)[count.table]++;
+		return;
+	}
 
-		if( rr->tb[RTA_ENCAP_TYPE] && rr->tb[RTA_ENCAP] && RTA_PAYLOAD(rr->tb[RTA_ENCAP_TYPE]) >= sizeof(uint16_t) ) {
-			ipr.osdep.enc.type = RTA_UINT16_T(rr->tb[RTA_ENCAP_TYPE]);
-			if( FillEncap(&ipr.osdep.enc, rr->tb[RTA_ENCAP] ) )
-				ipr.valid.encap = 1;
-		}
+	if( it == range.second )
+		return;
+	counted.erase(it);
 
-		if( rr->tb[RTA_MULTIPATH] && RTA_PAYLOAD(rr->tb[RTA_MULTIPATH]) >= sizeof(struct rtnexthop) ) {
-			const struct rtnexthop *nh = (struct rtnexthop *)RTA_DATA(rr->tb[RTA_MULTIPATH]);
-			int len = RTA_PAYLOAD(rr->tb[RTA_MULTIPATH]);
+	auto table = counts->find(count.table);
+	if( table != counts->end() && !--table->second )
+		counts->erase(table);
+}
 
-			ipr.valid.rtnexthop = 1;
+int NetRoutes::OnCountRoute(void * arg, const struct nlmsghdr * nlm, const void * record)
+{
+	NetRoutes * nrts = (NetRoutes *)arg;
+	const RouteRecord * rr = (const RouteRecord *)record;
+	if( RouteMatches(rr, &nrts->routeFilter) )
+		nrts->CountRoute(RecordCount(RTM_NEWROUTE, 0, rr));
+	return 1;
+}
 
-			while( len >= static_cast<int>(sizeof(*nh)) ) {
-				LOG_INFO("RTA_MULTIPATH: rtnh_len     %d\n", nh->rtnh_len);
-				LOG_INFO("RTA_MULTIPATH: rtnh_flags   0x%02X (%s)\n", nh->rtnh_flags, rtnhflagsname(nh->rtnh_flags));
-				LOG_INFO("RTA_MULTIPATH: rtnh_hops    %d\n", nh->rtnh_hops);
-				LOG_INFO("RTA_MULTIPATH: rtnh_ifindex %d\n", nh->rtnh_ifindex);
+bool NetRoutes::UpdateByNetlink(NetDumpCollector & pool)
+{
+	static const NetDumpRequest dumpRequests[DumpCount] = {
+		[](void * netlink, void * arg) {
+			NetRoutes * nrts = (NetRoutes *)arg;
+			if( !nrts->tablesOnly )
+				return (const void *)GetRoutesFiltered(netlink, &nrts->routeFilter);
+			return WalkRoutes(netlink, &nrts->routeFilter, OnCountRoute, nrts) >= 0 ? (const void *)&empty_routes:nullptr;
+		},
+		[](void * netlink, void *) { return (const void *)GetRules(netlink, AF_UNSPEC); },
+		[](void * netlink, void *) { return (const void *)GetNeighbors(netlink, AF_UNSPEC, 0); },
+		[](void * netlink, void *) { return (const void *)GetNeighbors(netlink, AF_UNSPEC, NTF_PROXY); },
+		[](void * netlink, void *) { return (const void *)GetLinks(netlink); }
+	};
+	const void * records[DumpCount];
+
+	// all dumps are requested at once, records are converted in the same order
+	// as they were requested one by one
+	pool.Run(dumpRequests, this, records, DumpCount);
+
+	if( records[DumpRoutes] )
+		AddIpRoutes((const RouteRecord *)records[DumpRoutes], pool);
+
+	const RuleRecord * r = (const RuleRecord *)records[DumpRules];
 
-				NextHope netHope;
-				netHope.valid.nexthope = 1;
-				netHope.flags = nh->rtnh_flags;
-				netHope.weight = nh->rtnh_hops;
-				netHope.ifindex = nh->rtnh_ifindex;
+	if( r )
+	for( ; r->frh; r++ ) {
+		RuleRouteInfo rri;
+		if( FillRuleRoute(r, rri) ) {
+			rri.Log();
+			AddRule(rri);
+		}
+	}
 
-				if (nh->rtnh_len > len) {
-					ipr.osdep.nhs.push_back(netHope);
-					break;
-				}
+	if( !UpdateNeigbours((const NeighborRecord *)records[DumpNeighbors]) )
+		return false;
 
-				struct rtattr * rta[RTA_MAX + 1];
+	UpdateNeigbours((const NeighborRecord *)records[DumpProxies]);
 
-				if( nh->rtnh_len > sizeof(*nh) && FillAttr((struct rtattr*)RTNH_DATA(nh),
-						rta,
-						RTA_MAX,
-						(short unsigned int)(~NLA_F_NESTED),
-						nh->rtnh_len - sizeof(*nh),
-						rtatype) ) {
+	const LinkRecord * lr = (const LinkRecord *)records[DumpLinks];
+	if( !lr )
+		return false;
 
-					if( rta[RTA_ENCAP_TYPE] && rta[RTA_ENCAP] && RTA_PAYLOAD(rta[RTA_ENCAP_TYPE]) >= sizeof(uint16_t) ) {
-						netHope.enc.type = RTA_UINT16_T(rta[RTA_ENCAP_TYPE]);
-						if( FillEncap(&netHope.enc, rta[RTA_ENCAP] ) )
-							netHope.valid.encap = 1;
-					}
+	for( ; lr->ifm; lr++ )
+		SetLink(lr);
 
-					if( rta[RTA_GATEWAY] && RTA_PAYLOAD(rta[RTA_GATEWAY]) >= addrlen ) {
-						if( inet_ntop(ipr.sa_family, RTA_DATA(rta[RTA_GATEWAY]), s, maxlen) ) {
-							netHope.gateway = towstr(s);
-							netHope.valid.gateway = 1;
-						}
-						LOG_INFO("RTA_GATEWAY: %S\n", netHope.gateway.c_str());
-					}
+	return true;
+}
 
-					if( rta[RTA_VIA] && RTA_PAYLOAD(rta[RTA_VIA]) >= sizeof(struct rtvia) ) {
-						const struct rtvia *via = (const struct rtvia *)RTA_DATA(rta[RTA_VIA]);
-						netHope.rtvia_family = via->rtvia_family;
-						if( inet_ntop(netHope.rtvia_family, &via->rtvia_addr, s, maxlen) ) {
-							netHope.rtvia_addr = towstr(s);
-							netHope.valid.rtvia = 1;
-						}
-						LOG_INFO("RTA_VIA:     %S\n", netHope.rtvia_addr.c_str());
-					}
+typedef std::tuple<uint8_t, uint32_t, RouteAddr, RouteAddr, uint8_t, uint32_t> IpRouteKey;
 
-					if( rta[RTA_FLOW] && RTA_PAYLOAD(rta[RTA_FLOW]) >= sizeof(uint32_t) ) {
-						uint32_t flow = RTA_UINT32_T(rta[RTA_FLOW]);
-						netHope.flowto = flow & 0xFFFF;
-						netHope.flowfrom = flow >> 16;
-						netHope.valid.flowto = 1;
-						netHope.valid.flowfrom = (netHope.flowfrom != 0);
-						LOG_INFO("RTA_FLOW:    %d/%d\n", netHope.flowfrom, netHope.flowto);
-					}
+static IpRouteKey GetIpRouteKey(const IpRouteInfo & ipr)
+{
+	return IpRouteKey(ipr.sa_family, ipr.osdep.table, ipr.destIpandMask,
+			ipr.valid.fromsrcIpandMask ? ipr.osdep.fromsrcIpandMask:RouteAddr(),
+			ipr.osdep.tos, ipr.valid.metric ? ipr.osdep.metric:0);
+}
 
-					// TODO: RTA_NEWDST
-				}
+typedef std::tuple<uint32_t, uint32_t, std::wstring> ArpRouteKey;
 
-				ipr.osdep.nhs.push_back(netHope);
-				len -= NLMSG_ALIGN(nh->rtnh_len);
-				nh = RTNH_NEXT(nh);
-			}
-			LOG_INFO("RTA_MULTIPATH ... ok\n");
-		}
+static ArpRouteKey GetArpRouteKey(const ArpRouteInfo & ari)
+{
+	return ArpRouteKey(ari.sa_family, ari.ifnameIndex, ari.ip);
+}
 
-		if( rr->tb[RTA_NH_ID] && RTA_PAYLOAD(rr->tb[RTA_NH_ID]) >= sizeof(uint32_t) ) {
-			ipr.osdep.nhid = RTA_UINT32_T(rr->tb[RTA_NH_ID]);
-			ipr.valid.nhid = 1;
-			LOG_INFO("RTA_NH_ID:    %u\n", ipr.osdep.nhid);
-		}
+void NetRoutes::ApplyPendingRoutes(void)
+{
+	if( pending.routes.empty() && replayed.routes.empty() )
+		return;
+
+	// last event for the same route wins, replayed events are older than received ones,
+	// so containers are walked once for both
+	std::map<IpRouteKey, const std::pair<uint16_t, IpRouteInfo> *> last;
+	for( auto events : { &replayed.routes, &pending.routes } ) {
+		for( const auto & event : *events )
+			last[GetIpRouteKey(event.second)] = &event;
+	}
 
-// TODO:
+	auto changed = [&last](const IpRouteInfo & ipr) { return last.find(GetIpRouteKey(ipr)) != last.end(); };
+	inet.erase(std::remove_if(inet.begin(), inet.end(), changed), inet.end());
+	inet6.erase(std::remove_if(inet6.begin(), inet6.end(), changed), inet6.end());
 
-/*const struct nla_policy rtm_ipv4_policy[RTA_MAX + 1] = {
-	[RTA_UNSPEC]		= { .strict_start_type = RTA_DPORT + 1 },
-	[RTA_DST]		= { .type = NLA_U32 },
-	[RTA_SRC]		= { .type = NLA_U32 },
-	[RTA_IIF]		= { .type = NLA_U32 },
-	[RTA_OIF]		= { .type = NLA_U32 },
-	[RTA_GATEWAY]		= { .type = NLA_U32 },
-	[RTA_PRIORITY]		= { .type = NLA_U32 },
-	[RTA_PREFSRC]		= { .type = NLA_U32 },
-	[RTA_METRICS]		= { .type = NLA_NESTED },
-	[RTA_MULTIPATH]		= { .len = sizeof(struct rtnexthop) },
-	[RTA_FLOW]		= { .type = NLA_U32 },
-	[RTA_ENCAP_TYPE]	= { .type = NLA_U16 },
-	[RTA_ENCAP]		= { .type = NLA_NESTED },
-	[RTA_UID]		= { .type = NLA_U32 },
-	[RTA_MARK]		= { .type = NLA_U32 },
-	[RTA_TABLE]		= { .type = NLA_U32 },
-	[RTA_IP_PROTO]		= { .type = NLA_U8 },
-	[RTA_SPORT]		= { .type = NLA_U16 },
-	[RTA_DPORT]		= { .type = NLA_U16 },
-	[RTA_NH_ID]		= { .type = NLA_U32 },
-};
+	// events are kept for replay, routes are copied
+	for( const auto & [key, event] : last ) {
+		if( event->first == RTM_NEWROUTE )
+			AddIpRoute(event->second);
+	}
 
-static const struct nla_policy rtm_ipv6_policy[RTA_MAX+1] = {
-	[RTA_UNSPEC]		= { .strict_start_type = RTA_DPORT + 1 },
-	[RTA_GATEWAY]           = { .len = sizeof(struct in6_addr) },
-	[RTA_PREFSRC]		= { .len = sizeof(struct in6_addr) },
-	[RTA_OIF]               = { .type = NLA_U32 },
-	[RTA_IIF]		= { .type = NLA_U32 },
-	[RTA_PRIORITY]          = { .type = NLA_U32 },
-	[RTA_METRICS]           = { .type = NLA_NESTED },
-	[RTA_MULTIPATH]		= { .len = sizeof(struct rtnexthop) },
-	[RTA_PREF]              = { .type = NLA_U8 },
-	[RTA_ENCAP_TYPE]	= { .type = NLA_U16 },
-	[RTA_ENCAP]		= { .type = NLA_NESTED },
-	[RTA_EXPIRES]		= { .type = NLA_U32 },
-	[RTA_UID]		= { .type = NLA_U32 },
-	[RTA_MARK]		= { .type = NLA_U32 },
-	[RTA_TABLE]		= { .type = NLA_U32 },
-	[RTA_IP_PROTO]		= { .type = NLA_U8 },
-	[RTA_SPORT]		= { .type = NLA_U16 },
-	[RTA_DPORT]		= { .type = NLA_U16 },
-	[RTA_NH_ID]		= { .type = NLA_U32 },
-};
-*/
-		if( ipr.valid.gateway || ipr.valid.rtvia ) {
-			LOG_INFO("push GATEWAY\n");
-			if( ipr.sa_family == AF_INET )
-				inet.push_front(ipr);
-			else if( ipr.sa_family == AF_INET6 )
-				inet6.push_front(ipr);
-		} else  {
-			LOG_INFO("push NORMAL\n");
-			if( ipr.sa_family == AF_INET )
-				inet.push_back(ipr);
-			else if( ipr.sa_family == AF_INET6 )
-				inet6.push_back(ipr);
-		}
+	replayed.routes.clear();
+}
 
-		rr++;
+void NetRoutes::ApplyPendingNeighbors(void)
+{
+	if( pending.neighbors.empty() && replayed.neighbors.empty() )
+		return;
+
+	std::map<ArpRouteKey, const std::pair<uint16_t, ArpRouteInfo> *> last;
+	for( auto events : { &replayed.neighbors, &pending.neighbors } ) {
+		for( const auto & event : *events )
+			last[GetArpRouteKey(event.second)] = &event;
 	}
 
-	rr = 0;
+	arp.erase(std::remove_if(arp.begin(), arp.end(), [&last](const ArpRouteInfo & ari) {
+		return last.find(GetArpRouteKey(ari)) != last.end();
+	}), arp.end());
 
-	const RuleRecord * r = GetRules(netlink, AF_UNSPEC);
+	for( const auto & [key, event] : last ) {
+		if( event->first == RTM_NEWNEIGH )
+			arp.push_back(event->second);
+	}
 
-	if( r )
-	while( r->frh ) {
-
-		LOG_INFO("---------------- RuleRecord ---------------------\n");
-		LOG_INFO("nlh.nlmsg_type: %d (%s)\n", r->nlm.nlmsg_type, nlmsgtype(r->nlm.nlmsg_type));
-		LOG_INFO("family:  %d (%s)\n", r->frh->family, familyname(r->frh->family));
-		LOG_INFO("dst_len: %d\n", r->frh->dst_len);
-		LOG_INFO("src_len: %d\n", r->frh->src_len);
-		LOG_INFO("tos:     0x%02X\n", r->frh->tos);
-		LOG_INFO("table:   %d (%s)\n", r->frh->table, rtruletable(r->frh->table));
-		LOG_INFO("res1:    %d\n", r->frh->res1);
-		LOG_INFO("res2:    %d\n", r->frh->res2);
-		LOG_INFO("action:  %d (%s)\n", r->frh->action, fractionrule(r->frh->action));
-		LOG_INFO("flags:   0x%08X (%s)\n", r->frh->flags, fibruleflagsname(r->frh->flags));
+	replayed.neighbors.clear();
+}
 
-		RuleRouteInfo rri;
-		rri.family = r->frh->family;
-		rri.fwmark = 0;
-		rri.fwmask = 0;
-		rri.valid = {0};
-		rri.tos = r->frh->tos;
-		rri.flags = r->frh->flags;
-		rri.type = r->nlm.nlmsg_type;
-		rri.priority = 0;
-		rri.table = r->frh->table;
-		rri.action = r->frh->action;
-
-		uint32_t addrlen = 0;
-		uint32_t family = r->frh->family;
-		const size_t maxlen = INET6_ADDRSTRLEN > INET_ADDRSTRLEN ? INET6_ADDRSTRLEN : INET_ADDRSTRLEN;
-		char s[maxlen+1] = {0};
+int NetRoutes::OnNotify(void * arg, const struct nlmsghdr * nlm, const void * record)
+{
+	NetRoutes * nrts = (NetRoutes *)arg;
 
-		switch( rri.family ) {
-		case AF_INET:
-		case RTNL_FAMILY_IPMR:
-			addrlen = sizeof(uint32_t);
-			family = AF_INET;
+	switch( nlm->nlmsg_type ) {
+	case RTM_NEWROUTE:
+	case RTM_DELROUTE:
+	{
+		IpRouteInfo ipr;
+		const RouteRecord * rr = (const RouteRecord *)record;
+		if( !RouteMatches(rr, &nrts->routeFilter) )
 			break;
-		case AF_INET6:
-		case RTNL_FAMILY_IP6MR:
-			addrlen = sizeof(struct in6_addr);
-			family = AF_INET6;
+		if( nrts->tablesOnly ) {
+			NetRoutesEvents::Count count = RecordCount(nlm->nlmsg_type, nlm->nlmsg_flags, rr);
+			nrts->CountRoute(count);
+			nrts->pending.counts.push_back(count);
 			break;
-		//case AF_MCTP:
-		//	addrlen = sizeof(uint8_t);
-		//	break;
-		default:
-			LOG_ERROR("unsupported family %u\n", rri.family);
-			continue;
-		};
-
-		if( r->tb[FRA_PRIORITY] && RTA_PAYLOAD(r->tb[FRA_PRIORITY]) >= sizeof(uint32_t) ) {
-			rri.priority = RTA_UINT32_T(r->tb[FRA_PRIORITY]);
-			rri.valid.priority = 1;
-			LOG_INFO("FRA_PRIORITY:           %d\n", rri.priority);
-		}
-
-		if( r->tb[FRA_SRC] && RTA_PAYLOAD(r->tb[FRA_SRC]) >= addrlen ) {
-			rri.fromIpandMask = destIpandMask(family, RTA_DATA(r->tb[FRA_SRC]), r->frh->src_len);
-			LOG_INFO("FRA_SRC:                %S\n", rri.fromIpandMask.c_str());
-		} else if( r->frh->src_len ) {
-			rri.fromIpandMask = L"0/";
-			rri.fromIpandMask += std::to_wstring(r->frh->src_len);
-		} else
-			rri.fromIpandMask = L"all";
-
-		rri.valid.fromIpandMask = 1;
-
-
-		if( r->tb[FRA_DST] && RTA_PAYLOAD(r->tb[FRA_DST]) >= addrlen ) {
-			rri.toIpandMask = destIpandMask(family, RTA_DATA(r->tb[FRA_DST]), r->frh->dst_len);
-			LOG_INFO("FRA_DST:                %S\n", rri.toIpandMask.c_str());
-			rri.valid.toIpandMask = 1;
-		} else if( r->frh->dst_len ) {
-			rri.toIpandMask = L"to 0/" + std::to_wstring(r->frh->dst_len);
-			rri.valid.toIpandMask = 1;
 		}
+		if( FillIpRoute(rr, ipr) )
+			nrts->pending.routes.emplace_back(nlm->nlmsg_type, std::move(ipr));
+		break;
+	}
+	case RTM_NEWNEIGH:
+	case RTM_DELNEIGH:
+	{
+		ArpRouteInfo ari;
+		if( FillArpRoute((const NeighborRecord *)record, ari) )
+			nrts->pending.neighbors.emplace_back(nlm->nlmsg_type, std::move(ari));
+		break;
+	}
+	case RTM_NEWRULE:
+	case RTM_DELRULE:
+	{
+		RuleRouteInfo rri;
+		if( !FillRuleRoute((const RuleRecord *)record, rri) )
+			break;
+		// rule string of deleted rule must be the same as of existing one
+		rri.type = RTM_NEWRULE;
+		rri.rule.clear();
+		rri.ToRuleString();
 
-		if( r->tb[FRA_FWMARK] && RTA_PAYLOAD(r->tb[FRA_FWMARK]) >= sizeof(uint32_t) ) {
-			rri.fwmark = RTA_UINT32_T(r->tb[FRA_FWMARK]);
-			rri.valid.fwmark = 1;
-			LOG_INFO("FRA_FWMARK:             0x%08X\n", rri.fwmark);
+		nrts->ApplyRule(nlm->nlmsg_type, rri);
+		nrts->pending.rules.emplace_back(nlm->nlmsg_type, std::move(rri));
+		break;
+	}
+	case RTM_NEWLINK:
+	{
+		const LinkRecord * lr = (const LinkRecord *)record;
+		uint32_t * flags = nrts->linkFlags.Find(lr->ifm->ifi_index);
+		// kernel flushes IPv4 routes of link put down without RTM_DELROUTE
+		if( flags && (*flags & IFF_UP) && !(lr->ifm->ifi_flags & IFF_UP) ) {
+			LOG_INFO("link %u is down\n", lr->ifm->ifi_index);
+			nrts->synced = false;
 		}
-		if( r->tb[FRA_FWMASK] && RTA_PAYLOAD(r->tb[FRA_FWMASK]) >= sizeof(uint32_t) ) {
-			rri.fwmask = RTA_UINT32_T(r->tb[FRA_FWMASK]);
-			rri.valid.fwmask = (rri.fwmask != 0xFFFFFFFF);
-			LOG_INFO("FRA_FWMARK/FRA_FWMASK:  0x%08X/0x%08X\n", rri.fwmark, rri.fwmask);
+		nrts->linkFlags[lr->ifm->ifi_index] = lr->ifm->ifi_flags;
+		const wchar_t * const * name = nrts->ifs.Find(lr->ifm->ifi_index);
+		// other link state changes are not interesting, only new or renamed interfaces,
+		// names are interned, so equal names are the same pointer
+		if( !name || (RECORD_TB(lr, IFLA_IFNAME) && *name != nrts->names.Intern((const char *)RTA_DATA(RECORD_TB(lr, IFLA_IFNAME)))) ) {
+			nrts->SetLink(lr);
+			if( const wchar_t * const * set = nrts->ifs.Find(lr->ifm->ifi_index) )
+				nrts->pending.links.push_back({RTM_NEWLINK, (uint32_t)lr->ifm->ifi_index, tostr(*set)});
 		}
+		break;
+	}
+	case RTM_DELLINK:
+	{
+		uint32_t ifindex = ((const LinkRecord *)record)->ifm->ifi_index;
+		// routes and nexthops of removed link are flushed without events too
+		LOG_INFO("link %u is removed\n", ifindex);
+		nrts->synced = false;
+		nrts->linkFlags.Erase(ifindex);
+		nrts->ifs.Erase(ifindex);
+		nrts->pending.links.push_back({RTM_DELLINK, ifindex, std::string()});
+		break;
+	}
+	}
+	return 1;
+}
 
-		if( r->tb[FRA_IIFNAME] && RTA_PAYLOAD(r->tb[FRA_IIFNAME]) >= sizeof(uint8_t) ) {
-			rri.iiface = towstr((const char *)RTA_DATA(r->tb[FRA_IIFNAME]));
-			rri.valid.iiface = 1;
-			LOG_INFO("FRA_IIFNAME:            %S\n", rri.iiface.c_str());
-		}
-		if( r->tb[FRA_OIFNAME] && RTA_PAYLOAD(r->tb[FRA_OIFNAME]) >= sizeof(uint8_t) ) {
-			rri.oiface = towstr((const char *)RTA_DATA(r->tb[FRA_OIFNAME]));
-			rri.valid.oiface = 1;
-			LOG_INFO("FRA_OIFNAME:            %S\n", rri.oiface.c_str());
-		}
+bool NetRoutes::UpdateByNotifications(void)
+{
+	if( !monitor ) {
+		// subscribe before full dump, so no changes will be lost between them
+		monitor = OpenNetlinkMonitor(NETLINK_MONITOR_ROUTES);
+		synced = false;
+		return false;
+	}
 
-		// on android #define FRA_UID_START FRA_PAD and #define FRA_UID_END FRA_L3MDEV
-		if( r->tb[FRA_L3MDEV] && !r->tb[FRA_PAD] && RTA_PAYLOAD(r->tb[FRA_L3MDEV]) >= sizeof(uint8_t) ) {
-			rri.l3mdev = RTA_UINT8_T(r->tb[FRA_L3MDEV]);
-			rri.valid.l3mdev = 1;
-			LOG_INFO("FRA_L3MDEV:             %d\n", rri.l3mdev);
-		}
+	if( !synced )
+		return false;
 
-		if( r->tb[FRA_UID_START] && r->tb[FRA_UID_END] && \
-				RTA_PAYLOAD(r->tb[FRA_UID_START]) >= sizeof(uint32_t) &&
-				RTA_PAYLOAD(r->tb[FRA_UID_END]) >= sizeof(uint32_t) ) {
-			rri.uid_range.start = RTA_UINT32_T(r->tb[FRA_UID_START]);
-			rri.uid_range.end = RTA_UINT32_T(r->tb[FRA_UID_END]);
-			assert( !rri.valid.l3mdev );
-			rri.valid.uid_range = 1;
-			LOG_INFO("FRA_UID_START:          %d\n", rri.uid_range.start);
-			LOG_INFO("FRA_UID_END:            %d\n", rri.uid_range.end);
-		}
+	int res = ProcessNotifications(monitor, OnNotify, this);
+	if( res < 0 ) {
+		LOG_WARN("notifications lost (%s), full dump required\n", errorname(errno));
+		pending.Clear();
+		replayed.Clear();
+		synced = false;
+		// queued events are older than full dump and some of them are lost,
+		// applied after it they would bring back deleted routes, so they are
+		// dropped with subscription and new one is made before full dump
+		CloseNetlink(monitor);
+		monitor = OpenNetlinkMonitor(NETLINK_MONITOR_ROUTES);
+		return false;
+	}
 
-		if( r->tb[FRA_UID_RANGE] && RTA_PAYLOAD(r->tb[FRA_UID_RANGE]) >= sizeof(struct uid_range) ) {
-			rri.uid_range = *(struct uid_range *)RTA_DATA(r->tb[FRA_UID_RANGE]);
-			assert( !rri.valid.uid_range );
-			rri.valid.uid_range = 1;
-			LOG_INFO("FRA_UID_RANGE:          %d-%d\n", rri.uid_range.start, rri.uid_range.end);
-		}
+	if( !synced ) {
+		LOG_INFO("routes were flushed by kernel, full dump required\n");
+		pending.Clear();
+		replayed.Clear();
+		return false;
+	}
 
-		if( r->tb[FRA_IP_PROTO] && RTA_PAYLOAD(r->tb[FRA_IP_PROTO]) >= sizeof(uint8_t) ) {
-			rri.ip_protocol = RTA_UINT8_T(r->tb[FRA_IP_PROTO]);
-			rri.valid.ip_protocol = 1;
-			LOG_INFO("FRA_IP_PROTO:           %d (%s)\n", rri.ip_protocol, iprotocolname(rri.ip_protocol));
-		}
+	LOG_INFO("applied %d notifications\n", res);
 
-		if( r->tb[FRA_SPORT_RANGE] && RTA_PAYLOAD(r->tb[FRA_SPORT_RANGE]) >= sizeof(struct port_range) ) {
-			rri.sport_range = *(struct port_range *)RTA_DATA(r->tb[FRA_SPORT_RANGE]);
-			rri.valid.sport_range = 1;
-			LOG_INFO("FRA_SPORT_RANGE:        %u-%u\n", rri.sport_range.start, rri.sport_range.end);
-		}
-		if( r->tb[FRA_DPORT_RANGE] && RTA_PAYLOAD(r->tb[FRA_DPORT_RANGE]) >= sizeof(struct port_range) ) {
-			rri.dport_range = *(struct port_range *)RTA_DATA(r->tb[FRA_DPORT_RANGE]);
-			rri.valid.dport_range = 1;
-			LOG_INFO("FRA_DPORT_RANGE:        %u-%u\n", rri.dport_range.start, rri.dport_range.end);
-		}
+	ApplyPendingRoutes();
+	ApplyPendingNeighbors();
 
-		if( r->tb[FRA_TUN_ID] && RTA_PAYLOAD(r->tb[FRA_TUN_ID]) >= sizeof(uint64_t) ) {
-			rri.tun_id = ntohll(RTA_UINT64_T(r->tb[FRA_TUN_ID]));
-			rri.valid.tun_id = 1;
-			LOG_INFO("FRA_TUN_ID:             %lld\n", rri.tun_id);
-		}
-		if( r->tb[FRA_TABLE] && RTA_PAYLOAD(r->tb[FRA_TABLE]) >= sizeof(uint32_t) ) {
-			rri.table = RTA_UINT32_T(r->tb[FRA_TABLE]);
-			rri.valid.table = 1;
-			LOG_INFO("FRA_TABLE:              %d\n", rri.table);
-		}
+	applied = std::move(pending);
+	pending.Clear();
+	appliedValid = true;
+	return true;
+}
 
-		if( r->tb[FRA_SUPPRESS_PREFIXLEN] && RTA_PAYLOAD(r->tb[FRA_SUPPRESS_PREFIXLEN]) >= sizeof(uint32_t) ) {
-			rri.suppress_prefixlength = RTA_UINT32_T(r->tb[FRA_SUPPRESS_PREFIXLEN]);
-			rri.valid.suppress_prefixlength = (rri.suppress_prefixlength != (uint32_t)-1);
-			LOG_INFO("FRA_SUPPRESS_PREFIXLEN: %d\n", rri.suppress_prefixlength);
-		}
-		if( r->tb[FRA_SUPPRESS_IFGROUP] && RTA_PAYLOAD(r->tb[FRA_SUPPRESS_IFGROUP]) >= sizeof(uint32_t) ) {
-			rri.suppress_ifgroup = RTA_UINT32_T(r->tb[FRA_SUPPRESS_IFGROUP]);
-			rri.valid.suppress_ifgroup = (rri.suppress_ifgroup != (uint32_t)-1);
-			LOG_INFO("FRA_SUPPRESS_IFGROUP:   %d\n", rri.suppress_ifgroup);
-		}
+bool NetRoutes::TakeEvents(NetRoutesEvents & events)
+{
+	if( !appliedValid )
+		return false;
+	events = std::move(applied);
+	applied.Clear();
+	appliedValid = false;
+	return true;
+}
 
-		if( r->tb[FRA_FLOW] && RTA_PAYLOAD(r->tb[FRA_FLOW]) >= sizeof(uint32_t) ) {
-			uint32_t flow = RTA_UINT32_T(r->tb[FRA_FLOW]);
-			rri.flowto = flow & 0xFFFF;
-			rri.flowfrom = flow >> 16;
-			rri.valid.flowto = 1;
-			rri.valid.flowfrom = (rri.flowfrom != 0);
-			LOG_INFO("FRA_FLOW:               %d/%d\n", rri.flowfrom, rri.flowto);
-		}
-		if( r->tb[FRA_GOTO] && RTA_PAYLOAD(r->tb[FRA_GOTO]) >= sizeof(uint32_t) ) {
-			rri.goto_priority = RTA_UINT32_T(r->tb[FRA_GOTO]);
-			rri.valid.goto_priority = 1;
-			LOG_INFO("FRA_GOTO:               %d\n", rri.goto_priority);
-		}
+void NetRoutes::Replay(const NetRoutesEvents & events)
+{
+	LOG_INFO("%u events\n", events.Size());
 
-		if( r->frh->action == RTN_NAT && r->tb[RTA_GATEWAY] && RTA_PAYLOAD(r->tb[RTA_GATEWAY]) ) {
-			if( inet_ntop(family, RTA_DATA(r->tb[RTA_GATEWAY]), s, maxlen) ) {
-				rri.gateway = towstr(s);
-				rri.valid.gateway = 1;
-			}
-			LOG_INFO("RTA_GATEWAY: %S\n", rri.gateway.c_str());
-		}
+	replayed.routes.insert(replayed.routes.end(), events.routes.begin(), events.routes.end());
+	replayed.neighbors.insert(replayed.neighbors.end(), events.neighbors.begin(), events.neighbors.end());
 
-		if( r->tb[FRA_PROTOCOL] && RTA_PAYLOAD(r->tb[FRA_PROTOCOL]) >= sizeof(uint8_t) ) {
-			rri.protocol = RTA_UINT8_T(r->tb[FRA_PROTOCOL]);
-			rri.valid.protocol = 1;
-			LOG_INFO("FRA_PROTOCOL:           %d (%s)\n", rri.protocol, rtprotocoltype(rri.protocol));
-		}
+	for( const auto & [type, rri] : events.rules )
+		ApplyRule(type, rri);
 
-		rri.ToRuleString();
-		rri.Log();
-		switch( rri.family ) {
-		case AF_INET:
-			rule.push_back(rri);
-			break;
-		case AF_INET6:
-			rule6.push_back(rri);
-			break;
-		case RTNL_FAMILY_IPMR:
-			mcrule.push_back(rri);
-			break;
-		case RTNL_FAMILY_IP6MR:
-			mcrule6.push_back(rri);
-			break;
-		};
-		r++;
+	for( const auto & link : events.links ) {
+		if( link.type == RTM_NEWLINK )
+			ifs[link.ifindex] = names.Intern(link.name.c_str());
+		else
+			ifs.Erase(link.ifindex);
 	}
 
-	r = 0;
+	for( const auto & count : events.counts )
+		CountRoute(count);
+}
 
-	if( !UpdateNeigbours(GetNeighbors(netlink, AF_UNSPEC, 0)) )
-		return false;
+void NetRoutes::Resync(void)
+{
+	synced = false;
+}
 
-	UpdateNeigbours(GetNeighbors(netlink, AF_UNSPEC, NTF_PROXY));
+void NetRoutes::SetRouteFilter(const RouteFilter & filter, bool tablesOnly_)
+{
+	if( SameRouteFilter(&routeFilter, &filter) && tablesOnly == tablesOnly_ )
+		return;
+
+	LOG_INFO("family %u table %u oif %u protocol %u type %u tables only %d\n", filter.family, filter.table, filter.oif, filter.protocol, filter.type, tablesOnly_);
+	routeFilter = filter;
+	tablesOnly = tablesOnly_;
+	// routes of new filter are not in containers yet
+	synced = false;
+}
 
-	const LinkRecord * lr = GetLinks(netlink);
-	if( !lr )
-		return false;
+// destination of route in network order, default route has no one
+static bool RoutePrefix(const IpRouteInfo & ipr, unsigned char * addr)
+{
+	memset(addr, 0, sizeof(struct in6_addr));
+	if( !ipr.valid.destIpandMask || ipr.destIpandMask.empty() )
+		return true;
 
-	while( lr->ifm ) {
-		LOG_INFO("-------------------------------------\n");
-		LOG_INFO("rtm_family:   %u (%s)\n", lr->ifm->ifi_family, familyname(lr->ifm->ifi_family));
-		LOG_INFO("ifi_type:     %u\n", lr->ifm->ifi_type); // ARPHRD_
-		LOG_INFO("ifi_index:    %u\n", lr->ifm->ifi_index); // Link index
-		LOG_INFO("ifi_flags:    0x%08X\n", lr->ifm->ifi_flags); // IFF_* flags
-		LOG_INFO("ifi_change:   0x%08X\n", lr->ifm->ifi_change); // IFF_* change mask
-
-		if( lr->tb[IFLA_IFNAME] && RTA_PAYLOAD(lr->tb[IFLA_IFNAME]) >= sizeof(uint8_t) ) {
-			LOG_INFO("set index: %u name: %s\n", lr->ifm->ifi_index, (const char *)RTA_DATA(lr->tb[IFLA_IFNAME]));
-			ifs[lr->ifm->ifi_index] = towstr((const char *)RTA_DATA(lr->tb[IFLA_IFNAME]));
-			SetNameByIndex((const char *)RTA_DATA(lr->tb[IFLA_IFNAME]), lr->ifm->ifi_index);
-		}
+	uint8_t len;
+	return ipr.destIpandMask.Get(ipr.sa_family, addr, &len);
+}
+
+const NetRoutes::RouteIndex * NetRoutes::GetPrefixes(uint8_t family, uint32_t table)
+{
+	if( !prefixesValid || prefixesVersion != version ) {
+		prefixes.clear();
+		for( auto routes : { &inet, &inet6 } ) {
+			for( const auto & ipr : *routes ) {
+				unsigned char addr[sizeof(struct in6_addr)];
+				if( !RoutePrefix(ipr, addr) ) {
+					LOG_ERROR("invalid destination %S\n", ipr.destIpandMask.str().c_str());
+					continue;
+				}
 
-		lr++;
+				size_t addrlen = ipr.sa_family == AF_INET6 ? sizeof(struct in6_addr):sizeof(struct in_addr);
+				auto & slot = prefixes[std::make_pair(ipr.sa_family, ipr.osdep.table)](addr, addrlen, ipr.dstprefixlen);
+				// route with tos is not used for packets without tos,
+				// then the lowest metric wins as in kernel list of aliases
+				if( !slot || (slot->osdep.tos && !ipr.osdep.tos) ||
+					(slot->osdep.tos == ipr.osdep.tos && slot->osdep.metric > ipr.osdep.metric) )
+					slot = &ipr;
+			}
+		}
+		for( auto & index : prefixes )
+			index.second.Compact();
+		prefixesVersion = version;
+		prefixesValid = true;
+		LOG_INFO("%u indexes\n", prefixes.size());
 	}
 
-	return true;
+	auto it = prefixes.find(std::make_pair(family, table));
+	return it != prefixes.end() ? &it->second:nullptr;
 }
 
+const IpRouteInfo * NetRoutes::FindRoute(uint8_t family, uint32_t table, const void * addr, uint8_t prefixlen)
+{
+	size_t addrlen = family == AF_INET6 ? sizeof(struct in6_addr):sizeof(struct in_addr);
+	if( prefixlen > addrlen * 8 )
+		return nullptr;
+	auto index = GetPrefixes(family, table);
+	auto ipr = index ? index->Find(addr, addrlen, prefixlen):nullptr;
+	return ipr ? *ipr:nullptr;
+}
+
+const IpRouteInfo * NetRoutes::LookupRoute(uint8_t family, uint32_t table, const void * addr)
+{
+	size_t addrlen = family == AF_INET6 ? sizeof(struct in6_addr):sizeof(struct in_addr);
+	auto index = GetPrefixes(family, table);
+	auto ipr = index ? index->Lookup(addr, addrlen):nullptr;
+	return ipr ? *ipr:nullptr;
+}
+
+#define NETLINK_DUMP_ATTEMPTS 3
+
 bool NetRoutes::UpdateByNetlink(void)
 {
-	void * netlink = OpenNetlink();
-	if(!netlink)
-		return false;
+	if( UpdateByNotifications() )
+		return true;
 
-	// clear before start
-	Clear();
+	bool res = false;
 
-	//bool res = UpdateByNetlink(netlink, AF_UNSPEC); //UpdateByNetlink(netlink, AF_INET) && UpdateByNetlink(netlink, AF_INET6);
-	//bool res = UpdateByNetlink(netlink, AF_PACKET);
-	bool res = UpdateByNetlink(netlink, AF_UNSPEC);
+	if( !collector )
+		collector = new NetDumpCollector();
 
-	CloseNetlink(netlink);
+	// full dump replaces replayed data
+	replayed.Clear();
 
+	for( int attempt = 0; attempt < NETLINK_DUMP_ATTEMPTS; attempt++ ) {
+		// clear before start
+		Clear();
+
+		// rest of interrupted dump is still in socket, collector closes it
+		// and next attempt gets new one
+		res = UpdateByNetlink(*collector);
+		if( !collector->Interrupted() )
+			break;
+
+		LOG_WARN("dump was interrupted, attempt %d\n", attempt + 1);
+		res = false;
+	}
+
+	// events received during dump can be included in it already, applying them
+	// once more is harmless: routes are replaced by key, counted routes are kept
+	// by key too and are not counted twice
+	synced = res && monitor;
 	return res;
 }
 #endif
 
 bool NetRoutes::Update(void)
 {
+	version++;
+
 #if !defined(__APPLE__) && !defined(__FreeBSD__)
+	applied.Clear();
+	appliedValid = false;
 
 	if( !UpdateByNetlink() && !UpdateByProcNet() )
 		return false;
@@ -1409,7 +2069,7 @@ bool NetRoutes::Update(void)
 					if( i == RTAX_DST ) {
 						ipr.destIpandMask = get_sockaddr_str((struct sockaddr *)&address, false);
 						ipr.valid.destIpandMask = !ipr.destIpandMask.empty();
-						LOG_INFO("%u. %s: destIp: %S\n", i, ifname, ipr.destIpandMask.c_str());
+						LOG_INFO("%u. %s: destIp: %S\n", i, ifname, ipr.destIpandMask.str().c_str());
 						src_sa_family = ((struct sockaddr *)&address)->sa_family;
 						sa_family = src_sa_family;
 						continue;
@@ -1417,7 +2077,7 @@ bool NetRoutes::Update(void)
 
 					if( i == RTAX_GATEWAY ) {
 						ipr.gateway = get_sockaddr_str((struct sockaddr *)&address, false);
-						LOG_INFO("%u. %s: gateway: %S\n", i, ifname, ipr.gateway.c_str());
+						LOG_INFO("%u. %s: gateway: %S\n", i, ifname, ipr.gateway.str().c_str());
 						ipr.valid.gateway = !ipr.gateway.empty();
 
 						if( ((struct sockaddr *)&address)->sa_family == AF_LINK ) {
@@ -1439,15 +2099,16 @@ bool NetRoutes::Update(void)
 					if( i == RTAX_NETMASK && sa_family != AF_LINK ) {
 						if( ipr.valid.destIpandMask ) {
 							((struct sockaddr *)&address)->sa_family = src_sa_family;
-							ipr.destIpandMask += L"/";
+							std::wstring dest = ipr.destIpandMask.str() + L"/";
 							if( sa_family == AF_INET )
-								ipr.destIpandMask += std::to_wstring(IpMaskToBits(tostr(get_sockaddr_str((struct sockaddr *)&address, true).c_str()).c_str()));
+								dest += std::to_wstring(IpMaskToBits(get_sockaddr_cstr((struct sockaddr *)&address, true).c_str()));
 							else if( sa_family == AF_INET6 )
-								ipr.destIpandMask += std::to_wstring(Ip6MaskToBits(tostr(get_sockaddr_str((struct sockaddr *)&address, true).c_str()).c_str()));
+								dest += std::to_wstring(Ip6MaskToBits(get_sockaddr_cstr((struct sockaddr *)&address, true).c_str()));
 							else
-								ipr.destIpandMask += get_sockaddr_str((struct sockaddr *)&address, true);
+								dest += get_sockaddr_str((struct sockaddr *)&address, true);
+							ipr.destIpandMask = dest;
 							ipr.valid.mask = 1;
-							LOG_INFO("%u. %s: destIpandMask: %S\n", i, ifname, ipr.destIpandMask.c_str());
+							LOG_INFO("%u. %s: destIpandMask: %S\n", i, ifname, dest.c_str());
 						}
 						continue;
 					}
@@ -1455,7 +2116,7 @@ bool NetRoutes::Update(void)
 					if( i == RTAX_IFA ) {
 						ipr.prefsrc = get_sockaddr_str((struct sockaddr *)&address, false);
 						ipr.valid.prefsrc = !ipr.prefsrc.empty();
-						LOG_INFO("%u. %s: prefsrc: %S\n", i, ifname, ipr.prefsrc.c_str());
+						LOG_INFO("%u. %s: prefsrc: %S\n", i, ifname, ipr.prefsrc.str().c_str());
 					}
 				}
 			}
@@ -1469,9 +2130,9 @@ bool NetRoutes::Update(void)
 				ArpRouteInfo ari;
 				ari.iface = ipr.iface;
 				ari.valid.iface = ipr.valid.iface;
-				ari.ip = ipr.destIpandMask;
+				ari.ip = ipr.destIpandMask.str();
 				ari.valid.ip = ipr.valid.destIpandMask;
-				ari.mac = ipr.gateway;
+				ari.mac = ipr.gateway.str();
 				ari.valid.mac = ipr.valid.gateway;
 				ari.sa_family = ipr.sa_family;
 				ari.flags = ipr.flags;
@@ -1518,6 +2179,15 @@ bool NetRoutes::Update(void)
 	return true;
 }
 
+bool NetRoutes::IsSynced(void) const
+{
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	return synced;
+#else
+	return false;
+#endif
+}
+
 void NetRoutes::Log(void)
 {
 	LOG_INFO("inet.size() %u\n", inet.size());
@@ -1553,7 +2223,8 @@ void NetRoutes::Clear(void)
 {
 	LOG_INFO("\n");
 
-	ifs.clear();
+	ifs.Clear();
+	names.Clear();
 
 	arp.clear();
 	inet.clear();
@@ -1565,6 +2236,14 @@ void NetRoutes::Clear(void)
 	rule6.clear();
 	mcrule.clear();
 	mcrule6.clear();
+	inetTables.clear();
+	inet6Tables.clear();
+	mcinetTables.clear();
+	mcinet6Tables.clear();
+	counted.clear();
+	prefixes.clear();
+	prefixesValid = false;
+	linkFlags.Clear();
 	#endif
 }
 
@@ -1650,7 +2329,7 @@ bool NetRoutes::UpdateInterfaces(void)
 			LOG_INFO("sdl_nlen:  %d\n", sdl->sdl_nlen);
 
 			LOG_INFO("%d. ifname: %s\n", ifm->ifm_index, ifname);
-			ifs[ifm->ifm_index] = towstr(ifname);
+			ifs[ifm->ifm_index] = names.Intern(ifname);
 		}
 
 	} while(0);
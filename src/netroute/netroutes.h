@@ -2,12 +2,64 @@
 #define __NETROUTES_H__
 
 #include "netroute.h"
+#include <netif/ifindextable.h>
+#include <netif/namepool.h>
+#include <netif/snapshotdiff.h>
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+#include "netdumpcollector.h"
+#include "prefixindex.h"
+#endif
 #include <deque>
 #include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+// Events of rtnetlink subscription applied by one update. They are kept to bring
+// data of older update up to date without full dump (see NetRoutesUpdater).
+struct NetRoutesEvents {
+	struct Link {
+		uint16_t type;
+		uint32_t ifindex;
+		std::string name;
+	};
+	// route counted in tables mode
+	struct Count {
+		uint16_t type;
+		uint16_t flags;
+		uint8_t family;
+		uint32_t table;
+		// route as kernel identifies it in table and its IPv4 alias,
+		// see NetRoutes::CountRoute()
+		uint64_t route;
+		uint64_t alias;
+	};
+
+	std::vector<std::pair<uint16_t, IpRouteInfo>> routes;
+	std::vector<std::pair<uint16_t, ArpRouteInfo>> neighbors;
+	std::vector<std::pair<uint16_t, RuleRouteInfo>> rules;
+	std::vector<Link> links;
+	std::vector<Count> counts;
+
+	size_t Size(void) const { return routes.size() + neighbors.size() + rules.size() + links.size() + counts.size(); };
+	void Clear(void)
+	{
+		routes.clear();
+		neighbors.clear();
+		rules.clear();
+		links.clear();
+		counts.clear();
+	};
+};
+#endif
 
 struct NetRoutes {
 
-	std::map<uint32_t, std::wstring> ifs;
+	// interface names, routes and neighbors of dump keep only ifnameIndex
+	// and are resolved by this table when shown, names are kept by pool
+	NamePool names;
+	IfIndexTable<const wchar_t *> ifs;
 	std::deque<ArpRouteInfo> arp;
 	std::deque<IpRouteInfo> inet;
 	std::deque<IpRouteInfo> inet6;
@@ -18,14 +70,31 @@ struct NetRoutes {
 	std::deque<RuleRouteInfo> rule6;
 	std::deque<RuleRouteInfo> mcrule;
 	std::deque<RuleRouteInfo> mcrule6;
+	// number of routes in every table, counted instead of loading routes
+	// when only directory of tables is shown
+	std::map<uint32_t, uint32_t> inetTables;
+	std::map<uint32_t, uint32_t> inet6Tables;
+	std::map<uint32_t, uint32_t> mcinetTables;
+	std::map<uint32_t, uint32_t> mcinet6Tables;
 #endif
 
 	bool ipv4_forwarding;
 	bool ipv6_forwarding;
 
+	// changed with every data update, panels rebuild their items by it
+	uint32_t version;
+	// routes and neighbors added, removed and modified by the last update,
+	// set by UpdateChanges(), never nullptr
+	std::shared_ptr<const SnapshotChanges> changes;
+
 	NetRoutes();
+	// copy of data only, without rtnetlink subscription
+	NetRoutes(const NetRoutes & other);
 	~NetRoutes();
 
+	// exchange data with other, subscriptions stay with their owners
+	void Swap(NetRoutes & other);
+
 	bool SetIpForwarding(bool on);
 	bool SetIp6Forwarding(bool on);
 
@@ -33,18 +102,96 @@ struct NetRoutes {
 	void Log(void);
 	void Clear(void);
 
+	// true if next Update() only applies subscription events to current data
+	bool IsSynced(void) const;
+
+	// compares routes and neighbors with previous snapshot given to diff
+	void UpdateChanges(SnapshotDiff & diff);
+	// stable keys of rows in changes: family, table, dst/len, tos and metric of route,
+	// family, address and interface of neighbor
+	static uint64_t RouteKey(const IpRouteInfo & ipr);
+	static uint64_t NeighborKey(const ArpRouteInfo & ari);
+
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	// only matching routes are requested from kernel and taken from events,
+	// with tablesOnly they are counted per table only, containers of routes stay empty,
+	// changed filter makes next Update() do full dump
+	void SetRouteFilter(const RouteFilter & filter, bool tablesOnly = false);
+	const RouteFilter & GetRouteFilter(void) const { return routeFilter; };
+
+	// route of one table by prefix: exact match or longest prefix match as kernel
+	// chooses it inside of table (without rules), addr is in network order,
+	// nullptr if there is no such route. Index of all tables is built by first
+	// query after data update.
+	const IpRouteInfo * FindRoute(uint8_t family, uint32_t table, const void * addr, uint8_t prefixlen);
+	const IpRouteInfo * LookupRoute(uint8_t family, uint32_t table, const void * addr);
+
+	// routes of dump are converted in chunks by threads of pool and added
+	// in order of dump, as one thread does it
+	void AddIpRoutes(const RouteRecord * rr, NetDumpCollector & pool);
+
+	// events applied by the last Update(), false if it was full dump
+	bool TakeEvents(NetRoutesEvents & events);
+	// brings data of older update up to date by events of later ones, rules, links
+	// and counts are applied at once, routes and neighbors by next Update()
+	void Replay(const NetRoutesEvents & events);
+	// next Update() does full dump
+	void Resync(void);
+#endif
+
 #if !defined(__APPLE__) && !defined(__FreeBSD__)
 protected:
 	bool UpdateByProcNet(void);
 	bool UpdateByNetlink(void);
 	bool UpdateNeigbours(const NeighborRecord * nb);
 private:
-	void SetNameByIndex(const char *ifname, uint32_t index);
-	bool UpdateByNetlink(void * netlink, unsigned char af_family);
+	bool UpdateByNetlink(NetDumpCollector & pool);
+
+	void SetLink(const LinkRecord * lr);
+	void AddIpRoute(IpRouteInfo ipr);
+	void AddRule(const RuleRouteInfo & rri);
+	void ApplyRule(uint16_t type, const RuleRouteInfo & rri);
+
+	// sockets and threads for parallel dumps, created by first full dump
+	NetDumpCollector * collector;
+	RouteFilter routeFilter;
+	bool tablesOnly;
+	std::map<uint32_t, uint32_t> * TableCounts(uint8_t family);
+	// counted routes by route and alias keys, so route is counted once
+	// by dump and by its event received during the dump
+	std::unordered_multimap<uint64_t, uint64_t> counted;
+	void CountRoute(const NetRoutesEvents::Count & count);
+	static int OnCountRoute(void * arg, const struct nlmsghdr * nlm, const void * record);
+
+	// prefix index by family and table, valid while version is the same
+	typedef PrefixIndex<const IpRouteInfo *> RouteIndex;
+	std::map<std::pair<uint8_t, uint32_t>, RouteIndex> prefixes;
+	uint32_t prefixesVersion;
+	bool prefixesValid;
+	const RouteIndex * GetPrefixes(uint8_t family, uint32_t table);
+
+	// rtnetlink multicast subscription, after full dump
+	// routes, rules and neighbors are changed by events only
+	void * monitor;
+	bool synced;
+	// IFF_* flags of links by events, down or removed link makes full dump,
+	// as kernel flushes its IPv4 routes silently
+	IfIndexTable<uint32_t> linkFlags;
+	// received events, routes and neighbors of them are applied
+	// at the end of update together with replayed ones
+	NetRoutesEvents pending;
+	NetRoutesEvents replayed;
+	NetRoutesEvents applied;
+	bool appliedValid;
+	static int OnNotify(void * arg, const struct nlmsghdr * nlm, const void * record);
+	bool UpdateByNotifications(void);
+	void ApplyPendingRoutes(void);
+	void ApplyPendingNeighbors(void);
 #else
 protected:
 	bool UpdateInterfaces(void);
 #endif
+	void operator=(const NetRoutes&) = delete;
 };
 
 #endif /* __NETROUTES_H__ */
@@ -0,0 +1,610 @@
+#include "netroutes.h"
+
+#include <common/log.h>
+#include <common/widestr.h>
+
+#include <thread>
+#include <unordered_map>
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <linux/if_arp.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <malloc.h>
+#include <unistd.h>
+}
+
+// Benchmarks of routes, one per MAIN_NETROUTES_*BENCH (see mktests).
+// Every one exits with 1 when its results are wrong.
+
+#define LOG_SOURCE_FILE "netroutesbench.cpp"
+const char * LOG_FILE = "/dev/null";
+
+int RootExec(const char * cmd)
+{
+	return system(cmd);
+}
+
+static double BenchNow(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+#ifdef MAIN_NETROUTES_LOGBENCH
+
+// full dump with logging off, info and trace levels
+// netroutes_logbench <log file> [runs]
+int main(int argc, char * argv[])
+{
+	static const struct {
+		const char * name;
+		int level;
+	} modes[] = {
+		{ "off",   LOG_LEVEL_NONE },
+		{ "info",  LOG_LEVEL_INFO },
+		{ "trace", LOG_LEVEL_TRACE },
+	};
+	int runs = argc > 2 ? atoi(argv[2]) : 3;
+
+	if( argc < 2 ) {
+		fprintf(stderr, "usage: %s <log file> [runs]\n", argv[0]);
+		return 1;
+	}
+
+	LOG_FILE = argv[1];
+	for( const auto & mode : modes ) {
+		common_log_level = mode.level;
+		for( int run = 0; run < runs; run++ ) {
+			// new object every run, otherwise it is updated by notifications
+			NetRoutes rt;
+			double start = BenchNow();
+			if( !rt.Update() )
+				return 1;
+			double dumped = BenchNow();
+			common_log_flush();
+			double written = BenchNow();
+			printf("logging %-5s run %d: %zu routes %zu neighbors dump %.3f ms, log written %.3f ms\n",
+				mode.name, run, rt.inet.size() + rt.inet6.size(), rt.arp.size(),
+				(dumped - start)*1e3, (written - start)*1e3);
+		}
+	}
+	return 0;
+}
+#endif //MAIN_NETROUTES_LOGBENCH
+
+#ifdef MAIN_NETROUTES_TABLESBENCH
+
+// directory of tables (counts only) against full load of all tables
+// netroutes_tablesbench [table] - table is checked to follow route events
+int main(int argc, char * argv[])
+{
+	uint32_t table = argc > 1 ? (uint32_t)atoi(argv[1]):100;
+	RouteFilter filter;
+	memset(&filter, 0, sizeof(filter));
+	filter.family = AF_INET;
+
+	for( bool tablesOnly : { true, false } ) {
+		size_t heap = mallinfo2().uordblks;
+		NetRoutes rt;
+		rt.SetRouteFilter(filter, tablesOnly);
+		double start = BenchNow();
+		if( !rt.Update() )
+			return 1;
+		double elapsed = BenchNow() - start;
+		uint32_t total = 0;
+		for( const auto & [id, count] : rt.inetTables )
+			total += count;
+		printf("%-11s %zu tables %u counted %zu routes kept, %.3f ms, heap %zu KB\n",
+			tablesOnly ? "tables only":"full", rt.inetTables.size(), total, rt.inet.size(),
+			elapsed*1e3, (mallinfo2().uordblks - heap) / 1024);
+
+		if( !tablesOnly )
+			break;
+
+		// counters are changed by events without dump
+		uint32_t before = rt.inetTables.count(table) ? rt.inetTables[table]:0;
+		char cmd[128];
+		snprintf(cmd, sizeof(cmd), "ip route add 10.250.250.250/32 dev lo table %u", table);
+		if( system(cmd) )
+			return 1;
+		rt.Update();
+		uint32_t added = rt.inetTables.count(table) ? rt.inetTables[table]:0;
+		snprintf(cmd, sizeof(cmd), "ip route del 10.250.250.250/32 dev lo table %u", table);
+		system(cmd);
+		rt.Update();
+		uint32_t deleted = rt.inetTables.count(table) ? rt.inetTables[table]:0;
+		printf("table %u: %u, after add %u, after del %u\n", table, before, added, deleted);
+		if( added != before + 1 || deleted != before )
+			return 1;
+	}
+	return 0;
+}
+#endif //MAIN_NETROUTES_TABLESBENCH
+
+#ifdef MAIN_NETROUTES_INDEXBENCH
+
+static uint32_t BenchRandom(void)
+{
+	static uint64_t state = 88172645463325252ULL;
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	return (uint32_t)state;
+}
+
+// prefix index against linear scan on synthetic table, most prefixes are /24 as in BGP feed,
+// every prefix must be found by exact match and scanned addresses by the same longest prefix
+static int SyntheticBench(size_t count, size_t lookups)
+{
+	static const uint8_t lens[] = { 24, 24, 24, 24, 24, 24, 22, 23, 20, 16, 19, 21, 32, 8 };
+	std::vector<std::pair<uint32_t, uint8_t>> routes;
+	PrefixIndex<uint32_t> index;
+
+	routes.reserve(count);
+	index.Reserve(count);
+	double start = BenchNow();
+	while( index.Size() < count ) {
+		uint8_t len = lens[BenchRandom() % sizeof(lens)];
+		uint32_t addr = htonl(BenchRandom() & (~0U << (32 - len)));
+		uint32_t & value = index(&addr, sizeof(addr), len);
+		if( !value ) {
+			routes.emplace_back(ntohl(addr), len);
+			value = (uint32_t)routes.size();
+		}
+	}
+	index.Compact();
+	double built = BenchNow() - start;
+
+	std::vector<uint32_t> addrs(lookups);
+	for( auto & addr : addrs )
+		addr = htonl(BenchRandom());
+
+	uint64_t found = 0;
+	start = BenchNow();
+	for( const auto & addr : addrs )
+		found += index.Lookup(&addr, sizeof(addr)) != nullptr;
+	double lpm = BenchNow() - start;
+
+	std::vector<const uint32_t *> exacts(routes.size());
+	start = BenchNow();
+	for( size_t i = 0; i < routes.size(); i++ ) {
+		uint32_t addr = htonl(routes[i].first);
+		exacts[i] = index.Find(&addr, sizeof(addr), routes[i].second);
+	}
+	double exact = BenchNow() - start;
+
+	// linear scan is too slow for all lookups
+	size_t scans = lookups / 1000 ? lookups / 1000:1;
+	std::vector<uint32_t> scanned(scans);
+	start = BenchNow();
+	for( size_t i = 0; i < scans; i++ ) {
+		uint32_t addr = ntohl(addrs[i]);
+		uint8_t best = 0;
+		for( size_t n = 0; n < routes.size(); n++ ) {
+			uint32_t mask = ~0U << (32 - routes[n].second);
+			if( (addr & mask) == routes[n].first && routes[n].second > best ) {
+				best = routes[n].second;
+				scanned[i] = (uint32_t)n + 1;
+			}
+		}
+	}
+	double scan = BenchNow() - start;
+
+	printf("%zu prefixes: build %.1f ms, %zu nodes %zu MB\n", index.Size(), built*1e3,
+		index.Nodes(), index.Memory() >> 20);
+	printf("  longest prefix match %.1f ns/op, exact match %.1f ns/op, linear scan %.0f ns/op (%lu found)\n",
+		lpm*1e9/lookups, exact*1e9/routes.size(), scan*1e9/scans, (unsigned long)found);
+
+	size_t mismatches = 0;
+	for( size_t i = 0; i < routes.size(); i++ ) {
+		if( !exacts[i] || *exacts[i] != i + 1 ) {
+			if( mismatches++ < 10 )
+				printf("  prefix %zu: exact match %u\n", i + 1, exacts[i] ? *exacts[i]:0);
+		}
+	}
+	for( size_t i = 0; i < scans; i++ ) {
+		const uint32_t * value = index.Lookup(&addrs[i], sizeof(addrs[i]));
+		if( (value ? *value:0) != scanned[i] ) {
+			char s[INET_ADDRSTRLEN];
+			if( mismatches++ < 10 )
+				printf("  %s: longest prefix match %u, linear scan %u\n", inet_ntop(AF_INET, &addrs[i], s, sizeof(s)),
+					value ? *value:0, scanned[i]);
+		}
+	}
+	printf("  %zu mismatches\n", mismatches);
+	return mismatches != 0;
+}
+
+// index of dumped routes against RTM_GETROUTE, tables are chosen by default rules
+static int KernelBench(size_t lookups)
+{
+	static const uint32_t tables[] = { RT_TABLE_LOCAL, RT_TABLE_MAIN, RT_TABLE_DEFAULT };
+	NetRoutes rt;
+	if( !rt.Update() )
+		return 1;
+
+	std::vector<uint32_t> addrs;
+	for( const auto & ipr : rt.inet ) {
+		uint32_t a;
+		uint8_t len;
+		if( ipr.osdep.table == RT_TABLE_MAIN && ipr.destIpandMask.Get(AF_INET, &a, &len) ) {
+			// any address inside of prefix
+			if( ipr.dstprefixlen < 32 )
+				a |= htonl(BenchRandom() & (~0U >> ipr.dstprefixlen));
+			addrs.push_back(a);
+		}
+	}
+	// multicast and reserved destinations are resolved by kernel without tables
+	while( addrs.size() < lookups ) {
+		uint32_t a = BenchRandom();
+		if( a < 0xE0000000 )
+			addrs.push_back(htonl(a));
+	}
+	if( addrs.size() > lookups )
+		addrs.resize(lookups);
+
+	double start = BenchNow();
+	rt.LookupRoute(AF_INET, RT_TABLE_MAIN, &addrs[0]);
+	double built = BenchNow() - start;
+
+	std::vector<const IpRouteInfo *> found(addrs.size());
+	start = BenchNow();
+	for( size_t i = 0; i < addrs.size(); i++ ) {
+		for( auto table : tables ) {
+			if( (found[i] = rt.LookupRoute(AF_INET, table, &addrs[i])) != nullptr )
+				break;
+		}
+	}
+	double index = BenchNow() - start;
+
+	void * nl = OpenNetlink();
+	size_t mismatches = 0, unreachable = 0;
+	start = BenchNow();
+	for( size_t i = 0; i < addrs.size(); i++ ) {
+		const RouteRecord * rr = GetRouteTo(nl, AF_INET, &addrs[i]);
+		if( !rr || !rr->rt ) {
+			unreachable++;
+			mismatches += found[i] != nullptr;
+			continue;
+		}
+		// kernel without custom rules keeps local table merged into main one
+		// and reports main, so prefix and type are compared only
+		if( !found[i] || found[i]->dstprefixlen != rr->rt->rtm_dst_len || found[i]->osdep.type != rr->rt->rtm_type ) {
+			char s[INET_ADDRSTRLEN];
+			if( mismatches++ < 10 )
+				printf("  %s: index %S type %u, kernel /%u type %u\n", inet_ntop(AF_INET, &addrs[i], s, sizeof(s)),
+					found[i] ? found[i]->destIpandMask.str().c_str():L"-", found[i] ? found[i]->osdep.type:0,
+					rr->rt->rtm_dst_len, rr->rt->rtm_type);
+		}
+	}
+	double kernel = BenchNow() - start;
+	CloseNetlink(nl);
+
+	printf("%zu routes: index built %.1f ms, lookup %.1f ns/op, RTM_GETROUTE %.0f ns/op, %zu unreachable, %zu mismatches\n",
+		rt.inet.size(), built*1e3, index*1e9/addrs.size(), kernel*1e9/addrs.size(), unreachable, mismatches);
+	return mismatches != 0;
+}
+
+// netroutes_indexbench [prefixes] [lookups]
+int main(int argc, char * argv[])
+{
+	size_t count = argc > 1 ? (size_t)atol(argv[1]):1000000;
+	size_t lookups = argc > 2 ? (size_t)atol(argv[2]):100000;
+
+	int res = SyntheticBench(count, lookups * 10);
+	return KernelBench(lookups) | res;
+}
+#endif //MAIN_NETROUTES_INDEXBENCH
+
+#ifdef MAIN_NETROUTES_DECODEBENCH
+
+static void BenchPut32(FILE * file, uint32_t value)
+{
+	fwrite(&value, sizeof(value), 1, file);
+}
+
+static void BenchAttr(char * msg, uint16_t type, const void * data, size_t len)
+{
+	struct nlmsghdr * nlh = (struct nlmsghdr *)msg;
+	struct rtattr * rta = (struct rtattr *)(msg + NLMSG_ALIGN(nlh->nlmsg_len));
+	rta->rta_type = type;
+	rta->rta_len = RTA_LENGTH(len);
+	memcpy(RTA_DATA(rta), data, len);
+	nlh->nlmsg_len = NLMSG_ALIGN(nlh->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+}
+
+// route of synthetic dump: via gateway, direct with prefsrc or multipath
+static size_t BenchRoute(char * msg, uint32_t n)
+{
+	struct nlmsghdr * nlh = (struct nlmsghdr *)msg;
+	struct rtmsg * rtm = (struct rtmsg *)NLMSG_DATA(nlh);
+	uint32_t dst = htonl(0x0A000000 | (n << 8)), table = RT_TABLE_MAIN, oif = 2 + n % 4, metric = n % 1000;
+	uint32_t gw = htonl(0xC0A80001 + n % 200);
+
+	memset(msg, 0, NLMSG_SPACE(sizeof(struct rtmsg)));
+	nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+	nlh->nlmsg_type = RTM_NEWROUTE;
+	nlh->nlmsg_flags = NLM_F_MULTI;
+	rtm->rtm_family = AF_INET;
+	rtm->rtm_dst_len = 24;
+	rtm->rtm_table = RT_TABLE_MAIN;
+	rtm->rtm_protocol = RTPROT_STATIC;
+	rtm->rtm_scope = RT_SCOPE_UNIVERSE;
+	rtm->rtm_type = RTN_UNICAST;
+
+	BenchAttr(msg, RTA_TABLE, &table, sizeof(table));
+	BenchAttr(msg, RTA_DST, &dst, sizeof(dst));
+	BenchAttr(msg, RTA_PRIORITY, &metric, sizeof(metric));
+	switch( n % 10 ) {
+	case 0:
+	{
+		char nhs[2 * (sizeof(struct rtnexthop) + RTA_SPACE(sizeof(uint32_t)))];
+		for( int i = 0; i < 2; i++ ) {
+			struct rtnexthop * nh = (struct rtnexthop *)(nhs + i * sizeof(nhs) / 2);
+			struct rtattr * rta = (struct rtattr *)RTNH_DATA(nh);
+			nh->rtnh_len = sizeof(nhs) / 2;
+			nh->rtnh_flags = 0;
+			nh->rtnh_hops = (unsigned char)i;
+			nh->rtnh_ifindex = (int)oif + i;
+			rta->rta_type = RTA_GATEWAY;
+			rta->rta_len = RTA_LENGTH(sizeof(uint32_t));
+			uint32_t addr = gw + htonl(i);
+			memcpy(RTA_DATA(rta), &addr, sizeof(addr));
+		}
+		BenchAttr(msg, RTA_MULTIPATH, nhs, sizeof(nhs));
+		break;
+	}
+	case 1:
+	case 2:
+		rtm->rtm_scope = RT_SCOPE_LINK;
+		BenchAttr(msg, RTA_OIF, &oif, sizeof(oif));
+		BenchAttr(msg, RTA_PREFSRC, &gw, sizeof(gw));
+		break;
+	default:
+		BenchAttr(msg, RTA_GATEWAY, &gw, sizeof(gw));
+		BenchAttr(msg, RTA_OIF, &oif, sizeof(oif));
+		break;
+	}
+	return NLMSG_ALIGN(nlh->nlmsg_len);
+}
+
+// capture of route dump as written by RecordNetlink(), datagrams of 32 KB
+static bool WriteSyntheticDump(const char * path, uint32_t routes)
+{
+	static const size_t DatagramSize = 32768;
+	std::vector<char> datagram(DatagramSize);
+	unsigned char sll[16] = { 0, 6, ARPHRD_NETLINK >> 8, ARPHRD_NETLINK & 0xFF };
+	size_t len = 0;
+	FILE * file = fopen(path, "wb");
+	if( !file )
+		return false;
+
+	BenchPut32(file, 0xA1B2C3D4);
+	BenchPut32(file, 2 | (4 << 16));
+	BenchPut32(file, 0);
+	BenchPut32(file, 0);
+	BenchPut32(file, 0x40000);
+	BenchPut32(file, 253);
+
+	auto flush = [&]() {
+		BenchPut32(file, 0);
+		BenchPut32(file, 0);
+		BenchPut32(file, (uint32_t)(len + sizeof(sll)));
+		BenchPut32(file, (uint32_t)(len + sizeof(sll)));
+		fwrite(sll, sizeof(sll), 1, file);
+		fwrite(&datagram[0], len, 1, file);
+		len = 0;
+	};
+
+	for( uint32_t n = 0; n <= routes; n++ ) {
+		char msg[512];
+		size_t size;
+		if( n < routes )
+			size = BenchRoute(msg, n);
+		else {
+			struct nlmsghdr * nlh = (struct nlmsghdr *)msg;
+			memset(msg, 0, NLMSG_SPACE(sizeof(int)));
+			nlh->nlmsg_len = NLMSG_LENGTH(sizeof(int));
+			nlh->nlmsg_type = NLMSG_DONE;
+			nlh->nlmsg_flags = NLM_F_MULTI;
+			size = NLMSG_ALIGN(nlh->nlmsg_len);
+		}
+		if( len + size > DatagramSize )
+			flush();
+		memcpy(&datagram[len], msg, size);
+		len += size;
+	}
+	flush();
+	return fclose(file) == 0;
+}
+
+// decode of synthetic route dump by 1, 2, 4 and 8 threads
+// netroutes_decodebench [routes] [capture file]
+int main(int argc, char * argv[])
+{
+	uint32_t routes = argc > 1 ? (uint32_t)atol(argv[1]):1000000;
+	const char * path = argc > 2 ? argv[2]:"/tmp/netroutes_decodebench.pcap";
+	static const unsigned int threads[] = { 1, 2, 4, 8 };
+
+	// decode only, as release build without trace log
+	common_log_level = LOG_LEVEL_INFO;
+	if( !WriteSyntheticDump(path, routes) ) {
+		fprintf(stderr, "can`t write %s\n", path);
+		return 1;
+	}
+
+	void * nl = OpenNetlinkReplay(path);
+	const RouteRecord * rr = nl ? GetRoutes(nl, AF_INET):nullptr;
+	if( !rr ) {
+		fprintf(stderr, "can`t replay %s\n", path);
+		return 1;
+	}
+
+	size_t total = 0;
+	while( rr[total].rt )
+		total++;
+	printf("%zu records, %u CPUs\n", total, std::thread::hardware_concurrency());
+
+	double base = 0;
+	std::vector<RouteAddr> order;
+	for( auto n : threads ) {
+		NetDumpCollector pool(n);
+		double best = 0;
+		for( int run = 0; run < 3; run++ ) {
+			NetRoutes rt;
+			double start = BenchNow();
+			rt.AddIpRoutes(rr, pool);
+			double elapsed = BenchNow() - start;
+			if( !run || elapsed < best )
+				best = elapsed;
+
+			// every number of threads gives the same routes in the same order
+			if( order.empty() )
+				for( const auto & ipr : rt.inet )
+					order.push_back(ipr.destIpandMask);
+			else if( !run ) {
+				size_t i = 0;
+				for( const auto & ipr : rt.inet ) {
+					if( i >= order.size() || order[i++] != ipr.destIpandMask ) {
+						fprintf(stderr, "%u threads: route %zu differs\n", n, i);
+						return 1;
+					}
+				}
+				if( i != order.size() ) {
+					fprintf(stderr, "%u threads: %zu routes instead of %zu\n", n, i, order.size());
+					return 1;
+				}
+			}
+		}
+		if( n == 1 )
+			base = best;
+		printf("%u threads: %.1f ms, %.2fx\n", n, best * 1e3, base / best);
+	}
+	CloseNetlink(nl);
+	unlink(path);
+	return 0;
+}
+#endif //MAIN_NETROUTES_DECODEBENCH
+
+#ifdef MAIN_NETROUTES_DIFFBENCH
+
+static IpRouteInfo BenchRoute(uint32_t n)
+{
+	IpRouteInfo ipr;
+	char s[sizeof("255.255.255.255/32")];
+	snprintf(s, sizeof(s), "10.%u.%u.0/24", (n >> 8) & 0xFF, n & 0xFF);
+	ipr.sa_family = AF_INET;
+	ipr.destIpandMask = towstr(s);
+	ipr.dstprefixlen = 24;
+	snprintf(s, sizeof(s), "192.168.%u.1", n % 200);
+	ipr.gateway = towstr(s);
+	ipr.valid.gateway = 1;
+	ipr.ifnameIndex = 2 + n % 4;
+	ipr.valid.ifnameIndex = 1;
+	ipr.osdep.table = 100 + (n >> 16);
+	ipr.valid.table = 1;
+	ipr.osdep.metric = n % 1000;
+	ipr.valid.metric = 1;
+	return ipr;
+}
+
+typedef std::unordered_map<uint64_t, IpRouteInfo> BenchSnapshot;
+
+static BenchSnapshot TakeSnapshot(const NetRoutes & nr)
+{
+	BenchSnapshot snapshot;
+	snapshot.reserve(nr.inet.size());
+	for( const auto & ipr : nr.inet )
+		snapshot.emplace(NetRoutes::RouteKey(ipr), ipr);
+	return snapshot;
+}
+
+// state of every row and counts of diff against full compare of snapshots,
+// routes of the same key are compared by all fields which bench routes differ in
+static size_t FullCompare(const BenchSnapshot & last, const NetRoutes & nr)
+{
+	const SnapshotChanges & changes = *nr.changes;
+	size_t added = 0, modified = 0, mismatches = 0;
+
+	for( const auto & ipr : nr.inet ) {
+		uint64_t key = NetRoutes::RouteKey(ipr);
+		auto it = last.find(key);
+		SnapshotChanges::RowState state = SnapshotChanges::RowSame;
+		if( it == last.end() )
+			state = SnapshotChanges::RowAdded;
+		else if( it->second.gateway != ipr.gateway || it->second.ifnameIndex != ipr.ifnameIndex ||
+			it->second.osdep.metric != ipr.osdep.metric )
+			state = SnapshotChanges::RowModified;
+		added += state == SnapshotChanges::RowAdded;
+		modified += state == SnapshotChanges::RowModified;
+		if( changes.Get(key) != state && mismatches++ < 10 )
+			fprintf(stderr, "  %S table %u: diff %d, full compare %d\n", ipr.destIpandMask.str().c_str(),
+				ipr.osdep.table, (int)changes.Get(key), (int)state);
+	}
+
+	size_t removed = last.size() - (nr.inet.size() - added);
+	if( changes.added != added || changes.removed != removed || changes.modified != modified ) {
+		fprintf(stderr, "  diff added %zu removed %zu modified %zu, full compare %zu %zu %zu\n",
+			changes.added, changes.removed, changes.modified, added, removed, modified);
+		mismatches++;
+	}
+	return mismatches;
+}
+
+// diff of synthetic snapshots: every step changes gateway of some routes,
+// removes some and adds new ones, rows and counts must match full compare
+// netroutes_diffbench [routes] [changes]
+int main(int argc, char * argv[])
+{
+	uint32_t routes = argc > 1 ? (uint32_t)atol(argv[1]):1000000;
+	uint32_t churn = argc > 2 ? (uint32_t)atol(argv[2]):1000;
+	NetRoutes nr;
+	SnapshotDiff diff;
+
+	common_log_level = LOG_LEVEL_INFO;
+	for( uint32_t n = 0; n < routes; n++ )
+		nr.inet.push_back(BenchRoute(n));
+
+	double start = BenchNow();
+	nr.UpdateChanges(diff);
+	printf("%u routes, baseline %.1f ms, changes %u\n", routes, (BenchNow() - start) * 1e3, (unsigned int)nr.changes->Total());
+	if( nr.changes->Total() )
+		return 1;
+
+	for( int step = 0; step < 3; step++ ) {
+		BenchSnapshot last = TakeSnapshot(nr);
+		uint32_t next = routes + step * churn;
+		for( uint32_t i = 0; i < churn; i++ ) {
+			nr.inet[i * 3].gateway = L"172.16.0.1";
+			nr.inet.pop_back();
+			nr.inet.push_front(BenchRoute(next + i));
+		}
+
+		start = BenchNow();
+		nr.UpdateChanges(diff);
+		double elapsed = BenchNow() - start;
+		const SnapshotChanges & changes = *nr.changes;
+		printf("step %d: %.1f ms, added %u removed %u modified %u\n", step, elapsed * 1e3,
+			(unsigned int)changes.added, (unsigned int)changes.removed, (unsigned int)changes.modified);
+
+		// new routes are shifted to the front, so some changed gateways are of new routes
+		if( changes.added != churn || changes.removed != churn || changes.modified > churn ||
+			changes.Get(NetRoutes::RouteKey(nr.inet.front())) != SnapshotChanges::RowAdded ) {
+			fprintf(stderr, "unexpected changes\n");
+			return 1;
+		}
+		if( FullCompare(last, nr) )
+			return 1;
+	}
+
+	diff.Reset();
+	nr.UpdateChanges(diff);
+	return nr.changes->Total() ? 1:0;
+}
+#endif //MAIN_NETROUTES_DIFFBENCH
@@ -0,0 +1,299 @@
+#include "netroutesupdater.h"
+
+#include <common/log.h>
+
+#include <string.h>
+
+#define LOG_SOURCE_FILE "netroutesupdater.cpp"
+#ifndef MAIN_NETROUTESUPDATER
+extern const char * LOG_FILE;
+#else
+const char * LOG_FILE = "";
+#endif
+
+// events kept for data of UI, beyond it data given back by UI is not replayed
+// and full dump is done instead
+#define NETROUTES_UPDATER_MAX_EVENTS 65536
+
+NetRoutesUpdater::NetRoutesUpdater():
+publishedGeneration(0),
+returnedGeneration(0),
+shownGeneration(0),
+request(false),
+updating(false),
+stop(false)
+{
+	LOG_INFO("\n");
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	memset(&filter, 0, sizeof(filter));
+	tablesOnly = false;
+#endif
+	worker = std::thread(&NetRoutesUpdater::Run, this);
+}
+
+NetRoutesUpdater::~NetRoutesUpdater()
+{
+	{
+		std::lock_guard<std::mutex> lck(lock);
+		stop = true;
+	}
+	cv.notify_one();
+
+	if( worker.joinable() )
+		worker.join();
+	LOG_INFO("\n");
+}
+
+void NetRoutesUpdater::Run(void)
+{
+	NetRoutes collector;
+	// snapshots are compared while the same routes are requested
+	SnapshotDiff diff;
+	// update counter and update which data collector keeps, 0 if data was moved out
+	uint32_t generation = 0, collectorGeneration = 0;
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	bool diffTablesOnly = false;
+	// events of updates after the last full dump, by update
+	std::deque<std::pair<uint32_t, NetRoutesEvents>> journal;
+	size_t journalEvents = 0;
+	uint32_t fullGeneration = 0;
+#endif
+
+	std::unique_lock<std::mutex> lck(lock);
+	for( ;; ) {
+		cv.wait(lck, [this] { return request || stop; });
+		if( stop )
+			break;
+		request = false;
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+		if( !SameRouteFilter(&filter, &collector.GetRouteFilter()) || tablesOnly != diffTablesOnly ) {
+			diff.Reset();
+			diffTablesOnly = tablesOnly;
+		}
+		collector.SetRouteFilter(filter, tablesOnly);
+#endif
+		// not taken data is the newest one, given back data is older
+		std::unique_ptr<NetRoutes> spare;
+		uint32_t spareGeneration = 0;
+		if( published ) {
+			spare = std::move(published);
+			spareGeneration = publishedGeneration;
+			returned.reset();
+		} else if( returned ) {
+			spare = std::move(returned);
+			spareGeneration = returnedGeneration;
+		}
+		lck.unlock();
+
+		if( !collectorGeneration ) {
+			if( spare ) {
+				collector.Swap(*spare);
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+				// journal has events of every update after its first one
+				if( spareGeneration >= fullGeneration && (spareGeneration == generation ||
+						(!journal.empty() && journal.front().first <= spareGeneration + 1)) ) {
+					for( const auto & [update, events] : journal ) {
+						if( update > spareGeneration )
+							collector.Replay(events);
+					}
+				} else
+					collector.Resync();
+#endif
+			} else
+				collector.Resync();
+		} else
+			// collector keeps newer data of full dump
+			spare.reset();
+
+		std::unique_ptr<NetRoutes> snapshot;
+		if( collector.Update() ) {
+			generation++;
+			collector.UpdateChanges(diff);
+
+			bool full = true;
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+			NetRoutesEvents events;
+			if( collector.TakeEvents(events) ) {
+				full = false;
+				journalEvents += events.Size();
+				journal.emplace_back(generation, std::move(events));
+			} else {
+				journal.clear();
+				journalEvents = 0;
+				fullGeneration = generation;
+			}
+			if( journalEvents > NETROUTES_UPDATER_MAX_EVENTS ) {
+				LOG_INFO("%u events, older data will not be replayed\n", journalEvents);
+				journal.clear();
+				journalEvents = 0;
+				fullGeneration = generation;
+			}
+#endif
+			if( full && collector.IsSynced() ) {
+				// next updates apply events to data of this one
+				snapshot = std::make_unique<NetRoutes>(collector);
+				collectorGeneration = generation;
+			} else {
+				// emptied buffer of given back data is reused
+				snapshot = spare ? std::move(spare):std::make_unique<NetRoutes>();
+				snapshot->Swap(collector);
+				collectorGeneration = 0;
+			}
+		} else {
+			LOG_ERROR("can`t update routes\n");
+			// data may be partly updated, next update does full dump
+			collector.Resync();
+			collectorGeneration = generation;
+		}
+
+		lck.lock();
+		if( snapshot ) {
+			published = std::move(snapshot);
+			publishedGeneration = generation;
+		}
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+		// UI gives back data of shown update, older events are not needed
+		uint32_t oldest = returned ? returnedGeneration:shownGeneration;
+		while( !journal.empty() && journal.front().first <= oldest ) {
+			journalEvents -= journal.front().second.Size();
+			journal.pop_front();
+		}
+#endif
+		// one more request was received while updating
+		updating = request;
+	}
+}
+
+void NetRoutesUpdater::Request(void)
+{
+	{
+		std::lock_guard<std::mutex> lck(lock);
+		request = true;
+		updating = true;
+	}
+	cv.notify_one();
+}
+
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+void NetRoutesUpdater::SetRouteFilter(const RouteFilter & filter_, bool tablesOnly_)
+{
+	std::lock_guard<std::mutex> lck(lock);
+	filter = filter_;
+	tablesOnly = tablesOnly_;
+}
+#endif
+
+bool NetRoutesUpdater::Exchange(NetRoutes & routes)
+{
+	std::lock_guard<std::mutex> lck(lock);
+	if( !published )
+		return false;
+
+	// containers are swapped, data of routes goes back to worker
+	routes.Swap(*published);
+	returned = std::move(published);
+	returnedGeneration = shownGeneration;
+	shownGeneration = publishedGeneration;
+	return true;
+}
+
+bool NetRoutesUpdater::IsReady(void)
+{
+	std::lock_guard<std::mutex> lck(lock);
+	return published != nullptr;
+}
+
+bool NetRoutesUpdater::IsUpdating(void)
+{
+	std::lock_guard<std::mutex> lck(lock);
+	return updating;
+}
+
+#ifdef MAIN_NETROUTESUPDATER
+
+#include <chrono>
+#include <set>
+#include <tuple>
+
+int RootExec(const char * cmd)
+{
+	return system(cmd);
+}
+
+static void WaitUpdate(NetRoutesUpdater & updater)
+{
+	updater.Request();
+	while( updater.IsUpdating() )
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+typedef std::multiset<std::tuple<uint64_t, std::wstring, uint32_t>> RouteSet;
+
+static RouteSet Routes(const NetRoutes & nrts)
+{
+	RouteSet routes;
+	for( auto list : { &nrts.inet, &nrts.inet6 } ) {
+		for( const auto & ipr : *list )
+			routes.emplace(NetRoutes::RouteKey(ipr), ipr.gateway.str(), ipr.valid.ifnameIndex ? ipr.ifnameIndex:0);
+	}
+	return routes;
+}
+
+static std::multiset<std::wstring> Rules(const NetRoutes & nrts)
+{
+	std::multiset<std::wstring> rules;
+	for( auto list : { &nrts.rule, &nrts.rule6 } ) {
+		for( const auto & rri : *list )
+			rules.insert(rri.rule);
+	}
+	return rules;
+}
+
+// netroutesupdater [iterations] - with iterations (root only) adds and deletes
+// blackhole routes and rules, and compares exchanged data with full dump
+int main(int argc, char * argv[])
+{
+	NetRoutesUpdater updater;
+	NetRoutes front;
+	int iterations = argc > 1 ? atoi(argv[1]):0;
+	char cmd[256];
+
+	WaitUpdate(updater);
+	updater.Exchange(front);
+
+	if( !iterations ) {
+		front.Log();
+		return 0;
+	}
+
+	for( int i = 0; i < iterations; i++ ) {
+		snprintf(cmd, sizeof(cmd), "ip route add blackhole 198.51.100.%d/32 metric %d", i % 200, i);
+		RootExec(cmd);
+		snprintf(cmd, sizeof(cmd), "ip route replace blackhole 198.51.100.%d/32 metric %d", (i * 7) % 200, (i * 7) % 5);
+		RootExec(cmd);
+		if( i % 3 == 0 ) {
+			snprintf(cmd, sizeof(cmd), "ip route del 198.51.100.%d/32", (i / 3) % 200);
+			RootExec(cmd);
+		}
+		snprintf(cmd, sizeof(cmd), "ip rule %s pref %d table %d", i % 4 == 3 ? "del":"add", 31000 + i % 8, 100 + i % 8);
+		RootExec(cmd);
+
+		WaitUpdate(updater);
+		// sometimes UI misses update, worker takes not shown data back
+		if( i % 5 != 4 && updater.Exchange(front) ) {
+			NetRoutes full;
+			full.Update();
+			if( Routes(front) != Routes(full) || Rules(front) != Rules(full) ) {
+				fprintf(stderr, "iteration %d: %u routes %u rules differ from full dump %u routes %u rules\n", i,
+					(unsigned)Routes(front).size(), (unsigned)Rules(front).size(), (unsigned)Routes(full).size(), (unsigned)Rules(full).size());
+				RootExec("ip route flush root 198.51.100.0/24; for p in 31000 31001 31002 31003 31004 31005 31006 31007; do while ip rule del pref $p 2>/dev/null; do :; done; done");
+				return 1;
+			}
+		}
+	}
+
+	RootExec("ip route flush root 198.51.100.0/24; for p in 31000 31001 31002 31003 31004 31005 31006 31007; do while ip rule del pref $p 2>/dev/null; do :; done; done");
+	printf("%d iterations ok\n", iterations);
+	return 0;
+}
+#endif //MAIN_NETROUTESUPDATER
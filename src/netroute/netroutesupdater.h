@@ -0,0 +1,61 @@
+#ifndef __NETROUTESUPDATER_H__
+#define __NETROUTESUPDATER_H__
+
+#include "netroutes.h"
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Background collector of NetRoutes data, double buffered.
+// Worker thread keeps NetRoutes with rtnetlink subscription, after each requested
+// update it moves its data to published buffer and UI exchanges data of its NetRoutes
+// with that buffer by Exchange(). Data is only moved, buffer belongs either to worker
+// or to UI and is never shared. Data given back by UI is older, worker brings it up
+// to date by subscription events of later updates and uses it as base of the next one.
+// Events of full dump can not be replayed, its data is copied and worker keeps original.
+class NetRoutesUpdater {
+private:
+	std::thread worker;
+	std::mutex lock;
+	std::condition_variable cv;
+
+	// data of the last update, not taken by UI yet
+	std::unique_ptr<NetRoutes> published;
+	// data given back by UI
+	std::unique_ptr<NetRoutes> returned;
+	// updates which data is published, returned and shown by UI
+	uint32_t publishedGeneration;
+	uint32_t returnedGeneration;
+	uint32_t shownGeneration;
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	RouteFilter filter;
+	bool tablesOnly;
+#endif
+	bool request;
+	bool updating;
+	bool stop;
+
+	void Run(void);
+
+	// copy and assignment not allowed
+	NetRoutesUpdater(const NetRoutesUpdater&) = delete;
+	void operator=(const NetRoutesUpdater&) = delete;
+public:
+	// ask worker for new snapshot, never blocks
+	void Request(void);
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	// routes of next snapshots, see NetRoutes::SetRouteFilter()
+	void SetRouteFilter(const RouteFilter & filter_, bool tablesOnly_ = false);
+#endif
+	// exchanges data of routes with data of the last update, O(1),
+	// returns false if there is no new one
+	bool Exchange(NetRoutes & routes);
+	bool IsReady(void);
+	bool IsUpdating(void);
+
+	NetRoutesUpdater();
+	~NetRoutesUpdater();
+};
+
+#endif /* __NETROUTESUPDATER_H__ */
@@ -0,0 +1,281 @@
+#ifndef __PREFIXINDEX_H__
+#define __PREFIXINDEX_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Values by address prefix (IPv4 or IPv6, up to 128 bits) with exact and
+// longest prefix match. Path compressed binary trie: node is created only where
+// prefixes diverge, so lookup visits at most one node per distinct prefix length
+// on the path instead of one per bit. Nodes are kept in vector and linked by
+// indexes, key is two 64-bit words compared by xor and count of leading zeros.
+// Compact() after bulk insert makes lookup of big index cheaper (see there).
+template<typename T>
+class PrefixIndex {
+	private:
+		struct Key {
+			uint64_t hi;
+			uint64_t lo;
+		};
+
+		struct Node {
+			Key key;
+			int32_t child[2];
+			uint8_t len;
+			bool present;
+			T value;
+		};
+
+		// where lookup continues after first JumpBits bits of key
+		struct Jump {
+			int32_t node;
+			int32_t best;
+		};
+
+		static const int32_t None = -1;
+		static const unsigned int JumpBits = 16;
+		static const size_t JumpMinimum = 4096;
+
+		std::vector<Node> nodes;
+		std::vector<Jump> jump;
+		int32_t root;
+		size_t count;
+
+		static uint64_t Load64(const uint8_t * p, size_t len)
+		{
+			uint64_t v = 0;
+			for( size_t i = 0; i < 8; i++ )
+				v = (v << 8) | (i < len ? p[i]:0);
+			return v;
+		};
+
+		// address in network order, bits after len are cleared
+		static Key MakeKey(const void * addr, size_t addrlen, uint8_t len)
+		{
+			const uint8_t * p = (const uint8_t *)addr;
+			Key k;
+			k.hi = Load64(p, addrlen);
+			k.lo = addrlen > 8 ? Load64(p + 8, addrlen - 8):0;
+			return Mask(k, len);
+		};
+
+		static Key Mask(Key k, uint8_t len)
+		{
+			if( len < 64 ) {
+				k.hi = len ? k.hi & (~0ULL << (64 - len)):0;
+				k.lo = 0;
+			} else if( len < 128 )
+				k.lo = len > 64 ? k.lo & (~0ULL << (128 - len)):0;
+			return k;
+		};
+
+		static unsigned int Bit(const Key & k, uint8_t pos)
+		{
+			return pos < 64 ? (k.hi >> (63 - pos)) & 1:(k.lo >> (127 - pos)) & 1;
+		};
+
+		// number of equal leading bits
+		static uint8_t Common(const Key & a, const Key & b)
+		{
+			if( uint64_t x = a.hi ^ b.hi )
+				return (uint8_t)__builtin_clzll(x);
+			if( uint64_t x = a.lo ^ b.lo )
+				return (uint8_t)(64 + __builtin_clzll(x));
+			return 128;
+		};
+
+		int32_t NewNode(const Key & key, uint8_t len)
+		{
+			Node n;
+			n.key = key;
+			n.child[0] = n.child[1] = None;
+			n.len = len;
+			n.present = false;
+			n.value = T();
+			nodes.push_back(n);
+			return (int32_t)nodes.size() - 1;
+		};
+
+	public:
+		PrefixIndex(): root(None), count(0) {};
+
+		// value of prefix is created if it is absent, addr is in network order
+		T & operator()(const void * addr, size_t addrlen, uint8_t len)
+		{
+			Key key = MakeKey(addr, addrlen, len);
+			jump.clear();
+			int32_t parent = None, cur = root, node;
+			unsigned int side = 0;
+
+			while( cur != None ) {
+				uint8_t curlen = nodes[cur].len;
+				uint8_t common = Common(nodes[cur].key, key);
+				if( common > curlen ) common = curlen;
+				if( common > len ) common = len;
+
+				if( common == curlen && len == curlen ) {
+					if( !nodes[cur].present ) {
+						nodes[cur].present = true;
+						count++;
+					}
+					return nodes[cur].value;
+				}
+				if( common == curlen ) {
+					parent = cur;
+					side = Bit(key, curlen);
+					cur = nodes[cur].child[side];
+					continue;
+				}
+				break;
+			}
+
+			node = NewNode(key, len);
+			if( cur != None ) {
+				// prefixes diverge inside of cur, it goes under new node
+				// or under glue node at their common prefix
+				uint8_t common = Common(nodes[cur].key, key);
+				if( common >= len )
+					nodes[node].child[Bit(nodes[cur].key, len)] = cur;
+				else {
+					int32_t glue = NewNode(Mask(key, common), common);
+					nodes[glue].child[Bit(key, common)] = node;
+					nodes[glue].child[Bit(nodes[cur].key, common)] = cur;
+					cur = glue;
+				}
+			}
+			if( cur == None || nodes[cur].len >= len )
+				cur = node;
+
+			if( parent == None )
+				root = cur;
+			else
+				nodes[parent].child[side] = cur;
+			nodes[node].present = true;
+			count++;
+			return nodes[node].value;
+		};
+
+		// nullptr if there is no such prefix
+		const T * Find(const void * addr, size_t addrlen, uint8_t len) const
+		{
+			Key key = MakeKey(addr, addrlen, len);
+			int32_t cur = root;
+
+			if( !jump.empty() && len >= JumpBits )
+				cur = jump[key.hi >> (64 - JumpBits)].node;
+
+			while( cur != None ) {
+				const Node & n = nodes[cur];
+				if( n.len > len || Common(n.key, key) < n.len )
+					return nullptr;
+				if( n.len == len )
+					return n.present ? &n.value:nullptr;
+				cur = n.child[Bit(key, n.len)];
+			}
+			return nullptr;
+		};
+
+		// value of the longest prefix containing addr, nullptr if there is no one
+		const T * Lookup(const void * addr, size_t addrlen) const
+		{
+			Key key = MakeKey(addr, addrlen, 128);
+			const T * best = nullptr;
+			int32_t cur = root;
+
+			if( !jump.empty() ) {
+				const Jump & j = jump[key.hi >> (64 - JumpBits)];
+				cur = j.node;
+				if( j.best != None )
+					best = &nodes[j.best].value;
+			}
+
+			while( cur != None ) {
+				const Node & n = nodes[cur];
+				if( Common(n.key, key) < n.len )
+					break;
+				if( n.present )
+					best = &n.value;
+				if( n.len == 128 )
+					break;
+				cur = n.child[Bit(key, n.len)];
+			}
+			return best;
+		};
+
+		void Reserve(size_t prefixes) { nodes.reserve(prefixes * 2); };
+
+		// Random lookups in big index are bound by cache misses, one per node on path.
+		// Nodes are renumbered in depth first order, so the first child is next to its
+		// parent, and for big index the first JumpBits bits of key are resolved by
+		// direct table instead of walk from root. Next insert drops the table.
+		void Compact(void)
+		{
+			struct Item {
+				int32_t node;
+				int32_t parent;
+				unsigned int side;
+			};
+			std::vector<Node> ordered;
+			std::vector<Item> stack;
+
+			ordered.reserve(nodes.size());
+			if( root != None )
+				stack.push_back({root, None, 0});
+			while( !stack.empty() ) {
+				Item item = stack.back();
+				stack.pop_back();
+
+				int32_t node = (int32_t)ordered.size();
+				ordered.push_back(nodes[item.node]);
+				if( item.parent == None )
+					root = node;
+				else
+					ordered[item.parent].child[item.side] = node;
+				for( int side = 1; side >= 0; side-- ) {
+					if( nodes[item.node].child[side] != None )
+						stack.push_back({nodes[item.node].child[side], node, (unsigned int)side});
+				}
+			}
+			nodes.swap(ordered);
+
+			jump.clear();
+			if( count < JumpMinimum )
+				return;
+
+			jump.resize(1 << JumpBits);
+			for( uint32_t slot = 0; slot < jump.size(); slot++ ) {
+				Key key = { (uint64_t)slot << (64 - JumpBits), 0 };
+				int32_t cur = root, best = None;
+				while( cur != None ) {
+					const Node & n = nodes[cur];
+					uint8_t bits = n.len < JumpBits ? n.len:JumpBits;
+					if( Common(n.key, key) < bits ) {
+						cur = None;
+						break;
+					}
+					// the rest of its prefix is checked by lookup
+					if( n.len >= JumpBits )
+						break;
+					if( n.present )
+						best = cur;
+					cur = n.child[Bit(key, n.len)];
+				}
+				jump[slot] = { cur, best };
+			}
+		};
+
+		void Clear(void)
+		{
+			nodes.clear();
+			jump.clear();
+			root = None;
+			count = 0;
+		};
+
+		size_t Size(void) const { return count; };
+		size_t Nodes(void) const { return nodes.size(); };
+		size_t Memory(void) const { return nodes.capacity() * sizeof(Node) + jump.capacity() * sizeof(Jump); };
+};
+
+#endif /* __PREFIXINDEX_H__ */
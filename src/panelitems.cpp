@@ -0,0 +1,111 @@
+#include "panelitems.h"
+#include "netcfgplugin.h"
+#include "netif/namepool.h"
+
+#include <algorithm>
+
+#include <common/log.h>
+
+extern const char * LOG_FILE;
+#define LOG_SOURCE_FILE "panelitems.cpp"
+
+struct PanelItems::Items {
+	int columnsNumber;
+	std::vector<PluginPanelItem> items;
+	std::vector<const wchar_t *> columns;
+	std::vector<PluginUserData> userData;
+	// metrics, flags and names repeat in many rows, kept once
+	// and released with the build
+	NamePool strings;
+};
+
+PanelItems::PanelItems():
+	version(0),
+	filter(0)
+{
+}
+
+PanelItems::~PanelItems()
+{
+	if( !given.empty() )
+		LOG_ERROR("%u arrays are still given\n", given.size());
+}
+
+bool PanelItems::IsValid(uint32_t version_, uint32_t filter_) const
+{
+	return cache && version == version_ && filter == filter_;
+}
+
+void PanelItems::Begin(uint32_t version_, uint32_t filter_, int columnsNumber, size_t reserve)
+{
+	version = version_;
+	filter = filter_;
+
+	cache = std::make_shared<Items>();
+	cache->columnsNumber = columnsNumber;
+	cache->items.reserve(reserve);
+	cache->columns.reserve(reserve * columnsNumber);
+	cache->userData.reserve(reserve);
+}
+
+PluginPanelItem & PanelItems::Append(void)
+{
+	static const wchar_t * empty_string = L"";
+	cache->columns.insert(cache->columns.end(), cache->columnsNumber, empty_string);
+	cache->userData.emplace_back();
+	cache->items.emplace_back();
+	return cache->items.back();
+}
+
+void PanelItems::SetColumn(int column, const wchar_t * value)
+{
+	cache->columns[(cache->items.size() - 1) * cache->columnsNumber + column] = value;
+}
+
+const wchar_t * PanelItems::Keep(std::wstring_view value)
+{
+	return cache->strings.Intern(value);
+}
+
+const wchar_t * PanelItems::Keep(const char * value)
+{
+	return cache->strings.Intern(value);
+}
+
+PluginUserData & PanelItems::UserData(void)
+{
+	cache->items.back().Flags |= PPIF_USERDATA;
+	cache->userData.back().size = sizeof(PluginUserData);
+	return cache->userData.back();
+}
+
+void PanelItems::End(void)
+{
+	// vectors do not grow anymore, pointers can be set
+	for( size_t index = 0; index < cache->items.size(); index++ ) {
+		PluginPanelItem & pi = cache->items[index];
+		pi.CustomColumnNumber = cache->columnsNumber;
+		pi.CustomColumnData = &cache->columns[index * cache->columnsNumber];
+		if( pi.Flags & PPIF_USERDATA )
+			pi.UserData = (DWORD_PTR)&cache->userData[index];
+	}
+	LOG_INFO("version %u filter %u items %u strings %u\n", version, filter, cache->items.size(), cache->strings.Size());
+}
+
+void PanelItems::Get(struct PluginPanelItem **pPanelItem, int *pItemsNumber)
+{
+	given.push_back(cache);
+	*pPanelItem = cache->items.data();
+	*pItemsNumber = static_cast<int>(cache->items.size());
+}
+
+bool PanelItems::Free(struct PluginPanelItem * panelItem)
+{
+	auto it = std::find_if(given.begin(), given.end(), [panelItem](const std::shared_ptr<Items> & items) {
+		return items->items.data() == panelItem;
+	});
+	if( it == given.end() )
+		return false;
+	given.erase(it);
+	return true;
+}
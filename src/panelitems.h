@@ -0,0 +1,54 @@
+#ifndef __PANELITEMS_H__
+#define __PANELITEMS_H__
+
+#include <farplug-wide.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct PluginUserData;
+
+// Panel items built once per model version and reused by every redraw.
+// far2l copies names, column strings and user data from GetFindData result,
+// so until the model changes GetFindData hands out the same array
+// and FreeFindData only releases the reference.
+class PanelItems {
+private:
+	struct Items;
+	std::shared_ptr<Items> cache;
+	uint32_t version;
+	uint32_t filter;
+
+	// arrays given to far2l and not freed yet, they keep old builds alive
+	std::vector<std::shared_ptr<Items>> given;
+
+	// copy and assignment not allowed
+	PanelItems(const PanelItems&) = delete;
+	void operator=(const PanelItems&) = delete;
+public:
+	// true if items for this model version and filter are built already
+	bool IsValid(uint32_t version, uint32_t filter) const;
+
+	// start new build, previous one stays alive while given to far2l
+	void Begin(uint32_t version, uint32_t filter, int columnsNumber, size_t reserve);
+	// append item, SetColumn() and UserData() refer to the last appended item
+	PluginPanelItem & Append(void);
+	// value must live as long as the model or be kept by Keep()
+	void SetColumn(int column, const wchar_t * value);
+	// stores computed string in the build, equal strings are stored once
+	const wchar_t * Keep(std::wstring_view value);
+	// ASCII string, e.g. name of protocol or flags
+	const wchar_t * Keep(const char * value);
+	PluginUserData & UserData(void);
+	void End(void);
+
+	void Get(struct PluginPanelItem **pPanelItem, int *pItemsNumber);
+	// returns false if panelItem was not given by Get()
+	bool Free(struct PluginPanelItem * panelItem);
+
+	PanelItems();
+	~PanelItems();
+};
+
+#endif /* __PANELITEMS_H__ */
@@ -12,6 +12,9 @@
 #include <KeyFileHelper.h>
 
 #include <common/log.h>
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+#include <common/netlink.h>
+#endif
 
 #define LOG_SOURCE_FILE "plugincfg.cpp"
 #define LOG_MAX_PATH 256
@@ -62,9 +65,15 @@ std::map<PanelIndex, CfgDefaults> PluginCfg::def = {\
 		// multicast                  C10
 		// collisions                 C11
 		// permanent_mac              C12
-		{L"N,C0,SF,C1,C2", L"N,C0,C1,C2,C3,C4,C5,C6,C7,C8,C9,C10,C11,C12"},
-		{L"7,15,7,17,0", L"7,15,17,25,0,0,0,0,0,0,0,0,0,17"},
-		{{L"ifc",L"ip",L"snd+rcv", L"mac", L"ipv6", 0}, {L"ifc",L"ip",L"mac", L"ipv6", L"mtu", L"rcv", L"snd", L"rpkts", L"spkts",L"rerr",L"serr",L"mcast",L"colls",L"permmac"}},
+		// recv_bytes per second      C13
+		// send_bytes per second      C14
+		// recv_packets per second    C15
+		// send_packets per second    C16
+		// recv_errors per second     C17
+		// send_errors per second     C18
+		{L"N,C0,SF,C1,C2", L"N,C0,C1,C2,C3,C4,C5,C6,C7,C8,C9,C10,C11,C12,C13,C14,C15,C16,C17,C18"},
+		{L"7,15,7,17,0", L"7,15,17,25,0,0,0,0,0,0,0,0,0,17,0,0,0,0,0,0"},
+		{{L"ifc",L"ip",L"snd+rcv", L"mac", L"ipv6", 0}, {L"ifc",L"ip",L"mac", L"ipv6", L"mtu", L"rcv", L"snd", L"rpkts", L"spkts",L"rerr",L"serr",L"mcast",L"colls",L"permmac",L"rcv/s",L"snd/s",L"rpkt/s",L"spkt/s",L"rerr/s",L"serr/s"}},
 		{0,MF2,MEmptyString,MF4,MF5,MF6,MEmptyString,MEmptyString,0,0,0,0},
 		{MEmptyString,MEmptyString,MEmptyString,MF4Create,MEmptyString,MEmptyString,MEmptyString,MEmptyString,MEmptyString,MEmptyString,MEmptyString,MEmptyString},
 		MPanelNetworkInterfacesTitle,
@@ -185,8 +194,10 @@ std::map<PanelIndex, CfgDefaults> PluginCfg::def = {\
 		};
 
 bool PluginCfg::logEnable = true;
+int PluginCfg::logLevel = LOG_LEVEL_INFO;
 bool PluginCfg::interfacesAddToDisksMenu = false;
 bool PluginCfg::interfacesAddToPluginsMenu = false;
+uint32_t PluginCfg::interfacesStatsInterval = 1000;
 bool PluginCfg::routesAddToDisksMenu = false;
 bool PluginCfg::routesAddToPluginsMenu = false;
 
@@ -272,6 +283,7 @@ PluginCfg::PluginCfg()
 
 		interfacesAddToDisksMenu = (bool)kfr.GetInt("interfacesAddToDisksMenu", true);
 		interfacesAddToPluginsMenu = (bool)kfr.GetInt("interfacesAddToPluginsMenu", true);
+		interfacesStatsInterval = (uint32_t)kfr.GetInt("interfacesStatsInterval", 1000);
 		routesAddToDisksMenu = (bool)kfr.GetInt("routesAddToDisksMenu", true);
 		routesAddToPluginsMenu = (bool)kfr.GetInt("routesAddToPluginsMenu", true);
 
@@ -285,12 +297,21 @@ PluginCfg::PluginCfg()
 		#endif
 
 		logEnable = (bool)kfr.GetInt("logEnable", true);
+		logLevel = kfr.GetInt("logLevel", LOG_LEVEL_INFO);
+		common_log_level = logEnable ? logLevel:LOG_LEVEL_NONE;
 	       	if( logEnable ) {
 			std::string logfile = kfr.GetString("logfile", initial_log);
 			if( logfile.size() < (LOG_MAX_PATH-1) && logfile.size() >= sizeof("/a") )
 				memmove(initial_log, logfile.c_str(), logfile.size()+1);
 		} else
 			memmove(initial_log, "/dev/null", sizeof("/dev/null"));
+
+		#if !defined(__APPLE__) && !defined(__FreeBSD__)
+		// pcap of all rtnetlink datagrams, "netlinkreplay decode" prints it
+		std::string netlinkTrace = kfr.GetString("netlinkTrace", "");
+		if( !netlinkTrace.empty() )
+			TraceNetlink(netlinkTrace.c_str());
+		#endif
 	}
 
 	KeyFileReadHelper kfrh(INI_LOCATION);
@@ -365,6 +386,7 @@ void PluginCfg::SaveConfig(void) const
 
 	kfh.SetInt(INI_SECTION, "interfacesAddToDisksMenu", interfacesAddToDisksMenu);
 	kfh.SetInt(INI_SECTION, "interfacesAddToPluginsMenu", interfacesAddToPluginsMenu);
+	kfh.SetInt(INI_SECTION, "interfacesStatsInterval", interfacesStatsInterval);
 	kfh.SetInt(INI_SECTION, "routesAddToDisksMenu", routesAddToDisksMenu);
 	kfh.SetInt(INI_SECTION, "routesAddToPluginsMenu", routesAddToPluginsMenu);
 	#if !defined(__APPLE__) && !defined(__FreeBSD__)
@@ -375,6 +397,7 @@ void PluginCfg::SaveConfig(void) const
 	std::string _logfile(LOG_FILE);
 	kfh.SetString(INI_SECTION, "logfile", _logfile);
 	kfh.SetInt(INI_SECTION, "logEnable", logEnable);
+	kfh.SetInt(INI_SECTION, "logLevel", logLevel);
 	kfh.Save();
 }
 
@@ -387,6 +410,10 @@ PluginCfg::~PluginCfg()
 
 	LOG_INFO("=== FREE ===\n");
 
+	#if !defined(__APPLE__) && !defined(__FreeBSD__)
+	TraceNetlink(0);
+	#endif
+
 	for( auto & [index, item] : def ) {
 		free((void *)item.statusColumnTypes);
 		free((void *)item.statusColumnWidths);
@@ -588,6 +615,7 @@ int PluginCfg::Configure(int itemNumber)
 				break;
 			case WinCfgEanbleLogIndex:
 				logEnable = bool(item.newVal.Selected);
+				common_log_level = logEnable ? logLevel:LOG_LEVEL_NONE;
 				if( !logEnable )
 					memmove(initial_log, "/dev/null", sizeof("/dev/null"));
 				break;
@@ -25,7 +25,7 @@ typedef struct {
 	const wchar_t * statusColumnWidths;
 	const wchar_t * columnTypes[2];
 	const wchar_t * columnWidths[2];
-	const wchar_t * columnTitles[2][15];
+	const wchar_t * columnTitles[2][21];
 	uint32_t keyBarTitles[12];
 	uint32_t keyBarShiftTitles[12];
 	uint32_t panelTitle;
@@ -57,6 +57,8 @@ class PluginCfg {
 		const char * GetPanelName(PanelIndex index) const;
 
 		static bool logEnable;
+		// LOG_LEVEL_*, lines below are not logged
+		static int logLevel;
 
 		const wchar_t * GetMsg(int msgId);
 
@@ -70,6 +72,8 @@ class PluginCfg {
 
 		static bool interfacesAddToDisksMenu;
 		static bool interfacesAddToPluginsMenu;
+		// ms between counters samples of interfaces panel, 0 - rates are not sampled
+		static uint32_t interfacesStatsInterval;
 
 		static bool routesAddToDisksMenu;
 		static bool routesAddToPluginsMenu;